@@ -117,6 +117,11 @@ public:
 #endif
     virtual void Preload_Model_Assets(Utf8String model) = 0;
     virtual void Preload_Texture_Assets(Utf8String texture) = 0;
+#ifndef GAME_DLL
+    // Thyme specific: Models preloaded between these calls may be collected and loaded together by the end call.
+    virtual void Begin_Model_Preloads() {}
+    virtual void End_Model_Preloads() {}
+#endif
     virtual void Take_ScreenShot() = 0;
     virtual void Toggle_Movie_Capture() = 0;
     virtual void Toggle_LetterBox() = 0;
@@ -13,6 +13,7 @@
  *            LICENSE
  */
 #include "eva.h"
+#include "audiomanager.h"
 #ifdef GAME_DLL
 #include "hooker.h"
 #endif
@@ -111,6 +112,23 @@ void Eva::Set_Should_Play(EvaMessage message)
     m_shouldPlay[message] = true;
 }
 
+void Eva::Prefetch_Side_Sounds(const Utf8String &side)
+{
+#ifndef GAME_DLL
+    for (const EvaCheckInfo *info : m_checkInfo) {
+        for (const EvaSideSounds &side_sounds : info->m_sideSounds) {
+            if (side_sounds.m_side.Compare_No_Case(side) != 0) {
+                continue;
+            }
+
+            for (const Utf8String &sound : side_sounds.m_sounds) {
+                g_theAudio->Prefetch_Audio_Event(sound);
+            }
+        }
+    }
+#endif
+}
+
 static const char *s_theEvaMessageNames[] = { "LOWPOWER",
     "INSUFFICIENTFUNDS",
     "SUPERWEAPONDETECTED_OWN_PARTICLECANNON",
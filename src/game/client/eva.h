@@ -134,6 +134,8 @@ public:
     bool Message_Should_Play(EvaMessage message, unsigned int frame);
     void Play_Message(EvaMessage message, unsigned int frame);
     void Process_Playing_Message(unsigned int frame);
+    // Thyme specific: Loads the messages a side's EVA speaks before they are first needed.
+    void Prefetch_Side_Sounds(const Utf8String &side);
 
     static void Parse(INI *ini);
     static EvaMessage Name_To_Message(Utf8String const &name);
@@ -15,6 +15,7 @@
  */
 #include "gameclient.h"
 #include "anim2d.h"
+#include "audiomanager.h"
 #include "campaignmanager.h"
 #include "challengegenerals.h"
 #include "commandxlat.h"
@@ -45,6 +46,7 @@
 #include "objectcreationlist.h"
 #include "particlesysmanager.h"
 #include "placeeventtranslator.h"
+#include "player.h"
 #include "playerlist.h"
 #include "rayeffect.h"
 #include "scriptengine.h"
@@ -683,9 +685,32 @@ void GameClient::Allocate_Shadows()
     }
 }
 
+#ifndef GAME_DLL
+// Thyme specific: Has the audio manager decode the responses a unit gives to orders before the first one is given.
+static void Prefetch_Unit_Responses(const ThingTemplate *thing)
+{
+    const AudioEventRTS *responses[] = { thing->Get_Voice_Select(),
+        thing->Get_Voice_Group_Select(),
+        thing->Get_Voice_Move(),
+        thing->Get_Voice_Attack(),
+        thing->Get_Voice_Guard(),
+        thing->Get_Voice_Created() };
+
+    for (const AudioEventRTS *response : responses) {
+        if (response != nullptr && response->Get_Event_Name().Is_Not_Empty()) {
+            g_theAudio->Prefetch_Audio_Event(response->Get_Event_Name());
+        }
+    }
+}
+#endif
+
 void GameClient::Preload_Assets(TimeOfDayType tod)
 {
     // TODO memory debug logging
+#ifndef GAME_DLL
+    g_theDisplay->Begin_Model_Preloads();
+#endif
+
     for (Drawable *draw = Get_Drawable_List(); draw != nullptr; draw = draw->Get_Next()) {
         draw->Preload_Assets(tod);
     }
@@ -702,11 +727,26 @@ void GameClient::Preload_Assets(TimeOfDayType tod)
         }
     }
 
+#ifndef GAME_DLL
+    for (Drawable *draw = Get_Drawable_List(); draw != nullptr; draw = draw->Get_Next()) {
+        Prefetch_Unit_Responses(draw->Get_Template());
+    }
+
+    Player *player = g_thePlayerList->Get_Local_Player();
+
+    if (player != nullptr) {
+        g_theEva->Prefetch_Side_Sounds(player->Get_Side());
+    }
+#endif
+
     for (unsigned int i = 0; i < g_debrisModelNamesGlobalHack.size(); i++) {
         g_theDisplay->Preload_Model_Assets(g_debrisModelNamesGlobalHack[i]);
     }
 
     g_debrisModelNamesGlobalHack.clear();
+#ifndef GAME_DLL
+    g_theDisplay->End_Model_Preloads();
+#endif
     g_theControlBar->Preload_Assets(tod);
     g_theParticleSystemManager->Preload_Assets(tod);
 
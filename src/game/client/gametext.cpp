@@ -52,25 +52,251 @@ int GameTextManager::Compare_LUT(void const *a, void const *b)
     return strcasecmp(ac, bc);
 }
 
+// Case insensitive FNV-1a with a final mix. Only ASCII is folded, matching strcasecmp in the C locale.
+uint32_t StringLabelHash::Hash(const char *label, size_t length, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ (seed * 0x9E3779B9u);
+
+    for (size_t i = 0; i < length; ++i) {
+        uint8_t current = label[i];
+
+        if (current >= 'A' && current <= 'Z') {
+            current += 'a' - 'A';
+        }
+
+        hash ^= current;
+        hash *= 16777619u;
+    }
+
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6Bu;
+    hash ^= hash >> 13;
+
+    return hash;
+}
+
+void StringLabelHash::Clear()
+{
+    delete[] m_displacements;
+    delete[] m_slots;
+    m_displacements = nullptr;
+    m_slots = nullptr;
+    m_bucketCount = 0;
+    m_slotCount = 0;
+}
+
+// Builds the hash from a sorted lookup table, the table must outlive the hash.
+void StringLabelHash::Build(const StringLookUp *lut, int count)
+{
+    Clear();
+
+    if (count <= 0) {
+        return;
+    }
+
+    // The lookup table is sorted case insensitively so duplicate labels are neighbours, bsearch could have found any
+    // of them so just keep the first.
+    const StringLookUp **keys = new const StringLookUp *[count];
+    int unique = 0;
+
+    for (int i = 0; i < count; ++i) {
+        if (unique == 0 || strcasecmp(lut[i].label->Str(), keys[unique - 1]->label->Str()) != 0) {
+            keys[unique++] = &lut[i];
+        }
+    }
+
+    // Retry with a sparser table if some bucket can't be placed, not expected to happen with the default load.
+    for (int slot_count = unique + unique / 4 + 1; !Try_Build(keys, unique, slot_count); slot_count *= 2) {
+        captainslog_warn("Failed to build string label hash with %d slots, retrying.", slot_count);
+    }
+
+    delete[] keys;
+}
+
+bool StringLabelHash::Try_Build(const StringLookUp **keys, int count, int slot_count)
+{
+    enum
+    {
+        MAX_DISPLACEMENT = 0x100000,
+    };
+
+    Clear();
+    m_bucketCount = count / 2 + 1;
+    m_slotCount = slot_count;
+    m_displacements = new uint32_t[m_bucketCount];
+    m_slots = new StringInfo *[m_slotCount];
+    memset(m_displacements, 0, sizeof(uint32_t) * m_bucketCount);
+    memset(m_slots, 0, sizeof(StringInfo *) * m_slotCount);
+
+    // Sort the keys into buckets by their first hash.
+    int *key_bucket = new int[count];
+    int *bucket_start = new int[m_bucketCount + 1];
+    int *bucket_keys = new int[count];
+    int *bucket_order = new int[m_bucketCount];
+    memset(bucket_start, 0, sizeof(int) * (m_bucketCount + 1));
+
+    for (int i = 0; i < count; ++i) {
+        const Utf8String &label = *keys[i]->label;
+        key_bucket[i] = Hash(label.Str(), label.Is_Empty() ? 0 : label.Get_Length(), 0) % m_bucketCount;
+        ++bucket_start[key_bucket[i] + 1];
+    }
+
+    int max_bucket_size = 0;
+
+    for (int i = 0; i < m_bucketCount; ++i) {
+        max_bucket_size = std::max(max_bucket_size, bucket_start[i + 1]);
+        bucket_start[i + 1] += bucket_start[i];
+        bucket_order[i] = i;
+    }
+
+    int *fill = new int[m_bucketCount];
+    memcpy(fill, bucket_start, sizeof(int) * m_bucketCount);
+
+    for (int i = 0; i < count; ++i) {
+        bucket_keys[fill[key_bucket[i]]++] = i;
+    }
+
+    // Place the largest buckets first while the table is still mostly empty.
+    std::sort(bucket_order, bucket_order + m_bucketCount, [bucket_start](int a, int b) {
+        int size_a = bucket_start[a + 1] - bucket_start[a];
+        int size_b = bucket_start[b + 1] - bucket_start[b];
+        return size_a != size_b ? size_a > size_b : a < b;
+    });
+
+    int *positions = new int[max_bucket_size + 1];
+    bool success = true;
+
+    for (int i = 0; i < m_bucketCount && success; ++i) {
+        int bucket = bucket_order[i];
+        int start = bucket_start[bucket];
+        int size = bucket_start[bucket + 1] - start;
+
+        if (size == 0) {
+            break;
+        }
+
+        success = false;
+
+        for (uint32_t displacement = 1; displacement < MAX_DISPLACEMENT && !success; ++displacement) {
+            success = true;
+
+            for (int k = 0; k < size && success; ++k) {
+                const Utf8String &label = *keys[bucket_keys[start + k]]->label;
+                int pos = Hash(label.Str(), label.Is_Empty() ? 0 : label.Get_Length(), displacement) % m_slotCount;
+                success = m_slots[pos] == nullptr;
+
+                for (int j = 0; j < k && success; ++j) {
+                    success = positions[j] != pos;
+                }
+
+                positions[k] = pos;
+            }
+
+            if (success) {
+                m_displacements[bucket] = displacement;
+
+                for (int k = 0; k < size; ++k) {
+                    m_slots[positions[k]] = keys[bucket_keys[start + k]]->info;
+                }
+            }
+        }
+    }
+
+    delete[] positions;
+    delete[] fill;
+    delete[] bucket_order;
+    delete[] bucket_keys;
+    delete[] bucket_start;
+    delete[] key_bucket;
+
+    if (!success) {
+        Clear();
+    }
+
+    return success;
+}
+
+static bool Label_Matches(const Utf8String &string, const char *label, size_t length, bool no_case)
+{
+    size_t string_length = string.Is_Empty() ? 0 : string.Get_Length();
+
+    if (string_length != length) {
+        return false;
+    }
+
+    return (no_case ? strncasecmp(string.Str(), label, length) : strncmp(string.Str(), label, length)) == 0;
+}
+
+StringInfo *StringLabelHash::Find(const char *label, size_t length) const
+{
+    if (m_slots == nullptr) {
+        return nullptr;
+    }
+
+    uint32_t displacement = m_displacements[Hash(label, length, 0) % m_bucketCount];
+    StringInfo *info = m_slots[Hash(label, length, displacement) % m_slotCount];
+
+    if (info != nullptr && Label_Matches(info->label, label, length, true)) {
+        return info;
+    }
+
+    return nullptr;
+}
+
 GameTextInterface *GameTextManager::Create_Game_Text_Interface()
 {
     return new GameTextManager;
 }
 
-// Get a char from a file.
-char GameTextManager::Read_Char(File *file)
+// Reads the whole file into memory and closes it.
+bool StringFileArena::Load(const char *filename, int mode)
+{
+    File *file = g_theFileSystem->Open_File(filename, mode);
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    delete[] m_data;
+    m_size = std::max(file->Size(), 0);
+    m_pos = 0;
+    m_data = new char[m_size + 1];
+    m_size = std::max(file->Read(m_data, m_size), 0);
+    m_data[m_size] = '\0';
+    file->Close();
+
+    return true;
+}
+
+// Copies the next size bytes out of the arena, fails without consuming anything if fewer remain.
+bool StringFileArena::Read(void *dst, int size)
 {
-    char tmp;
+    const char *src = Get(size);
 
-    if (file->Read(&tmp, sizeof(tmp)) == sizeof(tmp)) {
-        return tmp;
+    if (src == nullptr) {
+        return false;
     }
 
-    return '\0';
+    memcpy(dst, src, size);
+
+    return true;
+}
+
+// Returns a pointer to the next size bytes and consumes them, or null if fewer remain.
+const char *StringFileArena::Get(int size)
+{
+    if (size < 0 || size > Remaining()) {
+        return nullptr;
+    }
+
+    const char *data = Peek();
+    m_pos += size;
+
+    return data;
 }
 
 // Read a quoted string and also any extra data.
-void GameTextManager::Read_To_End_Of_Quote(File *file, char *in, char *out, char *wave, int buff_len)
+void GameTextManager::Read_To_End_Of_Quote(StringFileArena &file, char *in, char *out, char *wave, int buff_len)
 {
     bool escape = false;
     int i;
@@ -84,10 +310,10 @@ void GameTextManager::Read_To_End_Of_Quote(File *file, char *in, char *out, char
 
             if (current == '\0') {
                 in = nullptr;
-                current = Read_Char(file);
+                current = file.Read_Char();
             }
         } else {
-            current = Read_Char(file);
+            current = file.Read_Char();
         }
 
         // -1 and we are done?
@@ -130,10 +356,10 @@ void GameTextManager::Read_To_End_Of_Quote(File *file, char *in, char *out, char
 
             if (current == '\0') {
                 in = nullptr;
-                current = Read_Char(file);
+                current = file.Read_Char();
             }
         } else {
-            current = Read_Char(file);
+            current = file.Read_Char();
         }
 
         // Stop reading on line break or -1 char.
@@ -141,6 +367,11 @@ void GameTextManager::Read_To_End_Of_Quote(File *file, char *in, char *out, char
             break;
         }
 
+        // #BUGFIX Also stop at the end of the file, a last line without a line break used to never terminate.
+        if (current == '\0' && in == nullptr && file.At_End()) {
+            break;
+        }
+
         // state 0 ignores initial whitespace and '='
         if (state == 0 && !isspace(uint8_t(current)) && current != '=') {
             state = 1;
@@ -169,28 +400,25 @@ void GameTextManager::Read_To_End_Of_Quote(File *file, char *in, char *out, char
 }
 
 // Read a line from a str file into provided buffer.
-bool GameTextManager::Read_Line(char *buffer, int length, File *file)
+bool GameTextManager::Read_Line(char *buffer, int length, StringFileArena &file)
 {
-    bool ret = false;
-    char *putp = buffer;
-
-    for (int i = 0; i < length; ++i) {
-        if (file->Read(putp, sizeof(*putp)) != sizeof(*putp)) {
-            break;
-        }
-
-        ret = true;
+    int count = std::min(length, file.Remaining());
 
-        if (*putp == '\n') {
-            break;
-        }
+    if (count <= 0) {
+        *buffer = '\0';
 
-        ++putp;
+        return false;
     }
 
-    *putp = '\0';
+    const char *line = file.Peek();
+    const char *newline = static_cast<const char *>(memchr(line, '\n', count));
+    int line_len = newline != nullptr ? int(newline - line) : count;
+
+    memcpy(buffer, line, line_len);
+    buffer[line_len] = '\0';
+    file.Skip(newline != nullptr ? line_len + 1 : line_len);
 
-    return ret;
+    return true;
 }
 
 // Converts an ASCII string into a usc2/utf16 string.
@@ -347,10 +575,10 @@ void GameTextManager::Reverse_Word(char *start, char *end)
 // Get the count of strings in a str file.
 bool GameTextManager::Get_String_Count(const char *filename, int &count)
 {
-    File *file = g_theFileSystem->Open_File(filename, File::TEXT | File::READ);
+    StringFileArena file;
     count = 0;
 
-    if (file == nullptr) {
+    if (!file.Load(filename, File::TEXT | File::READ)) {
         return false;
     }
 
@@ -369,8 +597,6 @@ bool GameTextManager::Get_String_Count(const char *filename, int &count)
 
     count += 500;
 
-    file->Close();
-
     return true;
 }
 
@@ -403,9 +629,9 @@ bool GameTextManager::Get_CSF_Info(const char *filename)
 bool GameTextManager::Parse_String_File(const char *filename)
 {
     captainslog_info("Parsing string file '%s'.", filename);
-    File *file = g_theFileSystem->Open_File(filename, File::TEXT | File::READ);
+    StringFileArena file;
 
-    if (file == nullptr) {
+    if (!file.Load(filename, File::TEXT | File::READ)) {
         return false;
     }
 
@@ -473,8 +699,6 @@ bool GameTextManager::Parse_String_File(const char *filename)
         }
     }
 
-    file->Close();
-
     if (!end) {
         captainslog_error("Unexpected end of string file '%s'.", filename);
 
@@ -484,107 +708,167 @@ bool GameTextManager::Parse_String_File(const char *filename)
     return true;
 }
 
+// Copies a label or speech name straight out of the file data, neither is null terminated in CSF files.
+void GameTextManager::Copy_CSF_String(Utf8String &string, const char *data, int length)
+{
+    const char *end = static_cast<const char *>(memchr(data, '\0', length));
+
+    if (end != nullptr) {
+        length = int(end - data);
+    }
+
+    if (length <= 0) {
+        string.Clear();
+
+        return;
+    }
+
+    char *buffer = string.Get_Buffer_For_Read(length);
+    memcpy(buffer, data, length);
+    buffer[length] = '\0';
+}
+
+// Decodes CSF text straight out of the file data into the string. Characters are little endian and binary NOT
+// encoded, decoding stops at the first null like it did when the text was decoded in a null terminated buffer.
+void GameTextManager::Decode_CSF_Text(Utf16String &string, const char *data, int length)
+{
+    const uint8_t *src = reinterpret_cast<const uint8_t *>(data);
+    int decoded_len = 0;
+
+    // Read bytewise as the text has no alignment guarantee within the file. The text ends at a raw null as well as at
+    // a character that decodes to null.
+    while (decoded_len < length) {
+        uint16_t raw = src[decoded_len * 2] | (src[decoded_len * 2 + 1] << 8);
+
+        if (raw == 0x0000 || raw == 0xFFFF) {
+            break;
+        }
+
+        ++decoded_len;
+    }
+
+    if (decoded_len == 0) {
+        string.Clear();
+
+        return;
+    }
+
+    unichar_t *buffer = string.Get_Buffer_For_Read(decoded_len);
+
+    for (int i = 0; i < decoded_len; ++i) {
+        buffer[i] = unichar_t(~(src[i * 2] | (src[i * 2 + 1] << 8)));
+    }
+
+    buffer[decoded_len] = '\0';
+    Strip_Spaces(buffer);
+
+    if (buffer[0] == '\0') {
+        string.Clear();
+    }
+}
+
 // Parses CSF files which support UCS2 strings, essentially the BMP of unicode.
 bool GameTextManager::Parse_CSF_File(const char *filename)
 {
     captainslog_info("Parsing CSF file '%s'.", filename);
+    StringFileArena file;
     CSFHeader header;
-    File *file = g_theFileSystem->Open_File(filename, File::BINARY | File::READ);
 
-    if (file == nullptr || file->Read(&header, sizeof(header)) != sizeof(header)) {
+    if (!file.Load(filename, File::BINARY | File::READ) || !file.Read(&header, sizeof(header))) {
         return false;
     }
 
     uint32_t id;
     int index = 0;
 
-    if (file->Read(&id, sizeof(id)) != sizeof(id)) {
-        file->Close();
-
+    if (!file.Read(&id, sizeof(id))) {
         return false;
     }
 
     // Little endian "LBL " FourCC
     while (id == FourCC<' ', 'L', 'B', 'L'>::value) {
+        // #BUGFIX Don't write past the string info allocated for the label count in the header.
+        if (index >= m_textCount) {
+            captainslog_error("CSF file '%s' has more labels than its header declares.", filename);
+
+            break;
+        }
+
         int32_t num_strings;
         int32_t length;
 
-        file->Read(&num_strings, sizeof(num_strings));
-        file->Read(&length, sizeof(length));
+        if (!file.Read(&num_strings, sizeof(num_strings)) || !file.Read(&length, sizeof(length))) {
+            return false;
+        }
 
         // convert to host endianess
         length = le32toh(length);
         num_strings = le32toh(num_strings);
 
-        if (length > 0) {
-            file->Read(m_bufferIn, length);
+        const char *label = file.Get(length);
+
+        if (label == nullptr) {
+            return false;
         }
 
-        m_bufferIn[length] = '\0';
-        m_stringInfo[index].label = m_bufferIn;
+        Copy_CSF_String(m_stringInfo[index].label, label, length);
         m_maxLabelLen = std::max(length, m_maxLabelLen);
 
         // Read all strings associated with this label, Nox used multiple strings for
         // random variation, Generals only cares about first one.
         for (int i = 0; i < num_strings; ++i) {
-            file->Read(&id, sizeof(id));
+            if (!file.Read(&id, sizeof(id))) {
+                return false;
+            }
 
             if (id != FourCC<' ', 'R', 'T', 'S'>::value && id != FourCC<'W', 'R', 'T', 'S'>::value) {
-                file->Close();
+                return false;
+            }
 
+            if (!file.Read(&length, sizeof(length))) {
                 return false;
             }
 
-            file->Read(&length, sizeof(length));
             length = le32toh(length);
+            const int text_size = int(sizeof(unichar_t));
+            const char *text = length <= file.Remaining() / text_size ? file.Get(length * text_size) : nullptr;
 
-            if (length > 0) {
-                file->Read(m_translateBuffer, sizeof(m_translateBuffer[0]) * length);
+            if (text == nullptr) {
+                return false;
             }
 
             // CSF format supports multiple strings per label, but we only care about
             // first string.
             if (i == 0) {
-                m_translateBuffer[length] = '\0';
-
-                for (int j = 0; m_translateBuffer[j] != '\0'; ++j) {
-                    // Correct for big endian systems
-                    m_translateBuffer[j] = le16toh(m_translateBuffer[j]);
-
-                    // Binary NOT to decode
-                    m_translateBuffer[j] = ~m_translateBuffer[j];
-                }
-
-                Strip_Spaces(m_translateBuffer);
-                m_stringInfo[index].text = m_translateBuffer;
+                Decode_CSF_Text(m_stringInfo[index].text, text, length);
             }
 
             // FourCC of 'STRW' rather than 'STR ' indicates extra data.
             if (id == FourCC<'W', 'R', 'T', 'S'>::value) {
-                file->Read(&length, sizeof(length));
+                if (!file.Read(&length, sizeof(length))) {
+                    return false;
+                }
+
                 length = le32toh(length);
+                const char *speech = file.Get(length);
 
-                if (length > 0) {
-                    file->Read(m_bufferIn, length);
+                if (speech == nullptr) {
+                    return false;
                 }
 
-                m_bufferIn[length] = '\0';
-
                 if (i == 0) {
-                    m_stringInfo[index].speech = m_bufferIn;
+                    Copy_CSF_String(m_stringInfo[index].speech, speech, length);
                 }
             }
         }
 
         ++index;
 
-        if (file->Read(&id, sizeof(id)) != sizeof(id)) {
+        if (!file.Read(&id, sizeof(id))) {
             break;
         }
     }
 
-    file->Close();
-
     return true;
 }
 
@@ -592,9 +876,9 @@ bool GameTextManager::Parse_CSF_File(const char *filename)
 bool GameTextManager::Parse_Map_String_File(const char *filename)
 {
     captainslog_info("Parsing map string file '%s'.", filename);
-    File *file = g_theFileSystem->Open_File(filename, File::TEXT | File::READ);
+    StringFileArena file;
 
-    if (file == nullptr) {
+    if (!file.Load(filename, File::TEXT | File::READ)) {
         return false;
     }
 
@@ -664,8 +948,6 @@ bool GameTextManager::Parse_Map_String_File(const char *filename)
         }
     }
 
-    file->Close();
-
     if (!end) {
         captainslog_error("Unexpected end of string file '%s'.", filename);
 
@@ -762,6 +1044,7 @@ void GameTextManager::Init()
     }
 
     qsort(m_stringLUT, m_textCount, sizeof(StringLookUp), Compare_LUT);
+    m_stringHash.Build(m_stringLUT, m_textCount);
 
     // Fetch the GUI window title string and set it here.
     Utf8String ntitle;
@@ -787,6 +1070,7 @@ void GameTextManager::Init()
 void GameTextManager::Reset()
 {
     m_mapTextCount = 0; // #BUGFIX Reset map text count as well.
+    m_mapStringHash.Clear();
 
     if (m_mapStringInfo != nullptr) {
         delete[] m_mapStringInfo;
@@ -809,6 +1093,12 @@ Utf16String GameTextManager::Fetch(Utf8String args, bool *success)
 // Find and return the unicode string corresponding to the label provided.
 // Optionally can pass a bool pointer to determine if a string was found.
 Utf16String GameTextManager::Fetch(const char *args, bool *success)
+{
+    return Fetch_Label(args, args != nullptr ? strlen(args) : 0, success);
+}
+
+// Same as Fetch, but the label doesn't need to be null terminated so it can be part of a larger string.
+Utf16String GameTextManager::Fetch_Label(const char *label, size_t length, bool *success)
 {
     if (m_stringInfo == nullptr) {
         if (success != nullptr) {
@@ -818,31 +1108,18 @@ Utf16String GameTextManager::Fetch(const char *args, bool *success)
         return m_failed;
     }
 
-    Utf8String argstr = args;
-    StringLookUp key = { &argstr, nullptr };
+    StringInfo *found = m_stringHash.Find(label, length);
 
-    StringLookUp *found =
-        static_cast<StringLookUp *>(bsearch(&key, m_stringLUT, m_textCount, sizeof(StringLookUp), Compare_LUT));
+    if (found == nullptr) {
+        found = m_mapStringHash.Find(label, length);
+    }
 
     if (found != nullptr) {
         if (success != nullptr) {
             *success = true;
         }
 
-        return found->info->text;
-    }
-
-    if (m_mapStringLUT != nullptr && m_mapTextCount > 0) {
-        found =
-            static_cast<StringLookUp *>(bsearch(&key, m_mapStringLUT, m_mapTextCount, sizeof(StringLookUp), Compare_LUT));
-
-        if (found != nullptr) {
-            if (success != nullptr) {
-                *success = true;
-            }
-
-            return found->info->text;
-        }
+        return found->text;
     }
 
     if (success != nullptr) {
@@ -850,14 +1127,11 @@ Utf16String GameTextManager::Fetch(const char *args, bool *success)
     }
 
     // If we reached here, we didn't find a string from our string file.
-    Utf16String missing;
     NoString *no_string;
 
-    missing.Format(U_CHAR("MISSING: '%hs'"), args);
-
     // Find missing string in NoString list if it already exists.
     for (no_string = m_noStringList; no_string != nullptr; no_string = no_string->next) {
-        if (missing == no_string->text) {
+        if (Label_Matches(no_string->label, label, length, false)) {
             break;
         }
     }
@@ -865,7 +1139,14 @@ Utf16String GameTextManager::Fetch(const char *args, bool *success)
     // If it was not found or the list was empty, add a new one.
     if (no_string == nullptr) {
         no_string = new NoString;
-        no_string->text = missing;
+
+        if (length > 0) {
+            char *buffer = no_string->label.Get_Buffer_For_Read(length);
+            memcpy(buffer, label, length);
+            buffer[length] = '\0';
+        }
+
+        no_string->text.Format(U_CHAR("MISSING: '%hs'"), no_string->label.Str());
         no_string->next = m_noStringList;
         m_noStringList = no_string;
     }
@@ -873,6 +1154,40 @@ Utf16String GameTextManager::Fetch(const char *args, bool *success)
     return no_string->text;
 }
 
+// Finds the range of a sorted lookup table with labels starting with the prefix, ignoring case. The table is
+// sorted case insensitively so all such labels are next to each other.
+void GameTextManager::Find_Prefix_Range(
+    const StringLookUp *lut, int count, const char *prefix, size_t length, int &first, int &last)
+{
+    int low = 0;
+    int high = count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (strncasecmp(lut[mid].label->Str(), prefix, length) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    first = low;
+    high = count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+
+        if (strncasecmp(lut[mid].label->Str(), prefix, length) <= 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    last = low;
+}
+
 // List all string labels that start with the prefix passed to the function.
 std::vector<Utf8String> *GameTextManager::Get_Strings_With_Prefix(Utf8String label)
 {
@@ -880,12 +1195,18 @@ std::vector<Utf8String> *GameTextManager::Get_Strings_With_Prefix(Utf8String lab
 
     captainslog_trace("Searching for strings prefixed with '%s'.", label.Str());
 
-    // Search all string labels that start with the substring provided.
+    const char *prefix = label.Str();
+    size_t length = strlen(prefix);
+    int first;
+    int last;
+
+    // Search all string labels that start with the substring provided. The range is found ignoring case, the match
+    // itself is case sensitive.
     if (m_stringLUT != nullptr) {
-        for (int i = 0; i < m_textCount; ++i) {
-            const char *lut_label = m_stringLUT[i].label->Str();
+        Find_Prefix_Range(m_stringLUT, m_textCount, prefix, length, first, last);
 
-            if (strstr(lut_label, label.Str()) == lut_label) {
+        for (int i = first; i < last; ++i) {
+            if (strncmp(m_stringLUT[i].label->Str(), prefix, length) == 0) {
                 m_stringVector.push_back(*m_stringLUT[i].label);
             }
         }
@@ -893,9 +1214,10 @@ std::vector<Utf8String> *GameTextManager::Get_Strings_With_Prefix(Utf8String lab
 
     // Same again for map strings.
     if (m_mapStringLUT != nullptr) {
-        for (int i = 0; i < m_mapTextCount; ++i) {
-            const char *lut_label = m_mapStringLUT[i].label->Str();
-            if (strstr(lut_label, label.Str()) == lut_label) {
+        Find_Prefix_Range(m_mapStringLUT, m_mapTextCount, prefix, length, first, last);
+
+        for (int i = first; i < last; ++i) {
+            if (strncmp(m_mapStringLUT[i].label->Str(), prefix, length) == 0) {
                 m_stringVector.push_back(*m_mapStringLUT[i].label);
             }
         }
@@ -921,6 +1243,7 @@ void GameTextManager::Init_Map_String_File(Utf8String const &filename)
     }
 
     qsort(m_mapStringLUT, m_mapTextCount, sizeof(StringLookUp), Compare_LUT);
+    m_mapStringHash.Build(m_mapStringLUT, m_mapTextCount);
 }
 
 // Destroys the main string file, doesn't affect loaded map strings.
@@ -936,6 +1259,7 @@ void GameTextManager::Deinit()
         m_stringLUT = nullptr;
     }
 
+    m_stringHash.Clear();
     m_textCount = 0;
 
     for (NoString *ns = m_noStringList; ns != nullptr;) {
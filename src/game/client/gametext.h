@@ -52,6 +52,7 @@ struct CSFHeader
 struct NoString
 {
     NoString *next;
+    Utf8String label;
     Utf16String text;
 };
 
@@ -68,6 +69,51 @@ struct StringLookUp
     StringInfo *info;
 };
 
+// Perfect hash over the labels of a loaded string table, built with the hash and displace method. Every label maps
+// to its own slot so a lookup is two hashes and one case insensitive compare, without allocating.
+class StringLabelHash
+{
+public:
+    StringLabelHash() : m_displacements(nullptr), m_slots(nullptr), m_bucketCount(0), m_slotCount(0) {}
+    ~StringLabelHash() { Clear(); }
+
+    void Build(const StringLookUp *lut, int count);
+    void Clear();
+    StringInfo *Find(const char *label, size_t length) const;
+
+private:
+    static uint32_t Hash(const char *label, size_t length, uint32_t seed);
+    bool Try_Build(const StringLookUp **keys, int count, int slot_count);
+
+    uint32_t *m_displacements;
+    StringInfo **m_slots;
+    int m_bucketCount;
+    int m_slotCount;
+};
+
+// Holds the complete contents of a string file so it is read with a single File::Read and then parsed from memory.
+class StringFileArena
+{
+public:
+    StringFileArena() : m_data(nullptr), m_size(0), m_pos(0) {}
+    ~StringFileArena() { delete[] m_data; }
+
+    bool Load(const char *filename, int mode);
+    bool Read(void *dst, int size);
+    const char *Get(int size);
+    char Read_Char() { return m_pos < m_size ? m_data[m_pos++] : '\0'; }
+    bool At_End() const { return m_pos >= m_size; }
+
+    const char *Peek() const { return m_data + m_pos; }
+    int Remaining() const { return m_size - m_pos; }
+    void Skip(int size) { m_pos += size; }
+
+private:
+    char *m_data;
+    int m_size;
+    int m_pos;
+};
+
 class GameTextInterface : public SubsystemInterface
 {
 public:
@@ -78,6 +124,9 @@ public:
     virtual std::vector<Utf8String> *Get_Strings_With_Prefix(Utf8String label) = 0;
     virtual void Init_Map_String_File(Utf8String const &filename) = 0;
     virtual void Deinit() = 0;
+
+    // Not part of the original interface, must stay last in the vtable.
+    virtual Utf16String Fetch_Label(const char *label, size_t length, bool *success = nullptr) = 0;
 };
 
 class GameTextManager : public GameTextInterface
@@ -95,23 +144,27 @@ public:
     virtual std::vector<Utf8String> *Get_Strings_With_Prefix(Utf8String label) override;
     virtual void Init_Map_String_File(Utf8String const &filename) override;
     virtual void Deinit() override;
+    virtual Utf16String Fetch_Label(const char *label, size_t length, bool *success = nullptr) override;
 
     static int Compare_LUT(void const *a, void const *b);
     static GameTextInterface *Create_Game_Text_Interface();
 
 private:
-    void Read_To_End_Of_Quote(File *file, char *in, char *out, char *wave, int buff_len);
+    void Read_To_End_Of_Quote(StringFileArena &file, char *in, char *out, char *wave, int buff_len);
     void Translate_Copy(unichar_t *out, char *in);
     void Remove_Leading_And_Trailing(char *buffer);
     void Strip_Spaces(unichar_t *buffer);
     void Reverse_Word(char *start, char *end);
-    char Read_Char(File *file);
-    bool Read_Line(char *buffer, int length, File *file);
+    bool Read_Line(char *buffer, int length, StringFileArena &file);
     bool Get_String_Count(const char *filename, int &count);
     bool Get_CSF_Info(const char *filename);
     bool Parse_String_File(const char *filename);
     bool Parse_CSF_File(const char *filename);
     bool Parse_Map_String_File(const char *filename);
+    static void Copy_CSF_String(Utf8String &string, const char *data, int length);
+    void Decode_CSF_Text(Utf16String &string, const char *data, int length);
+    static void Find_Prefix_Range(
+        const StringLookUp *lut, int count, const char *prefix, size_t length, int &first, int &last);
 
 private:
     int m_textCount;
@@ -133,6 +186,8 @@ private:
     StringLookUp *m_mapStringLUT;
     int m_mapTextCount;
     std::vector<Utf8String> m_stringVector;
+    StringLabelHash m_stringHash;
+    StringLabelHash m_mapStringHash;
 };
 
 #ifdef GAME_DLL
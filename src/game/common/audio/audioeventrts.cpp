@@ -348,6 +348,23 @@ void AudioEventRTS::Generate_Play_Info()
     m_isLogical = false;
 }
 
+/**
+ * Generates the path to a sample of the event from its name.
+ */
+Utf8String AudioEventRTS::Generate_Sample_Filename(const Utf8String &sample)
+{
+    if (m_eventInfo == nullptr) {
+        return Utf8String();
+    }
+
+    Utf8String filename = Generate_Filename_Prefix(m_eventInfo->Get_Event_Type(), false);
+    filename += sample;
+    filename += Generate_Filename_Extension(m_eventInfo->Get_Event_Type());
+    Adjust_For_Localization(filename);
+
+    return filename;
+}
+
 /**
  * Decrements the events loop count.
  *
@@ -38,6 +38,8 @@ public:
     void Generate_Play_Info();
     void Decrease_Loop_Count();
     void Advance_Next_Play_Portion();
+    // Thyme specific: Builds the path to one of the event's sounds, attacks or decays the way the play filenames are.
+    Utf8String Generate_Sample_Filename(const Utf8String &sample);
 
     void Set_Event_Name(Utf8String name);
     void Set_Playing_Handle(int handle) { m_playingHandle = handle; }
@@ -173,6 +173,10 @@ public:
     virtual void Process_Playing_List() = 0;
     virtual void Process_Fading_List() = 0;
     virtual void Process_Stopped_List() = 0;
+#ifndef GAME_DLL
+    // Thyme specific: Lets the samples of an event be loaded ahead of it first playing.
+    virtual void Prefetch_Audio_Event(const Utf8String &event_name) {}
+#endif
 
     AudioSettings *Get_Audio_Settings() const { return m_audioSettings; }
     MiscAudio *Get_Misc_Audio() const { return m_miscAudio; }
@@ -209,7 +209,8 @@ int CompressionManager::Get_Max_Compressed_Size(int size, CompressionType type)
 {
     switch (type) {
         case COMPRESSION_EAR:
-            return size + sizeof(ComprHeader);
+            // #BUGFIX Incompressible data grows by a control byte for every 112 literals plus the RefPack header.
+            return size + size / 112 + 8 + sizeof(ComprHeader);
         case COMPRESSION_ZL1:
         case COMPRESSION_ZL2:
         case COMPRESSION_ZL3:
@@ -316,7 +317,8 @@ int CompressionManager::Decompress_Data(void *src, int src_size, void *dst, int
     switch (Get_Compression_Type(src, src_size)) {
         case COMPRESSION_EAR: // RefPack
             src_size -= sizeof(ComprHeader);
-            return RefPack_Uncompress(dst, static_cast<const uint8_t *>(src) + sizeof(ComprHeader), &src_size);
+            // #BUGFIX Check the stream against both buffers, saves and maps can be truncated or corrupt.
+            return RefPack_Uncompress_Safe(dst, dst_size, static_cast<const uint8_t *>(src) + sizeof(ComprHeader), src_size);
         case COMPRESSION_ZL1:
         case COMPRESSION_ZL2:
         case COMPRESSION_ZL3:
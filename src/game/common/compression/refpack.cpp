@@ -14,176 +14,445 @@
  */
 #include "refpack.h"
 #include <algorithm>
-#include <cstdlib>
+#include <captainslog.h>
 #include <cstring>
 
-using std::malloc;
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define REFPACK_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 using std::max;
 using std::memcpy;
+using std::memmove;
 using std::memset;
 using std::min;
 
+namespace
+{
+enum
+{
+    // Links further back than this can't be encoded in the very long form.
+    REFPACK_MAX_OFFSET = 131071,
+    // Candidates a fast encode checks per position, unbounded chains are what makes repetitive data slow.
+    REFPACK_FAST_CHAIN = 32,
+};
+} // namespace
+
 /**
- * Utility function to quickly calculate a pseudo-hash.
+ * Returns the index of the lowest set bit, value must not be 0.
  */
-static int32_t RefPack_Hash(const uint8_t *s)
+static inline int Lowest_Bit(uint32_t value)
 {
-    return ((s[0] << 8 | s[2]) ^ s[1] << 4);
+#if defined __GNUC__ || defined __clang__
+    return __builtin_ctz(value);
+#elif defined _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return int(index);
+#else
+    int index = 0;
+
+    while ((value & 1) == 0) {
+        value >>= 1;
+        ++index;
+    }
+
+    return index;
+#endif
+}
+
+/**
+ * Utility function to quickly calculate a hash of the next three bytes.
+ *
+ * Only positions whose first three bytes match can beat the minimum match, so the hash doesn't change which match is
+ * found, a better spread just means fewer useless candidates on the chains.
+ */
+static inline int32_t RefPack_Hash(const uint8_t *s)
+{
+    return ((uint32_t(s[0]) | uint32_t(s[1]) << 8 | uint32_t(s[2]) << 16) * 2654435761u) >> 16;
 }
 
 /**
  * Utility function for compression for checking length of matching data.
+ *
+ * Compares 16 or 4 bytes at a time and finds the first difference from the lowest set bit of the mismatch mask.
  */
-static uint32_t RefPack_Matchlen(const uint8_t *s, const uint8_t *d, uint32_t maxmatch)
+static inline uint32_t RefPack_Matchlen(const uint8_t *s, const uint8_t *d, uint32_t maxmatch)
 {
-    uint32_t current;
+    uint32_t current = 0;
+
+#ifdef REFPACK_USE_SSE2
+    for (; current + 16 <= maxmatch; current += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + current));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(d + current));
+        uint32_t mask = uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(a, b))) ^ 0xFFFF;
 
-    for (current = 0; current < maxmatch && *s++ == *d++; ++current)
+        if (mask != 0) {
+            return current + Lowest_Bit(mask);
+        }
+    }
+#endif
+
+#ifdef SYSTEM_LITTLE_ENDIAN
+    for (; current + 4 <= maxmatch; current += 4) {
+        uint32_t a;
+        uint32_t b;
+        memcpy(&a, s + current, sizeof(a));
+        memcpy(&b, d + current, sizeof(b));
+
+        if (a != b) {
+            return current + (Lowest_Bit(a ^ b) >> 3);
+        }
+    }
+#endif
+
+    for (; current < maxmatch && s[current] == d[current]; ++current)
         ;
 
     return current;
 }
 
+RefPackEncoder::RefPackEncoder() :
+    m_hashTable(new int32_t[HASH_SIZE]),
+    m_links(new int32_t[WINDOW_SIZE]),
+    m_buffer(nullptr),
+    m_data(nullptr),
+    m_dataPos(0),
+    m_dataEnd(0),
+    m_totalSize(0),
+    m_position(0),
+    m_runStart(0),
+    m_level(REFPACK_LEVEL_NORMAL),
+    m_hasPendingMatch(false)
+{
+}
+
+RefPackEncoder::~RefPackEncoder()
+{
+    delete[] m_hashTable;
+    delete[] m_links;
+    delete[] m_buffer;
+}
+
 /**
- * Compresses data using refpack LZ method
+ * Starts a stream of total_size bytes and writes its header, returns the number of bytes written to dst.
  */
-static int RefPack_Encode(const void *src, int src_len, void *dst, int dst_len, bool quick)
+int RefPackEncoder::Begin(void *dst, int total_size, RefPackLevel level)
 {
-    int32_t len;
-    uint32_t tlen;
-    uint32_t tcost;
-    uint32_t run;
-    uint32_t toffset;
-    uint32_t boffset;
-    uint32_t blen;
-    uint32_t bcost;
-    uint32_t mlen;
-    const uint8_t *tptr;
-    const uint8_t *getp;
-    const uint8_t *runp;
-    uint8_t *putp;
-    int32_t hash;
-    int32_t hoffset;
-    int32_t minhoffset;
-    int i;
-    int32_t *link;
-    int32_t *hashtbl;
-
-    len = src_len;
-    putp = static_cast<uint8_t *>(dst);
-    run = 0;
-    getp = runp = static_cast<const uint8_t *>(src);
-
-    hashtbl = static_cast<int32_t *>(malloc(sizeof(int32_t) * 0x10000));
-    link = static_cast<int32_t *>(malloc(sizeof(int32_t) * 0x20000));
-    memset(hashtbl, 0xFF, sizeof(int32_t) * 0x10000);
-
-    len -= 4;
-    while (len >= 0) {
-        boffset = 0;
-        blen = bcost = 2;
-        mlen = min(len, 1028);
-        tptr = getp - 1;
-        hash = RefPack_Hash(getp);
-        hoffset = hashtbl[hash];
-        minhoffset = max(intptr_t(getp - static_cast<const uint8_t *>(src) - 131071), intptr_t(0));
-
-        if (hoffset >= minhoffset) {
-            do {
-                tptr = static_cast<const uint8_t *>(src) + hoffset;
-
-                if (getp[blen] == tptr[blen]) {
-                    tlen = RefPack_Matchlen(getp, tptr, mlen);
-
-                    if (tlen > blen) {
-                        toffset = (getp - 1) - tptr;
-
-                        if (toffset < 1024 && tlen <= 10) { // two byte long form
-                            tcost = 2;
-                        } else if (toffset < 16384 && tlen <= 67) { // three byte long form
-                            tcost = 3;
-                        } else { // four byte very long form
-                            tcost = 4;
-                        }
-
-                        if (tlen - tcost + 4 > blen - bcost + 4) {
-                            blen = tlen;
-                            bcost = tcost;
-                            boffset = toffset;
-
-                            if (blen >= 1028) {
-                                break;
-                            }
-                        }
-                    }
-                }
-            } while ((hoffset = link[hoffset & 131071]) >= minhoffset);
+    // The window is only needed for input that comes in pieces.
+    if (m_buffer == nullptr) {
+        m_buffer = new uint8_t[BUFFER_SIZE];
+    }
+
+    Reset(total_size, level);
+    m_data = m_buffer;
+
+    return Write_Header(static_cast<uint8_t *>(dst));
+}
+
+/**
+ * Adds the next size bytes of the stream. Input near the end of what was handed over so far is held back until more
+ * arrives, dst needs room for Get_Max_Encoded_Size(size) bytes. Returns the number of bytes written to dst.
+ */
+int RefPackEncoder::Encode(void *dst, const void *src, int size)
+{
+    captainslog_dbgassert(m_data == m_buffer, "RefPackEncoder - Encode called without Begin");
+    captainslog_dbgassert(m_dataEnd + size <= m_totalSize, "RefPackEncoder - More data than the stream was started with");
+    uint8_t *putp = static_cast<uint8_t *>(dst);
+    const uint8_t *getp = static_cast<const uint8_t *>(src);
+
+    while (size > 0) {
+        if (m_dataEnd - m_dataPos == BUFFER_SIZE) {
+            Slide_Window();
         }
 
-        if (bcost >= blen || len < 4) {
-            hoffset = (getp - static_cast<const uint8_t *>(src));
-            link[hoffset & 131071] = hashtbl[hash];
-            hashtbl[hash] = hoffset;
+        int count = min(size, BUFFER_SIZE - (m_dataEnd - m_dataPos));
+        memcpy(m_buffer + (m_dataEnd - m_dataPos), getp, count);
+        m_dataEnd += count;
+        getp += count;
+        size -= count;
+        Process(putp, false);
+    }
 
-            ++run;
-            ++getp;
-            --len;
-        } else {
-            while (run > 3) { // literal block of data
-                tlen = min((uint32_t)112, run & ~3);
-                run -= tlen;
-                *putp++ = (unsigned char)(0xe0 + (tlen >> 2) - 1);
-                memcpy(putp, runp, tlen);
-                runp += tlen;
-                putp += tlen;
+    return putp - static_cast<uint8_t *>(dst);
+}
+
+/**
+ * Encodes what was held back and ends the stream, returns the number of bytes written to dst.
+ */
+int RefPackEncoder::End(void *dst)
+{
+    captainslog_dbgassert(m_dataEnd == m_totalSize, "RefPackEncoder - Stream ended before all data was encoded");
+    uint8_t *putp = static_cast<uint8_t *>(dst);
+
+    // Never read past the data that actually arrived, even if it is less than was announced.
+    m_totalSize = m_dataEnd;
+    Process(putp, true);
+
+    return Finish(putp) - static_cast<uint8_t *>(dst);
+}
+
+/**
+ * Compresses a stream that is in memory as a whole, without copying it into the window.
+ */
+int RefPackEncoder::Compress(void *dst, const void *src, int size, RefPackLevel level)
+{
+    uint8_t *putp = static_cast<uint8_t *>(dst);
+
+    Reset(size, level);
+    m_data = static_cast<const uint8_t *>(src);
+    m_dataEnd = size;
+    putp += Write_Header(putp);
+    Process(putp, true);
+
+    return Finish(putp) - static_cast<uint8_t *>(dst);
+}
+
+/**
+ * Returns how many bytes a stream of size bytes, or a single Encode call for size bytes, can write at most.
+ */
+int RefPackEncoder::Get_Max_Encoded_Size(int size)
+{
+    size += MAX_HELD;
+
+    // Every 112 literals cost a byte, plus the header and the end of stream command.
+    return size + size / 112 + 8;
+}
+
+void RefPackEncoder::Reset(int total_size, RefPackLevel level)
+{
+    memset(m_hashTable, 0xFF, sizeof(int32_t) * HASH_SIZE);
+    m_dataPos = 0;
+    m_dataEnd = 0;
+    m_totalSize = total_size;
+    m_position = 0;
+    m_runStart = 0;
+    m_level = level;
+    m_hasPendingMatch = false;
+}
+
+int RefPackEncoder::Write_Header(uint8_t *putp) const
+{
+    int size = m_totalSize;
+
+    if (size < 0xFFFFFF) {
+        putp[0] = 0x10;
+        putp[1] = 0xFB;
+        putp[2] = (unsigned)(size & 0xFF0000) >> 16;
+        putp[3] = (unsigned)(size & 0xFF00) >> 8;
+        putp[4] = (unsigned)(size & 0xFF);
+
+        return 5;
+    }
+
+    putp[0] = 0x90;
+    putp[1] = 0xFB;
+    putp[2] = (unsigned)(size & 0xFF000000) >> 24;
+    putp[3] = (unsigned)(size & 0xFF0000) >> 16;
+    putp[4] = (unsigned)(size & 0xFF00) >> 8;
+    putp[5] = (unsigned)(size & 0xFF);
+
+    return 6;
+}
+
+/**
+ * Finds the match that saves the most bytes at pos, a cost not below the length means there is none worth using.
+ */
+void RefPackEncoder::Find_Match(int pos, Match &match) const
+{
+    const uint8_t *getp = Get_Data(pos);
+    uint32_t mlen = min(m_totalSize - pos - 4, int(MAX_MATCH));
+    int32_t hoffset = m_hashTable[RefPack_Hash(getp)];
+    int32_t minhoffset = max(pos - int(REFPACK_MAX_OFFSET), 0);
+    int chain = m_level == REFPACK_LEVEL_FAST ? int(REFPACK_FAST_CHAIN) : int(WINDOW_SIZE);
+    const int32_t *links = m_links;
+    uint32_t blen = 2;
+    uint32_t bcost = 2;
+    uint32_t boffset = 0;
+
+    for (; hoffset >= minhoffset && chain > 0; hoffset = links[hoffset & WINDOW_MASK], --chain) {
+        const uint8_t *tptr = getp - (pos - hoffset);
+
+        if (getp[blen] != tptr[blen]) {
+            continue;
+        }
+
+        uint32_t tlen = RefPack_Matchlen(getp, tptr, mlen);
+
+        if (tlen <= blen) {
+            continue;
+        }
+
+        uint32_t toffset = (pos - 1) - hoffset;
+        uint32_t tcost;
+
+        if (toffset < 1024 && tlen <= 10) { // two byte long form
+            tcost = 2;
+        } else if (toffset < 16384 && tlen <= 67) { // three byte long form
+            tcost = 3;
+        } else { // four byte very long form
+            tcost = 4;
+        }
+
+        if (tlen - tcost + 4 > blen - bcost + 4) {
+            blen = tlen;
+            bcost = tcost;
+            boffset = toffset;
+
+            // Nothing further back can be longer.
+            if (blen >= mlen) {
+                break;
             }
+        }
+    }
+
+    match.length = blen;
+    match.cost = bcost;
+    match.offset = boffset;
+}
+
+/**
+ * Adds a position to the hash chains.
+ */
+static inline void RefPack_Insert(int32_t *hashtbl, int32_t *link, const uint8_t *getp, int32_t pos)
+{
+    int32_t hash = RefPack_Hash(getp);
+    link[pos & 131071] = hashtbl[hash];
+    hashtbl[hash] = pos;
+}
 
-            if (bcost == 2) // two byte long form
-            {
-                *putp++ = (unsigned char)(((boffset >> 8) << 5) + ((blen - 3) << 2) + run);
-                *putp++ = (unsigned char)boffset;
-            } else if (bcost == 3) { // three byte long form
-                *putp++ = (unsigned char)(0x80 + (blen - 4));
-                *putp++ = (unsigned char)((run << 6) + (boffset >> 8));
-                *putp++ = (unsigned char)boffset;
-            } else { // four byte very long form
-                *putp++ = (unsigned char)(0xc0 + ((boffset >> 16) << 4) + (((blen - 5) >> 8) << 2) + run);
-                *putp++ = (unsigned char)(boffset >> 8);
-                *putp++ = (unsigned char)(boffset);
-                *putp++ = (unsigned char)(blen - 5);
+/**
+ * Encodes the positions that have enough data behind them, or all remaining ones on the last call.
+ */
+void RefPackEncoder::Process(uint8_t *&putp, bool last)
+{
+    // The loop state lives in locals, every store to the tables or the output could otherwise alias the members.
+    int32_t *hashtbl = m_hashTable;
+    int32_t *link = m_links;
+    int pos = m_position;
+    int limit = last ? m_totalSize - 4 : min(m_dataEnd - int(LOOKAHEAD), m_totalSize - 4);
+    uint32_t run = pos - m_runStart;
+    const uint8_t *getp = Get_Data(pos);
+    const uint8_t *runp = getp - run;
+    uint8_t *out = putp;
+    bool pending = m_hasPendingMatch;
+    bool lazy = m_level == REFPACK_LEVEL_LAZY;
+    bool fast = m_level == REFPACK_LEVEL_FAST;
+    Match match;
+
+    while (pos <= limit) {
+        int32_t len = m_totalSize - pos - 4;
+        bool inserted = false;
+
+        if (pending) {
+            match = m_pendingMatch;
+            pending = false;
+        } else {
+            Find_Match(pos, match);
+        }
+
+        // Lazy matching, a literal now is worth it if the match one byte later saves more than that byte costs.
+        if (lazy && match.cost < match.length && match.length < MAX_MATCH && len > 4) {
+            RefPack_Insert(hashtbl, link, getp, pos);
+            inserted = true;
+            Find_Match(pos + 1, m_pendingMatch);
+            pending = m_pendingMatch.cost < m_pendingMatch.length
+                && m_pendingMatch.length - m_pendingMatch.cost > match.length - match.cost + 1;
+        }
+
+        if (pending || match.cost >= match.length || len < 4) {
+            if (!inserted) {
+                RefPack_Insert(hashtbl, link, getp, pos);
             }
 
-            if (run) {
-                memcpy(putp, runp, run);
-                putp += run;
+            ++run;
+            ++getp;
+            ++pos;
+
+            // Full literal blocks are written straight away so the run never needs more than the window holds.
+            if (run == 112) {
+                *out++ = (unsigned char)(0xe0 + (112 >> 2) - 1);
+                memcpy(out, runp, 112);
+                runp += 112;
+                out += 112;
                 run = 0;
             }
 
-            if (quick) {
-                hoffset = (getp - static_cast<const uint8_t *>(src));
-                link[hoffset & 131071] = hashtbl[hash];
-                hashtbl[hash] = hoffset;
-                getp += blen;
-            } else {
-                for (i = 0; i < (int)blen; ++i) {
-                    hash = RefPack_Hash(getp);
-                    hoffset = (getp - static_cast<const uint8_t *>(src));
-                    link[hoffset & 131071] = hashtbl[hash];
-                    hashtbl[hash] = hoffset;
-                    ++getp;
-                }
+            continue;
+        }
+
+        while (run > 3) { // literal block of data
+            uint32_t tlen = min((uint32_t)112, run & ~3);
+            run -= tlen;
+            *out++ = (unsigned char)(0xe0 + (tlen >> 2) - 1);
+            memcpy(out, runp, tlen);
+            runp += tlen;
+            out += tlen;
+        }
+
+        if (match.cost == 2) { // two byte long form
+            *out++ = (unsigned char)(((match.offset >> 8) << 5) + ((match.length - 3) << 2) + run);
+            *out++ = (unsigned char)match.offset;
+        } else if (match.cost == 3) { // three byte long form
+            *out++ = (unsigned char)(0x80 + (match.length - 4));
+            *out++ = (unsigned char)((run << 6) + (match.offset >> 8));
+            *out++ = (unsigned char)match.offset;
+        } else { // four byte very long form
+            *out++ = (unsigned char)(0xc0 + ((match.offset >> 16) << 4) + (((match.length - 5) >> 8) << 2) + run);
+            *out++ = (unsigned char)(match.offset >> 8);
+            *out++ = (unsigned char)(match.offset);
+            *out++ = (unsigned char)(match.length - 5);
+        }
+
+        if (run) {
+            memcpy(out, runp, run);
+            out += run;
+            run = 0;
+        }
+
+        // A fast encode only remembers where matches start, skipping the hashing of the bytes they cover.
+        if (fast) {
+            RefPack_Insert(hashtbl, link, getp, pos);
+            getp += match.length;
+            pos += match.length;
+        } else {
+            int end = pos + match.length;
+
+            // The lazy look ahead has already added the first one.
+            if (inserted) {
+                ++getp;
+                ++pos;
             }
 
-            runp = getp;
-            len -= blen;
+            for (; pos < end; ++pos, ++getp) {
+                RefPack_Insert(hashtbl, link, getp, pos);
+            }
         }
+
+        runp = getp;
     }
-    len += 4;
-    run += len;
 
-    while (run > 3) // no match at end, use literal
-    {
-        tlen = min((uint32_t)112, run & ~3);
+    m_position = pos;
+    m_runStart = pos - run;
+    m_hasPendingMatch = pending;
+    putp = out;
+}
+
+/**
+ * Writes the trailing literals and the end of stream command, returns the end of the output.
+ */
+uint8_t *RefPackEncoder::Finish(uint8_t *putp)
+{
+    uint32_t run = m_totalSize - m_runStart;
+    const uint8_t *runp = Get_Data(m_runStart);
+
+    while (run > 3) { // no match at end, use literal
+        uint32_t tlen = min((uint32_t)112, run & ~3);
         run -= tlen;
         *putp++ = (unsigned char)(0xe0 + (tlen >> 2) - 1);
         memcpy(putp, runp, tlen);
@@ -197,177 +466,226 @@ static int RefPack_Encode(const void *src, int src_len, void *dst, int dst_len,
         putp += run;
     }
 
-    free(link);
-    free(hashtbl);
+    return putp;
+}
 
-    return putp - static_cast<uint8_t *>(dst);
+/**
+ * Drops the input that can't be referenced anymore from the front of the window.
+ */
+void RefPackEncoder::Slide_Window()
+{
+    int keep = max(min(m_position - int(WINDOW_SIZE), m_runStart), m_dataPos);
+    int count = keep - m_dataPos;
+    captainslog_dbgassert(count > 0, "RefPackEncoder - Window is full with nothing to drop");
+    memmove(m_buffer, m_buffer + count, m_dataEnd - keep);
+    m_dataPos = keep;
 }
 
 /**
- * Decompresses EA's proprietary "RefPack" format.
+ * Copies a match of run bytes from ref, which may overlap the destination when the offset is shorter than the run.
+ * Up to 16 bytes may be written when avail says there is room for them.
  */
-int RefPack_Uncompress(void *dst, const void *src, int *size)
+static inline void RefPack_Copy_Match(uint8_t *putp, const uint8_t *ref, uint32_t run, intptr_t avail)
+{
+    uint32_t offset = uint32_t(putp - ref);
+
+    // Most matches are short and far enough back to take one fixed size copy.
+    if (offset >= 8 && run <= 8 && avail >= 8) {
+        memcpy(putp, ref, 8);
+        return;
+    }
+
+    if (offset >= 16 && run <= 16 && avail >= 16) {
+        memcpy(putp, ref, 16);
+        return;
+    }
+
+    if (offset >= run) {
+        memcpy(putp, ref, run);
+        return;
+    }
+
+    if (offset == 1) {
+        memset(putp, *ref, run);
+        return;
+    }
+
+    // The bytes from ref repeat every offset bytes, so each copy can take twice as many as the one before it.
+    while (run > 0) {
+        uint32_t count = min(uint32_t(putp - ref), run);
+        memcpy(putp, ref, count);
+        putp += count;
+        run -= count;
+    }
+}
+
+/**
+ * Decodes a RefPack stream. When checked, every read and write is kept inside the buffers and a malformed stream
+ * returns 0, otherwise the stream is trusted and dst_size and src_size are not used.
+ */
+template<bool Checked> static int RefPack_Decode(void *dst, int dst_size, const void *src, int src_size, int *size)
 {
-    const uint8_t *getp;
-    uint8_t *ref;
-    uint8_t *putp;
-    uint8_t first;
-    uint8_t second;
-    uint8_t third;
-    uint8_t forth;
+    const uint8_t *getp = static_cast<const uint8_t *>(src);
+    const uint8_t *src_end = getp + src_size;
+    uint8_t *putp = static_cast<uint8_t *>(dst);
+    uint8_t *dst_end;
     uint16_t flags;
     uint32_t run;
-    int out_length = 0;
+    uint32_t length;
+    uint32_t offset;
+    int out_length;
 
-    if (src == nullptr) {
-        if (size != nullptr) {
-            *size = 0;
-        }
+    if (size != nullptr) {
+        *size = 0;
+    }
 
+    if (src == nullptr || (Checked && src_size < 2)) {
         return 0;
     }
 
-    getp = static_cast<const uint8_t *>(src);
-
     // This flag and size reading section appears to differe between different RefPack versions.
     flags = (getp[0] << 8) | getp[1];
     getp += 2;
 
-    if (flags & 0x8000) {
-        if (flags & 0x0100) {
-            getp += 4;
-        }
+    int size_bytes = (flags & 0x8000) ? 4 : 3;
+    int skip_bytes = (flags & 0x0100) ? size_bytes : 0;
 
-        out_length = (getp[0] << 24) | (getp[1] << 16) | (getp[2] << 8) | getp[3];
-        getp += 4;
-    } else {
-        if (flags & 0x0100) {
-            getp += 3;
-        }
-
-        out_length = (getp[0] << 16) | (getp[1] << 8) | getp[2];
-        getp += 3;
+    if (Checked && src_end - getp < skip_bytes + size_bytes) {
+        return 0;
     }
 
-    putp = static_cast<uint8_t *>(dst);
-
-    while (true) {
-        first = *getp++;
-
-        // Short command.
-        if (!(first & 0x80)) {
-            second = *getp++;
-            run = first & 3;
+    getp += skip_bytes;
+    out_length = 0;
 
-            while (run--) {
-                *putp++ = *getp++;
-            }
+    for (int i = 0; i < size_bytes; ++i) {
+        out_length = int((uint32_t(out_length) << 8) | *getp++);
+    }
 
-            ref = putp - 1 - (((first & 0x60) << 3) + second);
-            run = ((first & 0x1c) >> 2) + 3 - 1;
+    if (Checked && (out_length < 0 || out_length > dst_size)) {
+        return 0;
+    }
 
-            do {
-                *putp++ = *ref++;
-            } while (run--);
+    dst_end = putp + out_length;
 
-            continue;
+    while (true) {
+        if (Checked && getp >= src_end) {
+            return 0;
         }
 
-        // Medium command.
-        if (!(first & 0x40)) {
-            second = *getp++;
-            third = *getp++;
-            run = second >> 6;
+        uint8_t first = *getp++;
 
-            while (run--) {
-                *putp++ = *getp++;
+        if (!(first & 0x80)) { // Short command.
+            if (Checked && src_end - getp < 1) {
+                return 0;
             }
 
-            ref = putp - 1 - (((second & 0x3f) << 8) + third);
-
-            run = (first & 0x3f) + 4 - 1;
-
-            do {
-                *putp++ = *ref++;
-            } while (run--);
-
-            continue;
-        }
-
-        // Long command.
-        if (!(first & 0x20)) {
-            second = *getp++;
-            third = *getp++;
-            forth = *getp++;
+            uint8_t second = *getp++;
             run = first & 3;
-
-            while (run--) {
-                *putp++ = *getp++;
+            offset = ((first & 0x60) << 3) + second + 1;
+            length = ((first & 0x1c) >> 2) + 3;
+        } else if (!(first & 0x40)) { // Medium command.
+            if (Checked && src_end - getp < 2) {
+                return 0;
             }
 
-            ref = putp - 1 - (((first & 0x10) >> 4 << 16) + (second << 8) + third);
-
-            run = ((first & 0x0c) >> 2 << 8) + forth + 5 - 1;
+            uint8_t second = *getp++;
+            uint8_t third = *getp++;
+            run = second >> 6;
+            offset = ((second & 0x3f) << 8) + third + 1;
+            length = (first & 0x3f) + 4;
+        } else if (!(first & 0x20)) { // Long command.
+            if (Checked && src_end - getp < 3) {
+                return 0;
+            }
 
-            do {
-                *putp++ = *ref++;
-            } while (run--);
+            uint8_t second = *getp++;
+            uint8_t third = *getp++;
+            uint8_t forth = *getp++;
+            run = first & 3;
+            offset = ((first & 0x10) << 12) + (second << 8) + third + 1;
+            length = ((first & 0x0c) << 6) + forth + 5;
+        } else { // Byte command, or the end marker with a run of up to 3 bytes.
+            run = ((first & 0x1f) << 2) + 4;
+            bool end = run > 112;
+
+            if (end) {
+                run = first & 3;
+            }
 
-            continue;
-        }
+            if (Checked && (src_end - getp < intptr_t(run) || dst_end - putp < intptr_t(run))) {
+                return 0;
+            }
 
-        // Byte command.
-        run = ((first & 0x1f) << 2) + 4;
+            memcpy(putp, getp, run);
+            getp += run;
+            putp += run;
 
-        if (run <= 112) {
-            while (run--) {
-                *putp++ = *getp++;
+            if (end) {
+                break;
             }
 
             continue;
         }
 
-        // End marker and possibly run of up to 3 bytes.
-        run = first & 3;
+        if (Checked
+            && (src_end - getp < intptr_t(run) || dst_end - putp < intptr_t(run + length)
+                || putp + run - static_cast<uint8_t *>(dst) < intptr_t(offset))) {
+            return 0;
+        }
 
-        while (run--) {
-            *putp++ = *getp++;
+        // The 0..3 literals are copied as one word when both buffers are known to have room for it.
+        if (Checked && src_end - getp >= 4 && dst_end - putp >= 4) {
+            memcpy(putp, getp, 4);
+        } else {
+            for (uint32_t i = 0; i < run; ++i) {
+                putp[i] = getp[i];
+            }
         }
 
-        break;
+        getp += run;
+        putp += run;
+        RefPack_Copy_Match(putp, putp - offset, length, dst_end - putp);
+        putp += length;
     }
 
     if (size != nullptr) {
         *size = getp - static_cast<const uint8_t *>(src);
     }
 
+    if (Checked && putp != dst_end) {
+        return 0;
+    }
+
     return out_length;
 }
 
+/**
+ * Decompresses EA's proprietary "RefPack" format.
+ *
+ * Thyme specific: The stream is trusted, use RefPack_Uncompress_Safe for data that may be corrupt.
+ */
+int RefPack_Uncompress(void *dst, const void *src, int *size)
+{
+    return RefPack_Decode<false>(dst, 0, src, 0, size);
+}
+
+/**
+ * Thyme specific: Decompresses a RefPack stream without reading or writing outside of the buffers. Returns 0 if the
+ * stream is malformed or doesn't decompress to exactly the size in its header.
+ */
+int RefPack_Uncompress_Safe(void *dst, int dst_size, const void *src, int src_size, int *size)
+{
+    return RefPack_Decode<true>(dst, dst_size, src, src_size, size);
+}
+
 /**
  * Compresses EA's proprietary "RefPack" format.
+ *
+ * Thyme specific: opts can point to a RefPackLevel, without it the output is the same as the original encoder's.
  */
 int RefPack_Compress(void *dst, const void *src, int size, int *opts)
 {
-    uint8_t *putp = static_cast<uint8_t *>(dst);
-    int header_len = 0;
-
-    if (size < 0xFFFFFF) {
-        putp[0] = 0x10;
-        putp[1] = 0xFB;
-        putp[2] = (unsigned)(size & 0xFF0000) >> 16;
-        putp[3] = (unsigned)(size & 0xFF00) >> 8;
-        putp[4] = (unsigned)(size & 0xFF);
-        header_len = 5;
-    } else {
-        putp[0] = 0x90;
-        putp[1] = 0xFB;
-        putp[2] = (unsigned)(size & 0xFF000000) >> 24;
-        putp[3] = (unsigned)(size & 0xFF0000) >> 16;
-        putp[4] = (unsigned)(size & 0xFF00) >> 8;
-        putp[5] = (unsigned)(size & 0xFF);
-        header_len = 6;
-    }
+    RefPackEncoder encoder;
 
-    return header_len + RefPack_Encode(src, size, &putp[header_len], 0x20000, false);
+    return encoder.Compress(dst, src, size, opts != nullptr ? RefPackLevel(*opts) : REFPACK_LEVEL_NORMAL);
 }
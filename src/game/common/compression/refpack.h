@@ -16,5 +16,73 @@
 
 #include "always.h"
 
+// Thyme specific: How hard the encoder looks for matches. Normal produces the same output as the original encoder.
+enum RefPackLevel
+{
+    REFPACK_LEVEL_FAST,
+    REFPACK_LEVEL_NORMAL,
+    REFPACK_LEVEL_LAZY,
+};
+
 int RefPack_Uncompress(void *dst, const void *src, int *size);
+int RefPack_Uncompress_Safe(void *dst, int dst_size, const void *src, int src_size, int *size = nullptr);
 int RefPack_Compress(void *dst, const void *src, int size, int *opts);
+
+// Thyme specific: RefPack encoder that can be handed its input in pieces. The match tables are kept between streams so
+// one encoder can compress any number of them without allocating again.
+class RefPackEncoder
+{
+    enum
+    {
+        HASH_SIZE = 0x10000,
+        WINDOW_SIZE = 0x20000,
+        WINDOW_MASK = WINDOW_SIZE - 1,
+        MAX_MATCH = 1028,
+        // Bytes that must follow a position before it can be encoded, covers the lazy look one byte ahead.
+        LOOKAHEAD = MAX_MATCH + 8,
+        // Bytes that can be held back between calls, the lookahead plus a literal run that is not written yet.
+        MAX_HELD = LOOKAHEAD + 112,
+        BUFFER_SIZE = WINDOW_SIZE * 2,
+    };
+
+    struct Match
+    {
+        uint32_t length;
+        uint32_t cost;
+        uint32_t offset;
+    };
+
+public:
+    RefPackEncoder();
+    ~RefPackEncoder();
+
+    int Begin(void *dst, int total_size, RefPackLevel level = REFPACK_LEVEL_NORMAL);
+    int Encode(void *dst, const void *src, int size);
+    int End(void *dst);
+    int Compress(void *dst, const void *src, int size, RefPackLevel level = REFPACK_LEVEL_NORMAL);
+
+    static int Get_Max_Encoded_Size(int size);
+
+private:
+    void Reset(int total_size, RefPackLevel level);
+    int Write_Header(uint8_t *putp) const;
+    const uint8_t *Get_Data(int pos) const { return m_data + (pos - m_dataPos); }
+    void Find_Match(int pos, Match &match) const;
+    void Process(uint8_t *&putp, bool last);
+    uint8_t *Finish(uint8_t *putp);
+    void Slide_Window();
+
+private:
+    int32_t *m_hashTable;
+    int32_t *m_links;
+    uint8_t *m_buffer;
+    const uint8_t *m_data;
+    int m_dataPos;
+    int m_dataEnd;
+    int m_totalSize;
+    int m_position;
+    int m_runStart;
+    RefPackLevel m_level;
+    bool m_hasPendingMatch;
+    Match m_pendingMatch;
+};
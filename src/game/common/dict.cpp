@@ -14,8 +14,19 @@
  */
 #include "dict.h"
 #include "memdynalloc.h"
+#include <algorithm>
 #include <captainslog.h>
 
+#ifndef GAME_DLL
+namespace
+{
+inline unsigned Hash_Key(NameKeyType key, int slots)
+{
+    return (unsigned(key) * 0x9E3779B1u >> 16) & (slots - 1);
+}
+} // namespace
+#endif
+
 void Dict::DictPair::Copy_From(const DictPair &that)
 {
     if (Get_Type() != that.Get_Type()) {
@@ -303,35 +314,30 @@ void Dict::Set_Bool(NameKeyType key, bool value)
 {
     DictPair *pair = Set_Prep(key, DICT_BOOL);
     pair->Set_Value(value);
-    Sort_Pairs();
 }
 
 void Dict::Set_Int(NameKeyType key, int value)
 {
     DictPair *pair = Set_Prep(key, DICT_INT);
     pair->Set_Value(value);
-    Sort_Pairs();
 }
 
 void Dict::Set_Real(NameKeyType key, float value)
 {
     DictPair *pair = Set_Prep(key, DICT_REAL);
     pair->Set_Value(value);
-    Sort_Pairs();
 }
 
 void Dict::Set_AsciiString(NameKeyType key, const Utf8String &value)
 {
     DictPair *pair = Set_Prep(key, DICT_ASCIISTRING);
     pair->Set_Value(value);
-    Sort_Pairs();
 }
 
 void Dict::Set_UnicodeString(NameKeyType key, const Utf16String &value)
 {
     DictPair *pair = Set_Prep(key, DICT_UNICODESTRING);
     pair->Set_Value(value);
-    Sort_Pairs();
 }
 
 bool Dict::Remove(NameKeyType key)
@@ -346,8 +352,13 @@ bool Dict::Remove(NameKeyType key)
 
     pair = Ensure_Unique(m_data->m_numPairsUsed, true, pair);
     pair->Set_Name_And_Type(NAMEKEY_MAX, DICT_BOOL);
-    Sort_Pairs();
+
+    // Close the gap rather than sorting the removed pair to the end, the order of the rest doesn't change.
+    DictPair *last = &m_data->Get_Pairs()[m_data->m_numPairsUsed - 1];
+    memmove(static_cast<void *>(pair), pair + 1, (last - pair) * sizeof(DictPair));
+    memset(static_cast<void *>(last), 0, sizeof(DictPair));
     --m_data->m_numPairsUsed;
+    Rebuild_Hash_Index();
 
     return true;
 }
@@ -359,7 +370,6 @@ void Dict::Copy_Pair_From(Dict &that, NameKeyType key)
     if (pair != nullptr) {
         DictPair *prep_pair = Set_Prep(key, pair->Get_Type());
         prep_pair->Copy_From(*pair);
-        Sort_Pairs();
     } else if (Find_Pair_By_Key(key) != nullptr) {
         Remove(key);
     }
@@ -389,6 +399,7 @@ void Dict::Sort_Pairs()
 #endif
 
     qsort(m_data->Get_Pairs(), m_data->m_numPairsUsed, sizeof(DictPair), Pair_Compare);
+    Rebuild_Hash_Index();
 }
 
 int Dict::Pair_Compare(const void *l, const void *r)
@@ -410,36 +421,181 @@ Dict::DictPair *Dict::Set_Prep(NameKeyType key, DataType type)
     int needed = m_data != nullptr ? m_data->m_numPairsUsed : 0;
 
     if (pair == nullptr) {
-        ++needed;
+        needed = Get_Grown_Pair_Count(needed + 1);
     }
 
     pair = Ensure_Unique(needed, true, pair);
 
     if (pair == nullptr) {
-        pair = &m_data->Get_Pairs()[m_data->m_numPairsUsed++];
+        // Thyme specific: insert in order instead of appending and sorting all pairs afterwards.
+        pair = Insert_Pair(key);
+        pair->Set_Name_And_Type(key, type);
+        Rebuild_Hash_Index();
+    } else {
+        pair->Set_Name_And_Type(key, type);
     }
 
+    return pair;
+}
+
+/**
+ * Makes room for a new pair at the sorted position for the key and returns it cleared, the hash index has to be rebuilt
+ * once the key is set.
+ */
+Dict::DictPair *Dict::Insert_Pair(NameKeyType key)
+{
+    DictPair *pairs = m_data->Get_Pairs();
+    int count = m_data->m_numPairsUsed;
+    int lower = 0;
+    int upper = count;
+
+    while (lower < upper) {
+        int index = (lower + upper) / 2;
+
+        if (pairs[index].Get_Key() <= key) {
+            lower = index + 1;
+        } else {
+            upper = index;
+        }
+    }
+
+    memmove(static_cast<void *>(&pairs[lower + 1]), &pairs[lower], (count - lower) * sizeof(DictPair));
+    memset(static_cast<void *>(&pairs[lower]), 0, sizeof(DictPair));
+    ++m_data->m_numPairsUsed;
+
+    return &pairs[lower];
+}
+
+Dict::DictPair *Dict::Append_Prep(NameKeyType key, DataType type)
+{
+    int needed = m_data != nullptr ? m_data->m_numPairsUsed + 1 : 1;
+    Ensure_Unique(Get_Grown_Pair_Count(needed), true);
+
+    DictPair *pair = &m_data->Get_Pairs()[m_data->m_numPairsUsed++];
     pair->Set_Name_And_Type(key, type);
 
     return pair;
 }
 
+/**
+ * Gets the number of pairs to make room for when adding pairs, doubling the allocation when it is full so that adding
+ * many pairs one by one doesn't copy all of them every time.
+ */
+int Dict::Get_Grown_Pair_Count(int pairs_needed) const
+{
+    if (m_data == nullptr || pairs_needed <= m_data->m_numPairsAllocated) {
+        return pairs_needed;
+    }
+
+    return std::max(pairs_needed, std::min<int>(m_data->m_numPairsAllocated * 2, INT16_MAX));
+}
+
+/**
+ * Reserves room for pair_count more pairs to be added with the Append functions.
+ */
+void Dict::Begin_Build(int pair_count)
+{
+    int used = m_data != nullptr ? m_data->m_numPairsUsed : 0;
+
+    if (used + pair_count > 0) {
+        Ensure_Unique(used + pair_count, true);
+    }
+}
+
+/**
+ * Sorts the appended pairs by key and drops all but the last pair for keys that were appended more than once.
+ */
+void Dict::End_Build()
+{
+    if (m_data == nullptr) {
+        return;
+    }
+
+    int count = m_data->m_numPairsUsed;
+
+    if (count > 1) {
+        DictPair *pairs = m_data->Get_Pairs();
+
+        // Sorting the key together with the position keeps pairs with the same key in the order they were appended.
+        uint64_t *order = static_cast<uint64_t *>(
+            g_dynamicMemoryAllocator->Allocate_Bytes_No_Zero(count * (sizeof(uint64_t) + sizeof(DictPair))));
+        DictPair *sorted = reinterpret_cast<DictPair *>(&order[count]);
+
+        for (int i = 0; i < count; ++i) {
+            order[i] = (uint64_t(pairs[i].Get_Key()) << 16) | i;
+        }
+
+        std::sort(order, order + count);
+        int used = 0;
+
+        for (int i = 0; i < count; ++i) {
+            DictPair &pair = pairs[order[i] & 0xFFFF];
+
+            if (i + 1 < count && (order[i + 1] >> 16) == (order[i] >> 16)) {
+                pair.Clear();
+            } else {
+                memcpy(static_cast<void *>(&sorted[used++]), &pair, sizeof(DictPair));
+            }
+        }
+
+        memcpy(static_cast<void *>(pairs), sorted, used * sizeof(DictPair));
+        memset(static_cast<void *>(&pairs[used]), 0, (count - used) * sizeof(DictPair));
+        m_data->m_numPairsUsed = used;
+        g_dynamicMemoryAllocator->Free_Bytes(order);
+    }
+
+    Rebuild_Hash_Index();
+}
+
 Dict::DictPair *Dict::Find_Pair_By_Key(NameKeyType key) const
 {
     if (m_data == nullptr || m_data->m_numPairsUsed <= 0) {
         return nullptr;
     }
 
+    DictPair *pairs = m_data->Get_Pairs();
+
+    // Thyme specific: small dicts, which most are, are quicker to scan than to search.
+    if (m_data->m_numPairsUsed <= DICT_LINEAR_MAX) {
+        for (int i = 0; i < m_data->m_numPairsUsed; ++i) {
+            NameKeyType pair_key = pairs[i].Get_Key();
+
+            if (pair_key >= key) {
+                return pair_key == key ? &pairs[i] : nullptr;
+            }
+        }
+
+        return nullptr;
+    }
+
+#ifndef GAME_DLL
+    int slots = Get_Hash_Slot_Count(m_data->m_numPairsAllocated);
+
+    if (slots != 0) {
+        const uint16_t *index = m_data->Get_Hash_Index();
+
+        for (unsigned slot = Hash_Key(key, slots); index[slot] != 0; slot = (slot + 1) & (slots - 1)) {
+            DictPair *pair = &pairs[index[slot] - 1];
+
+            if (pair->Get_Key() == key) {
+                return pair;
+            }
+        }
+
+        return nullptr;
+    }
+#endif
+
     unsigned lower = 0;
     unsigned upper = m_data->m_numPairsUsed;
 
     while (lower < upper) {
         unsigned index = (upper + lower - 1) / 2;
-        NameKeyType pair_key = m_data->Get_Pairs()[index].Get_Key();
+        NameKeyType pair_key = pairs[index].Get_Key();
 
         if (pair_key >= key) {
             if (pair_key == key) {
-                return &m_data->Get_Pairs()[index];
+                return &pairs[index];
             }
 
             upper = (upper + lower - 1) / 2;
@@ -451,6 +607,61 @@ Dict::DictPair *Dict::Find_Pair_By_Key(NameKeyType key) const
     return nullptr;
 }
 
+/**
+ * Gets the number of hash index slots kept for a dict with room for the given number of pairs, 0 if it has none.
+ */
+int Dict::Get_Hash_Slot_Count(int pairs)
+{
+#ifndef GAME_DLL
+    if (pairs >= DICT_HASH_MIN) {
+        int slots = DICT_HASH_MIN;
+
+        // At most half full so probe sequences stay short.
+        while (slots < pairs * 2) {
+            slots *= 2;
+        }
+
+        return slots;
+    }
+#endif
+
+    return 0;
+}
+
+int Dict::Get_Data_Size(int pairs)
+{
+    return sizeof(DictPairData) + sizeof(DictPair) * pairs + sizeof(uint16_t) * Get_Hash_Slot_Count(pairs);
+}
+
+void Dict::Rebuild_Hash_Index()
+{
+#ifndef GAME_DLL
+    if (m_data == nullptr) {
+        return;
+    }
+
+    int slots = Get_Hash_Slot_Count(m_data->m_numPairsAllocated);
+
+    if (slots == 0) {
+        return;
+    }
+
+    uint16_t *index = m_data->Get_Hash_Index();
+    DictPair *pairs = m_data->Get_Pairs();
+    memset(index, 0, slots * sizeof(uint16_t));
+
+    for (int i = 0; i < m_data->m_numPairsUsed; ++i) {
+        unsigned slot = Hash_Key(pairs[i].Get_Key(), slots);
+
+        while (index[slot] != 0) {
+            slot = (slot + 1) & (slots - 1);
+        }
+
+        index[slot] = uint16_t(i + 1);
+    }
+#endif
+}
+
 void Dict::Release_Data()
 {
     if (m_data == nullptr) {
@@ -483,12 +694,17 @@ Dict::DictPair *Dict::Ensure_Unique(int pairs_needed, bool preserve_data, DictPa
 
     if (pairs_needed > 0) {
         // captainslog_trace("Allocating for %d Dict pairs.", pairs_needed);
-        int size =
-            g_dynamicMemoryAllocator->Get_Actual_Allocation_Size(sizeof(DictPair) * pairs_needed + sizeof(DictPairData));
+        int size = g_dynamicMemoryAllocator->Get_Actual_Allocation_Size(Get_Data_Size(pairs_needed));
         new_data = reinterpret_cast<DictPairData *>(g_dynamicMemoryAllocator->Allocate_Bytes(size));
+        int allocated = (size - sizeof(DictPairData)) / sizeof(DictPair);
+
+        // Leave room for the hash index of as many pairs as fit.
+        while (Get_Data_Size(allocated) > size) {
+            --allocated;
+        }
 
         new_data->m_refCount = 1;
-        new_data->m_numPairsAllocated = (size - sizeof(DictPairData)) / sizeof(DictPair);
+        new_data->m_numPairsAllocated = allocated;
         new_data->m_numPairsUsed = 0;
         // captainslog_trace("  Allocated for %d Dict pairs.", (int)new_data->m_numPairsAllocated);
 
@@ -523,5 +739,7 @@ Dict::DictPair *Dict::Ensure_Unique(int pairs_needed, bool preserve_data, DictPa
         to_translate = &new_data->Get_Pairs()[translate_val];
     }
 
+    Rebuild_Hash_Index();
+
     return to_translate;
 }
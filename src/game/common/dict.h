@@ -25,6 +25,8 @@ class Dict
     enum
     {
         MAX_LEN = 0x7FFF,
+        DICT_LINEAR_MAX = 8, // Thyme specific: dicts up to this size are searched linearly.
+        DICT_HASH_MIN = 128, // Thyme specific: dicts with room for this many pairs keep a hash index.
     };
 
     enum DictPairKeyType : int32_t
@@ -98,6 +100,10 @@ private:
         friend class Dict;
 
         DictPair *Get_Pairs() { return reinterpret_cast<DictPair *>(&this[1]); }
+#ifndef GAME_DLL
+        // The open addressed index of pair positions + 1 lives behind the allocated pairs.
+        uint16_t *Get_Hash_Index() { return reinterpret_cast<uint16_t *>(Get_Pairs() + m_numPairsAllocated); }
+#endif
 
         uint16_t m_refCount;
         uint16_t m_numPairsAllocated;
@@ -141,12 +147,34 @@ public:
     void Copy_Pair_From(Dict &that, NameKeyType key);
     void Release_Data();
 
+    // Thyme specific: builds a dict from many pairs at once. Pairs are appended unsorted and End_Build sorts them once,
+    // a later pair replacing an earlier one with the same key. The dict must not be queried before End_Build.
+    void Begin_Build(int pair_count);
+    void Append_Bool(NameKeyType key, bool value) { Append_Prep(key, DICT_BOOL)->Set_Value(value); }
+    void Append_Int(NameKeyType key, int value) { Append_Prep(key, DICT_INT)->Set_Value(value); }
+    void Append_Real(NameKeyType key, float value) { Append_Prep(key, DICT_REAL)->Set_Value(value); }
+    void Append_AsciiString(NameKeyType key, const Utf8String &value)
+    {
+        Append_Prep(key, DICT_ASCIISTRING)->Set_Value(value);
+    }
+    void Append_UnicodeString(NameKeyType key, const Utf16String &value)
+    {
+        Append_Prep(key, DICT_UNICODESTRING)->Set_Value(value);
+    }
+    void End_Build();
+
 private:
     DictPair *Ensure_Unique(int pairs_needed, bool preserve_data = false, DictPair *to_translate = nullptr);
     DictPair *Set_Prep(NameKeyType key, DataType type);
     DictPair *Find_Pair_By_Key(NameKeyType key) const;
     void Sort_Pairs();
     static int Pair_Compare(const void *l, const void *r);
+    DictPair *Append_Prep(NameKeyType key, DataType type);
+    DictPair *Insert_Pair(NameKeyType key);
+    int Get_Grown_Pair_Count(int pairs_needed) const;
+    void Rebuild_Hash_Index();
+    static int Get_Hash_Slot_Count(int pairs);
+    static int Get_Data_Size(int pairs);
 
 private:
     DictPairData *m_data;
@@ -16,20 +16,55 @@
 #include "gamemessagelist.h"
 #include "playerlist.h"
 
+GameMessageArgumentStore::~GameMessageArgumentStore()
+{
+    if (m_args != m_inline) {
+        delete[] m_args;
+    }
+}
+
+ArgumentType *GameMessageArgumentStore::Append(ArgumentDataType type)
+{
+    if (m_count == m_capacity) {
+        Slot *args = new Slot[m_capacity * 2];
+
+        for (int i = 0; i < m_count; ++i) {
+            args[i] = m_args[i];
+        }
+
+        if (m_args != m_inline) {
+            delete[] m_args;
+        }
+
+        m_args = args;
+        m_capacity *= 2;
+    }
+
+    Slot &slot = m_args[m_count++];
+    slot.type = type;
+
+    return &slot.data;
+}
+
 GameMessage::GameMessage(MessageType type) :
     m_next(nullptr),
     m_prev(nullptr),
     m_list(nullptr),
     m_type(type),
     m_playerIndex(g_thePlayerList->Get_Local_Player()->Get_Player_Index()), // g_thePlayerList->m_local->m_playerIndex
+#ifdef GAME_DLL
     m_argCount(0),
     m_argList(nullptr),
     m_argTail(nullptr)
+#else
+    m_argCount(0)
+#endif
 {
 }
 
 GameMessage::~GameMessage()
 {
+#ifdef GAME_DLL
     GameMessageArgument *argobj = m_argList;
 
     while (argobj != nullptr) {
@@ -37,14 +72,18 @@ GameMessage::~GameMessage()
         argobj = argobj->m_next;
         tmp->Delete_Instance();
     }
+#endif
 
     if (m_list != nullptr) {
         m_list->Remove_Message(this);
     }
 }
 
-GameMessageArgument *GameMessage::Allocate_Arg()
+ArgumentType *GameMessage::Allocate_Arg(ArgumentDataType type)
 {
+    ++m_argCount;
+
+#ifdef GAME_DLL
     GameMessageArgument *arg = NEW_POOL_OBJ(GameMessageArgument);
 
     if (m_argTail != nullptr) {
@@ -54,16 +93,20 @@ GameMessageArgument *GameMessage::Allocate_Arg()
     }
 
     arg->m_next = nullptr;
+    arg->m_type = type;
     m_argTail = arg;
-    ++m_argCount;
 
-    return arg;
+    return &arg->m_data;
+#else
+    return m_args.Append(type);
+#endif
 }
 
 ArgumentType *GameMessage::Get_Argument(int arg) const
 {
     static ArgumentType junkconst;
 
+#ifdef GAME_DLL
     GameMessageArgument *argobj = m_argList;
     int i = 0;
 
@@ -75,6 +118,11 @@ ArgumentType *GameMessage::Get_Argument(int arg) const
         ++i;
         argobj = argobj->m_next;
     }
+#else
+    if (arg >= 0 && arg < m_args.Count()) {
+        return m_args.Get(arg);
+    }
+#endif
 
     return &junkconst;
 }
@@ -85,6 +133,7 @@ ArgumentDataType GameMessage::Get_Argument_Type(int arg)
         return ARGUMENTDATATYPE_UNKNOWN;
     }
 
+#ifdef GAME_DLL
     GameMessageArgument *argobj = m_argList;
 
     for (int i = 0; i < arg; ++i) {
@@ -100,6 +149,13 @@ ArgumentDataType GameMessage::Get_Argument_Type(int arg)
     }
 
     return argobj->m_type;
+#else
+    if (arg < 0 || arg >= m_args.Count()) {
+        return ARGUMENTDATATYPE_UNKNOWN;
+    }
+
+    return m_args.Get_Type(arg);
+#endif
 }
 
 Utf8String GameMessage::Get_Command_As_Ascii(MessageType command)
@@ -650,77 +706,55 @@ Utf8String GameMessage::Get_Command_As_Ascii(MessageType command)
 
 void GameMessage::Append_Int_Arg(int arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.integer = arg;
-    argobj->m_type = ARGUMENTDATATYPE_INTEGER;
+    Allocate_Arg(ARGUMENTDATATYPE_INTEGER)->integer = arg;
 }
 
 void GameMessage::Append_Real_Arg(float arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.real = arg;
-    argobj->m_type = ARGUMENTDATATYPE_REAL;
+    Allocate_Arg(ARGUMENTDATATYPE_REAL)->real = arg;
 }
 
 void GameMessage::Append_Bool_Arg(bool arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.boolean = arg;
-    argobj->m_type = ARGUMENTDATATYPE_BOOLEAN;
+    Allocate_Arg(ARGUMENTDATATYPE_BOOLEAN)->boolean = arg;
 }
 
 void GameMessage::Append_ObjectID_Arg(ObjectID arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.objectID = arg;
-    argobj->m_type = ARGUMENTDATATYPE_OBJECTID;
+    Allocate_Arg(ARGUMENTDATATYPE_OBJECTID)->objectID = arg;
 }
 
 void GameMessage::Append_DrawableID_Arg(DrawableID arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.drawableID = arg;
-    argobj->m_type = ARGUMENTDATATYPE_DRAWABLEID;
+    Allocate_Arg(ARGUMENTDATATYPE_DRAWABLEID)->drawableID = arg;
 }
 
 void GameMessage::Append_TeamID_Arg(unsigned int arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.teamID = arg;
-    argobj->m_type = ARGUMENTDATATYPE_TEAMID;
+    Allocate_Arg(ARGUMENTDATATYPE_TEAMID)->teamID = arg;
 }
 
 void GameMessage::Append_Location_Arg(Coord3D const &arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.position = arg;
-    argobj->m_type = ARGUMENTDATATYPE_LOCATION;
+    Allocate_Arg(ARGUMENTDATATYPE_LOCATION)->position = arg;
 }
 
 void GameMessage::Append_Pixel_Arg(ICoord2D const &arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.pixel = arg;
-    argobj->m_type = ARGUMENTDATATYPE_PIXEL;
+    Allocate_Arg(ARGUMENTDATATYPE_PIXEL)->pixel = arg;
 }
 
 void GameMessage::Append_Region_Arg(IRegion2D const &arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.region = arg;
-    argobj->m_type = ARGUMENTDATATYPE_PIXELREGION;
+    Allocate_Arg(ARGUMENTDATATYPE_PIXELREGION)->region = arg;
 }
 
 void GameMessage::Append_Time_Stamp_Arg(unsigned int arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.timestamp = arg;
-    argobj->m_type = ARGUMENTDATATYPE_TIMESTAMP;
+    Allocate_Arg(ARGUMENTDATATYPE_TIMESTAMP)->timestamp = arg;
 }
 
 void GameMessage::Append_Wide_Char_Arg(wchar_t arg)
 {
-    GameMessageArgument *argobj = Allocate_Arg();
-    argobj->m_data.widechar = arg;
-    argobj->m_type = ARGUMENTDATATYPE_WIDECHAR;
+    Allocate_Arg(ARGUMENTDATATYPE_WIDECHAR)->widechar = arg;
 }
@@ -72,6 +72,41 @@ public:
     ArgumentDataType m_type;
 };
 
+/**
+ * Holds the arguments of a message in one array so they can be read by index. The first few live inside the message
+ * itself, which covers most commands without any allocation.
+ */
+class GameMessageArgumentStore
+{
+public:
+    enum
+    {
+        INLINE_COUNT = 4,
+    };
+
+    GameMessageArgumentStore() : m_args(m_inline), m_count(0), m_capacity(INLINE_COUNT) {}
+    ~GameMessageArgumentStore();
+    GameMessageArgumentStore(const GameMessageArgumentStore &src) = delete;
+    GameMessageArgumentStore &operator=(const GameMessageArgumentStore &that) = delete;
+
+    ArgumentType *Append(ArgumentDataType type);
+    ArgumentType *Get(int index) const { return &m_args[index].data; }
+    ArgumentDataType Get_Type(int index) const { return m_args[index].type; }
+    int Count() const { return m_count; }
+
+private:
+    struct Slot
+    {
+        ArgumentType data;
+        ArgumentDataType type;
+    };
+
+    Slot *m_args;
+    int m_count;
+    int m_capacity;
+    Slot m_inline[INLINE_COUNT];
+};
+
 class GameMessage : public MemoryPoolObject
 {
     IMPLEMENT_POOL(GameMessage);
@@ -360,7 +395,6 @@ protected:
 public:
     GameMessage(MessageType type);
 
-    GameMessageArgument *Allocate_Arg();
     ArgumentType *Get_Argument(int arg) const;
     int Get_Argument_Count() const { return m_argCount; }
     ArgumentDataType Get_Argument_Type(int arg);
@@ -384,6 +418,9 @@ public:
     MessageType Get_Type() const { return m_type; }
     int Get_Player_Index() const { return m_playerIndex; }
 
+private:
+    ArgumentType *Allocate_Arg(ArgumentDataType type);
+
 private:
     GameMessage *m_next;
     GameMessage *m_prev;
@@ -392,6 +429,10 @@ private:
     int m_playerIndex;
     int8_t m_argCount;
     // 3 bytes padding
+#ifdef GAME_DLL
     GameMessageArgument *m_argList;
     GameMessageArgument *m_argTail;
+#else
+    GameMessageArgumentStore m_args;
+#endif
 };
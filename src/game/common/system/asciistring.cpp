@@ -29,23 +29,27 @@ Utf8String const Utf8String::s_emptyString(nullptr);
 /**
  * Default constructor added for convenience
  */
-Utf8String::Utf8String() : m_data(nullptr) {}
+Utf8String::Utf8String()
+{
+    Set_Null();
+}
 
 /**
  * Initializes this string with an existing string (copy) and increments reference count.
  */
-Utf8String::Utf8String(Utf8String const &string) : m_data(string.m_data)
+Utf8String::Utf8String(Utf8String const &string)
 {
-    if (m_data != nullptr) {
-        m_data->Inc_Ref_Count();
-    }
+    Set_Null();
+    Share(string);
 }
 
 /**
  * Initializes this string with a reference to the start of a char array.
  */
-Utf8String::Utf8String(const char *s) : m_data(nullptr)
+Utf8String::Utf8String(const char *s)
 {
+    Set_Null();
+
     if (s != nullptr) {
         // Get length of the string that was passed
         const size_type len = static_cast<size_type>(strlen(s));
@@ -56,11 +60,39 @@ Utf8String::Utf8String(const char *s) : m_data(nullptr)
     }
 }
 
+/**
+ * Thyme specific: initializes this string to share the characters of a string constant.
+ */
+Utf8String::Utf8String(AsciiStringData &literal_data)
+{
+    Set_Null();
+    m_data = &literal_data;
+    m_data->Inc_Ref_Count();
+}
+
+/**
+ * Makes this empty string refer to the same characters as another string, short strings are copied.
+ */
+void Utf8String::Share(Utf8String const &string)
+{
+    memcpy(static_cast<void *>(this), &string, sizeof(Utf8String));
+
+    if (Get_Data() != nullptr) {
+        m_data->Inc_Ref_Count();
+    }
+}
+
 /**
  * A utility method to test nullptr on string content and log if that happens
  */
 const char *Utf8String::Peek() const
 {
+#ifndef GAME_DLL
+    if (Is_Small()) {
+        return m_buffer;
+    }
+#endif
+
     captainslog_dbgassert(m_data != nullptr, "null string ptr");
 
     return m_data->Peek();
@@ -71,6 +103,12 @@ const char *Utf8String::Peek() const
  */
 char *Utf8String::Peek()
 {
+#ifndef GAME_DLL
+    if (Is_Small()) {
+        return m_buffer;
+    }
+#endif
+
     captainslog_dbgassert(m_data != nullptr, "null string ptr");
 
     return m_data->Peek();
@@ -83,14 +121,15 @@ void Utf8String::Release_Buffer()
 {
     Validate();
 
-    if (m_data != nullptr) {
+    if (Get_Data() != nullptr) {
         m_data->Dec_Ref_Count();
-        if (m_data->ref_count == 0) {
+        // Thyme specific: string constants have nothing allocated and are never freed.
+        if (m_data->ref_count == 0 && m_data->num_chars_allocated != 0) {
             Free_Bytes();
         }
-        m_data = nullptr;
     }
 
+    Set_Null();
     Validate();
 }
 
@@ -110,7 +149,9 @@ void Utf8String::Ensure_Unique_Buffer_Of_Size(
 {
     Validate();
 
-    if (m_data != nullptr && m_data->ref_count == 1 && m_data->num_chars_allocated >= chars_needed) {
+    AsciiStringData *data = Get_Data();
+
+    if (data != nullptr && data->ref_count == 1 && data->num_chars_allocated >= chars_needed) {
         if (str_to_cpy != nullptr) {
             // #BUGFIX Originally uses strcpy here. Use memmove to support overlaps gracefully.
             captainslog_dbgassert(strlen(str_to_cpy) == chars_needed - 1, "Length does not match");
@@ -120,7 +161,31 @@ void Utf8String::Ensure_Unique_Buffer_Of_Size(
         if (str_to_cat != nullptr) {
             strcat(Peek(), str_to_cat);
         }
+#ifndef GAME_DLL
+    } else if (chars_needed < SMALL_BUFFER_SIZE) {
+        // Thyme specific: short strings are stored inline rather than allocated. Build the new string on the stack as the
+        // strings to copy from may be this one.
+        char buf[SMALL_BUFFER_SIZE];
+
+        if (Has_Data() && keep_data) {
+            strcpy(buf, Peek());
+        } else {
+            *buf = '\0';
+        }
 
+        if (str_to_cpy != nullptr) {
+            strcpy(buf, str_to_cpy);
+        }
+
+        if (str_to_cat != nullptr) {
+            strcat(buf, str_to_cat);
+        }
+
+        Release_Buffer();
+        memcpy(m_buffer, buf, SMALL_BUFFER_SIZE - 1);
+        m_buffer[SMALL_BUFFER_SIZE - 1] = 1;
+        Validate();
+#endif
     } else {
         const int required_size = chars_needed + sizeof(AsciiStringData);
 
@@ -136,7 +201,7 @@ void Utf8String::Ensure_Unique_Buffer_Of_Size(
         new_data->debug_ptr = new_data->Peek();
 #endif
 
-        if (m_data != nullptr && keep_data) {
+        if (Has_Data() && keep_data) {
             strcpy(new_data->Peek(), Peek());
         } else {
             *new_data->Peek() = '\0';
@@ -161,7 +226,7 @@ void Utf8String::Ensure_Unique_Buffer_Of_Size(
  */
 Utf8String::size_type Utf8String::Get_Length() const
 {
-    if (m_data != nullptr) {
+    if (Has_Data()) {
         const size_type len = static_cast<size_type>(strlen(Str()));
         captainslog_dbgassert(len > 0, "length of string is less than or equal to 0.");
 
@@ -186,7 +251,7 @@ const char *Utf8String::Str() const
 {
     static char const TheNullChr[4] = "";
 
-    if (m_data != nullptr) {
+    if (Has_Data()) {
         return Peek();
     }
 
@@ -207,7 +272,7 @@ char *Utf8String::Get_Buffer_For_Read(size_type len)
  */
 void Utf8String::Set(const char *str)
 {
-    if (m_data == nullptr || str != m_data->Peek()) {
+    if (!Has_Data() || str != Peek()) {
         const size_type len = str ? static_cast<size_type>(strlen(str)) : 0;
 
         if (len != 0) {
@@ -225,11 +290,7 @@ void Utf8String::Set(Utf8String const &string)
 {
     if (&string != this) {
         Release_Buffer();
-        m_data = string.m_data;
-
-        if (m_data != nullptr) {
-            m_data->Inc_Ref_Count();
-        }
+        Share(string);
     }
 }
 
@@ -319,7 +380,7 @@ void Utf8String::Concat(const char *s)
     const size_type add_len = static_cast<size_type>(strlen(s));
 
     if (add_len > 0) {
-        if (m_data != nullptr) {
+        if (Has_Data()) {
             const size_type cur_len = strlen(Peek());
             Ensure_Unique_Buffer_Of_Size(cur_len + add_len + 1, true, nullptr, s);
         } else {
@@ -334,7 +395,7 @@ void Utf8String::Concat(const char *s)
 void Utf8String::Trim()
 {
     // No string, no Trim.
-    if (m_data == nullptr) {
+    if (!Has_Data()) {
         return;
     }
 
@@ -353,7 +414,7 @@ void Utf8String::Trim()
     }
 
     // Oops, Set call broke the string.
-    if (m_data == nullptr) {
+    if (!Has_Data()) {
         return;
     }
 
@@ -376,7 +437,7 @@ void Utf8String::To_Lower()
     // Size specifically matches original code for compatibility.
     char buf[MAX_TO_LOWER_BUF_LEN];
 
-    if (m_data == nullptr) {
+    if (!Has_Data()) {
         return;
     }
 
@@ -396,7 +457,7 @@ Utf8String Utf8String::Posix_Path() const
 {
     char buf[MAX_FORMAT_BUF_LEN];
 
-    if (m_data == nullptr) {
+    if (!Has_Data()) {
         return s_emptyString;
     }
 
@@ -418,7 +479,7 @@ Utf8String Utf8String::Windows_Path() const
 {
     char buf[MAX_FORMAT_BUF_LEN];
 
-    if (m_data == nullptr) {
+    if (!Has_Data()) {
         return s_emptyString;
     }
 
@@ -438,7 +499,7 @@ Utf8String Utf8String::Windows_Path() const
  */
 void Utf8String::Remove_Last_Char()
 {
-    if (m_data == nullptr) {
+    if (!Has_Data()) {
         return;
     }
 
@@ -508,7 +569,7 @@ bool Utf8String::Starts_With(const char *p) const
         return true;
     }
     // early out if our string is shorter than the input one
-    const size_type thislen = m_data != nullptr ? static_cast<size_type>(strlen(Peek())) : 0;
+    const size_type thislen = Has_Data() ? static_cast<size_type>(strlen(Peek())) : 0;
     const size_type thatlen = static_cast<size_type>(strlen(p));
 
     if (thislen < thatlen) {
@@ -527,7 +588,7 @@ bool Utf8String::Ends_With(const char *p) const
         return true;
     }
     // early out if our string is shorter than the input one
-    const size_type thislen = m_data != nullptr ? static_cast<size_type>(strlen(Peek())) : 0;
+    const size_type thislen = Has_Data() ? static_cast<size_type>(strlen(Peek())) : 0;
     const size_type thatlen = static_cast<size_type>(strlen(p));
 
     if (thislen < thatlen) {
@@ -565,7 +626,7 @@ bool Utf8String::Ends_With_No_Case(const char *p) const
         return true;
     }
 
-    const size_type thislen = m_data != nullptr ? static_cast<size_type>(strlen(Peek())) : 0;
+    const size_type thislen = Has_Data() ? static_cast<size_type>(strlen(Peek())) : 0;
     const size_type thatlen = static_cast<size_type>(strlen(p));
 
     if (thislen < thatlen) {
@@ -581,7 +642,7 @@ bool Utf8String::Ends_With_No_Case(const char *p) const
  */
 bool Utf8String::Next_Token(Utf8String *tok, const char *delims)
 {
-    if (m_data == nullptr) {
+    if (!Has_Data()) {
         return false;
     }
 
@@ -48,6 +48,10 @@ public:
         MAX_FORMAT_BUF_LEN = 2048,
         MAX_LEN = 0x7FFF,
         MAX_TO_LOWER_BUF_LEN = 2060,
+#ifndef GAME_DLL
+        // Thyme specific: strings shorter than this minus one are stored inline, the last byte flags inline storage.
+        SMALL_BUFFER_SIZE = 24,
+#endif
     };
 
     struct AsciiStringData
@@ -86,9 +90,25 @@ public:
         char *Peek() { return reinterpret_cast<char *>(&this[1]); }
     };
 
+    // Thyme specific: static storage for a string constant that Utf8Strings share without ever allocating or freeing
+    // it, which is marked by having no characters allocated. Use through UTF8_LITERAL.
+    template<size_t N> struct Literal
+    {
+        constexpr Literal(const char (&str)[N]) : header(), chars()
+        {
+            for (size_t i = 0; i < N; ++i) {
+                chars[i] = str[i];
+            }
+        }
+
+        AsciiStringData header;
+        char chars[N];
+    };
+
     Utf8String();
     Utf8String(const char *s);
     Utf8String(Utf8String const &string);
+    template<size_t N> explicit Utf8String(Literal<N> &literal) : Utf8String(literal.header) {}
     // Utf8String(Utf16String const &stringSrc);
     ~Utf8String() { Release_Buffer(); }
 
@@ -151,19 +171,25 @@ public:
 
     bool Next_Token(Utf8String *tok, const char *seps = nullptr);
 
-    bool Is_None() const { return m_data != nullptr && strcasecmp(Peek(), "None") == 0; }
-    bool Is_Empty() const { return m_data == nullptr || *m_data->Peek() == '\0'; }
+    bool Is_None() const { return Has_Data() && strcasecmp(Peek(), "None") == 0; }
+    bool Is_Empty() const { return !Has_Data() || *Peek() == '\0'; }
     bool Is_Not_Empty() const { return !Is_Empty(); }
     bool Is_Not_None() const { return !Is_None(); }
 
     Utf8String Posix_Path() const;
     Utf8String Windows_Path() const;
 
-    friend bool operator==(Utf8String const &left, Utf8String const &right) { return left.Compare(right) == 0; }
+    friend bool operator==(Utf8String const &left, Utf8String const &right)
+    {
+        return left.Shares_Data(right) || left.Compare(right) == 0;
+    }
     friend bool operator==(Utf8String const &left, const char *right) { return left.Compare(right) == 0; }
     friend bool operator==(const char *left, Utf8String const &right) { return right.Compare(left) == 0; }
 
-    friend bool operator!=(Utf8String const &left, Utf8String const &right) { return left.Compare(right) != 0; }
+    friend bool operator!=(Utf8String const &left, Utf8String const &right)
+    {
+        return !left.Shares_Data(right) && left.Compare(right) != 0;
+    }
     friend bool operator!=(Utf8String const &left, const char *right) { return left.Compare(right) != 0; }
     friend bool operator!=(const char *left, Utf8String const &right) { return right.Compare(left) != 0; }
 
@@ -198,6 +224,31 @@ protected:
     char *Peek();
 
 private:
+    explicit Utf8String(AsciiStringData &literal_data);
+
+    bool Is_Small() const
+    {
+#ifndef GAME_DLL
+        return m_buffer[SMALL_BUFFER_SIZE - 1] != 0;
+#else
+        return false;
+#endif
+    }
+
+    bool Has_Data() const { return Is_Small() || m_data != nullptr; }
+    // Gets the reference counted buffer, if the string has one.
+    AsciiStringData *Get_Data() const { return Is_Small() ? nullptr : m_data; }
+    bool Shares_Data(Utf8String const &string) const { return Get_Data() != nullptr && Get_Data() == string.Get_Data(); }
+
+    void Set_Null()
+    {
+        m_data = nullptr;
+#ifndef GAME_DLL
+        m_buffer[SMALL_BUFFER_SIZE - 1] = 0;
+#endif
+    }
+
+    void Share(Utf8String const &string);
     void Translate_Internal(const unichar_t *utf16_string, const size_type utf16_len);
 
     // Probably supposed to be private
@@ -207,9 +258,26 @@ private:
     void Format_VA(const char *format, va_list args);
     void Format_VA(Utf8String &format, va_list args);
 
+#ifndef GAME_DLL
+    union
+    {
+        AsciiStringData *m_data;
+        char m_buffer[SMALL_BUFFER_SIZE];
+    };
+#else
     AsciiStringData *m_data;
+#endif
 };
 
+// Thyme specific: a const Utf8String & to a string constant that is set up once and never allocates. Copies of it
+// share the characters and compare equal to it without comparing them.
+#define UTF8_LITERAL(str) \
+    ([]() -> const Utf8String & { \
+        static Utf8String::Literal<sizeof(str)> s_literal(str); \
+        static const Utf8String s_string(s_literal); \
+        return s_string; \
+    }())
+
 inline Utf8String &Utf8String::operator=(const char *s)
 {
     Set(s);
@@ -14,6 +14,8 @@
  */
 #include "datachunk.h"
 #include "endiantype.h"
+#include <algorithm>
+#include <cstring>
 
 void DataChunkInput::Decrement_Data_Left(int size)
 {
@@ -35,9 +37,193 @@ void DataChunkInput::Clear_Chunk_Stack()
     m_chunkStack = nullptr;
 }
 
+/**
+ * @brief Find the parser registered for a chunk label under a parent label, the most recently registered one wins.
+ */
+DataChunkInput::UserParser *DataChunkInput::Find_Parser(
+    const Utf8String &label, const Utf8String &parent_label, unsigned parent_id)
+{
+#ifndef GAME_DLL
+    if (m_parserTableDirty) {
+        Build_Parser_Table();
+    }
+
+    // Look the parser up by the IDs from the TOC rather than comparing the labels against every registered parser.
+    if (!m_parserIndex.empty()) {
+        unsigned label_id = m_chunkStack->id;
+
+        if (label_id + 1 >= m_parserIndex.size()) {
+            return nullptr;
+        }
+
+        for (int i = m_parserIndex[label_id]; i < m_parserIndex[label_id + 1]; ++i) {
+            if (m_parserTable[i].parent_id == parent_id) {
+                return m_parserTable[i].parser;
+            }
+        }
+
+        return nullptr;
+    }
+#endif
+
+    for (UserParser *parser = m_parserList; parser != nullptr; parser = parser->next) {
+        if (label == parser->label && parent_label == parser->parent_label) {
+            return parser;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * @brief Resolve the labels of the registered parsers to TOC IDs and index them by label.
+ */
+void DataChunkInput::Build_Parser_Table()
+{
+#ifndef GAME_DLL
+    m_parserTable.clear();
+    m_parserIndex.clear();
+    m_parserTableDirty = false;
+
+    // Files with IDs too large to index are handled by searching the parser list instead.
+    unsigned max_id = m_contents.Get_Max_ID();
+
+    if (max_id > DataChunkTableOfContents::MAX_INDEXED_ID) {
+        return;
+    }
+
+    for (UserParser *parser = m_parserList; parser != nullptr; parser = parser->next) {
+        ParserEntry entry;
+        entry.parser = parser;
+        entry.parent_id = NO_PARENT_ID;
+
+        // Parsers for labels the file doesn't contain can never be called.
+        if (!m_contents.Find_ID(parser->label, entry.label_id) || entry.label_id > max_id) {
+            continue;
+        }
+
+        if (parser->parent_label.Is_Not_Empty() && !m_contents.Find_ID(parser->parent_label, entry.parent_id)) {
+            continue;
+        }
+
+        m_parserTable.push_back(entry);
+    }
+
+    // Stable so parsers for the same label stay in list order.
+    std::stable_sort(m_parserTable.begin(), m_parserTable.end(), [](const ParserEntry &a, const ParserEntry &b) {
+        return a.label_id < b.label_id;
+    });
+
+    m_parserIndex.assign(max_id + 2, 0);
+
+    for (const ParserEntry &entry : m_parserTable) {
+        ++m_parserIndex[entry.label_id + 1];
+    }
+
+    for (unsigned i = 1; i < m_parserIndex.size(); ++i) {
+        m_parserIndex[i] += m_parserIndex[i - 1];
+    }
+#endif
+}
+
+/**
+ * @brief Get the name key for a name in the TOC, generating each one only once.
+ */
+NameKeyType DataChunkInput::Get_Name_Key(unsigned id)
+{
+#ifndef GAME_DLL
+    if (id <= DataChunkTableOfContents::MAX_INDEXED_ID) {
+        if (id >= m_nameKeys.size()) {
+            m_nameKeys.resize(id + 1, NAMEKEY_INVALID);
+        }
+
+        if (m_nameKeys[id] == NAMEKEY_INVALID) {
+            m_nameKeys[id] = g_theNameKeyGenerator->Name_To_Key(m_contents.Get_Name(id).Str());
+        }
+
+        return m_nameKeys[id];
+    }
+#endif
+
+    return g_theNameKeyGenerator->Name_To_Key(m_contents.Get_Name(id).Str());
+}
+
+/**
+ * @brief Read from the stream through a buffer, so that reading a value doesn't take a stream call each.
+ */
+int DataChunkInput::Read_Data(void *dst, int size)
+{
+#ifdef GAME_DLL
+    return m_file->Read(dst, size);
+#else
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    int read = std::min(size, m_readEnd - m_readPos);
+    memcpy(out, &m_readBuffer[m_readPos], read);
+    m_readPos += read;
+
+    if (read == size) {
+        return read;
+    }
+
+    // Large reads go straight to the stream, small ones refill the buffer. The buffer no longer holds the bytes before
+    // the stream position after a direct read, so it is dropped for Seek_Data.
+    if (size - read >= READ_BUFFER_SIZE) {
+        m_readPos = 0;
+        m_readEnd = 0;
+
+        return read + std::max(m_file->Read(out + read, size - read), 0);
+    }
+
+    m_readEnd = std::max(m_file->Read(m_readBuffer, READ_BUFFER_SIZE), 0);
+    m_readPos = std::min(size - read, m_readEnd);
+    memcpy(out + read, m_readBuffer, m_readPos);
+
+    return read + m_readPos;
+#endif
+}
+
+/**
+ * @brief Get the position in the stream, not counting what has been buffered but not read yet.
+ */
+unsigned DataChunkInput::Tell_Data()
+{
+#ifdef GAME_DLL
+    return m_file->Tell();
+#else
+    return m_file->Tell() - (m_readEnd - m_readPos);
+#endif
+}
+
+/**
+ * @brief Seek to an absolute position in the stream, staying within the buffer where possible.
+ */
+void DataChunkInput::Seek_Data(unsigned pos)
+{
+#ifndef GAME_DLL
+    unsigned end = m_file->Tell();
+    unsigned start = end - m_readEnd;
+
+    if (pos >= start && pos <= end) {
+        m_readPos = pos - start;
+        return;
+    }
+
+    m_readPos = 0;
+    m_readEnd = 0;
+#endif
+
+    m_file->Absolute_Seek(pos);
+}
+
 DataChunkInput::DataChunkInput(ChunkInputStream *stream) :
     m_file(stream), m_contents(), m_parserList(nullptr), m_chunkStack(nullptr), m_currentObject(nullptr), m_userData(nullptr)
 {
+#ifndef GAME_DLL
+    m_parserTableDirty = true;
+    m_readPos = 0;
+    m_readEnd = 0;
+#endif
+
     m_contents.Read(*m_file);
     m_fileposOfFirstChunk = m_file->Tell();
 }
@@ -47,6 +233,11 @@ DataChunkInput::~DataChunkInput()
 {
     Clear_Chunk_Stack();
 
+#ifndef GAME_DLL
+    // Leave the stream where reading stopped rather than where the buffer got to.
+    m_file->Absolute_Seek(Tell_Data());
+#endif
+
     auto *current = m_parserList;
     while (current != nullptr) {
         auto *next = current->next;
@@ -71,6 +262,10 @@ void DataChunkInput::Register_Parser(const Utf8String &label,
     user_parser->user_data = user_data;
     user_parser->next = m_parserList;
     m_parserList = user_parser;
+
+#ifndef GAME_DLL
+    m_parserTableDirty = true;
+#endif
 }
 
 /**
@@ -80,6 +275,7 @@ bool DataChunkInput::Parse(void *user_data)
 {
     Utf8String label;
     Utf8String parent_label;
+    unsigned parent_id = NO_PARENT_ID;
 
     // We can't parse if the header chunk hasn't been opened yet.
     if (!Is_Valid_File()) {
@@ -89,6 +285,7 @@ bool DataChunkInput::Parse(void *user_data)
 
     if (m_chunkStack != nullptr) {
         parent_label = m_contents.Get_Name(m_chunkStack->id);
+        parent_id = m_chunkStack->id;
     }
 
     while (!At_End_Of_File()) {
@@ -106,21 +303,18 @@ bool DataChunkInput::Parse(void *user_data)
         }
 
         // Find suitable parser for the current chunk.
-        UserParser *parser;
-        for (parser = m_parserList; parser != nullptr; parser = parser->next) {
-            if (label == parser->label && parent_label == parser->parent_label) {
-                DataChunkInfo info;
-                info.label = label;
-                info.parent_label = parent_label;
-                info.version = version;
-                info.data_size = Get_Chunk_Data_Size();
-
-                // If parsing failed, return false.
-                if (!parser->parser(*this, &info, user_data)) {
-                    return false;
-                }
-
-                break;
+        UserParser *parser = Find_Parser(label, parent_label, parent_id);
+
+        if (parser != nullptr) {
+            DataChunkInfo info;
+            info.label = label;
+            info.parent_label = parent_label;
+            info.version = version;
+            info.data_size = Get_Chunk_Data_Size();
+
+            // If parsing failed, return false.
+            if (!parser->parser(*this, &info, user_data)) {
+                return false;
             }
         }
 
@@ -141,15 +335,15 @@ Utf8String DataChunkInput::Open_Data_Chunk(uint16_t *version)
     chunk->version = 0;
     chunk->data_size = 0;
 
-    m_file->Read(&chunk->id, sizeof(chunk->id));
+    Read_Data(&chunk->id, sizeof(chunk->id));
     chunk->id = le32toh(chunk->id);
     Decrement_Data_Left(sizeof(chunk->id));
 
-    m_file->Read(&chunk->version, sizeof(chunk->version));
+    Read_Data(&chunk->version, sizeof(chunk->version));
     chunk->version = le16toh(chunk->version);
     Decrement_Data_Left(sizeof(chunk->version));
 
-    m_file->Read(&chunk->data_size, sizeof(chunk->data_size));
+    Read_Data(&chunk->data_size, sizeof(chunk->data_size));
     chunk->data_size = le32toh(chunk->data_size);
     Decrement_Data_Left(sizeof(chunk->data_size));
 
@@ -158,11 +352,11 @@ Utf8String DataChunkInput::Open_Data_Chunk(uint16_t *version)
     }
 
     chunk->data_left = chunk->data_size;
-    chunk->chunk_start = m_file->Tell();
+    chunk->chunk_start = Tell_Data();
     chunk->next = m_chunkStack;
     m_chunkStack = chunk;
 
-    if (m_file->Eof()) {
+    if (At_End_Of_File()) {
         return Utf8String::s_emptyString;
     }
 
@@ -179,7 +373,7 @@ void DataChunkInput::Close_Data_Chunk()
     }
 
     if (m_chunkStack->data_left > 0) {
-        m_file->Absolute_Seek(m_chunkStack->data_left + m_file->Tell());
+        Seek_Data(m_chunkStack->data_left + Tell_Data());
         Decrement_Data_Left(m_chunkStack->data_left);
     }
 
@@ -194,7 +388,21 @@ void DataChunkInput::Close_Data_Chunk()
 void DataChunkInput::Reset()
 {
     Clear_Chunk_Stack();
-    m_file->Absolute_Seek(m_fileposOfFirstChunk);
+    Seek_Data(m_fileposOfFirstChunk);
+}
+
+/**
+ * @brief Check if the whole file has been read.
+ */
+bool DataChunkInput::At_End_Of_File()
+{
+#ifndef GAME_DLL
+    if (m_readPos < m_readEnd) {
+        return false;
+    }
+#endif
+
+    return m_file->Eof();
 }
 
 Utf8String DataChunkInput::Get_Chunk_Label()
@@ -216,7 +424,7 @@ float DataChunkInput::Read_Real32()
 
     captainslog_dbgassert(m_chunkStack->data_left >= sizeof(tmp), "Read past end of chunk reading a float.");
 
-    m_file->Read(&tmp, sizeof(tmp));
+    Read_Data(&tmp, sizeof(tmp));
     Decrement_Data_Left(sizeof(tmp));
     tmp = le32toh(tmp);
 
@@ -233,7 +441,7 @@ int32_t DataChunkInput::Read_Int32()
 
     captainslog_dbgassert(m_chunkStack->data_left >= sizeof(tmp), "Read past end of chunk reading an int.");
 
-    m_file->Read(&tmp, sizeof(tmp));
+    Read_Data(&tmp, sizeof(tmp));
     Decrement_Data_Left(sizeof(tmp));
     tmp = le32toh(tmp);
 
@@ -249,7 +457,7 @@ uint8_t DataChunkInput::Read_Byte()
 
     captainslog_dbgassert(m_chunkStack->data_left >= sizeof(tmp), "Read past end of chunk reading a byte.");
 
-    m_file->Read(&tmp, sizeof(tmp));
+    Read_Data(&tmp, sizeof(tmp));
     Decrement_Data_Left(sizeof(tmp));
 
     return tmp;
@@ -265,14 +473,14 @@ Utf8String DataChunkInput::Read_AsciiString()
 
     captainslog_dbgassert(m_chunkStack->data_left >= sizeof(size), "Read past end of chunk reading Utf8String length.");
 
-    m_file->Read(&size, sizeof(size));
+    Read_Data(&size, sizeof(size));
     Decrement_Data_Left(sizeof(size));
     size = le16toh(size);
 
     captainslog_dbgassert(m_chunkStack->data_left >= size, "Read past end of chunk reading Utf8String string.");
 
     char *buf = string.Get_Buffer_For_Read(size);
-    m_file->Read(buf, size);
+    Read_Data(buf, size);
     Decrement_Data_Left(size);
     buf[size] = '\0';
 
@@ -290,7 +498,7 @@ Utf16String DataChunkInput::Read_UnicodeString()
 
     captainslog_dbgassert(m_chunkStack->data_left >= sizeof(size), "Read past end of chunk reading Utf8String length.");
 
-    m_file->Read(&size, sizeof(size));
+    Read_Data(&size, sizeof(size));
     Decrement_Data_Left(sizeof(size));
     size = le16toh(size);
 
@@ -300,7 +508,7 @@ Utf16String DataChunkInput::Read_UnicodeString()
     // Data is stored as LE UCS-16, so only BMP unicode chars can be stored.
     // TODO revamp unicode handling for none windows systems using libicu or libiconv.
     for (unsigned i = 0; i < size; ++i) {
-        m_file->Read(&ch, sizeof(ch));
+        Read_Data(&ch, sizeof(ch));
         ch = le16toh(ch);
         string += ch;
     }
@@ -319,34 +527,36 @@ Dict DataChunkInput::Read_Dict()
 
     captainslog_dbgassert(m_chunkStack->data_left >= sizeof(size), "Read past end of chunk reading Utf8String length.");
 
-    m_file->Read(&size, sizeof(size));
+    Read_Data(&size, sizeof(size));
     Decrement_Data_Left(sizeof(size));
     size = le16toh(size);
 
     captainslog_dbgassert(m_chunkStack->data_left >= size, "Read past end of chunk reading Dict.");
 
-    Dict dict(size);
+    // Thyme specific: the pairs are sorted once at the end rather than on every insert.
+    Dict dict;
+    dict.Begin_Build(size);
 
     for (int i = 0; i < size; ++i) {
         uint32_t key = Read_Int32();
         // Generate a new name key based on the one that was stored in the file.
-        NameKeyType nk = g_theNameKeyGenerator->Name_To_Key(m_contents.Get_Name(key >> Dict::DICT_KEY_SHIFT).Str());
+        NameKeyType nk = Get_Name_Key(key >> Dict::DICT_KEY_SHIFT);
 
         switch (key & Dict::DICT_TYPE_MASK) {
             case Dict::DICT_BOOL:
-                dict.Set_Bool(nk, bool(Read_Byte()));
+                dict.Append_Bool(nk, bool(Read_Byte()));
                 break;
             case Dict::DICT_INT:
-                dict.Set_Int(nk, Read_Int32());
+                dict.Append_Int(nk, Read_Int32());
                 break;
             case Dict::DICT_REAL:
-                dict.Set_Real(nk, Read_Real32());
+                dict.Append_Real(nk, Read_Real32());
                 break;
             case Dict::DICT_ASCIISTRING:
-                dict.Set_AsciiString(nk, Read_AsciiString());
+                dict.Append_AsciiString(nk, Read_AsciiString());
                 break;
             case Dict::DICT_UNICODESTRING:
-                dict.Set_UnicodeString(nk, Read_UnicodeString());
+                dict.Append_UnicodeString(nk, Read_UnicodeString());
                 break;
             default:
                 captainslog_relassert(
@@ -354,6 +564,8 @@ Dict DataChunkInput::Read_Dict()
         }
     }
 
+    dict.End_Build();
+
     return dict;
 }
 
@@ -364,7 +576,7 @@ void DataChunkInput::Read_Byte_Array(uint8_t *ptr, int length)
 {
     captainslog_dbgassert(m_chunkStack->data_left >= length, "Read past end of chunk reading Utf8String string.");
 
-    m_file->Read(ptr, length);
+    Read_Data(ptr, length);
     Decrement_Data_Left(length);
 }
 
@@ -375,5 +587,5 @@ NameKeyType DataChunkInput::Read_Name_Key()
 {
     uint32_t key = Read_Int32();
 
-    return g_theNameKeyGenerator->Name_To_Key(m_contents.Get_Name(key >> Dict::DICT_KEY_SHIFT).Str());
+    return Get_Name_Key(key >> Dict::DICT_KEY_SHIFT);
 }
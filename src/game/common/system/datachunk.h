@@ -23,6 +23,10 @@
 #include "namekeygenerator.h"
 #include "unicodestring.h"
 
+#ifndef GAME_DLL
+#include <vector>
+#endif
+
 // Mac ZH also includes DataChunkOutput class, presumably for writing maps though it doesn't appear in the windows binary.
 
 class DataChunkOutput;
@@ -70,6 +74,23 @@ class DataChunkInput
         void *user_data;
     };
 
+    struct ParserEntry
+    {
+        unsigned label_id;
+        unsigned parent_id;
+        UserParser *parser;
+    };
+
+    enum
+    {
+        READ_BUFFER_SIZE = 4096,
+    };
+
+    enum : unsigned
+    {
+        NO_PARENT_ID = 0xFFFFFFFF, // Parent ID for chunks at the top level of the file.
+    };
+
 public:
     DataChunkInput(ChunkInputStream *stream);
     ~DataChunkInput();
@@ -82,7 +103,7 @@ public:
     bool Is_Valid_File() { return m_contents.Header_Opened(); }
     Utf8String Open_Data_Chunk(uint16_t *version);
     void Close_Data_Chunk();
-    bool At_End_Of_File() { return m_file->Eof(); }
+    bool At_End_Of_File();
     bool At_End_Of_Chunk() { return m_chunkStack != nullptr ? m_chunkStack->data_left <= 0 : true; }
     void Reset();
     Utf8String Get_Chunk_Label();
@@ -101,6 +122,12 @@ public:
 private:
     void Decrement_Data_Left(int size);
     void Clear_Chunk_Stack();
+    UserParser *Find_Parser(const Utf8String &label, const Utf8String &parent_label, unsigned parent_id);
+    void Build_Parser_Table();
+    NameKeyType Get_Name_Key(unsigned id);
+    int Read_Data(void *dst, int size);
+    unsigned Tell_Data();
+    void Seek_Data(unsigned pos);
 
 private:
     ChunkInputStream *m_file;
@@ -110,6 +137,16 @@ private:
     InputChunk *m_chunkStack;
     void *m_currentObject;
     void *m_userData;
+#ifndef GAME_DLL
+    // Registered parsers by the TOC ID of their label, m_parserIndex[id] to m_parserIndex[id + 1] is the range for a label.
+    std::vector<ParserEntry> m_parserTable;
+    std::vector<int> m_parserIndex;
+    bool m_parserTableDirty;
+    std::vector<NameKeyType> m_nameKeys; // Name keys by TOC ID.
+    int m_readPos;
+    int m_readEnd;
+    uint8_t m_readBuffer[READ_BUFFER_SIZE];
+#endif
     friend class WorldHeightMap;
     friend bool Parse_Objects_Data_Chunk(DataChunkInput &input, DataChunkInfo *info, void *data);
 };
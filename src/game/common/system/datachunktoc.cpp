@@ -52,6 +52,12 @@ unsigned DataChunkTableOfContents::Get_ID(const Utf8String &name)
  */
 Utf8String DataChunkTableOfContents::Get_Name(unsigned id)
 {
+#ifndef GAME_DLL
+    if (id < m_idIndex.size() && m_idIndex[id] != nullptr) {
+        return m_idIndex[id]->m_name;
+    }
+#endif
+
     Mapping *map = m_list;
 
     while (map != nullptr) {
@@ -84,10 +90,26 @@ unsigned DataChunkTableOfContents::Allocate_ID(const Utf8String &name)
     map->m_next = m_list;
     m_list = map;
     ++m_listLength;
+    Index_Mapping(map);
 
     return map->m_id;
 }
 
+/**
+ * @brief Get the ID of an entry with the given name if there is one, without complaining if there isn't.
+ */
+bool DataChunkTableOfContents::Find_ID(const Utf8String &name, unsigned &id)
+{
+    Mapping *map = Find_Mapping(name);
+
+    if (map != nullptr) {
+        id = map->m_id;
+        return true;
+    }
+
+    return false;
+}
+
 /**
  * @brief Read the data chunk TOC from the given data stream.
  */
@@ -122,6 +144,7 @@ void DataChunkTableOfContents::Read(ChunkInputStream &stream)
             m_list = map;
             ++m_listLength;
             max_id = std::max(max_id, map->m_id);
+            Index_Mapping(map);
         }
 
         m_headerOpened = !(count <= 0 || stream.Eof());
@@ -173,3 +196,22 @@ DataChunkTableOfContents::Mapping *DataChunkTableOfContents::Find_Mapping(const
 
     return nullptr;
 }
+
+/**
+ * @brief Add a Mapping entry to the ID lookup table.
+ */
+void DataChunkTableOfContents::Index_Mapping(Mapping *map)
+{
+#ifndef GAME_DLL
+    if (map->m_id > MAX_INDEXED_ID) {
+        return;
+    }
+
+    if (map->m_id >= m_idIndex.size()) {
+        m_idIndex.resize(map->m_id + 1, nullptr);
+    }
+
+    // Entries are added to the head of the list, so the last one added is also the one a search of the list finds.
+    m_idIndex[map->m_id] = map;
+#endif
+}
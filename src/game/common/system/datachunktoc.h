@@ -20,6 +20,10 @@
 #include "mempoolobj.h"
 #include "outputstream.h"
 
+#ifndef GAME_DLL
+#include <vector>
+#endif
+
 class DataChunkTableOfContents
 {
     class Mapping : public MemoryPoolObject
@@ -39,6 +43,13 @@ class DataChunkTableOfContents
         unsigned m_id;
     };
 
+public:
+    enum
+    {
+        // IDs are handed out counting up from 1, anything above this is not worth a lookup table.
+        MAX_INDEXED_ID = 0xFFFF,
+    };
+
 public:
     DataChunkTableOfContents() : m_list(nullptr), m_listLength(0), m_nextID(1), m_headerOpened(false) {}
     ~DataChunkTableOfContents();
@@ -49,13 +60,19 @@ public:
     void Read(ChunkInputStream &stream);
     void Write(OutputStream &stream);
     bool Header_Opened() { return m_headerOpened; }
+    bool Find_ID(const Utf8String &name, unsigned &id);
+    unsigned Get_Max_ID() const { return m_nextID - 1; }
 
 private:
     Mapping *Find_Mapping(const Utf8String &name);
+    void Index_Mapping(Mapping *map);
 
 private:
     Mapping *m_list;
     int m_listLength;
     unsigned m_nextID;
     bool m_headerOpened;
+#ifndef GAME_DLL
+    std::vector<Mapping *> m_idIndex; // Mappings by ID for the chunk labels looked up for every chunk read.
+#endif
 };
\ No newline at end of file
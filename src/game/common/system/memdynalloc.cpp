@@ -32,6 +32,9 @@ DynamicMemoryAllocator::DynamicMemoryAllocator() :
     m_factory(nullptr), m_nextDmaInFactory(nullptr), m_poolCount(0), m_usedBlocksInDma(0), m_rawBlocks(0)
 {
     memset(m_pools, 0, sizeof(m_pools));
+#ifndef GAME_DLL
+    m_allocationCount = 0;
+#endif
 }
 
 void DynamicMemoryAllocator::Init(MemoryPoolFactory *factory, int subpools, PoolInitRec const *const params)
@@ -129,6 +132,9 @@ void DynamicMemoryAllocator::Remove_From_List(DynamicMemoryAllocator **head)
 
 void *DynamicMemoryAllocator::Allocate_Bytes_No_Zero(int bytes)
 {
+#ifndef GAME_DLL
+    ++m_allocationCount;
+#endif
 #ifdef __SANITIZE_ADDRESS__
     return malloc(bytes);
 #else
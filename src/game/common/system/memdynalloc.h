@@ -16,6 +16,7 @@
 
 #include "always.h"
 #include "rawalloc.h"
+#include <atomic>
 
 struct PoolInitRec;
 class MemoryPool;
@@ -39,6 +40,10 @@ public:
     void Free_Bytes(void *block);
     int Get_Actual_Allocation_Size(int bytes);
     void Reset();
+#ifndef GAME_DLL
+    // Thyme specific: the number of allocations made so far, for measuring how often code allocates.
+    unsigned Get_Allocation_Count() const { return m_allocationCount; }
+#endif
 
     void *operator new(size_t size) { return Raw_Allocate_No_Zero(size); }
     void operator delete(void *obj) { Raw_Free(obj); }
@@ -50,6 +55,10 @@ private:
     int m_usedBlocksInDma;
     MemoryPool *m_pools[8];
     MemoryPoolSingleBlock *m_rawBlocks;
+#ifndef GAME_DLL
+    // Atomic as worker threads allocate too and sanitizer builds never take g_dmaCriticalSection.
+    std::atomic<unsigned> m_allocationCount;
+#endif
 };
 
 #ifdef GAME_DLL
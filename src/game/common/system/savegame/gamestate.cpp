@@ -16,7 +16,12 @@
 #include "filetransfer.h"
 #include "globaldata.h"
 #include "maputil.h"
+#include "xferload.h"
+#include "xfersave.h"
 #include <captainslog.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 
 #ifndef GAME_DLL
 GameState *g_theGameState = nullptr;
@@ -24,7 +29,13 @@ GameState *g_theGameState = nullptr;
 
 SaveGameInfo::SaveGameInfo() : m_missionNumber(0), m_saveFileType(SAVE_TYPE_UNK) {}
 
-GameState::GameState() : m_availableGames(nullptr), m_isLoading(false) {}
+GameState::GameState() : m_availableGames(nullptr), m_isLoading(false)
+{
+#ifndef GAME_DLL
+    m_incrementalBaseId = 0;
+    m_incrementalBase = nullptr;
+#endif
+}
 
 GameState::~GameState()
 {
@@ -34,6 +45,9 @@ GameState::~GameState()
 
     m_snapShots.clear();
     Clear_Available_Games();
+#ifndef GAME_DLL
+    Close_Incremental_Base();
+#endif
 }
 
 void GameState::Init()
@@ -47,6 +61,9 @@ void GameState::Reset()
 {
     m_snapShots.clear();
     Clear_Available_Games();
+#ifndef GAME_DLL
+    Clear_Incremental_Base();
+#endif
 }
 
 void GameState::Xfer_Snapshot(Xfer *xfer)
@@ -194,8 +211,7 @@ void GameState::Xfer_Save_Data(Xfer *xfer, SnapShotType type)
             name = it->m_name;
             captainslog_debug("Looking at block '%s'", name.Str());
 
-            if (Get_Save_Info()->m_saveFileType != SAVE_TYPE_UNK2 || name.Compare_No_Case("CHUNK_GameState") == 0
-                || name.Compare_No_Case("CHUNK_Campaign") == 0) {
+            if (Is_Block_Saved(name)) {
                 xfer->xferAsciiString(&name);
                 xfer->Begin_Block();
                 xfer->xferSnapshot(it->m_snapShot);
@@ -203,7 +219,7 @@ void GameState::Xfer_Save_Data(Xfer *xfer, SnapShotType type)
             }
         }
 
-        Utf8String eof("SG_EOF");
+        Utf8String eof(UTF8_LITERAL("SG_EOF"));
         xfer->xferAsciiString(&eof);
     } else {
         captainslog_debug("GameState::xferSaveData() - not XFER_SAVE");
@@ -220,6 +236,14 @@ void GameState::Xfer_Save_Data(Xfer *xfer, SnapShotType type)
                     xfer->Begin_Block();
                     xfer->xferSnapshot(block->m_snapShot);
                     xfer->End_Block();
+#ifndef GAME_DLL
+                } else if (name == UTF8_LITERAL("SG_INCREMENTAL_ID")) {
+                    xfer->Skip(xfer->Begin_Block());
+                } else if (name == UTF8_LITERAL("SG_INCREMENTAL_BASE")) {
+                    Open_Incremental_Base(xfer);
+                } else if (name == UTF8_LITERAL("SG_BLOCK_REFERENCE")) {
+                    Xfer_Block_From_Base(xfer, type);
+#endif
                 } else {
                     captainslog_debug("GameState::xferSaveData - Skipping unknown block '%s'", name.Str());
                     xfer->Skip(xfer->Begin_Block());
@@ -228,9 +252,316 @@ void GameState::Xfer_Save_Data(Xfer *xfer, SnapShotType type)
                 done = true;
             }
         }
+
+#ifndef GAME_DLL
+        Close_Incremental_Base();
+#endif
+    }
+}
+
+void GameState::Add_Snapshot_Block(Utf8String name, SnapShot *snapshot, SnapShotType type)
+{
+    captainslog_relassert(!name.Is_Empty() && snapshot != nullptr,
+        XFER_STATUS_INVALID_PARAMETERS,
+        "GameState::Add_Snapshot_Block - Invalid parameters");
+    SnapShotBlock block;
+    block.m_snapShot = snapshot;
+    block.m_name = name;
+    m_snapShotBlocks[type].push_back(block);
+}
+
+bool GameState::Is_Block_Saved(const Utf8String &name)
+{
+    return Get_Save_Info()->m_saveFileType != SAVE_TYPE_UNK2 || name.Compare_No_Case("CHUNK_GameState") == 0
+        || name.Compare_No_Case("CHUNK_Campaign") == 0;
+}
+
+#ifndef GAME_DLL
+/**
+ * Saves like Xfer_Save_Data, but blocks whose data hasn't changed since the last full save are stored as a reference to
+ * the block in that save. Without a base to refer to, or when saving over it, a full save is made that becomes the new
+ * base. Saving over a base that other saves still refer to is refused and nothing is written, the caller should
+ * Discard the file.
+ */
+XferStatus GameState::Xfer_Save_Data_Incremental(XferSave *xfer, SnapShotType type)
+{
+    captainslog_debug("GameState::Xfer_Save_Data_Incremental() - '%s'", xfer->Get_Filename().Str());
+    bool full = m_incrementalBasePath.Is_Empty() || m_incrementalBasePath.Compare_No_Case(xfer->Get_Filename()) == 0;
+    Utf8String name;
+
+    if (full && Has_Incremental_Dependents()) {
+        captainslog_error("GameState::Xfer_Save_Data_Incremental - Not overwriting base save '%s', '%s' refers to it",
+            m_incrementalBasePath.Str(),
+            m_incrementalDependents.front().Str());
+        return XFER_STATUS_WRITE_ERROR;
+    }
+
+    if (full) {
+        // Tells this base apart from earlier saves to the same file, so that saves referring to those aren't loaded
+        // with its data.
+        uint64_t stamp[2];
+        stamp[0] = uint64_t(std::chrono::system_clock::now().time_since_epoch().count());
+        stamp[1] = m_incrementalBaseId;
+        m_incrementalBaseId = XferSave::Hash_Data(stamp, sizeof(stamp));
+        m_incrementalBaseBlocks.clear();
+        m_incrementalBaseData.clear();
+
+        name = "SG_INCREMENTAL_ID";
+        xfer->xferAsciiString(&name);
+        xfer->Begin_Block();
+        xfer->xferUser(&m_incrementalBaseId, sizeof(m_incrementalBaseId));
+        xfer->End_Block();
+    } else {
+        name = "SG_INCREMENTAL_BASE";
+        xfer->xferAsciiString(&name);
+        xfer->Begin_Block();
+        xfer->xferAsciiString(&m_incrementalBasePath);
+        xfer->xferUser(&m_incrementalBaseId, sizeof(m_incrementalBaseId));
+        xfer->End_Block();
+    }
+
+    for (auto it = m_snapShotBlocks[type].begin(); it != m_snapShotBlocks[type].end(); it++) {
+        name = it->m_name;
+
+        if (!Is_Block_Saved(name)) {
+            continue;
+        }
+
+        int block_pos = xfer->Get_Position();
+        xfer->xferAsciiString(&name);
+        xfer->Begin_Block();
+        int data_pos = xfer->Get_Position();
+        xfer->xferSnapshot(it->m_snapShot);
+        xfer->End_Block();
+
+        const uint8_t *data = xfer->Get_Data(data_pos);
+        int size = xfer->Get_Position() - data_pos;
+
+        if (full) {
+            BaseBlock block;
+            block.m_name = name;
+            block.m_hash = XferSave::Hash_Data(data, size);
+            block.m_offset = int(m_incrementalBaseData.size());
+            block.m_size = size;
+            m_incrementalBaseBlocks.push_back(block);
+            m_incrementalBaseData.insert(m_incrementalBaseData.end(), data, data + size);
+            continue;
+        }
+
+        const BaseBlock *base = Find_Base_Block(name);
+
+        // Only the exact same bytes may be referenced, a matching hash alone could drop a change.
+        if (base != nullptr && base->m_size == size
+            && memcmp(m_incrementalBaseData.data() + base->m_offset, data, size) == 0) {
+            captainslog_debug("Block '%s' unchanged, referencing base save", name.Str());
+            BaseBlock reference = *base;
+            xfer->Truncate(block_pos);
+            name = "SG_BLOCK_REFERENCE";
+            xfer->xferAsciiString(&name);
+            xfer->Begin_Block();
+            xfer->xferAsciiString(&reference.m_name);
+            xfer->xferUser(&reference.m_hash, sizeof(reference.m_hash));
+            xfer->xferInt(&reference.m_size);
+            xfer->End_Block();
+        }
+    }
+
+    Utf8String eof(UTF8_LITERAL("SG_EOF"));
+    xfer->xferAsciiString(&eof);
+
+    if (full) {
+        m_incrementalBasePath = xfer->Get_Filename();
+        m_incrementalDependents.clear();
+    } else {
+        auto it = m_incrementalDependents.begin();
+
+        while (it != m_incrementalDependents.end() && it->Compare_No_Case(xfer->Get_Filename()) != 0) {
+            ++it;
+        }
+
+        if (it == m_incrementalDependents.end()) {
+            m_incrementalDependents.push_back(xfer->Get_Filename());
+        }
     }
+
+    return XFER_STATUS_OK;
 }
 
+/**
+ * Forgets the last full save, the next incremental save will be a full one.
+ */
+void GameState::Clear_Incremental_Base()
+{
+    m_incrementalBasePath.Clear();
+    m_incrementalBaseBlocks.clear();
+    m_incrementalBaseData.clear();
+    m_incrementalDependents.clear();
+}
+
+const GameState::BaseBlock *GameState::Find_Base_Block(const Utf8String &name) const
+{
+    for (auto it = m_incrementalBaseBlocks.begin(); it != m_incrementalBaseBlocks.end(); ++it) {
+        if (it->m_name == name) {
+            return &*it;
+        }
+    }
+
+    return nullptr;
+}
+
+/**
+ * Returns whether any saves made since the last full save still refer to it. Saves that have been deleted since don't
+ * count.
+ */
+bool GameState::Has_Incremental_Dependents()
+{
+    // The last save may not have reached the disk yet.
+    XferSave::Wait_For_Flush();
+
+    for (auto it = m_incrementalDependents.begin(); it != m_incrementalDependents.end();) {
+        FILE *fp = fopen(it->Str(), "rb");
+
+        if (fp != nullptr) {
+            fclose(fp);
+            ++it;
+        } else {
+            it = m_incrementalDependents.erase(it);
+        }
+    }
+
+    return !m_incrementalDependents.empty();
+}
+
+void GameState::Open_Incremental_Base(Xfer *xfer)
+{
+    Utf8String path;
+    uint64_t id = 0;
+    xfer->Begin_Block();
+    xfer->xferAsciiString(&path);
+    xfer->xferUser(&id, sizeof(id));
+    xfer->End_Block();
+
+    captainslog_debug("GameState::xferSaveData - Loading unchanged blocks from base save '%s'", path.Str());
+    Close_Incremental_Base();
+
+    // The player may have deleted the base, which XferLoad would treat as a programming error.
+    FILE *fp = fopen(path.Str(), "rb");
+
+    if (fp == nullptr) {
+        captainslog_error("GameState::xferSaveData - Base save '%s' not found", path.Str());
+        Fail_Incremental_Load(XFER_STATUS_FILE_NOT_FOUND);
+    }
+
+    fclose(fp);
+    m_incrementalBase = new XferLoad;
+    m_incrementalBase->Open(path);
+
+    if (m_incrementalBase->Get_Filename().Is_Empty()) {
+        Fail_Incremental_Load(XFER_STATUS_READ_ERROR);
+    }
+
+    // A base starts with its id, if it doesn't match the file has been saved over since.
+    Utf8String token;
+    uint64_t base_id = 0;
+    m_incrementalBase->xferAsciiString(&token);
+
+    if (token == UTF8_LITERAL("SG_INCREMENTAL_ID")) {
+        m_incrementalBase->Begin_Block();
+        m_incrementalBase->xferUser(&base_id, sizeof(base_id));
+        m_incrementalBase->End_Block();
+    }
+
+    if (base_id != id) {
+        captainslog_error("GameState::xferSaveData - Base save '%s' has been overwritten", path.Str());
+        Fail_Incremental_Load(XFER_STATUS_READ_ERROR);
+    }
+}
+
+void GameState::Close_Incremental_Base()
+{
+    if (m_incrementalBase != nullptr) {
+        if (!m_incrementalBase->Get_Filename().Is_Empty()) {
+            m_incrementalBase->Close();
+        }
+
+        delete m_incrementalBase;
+        m_incrementalBase = nullptr;
+    }
+}
+
+/**
+ * Stops loading a save whose referenced blocks can't be found, rather than carrying on with them missing.
+ */
+void GameState::Fail_Incremental_Load(XferStatus status)
+{
+    Close_Incremental_Base();
+    throw status;
+}
+
+/**
+ * Moves the base save to the data of the named block. Blocks are referenced in the order they were saved in, so the
+ * search carries on from where the previous one ended.
+ */
+bool GameState::Seek_Base_Block(const Utf8String &name)
+{
+    Utf8String token;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (m_incrementalBase->xferAsciiString(&token); token.Compare_No_Case("SG_EOF") != 0;
+             m_incrementalBase->xferAsciiString(&token)) {
+            int size = m_incrementalBase->Begin_Block();
+
+            if (token == name) {
+                return true;
+            }
+
+            m_incrementalBase->Skip(size);
+        }
+
+        m_incrementalBase->Set_Position(0);
+    }
+
+    return false;
+}
+
+void GameState::Xfer_Block_From_Base(Xfer *xfer, SnapShotType type)
+{
+    BaseBlock reference;
+    xfer->Begin_Block();
+    xfer->xferAsciiString(&reference.m_name);
+    xfer->xferUser(&reference.m_hash, sizeof(reference.m_hash));
+    xfer->xferInt(&reference.m_size);
+    xfer->End_Block();
+
+    SnapShotBlock *block = Find_Block_Info_By_Token(reference.m_name, type);
+
+    if (block == nullptr) {
+        captainslog_debug("GameState::xferSaveData - Skipping unknown referenced block '%s'", reference.m_name.Str());
+        return;
+    }
+
+    if (m_incrementalBase == nullptr || !Seek_Base_Block(reference.m_name)) {
+        captainslog_error(
+            "GameState::xferSaveData - Referenced block '%s' not found in a base save", reference.m_name.Str());
+        Fail_Incremental_Load(XFER_STATUS_NOT_FOUND);
+    }
+
+    // Guards against a damaged base, the id already ruled out one that was saved over.
+    int pos = m_incrementalBase->Get_Position();
+
+    if (m_incrementalBase->Get_Hash(pos, reference.m_size) != reference.m_hash) {
+        captainslog_error("GameState::xferSaveData - Block '%s' in base save '%s' doesn't match",
+            reference.m_name.Str(),
+            m_incrementalBase->Get_Filename().Str());
+        Fail_Incremental_Load(XFER_STATUS_READ_ERROR);
+    }
+
+    m_incrementalBase->xferSnapshot(block->m_snapShot);
+    m_incrementalBase->End_Block();
+    m_incrementalBase->Set_Position(pos + reference.m_size);
+}
+#endif
+
 GameState::SnapShotBlock *GameState::Find_Block_Info_By_Token(Utf8String name, SnapShotType type)
 {
     if (name.Is_Empty()) {
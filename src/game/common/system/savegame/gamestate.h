@@ -19,6 +19,10 @@
 #include "snapshot.h"
 #include "subsysteminterface.h"
 #include "xfer.h"
+#include <vector>
+
+class XferLoad;
+class XferSave;
 
 struct SaveDate
 {
@@ -95,6 +99,13 @@ public:
     bool Is_In_Save_Dir(const Utf8String &path) const;
     void Friend_Xfer_Save_Data_For_CRC(Xfer *xfer, SnapShotType type);
     void Xfer_Save_Data(Xfer *xfer, SnapShotType type);
+    void Add_Snapshot_Block(Utf8String name, SnapShot *snapshot, SnapShotType type);
+
+#ifndef GAME_DLL
+    // Thyme specific: Incremental saves store the blocks that didn't change since the last full save as references to it.
+    XferStatus Xfer_Save_Data_Incremental(XferSave *xfer, SnapShotType type);
+    void Clear_Incremental_Base();
+#endif
 
     bool Is_Loading() const { return m_isLoading; }
     void Set_Pristine_Map_Name(Utf8String path) { m_saveInfo.m_pristineMapPath = path; }
@@ -107,13 +118,40 @@ private:
         Utf8String m_name;
     };
 
+    struct BaseBlock
+    {
+        Utf8String m_name;
+        uint64_t m_hash;
+        int m_offset; // Where the data is kept in m_incrementalBaseData.
+        int m_size;
+    };
+
     SnapShotBlock *Find_Block_Info_By_Token(Utf8String name, SnapShotType type);
+    bool Is_Block_Saved(const Utf8String &name);
+
+#ifndef GAME_DLL
+    const BaseBlock *Find_Base_Block(const Utf8String &name) const;
+    bool Has_Incremental_Dependents();
+    void Open_Incremental_Base(Xfer *xfer);
+    void Close_Incremental_Base();
+    void Fail_Incremental_Load(XferStatus status);
+    bool Seek_Base_Block(const Utf8String &name);
+    void Xfer_Block_From_Base(Xfer *xfer, SnapShotType type);
+#endif
 
     std::list<SnapShotBlock> m_snapShotBlocks[SNAPSHOT_TYPE_COUNT];
     SaveGameInfo m_saveInfo;
     std::list<SnapShot *> m_snapShots;
     AvailableGameInfo *m_availableGames;
     bool m_isLoading;
+#ifndef GAME_DLL
+    Utf8String m_incrementalBasePath;
+    uint64_t m_incrementalBaseId;
+    std::vector<BaseBlock> m_incrementalBaseBlocks;
+    std::vector<uint8_t> m_incrementalBaseData;
+    std::vector<Utf8String> m_incrementalDependents; // Saves that refer to the base.
+    XferLoad *m_incrementalBase;
+#endif
 };
 
 Utf8String Get_Leaf_And_Dir_Name(const Utf8String &path);
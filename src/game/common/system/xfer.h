@@ -87,6 +87,7 @@ public:
     virtual void Set_Options(unsigned options) { m_options |= options; }
     virtual void Clear_Options(unsigned options) { m_options &= ~options; }
     virtual unsigned Get_Options() { return m_options; }
+    const Utf8String &Get_Filename() const { return m_filename; }
 
     virtual void Open(Utf8String filename);
     virtual void Close() = 0;
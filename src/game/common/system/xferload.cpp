@@ -0,0 +1,197 @@
+/**
+ * @file
+ *
+ * @author agent
+ *
+ * @brief Xfer implementation for loading game state from a file.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include "xferload.h"
+#include "compressionmanager.h"
+#include "memdynalloc.h"
+#include "snapshot.h"
+#include "xfersave.h"
+#include <algorithm>
+#include <captainslog.h>
+#include <cstdio>
+#include <cstring>
+
+XferLoad::XferLoad() : m_buffer(nullptr), m_bufferSize(0), m_position(0)
+{
+    m_type = XFER_LOAD;
+}
+
+XferLoad::~XferLoad()
+{
+    if (m_buffer != nullptr) {
+        captainslog_dbgassert(false, "Warning: Xfer file '%s' was left open", m_filename.Str());
+        Close();
+    }
+}
+
+/**
+ * Reads the whole file into memory, decompressing it if it was saved compressed.
+ */
+void XferLoad::Open(Utf8String filename)
+{
+    captainslog_relassert(m_buffer == nullptr,
+        XFER_STATUS_FILE_ALREADY_OPEN,
+        "Cannot open file '%s' cause we've already got '%s' open",
+        filename.Str(),
+        m_filename.Str());
+
+    // A save that is still being written has to reach the disk before it can be read back.
+    XferSave::Wait_For_Flush();
+
+    FILE *fp = fopen(filename.Str(), "rb");
+    captainslog_relassert(fp != nullptr, XFER_STATUS_FILE_NOT_FOUND, "File '%s' not found", filename.Str());
+
+    fseek(fp, 0, SEEK_END);
+    int size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    uint8_t *data = static_cast<uint8_t *>(g_dynamicMemoryAllocator->Allocate_Bytes_No_Zero(std::max(size, 1)));
+    bool read = size <= 0 || fread(data, size, 1, fp) == 1;
+    fclose(fp);
+
+    if (!read) {
+        g_dynamicMemoryAllocator->Free_Bytes(data);
+        captainslog_relassert(false, XFER_STATUS_READ_ERROR, "XferLoad - Error reading file '%s'", filename.Str());
+        return;
+    }
+
+    if (CompressionManager::Is_Data_Compressed(data, size)) {
+        int uncompressed_size = CompressionManager::Get_Uncompressed_Size(data, size);
+        uint8_t *uncompressed =
+            static_cast<uint8_t *>(g_dynamicMemoryAllocator->Allocate_Bytes_No_Zero(std::max(uncompressed_size, 1)));
+        int decompressed_size = CompressionManager::Decompress_Data(data, size, uncompressed, uncompressed_size);
+        g_dynamicMemoryAllocator->Free_Bytes(data);
+
+        if (decompressed_size != uncompressed_size) {
+            g_dynamicMemoryAllocator->Free_Bytes(uncompressed);
+            captainslog_relassert(false, XFER_STATUS_READ_ERROR, "XferLoad - Error decompressing file '%s'", filename.Str());
+            return;
+        }
+
+        data = uncompressed;
+        size = uncompressed_size;
+    }
+
+    Xfer::Open(filename);
+    m_buffer = data;
+    m_bufferSize = std::max(size, 0);
+    m_position = 0;
+}
+
+void XferLoad::Close()
+{
+    captainslog_relassert(m_buffer != nullptr, XFER_STATUS_FILE_NOT_OPEN, "Xfer close called, but no file was open");
+    g_dynamicMemoryAllocator->Free_Bytes(m_buffer);
+    m_buffer = nullptr;
+    m_bufferSize = 0;
+    m_position = 0;
+    m_filename.Clear();
+}
+
+/**
+ * Returns the size of the block that follows.
+ */
+int XferLoad::Begin_Block()
+{
+    captainslog_dbgassert(m_buffer != nullptr, "Xfer begin block - file pointer for '%s' is NULL", m_filename.Str());
+    int size = 0;
+    xferImplementation(&size, sizeof(size));
+
+    return size;
+}
+
+void XferLoad::Skip(int offset)
+{
+    if (offset < 0 || offset > m_bufferSize - m_position) {
+        captainslog_relassert(
+            false, XFER_STATUS_FILE_SEEK_ERROR, "XferLoad - Cannot skip %d bytes in '%s'", offset, m_filename.Str());
+        return;
+    }
+
+    m_position += offset;
+}
+
+void XferLoad::Set_Position(int pos)
+{
+    if (pos < 0 || pos > m_bufferSize) {
+        captainslog_relassert(
+            false, XFER_STATUS_FILE_SEEK_ERROR, "XferLoad - Cannot seek to %d in '%s'", pos, m_filename.Str());
+        return;
+    }
+
+    m_position = pos;
+}
+
+/**
+ * Returns a hash of size bytes of the file from pos, or 0 if they are not all in the file.
+ */
+uint64_t XferLoad::Get_Hash(int pos, int size) const
+{
+    if (pos < 0 || size < 0 || size > m_bufferSize - pos) {
+        return 0;
+    }
+
+    return XferSave::Hash_Data(&m_buffer[pos], size);
+}
+
+void XferLoad::xferSnapshot(SnapShot *thing)
+{
+    if (thing != nullptr) {
+        thing->Xfer_Snapshot(this);
+    }
+}
+
+void XferLoad::xferAsciiString(Utf8String *thing)
+{
+    uint16_t len = 0;
+    xferUnsignedShort(&len);
+
+    if (len != 0) {
+        char *buffer = thing->Get_Buffer_For_Read(len);
+        xferUser(buffer, len);
+        buffer[len] = '\0';
+    } else {
+        thing->Clear();
+    }
+}
+
+void XferLoad::xferUnicodeString(Utf16String *thing)
+{
+    uint8_t len = 0;
+    xferUnsignedByte(&len);
+
+    if (len != 0) {
+        unichar_t *buffer = thing->Get_Buffer_For_Read(len);
+        xferUser(buffer, len * sizeof(unichar_t));
+        buffer[len] = 0;
+    } else {
+        thing->Clear();
+    }
+}
+
+void XferLoad::xferImplementation(void *thing, int size)
+{
+    if (thing != nullptr && size >= 1) {
+        captainslog_dbgassert(m_buffer != nullptr, "XferLoad - file pointer for '%s' is NULL", m_filename.Str());
+
+        if (size > m_bufferSize - m_position) {
+            captainslog_relassert(
+                false, XFER_STATUS_READ_ERROR, "XferLoad - Error reading from file '%s'", m_filename.Str());
+            return;
+        }
+
+        memcpy(thing, &m_buffer[m_position], size);
+        m_position += size;
+    }
+}
@@ -0,0 +1,46 @@
+/**
+ * @file
+ *
+ * @author agent
+ *
+ * @brief Xfer implementation for loading game state from a file.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#pragma once
+
+#include "always.h"
+#include "xfer.h"
+
+// Thyme specific: The file is read into memory in one go on opening and decompressed if it was saved compressed.
+class XferLoad : public Xfer
+{
+public:
+    XferLoad();
+    virtual ~XferLoad() override;
+
+    virtual void Open(Utf8String filename) override;
+    virtual void Close() override;
+    virtual int Begin_Block() override;
+    virtual void End_Block() override {}
+    virtual void Skip(int offset) override;
+
+    virtual void xferSnapshot(SnapShot *thing) override;
+    virtual void xferAsciiString(Utf8String *thing) override;
+    virtual void xferUnicodeString(Utf16String *thing) override;
+    virtual void xferImplementation(void *thing, int size) override;
+
+    int Get_Position() const { return m_position; }
+    void Set_Position(int pos);
+    uint64_t Get_Hash(int pos, int size) const;
+
+private:
+    uint8_t *m_buffer;
+    int m_bufferSize;
+    int m_position;
+};
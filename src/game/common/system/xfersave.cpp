@@ -0,0 +1,412 @@
+/**
+ * @file
+ *
+ * @author agent
+ *
+ * @brief Xfer implementation for saving game state to a file.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include "xfersave.h"
+#include "memdynalloc.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <captainslog.h>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+enum
+{
+    XFER_SAVE_MIN_CAPACITY = 64 * 1024,
+};
+
+// Compresses closed saves and writes them to disk on a thread that is started with the first save and kept until
+// shutdown. Only the main thread saves, so there is never more than one flush in flight.
+class XferFlushThread
+{
+public:
+    XferFlushThread() :
+        m_buffer(nullptr),
+        m_size(0),
+        m_compression(COMPRESSION_NONE),
+        m_status(XFER_STATUS_OK),
+        m_pending(false),
+        m_stop(false)
+    {
+    }
+
+    ~XferFlushThread() { Shutdown(); }
+
+    void Flush(const char *filename, uint8_t *buffer, int size, CompressionType compression);
+    XferStatus Wait();
+    void Shutdown();
+
+private:
+    void Thread_Function();
+    XferStatus Write();
+
+    std::thread m_thread;
+    std::mutex m_lock;
+    std::condition_variable m_signal; // Signalled when a flush is handed over, finished, or the thread has to stop.
+    Utf8String m_filename;
+    uint8_t *m_buffer;
+    int m_size;
+    CompressionType m_compression;
+    XferStatus m_status; // Result of the last flush.
+    bool m_pending;
+    bool m_stop;
+};
+
+XferFlushThread g_flushThread;
+
+/**
+ * Finishes the last flush and stops the thread, the next flush starts it again.
+ */
+void XferFlushThread::Shutdown()
+{
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_stop = true;
+    }
+
+    m_signal.notify_all();
+    m_thread.join();
+    m_stop = false;
+}
+
+/**
+ * Hands a buffer to the thread to be written, taking ownership of it. Waits for the previous flush first.
+ */
+void XferFlushThread::Flush(const char *filename, uint8_t *buffer, int size, CompressionType compression)
+{
+    Wait();
+
+    {
+        std::lock_guard<std::mutex> lock(m_lock);
+        m_filename = filename;
+        m_buffer = buffer;
+        m_size = size;
+        m_compression = compression;
+        m_pending = true;
+    }
+
+    if (!m_thread.joinable()) {
+        m_thread = std::thread(&XferFlushThread::Thread_Function, this);
+    }
+
+    m_signal.notify_all();
+}
+
+XferStatus XferFlushThread::Wait()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+    m_signal.wait(lock, [this] { return !m_pending; });
+
+    return m_status;
+}
+
+void XferFlushThread::Thread_Function()
+{
+    std::unique_lock<std::mutex> lock(m_lock);
+
+    for (;;) {
+        m_signal.wait(lock, [this] { return m_pending || m_stop; });
+
+        if (!m_pending) {
+            return;
+        }
+
+        lock.unlock();
+        XferStatus status = Write();
+        lock.lock();
+        m_status = status;
+        m_pending = false;
+        m_signal.notify_all();
+    }
+}
+
+/**
+ * Writes the buffer out and frees it. Nothing is written if the save can't be compressed as asked.
+ */
+XferStatus XferFlushThread::Write()
+{
+    XferStatus status = XFER_STATUS_OK;
+    uint8_t *data = m_buffer;
+    int size = m_size;
+    uint8_t *compressed = nullptr;
+
+    if (m_compression != COMPRESSION_NONE && m_size > 0) {
+        int max_size = CompressionManager::Get_Max_Compressed_Size(m_size, m_compression);
+        size = 0;
+
+        if (max_size > 0) {
+            compressed = static_cast<uint8_t *>(g_dynamicMemoryAllocator->Allocate_Bytes_No_Zero(max_size));
+            size = CompressionManager::Compress_Data(m_compression, m_buffer, m_size, compressed, max_size);
+            data = compressed;
+        }
+
+        if (size <= 0) {
+            captainslog_error("XferSave - Failed to compress '%s'", m_filename.Str());
+            status = XFER_STATUS_WRITE_ERROR;
+        }
+    }
+
+    if (status == XFER_STATUS_OK) {
+        FILE *fp = fopen(m_filename.Str(), "wb");
+
+        if (fp != nullptr) {
+            if (size > 0 && fwrite(data, size, 1, fp) != 1) {
+                captainslog_error("XferSave - Error writing to file '%s'", m_filename.Str());
+                status = XFER_STATUS_WRITE_ERROR;
+            }
+
+            if (fclose(fp) != 0 && status == XFER_STATUS_OK) {
+                captainslog_error("XferSave - Error writing to file '%s'", m_filename.Str());
+                status = XFER_STATUS_WRITE_ERROR;
+            }
+        } else {
+            captainslog_error("XferSave - Unable to open file '%s' for writing", m_filename.Str());
+            status = XFER_STATUS_FILE_NOT_FOUND;
+        }
+    }
+
+    if (compressed != nullptr) {
+        g_dynamicMemoryAllocator->Free_Bytes(compressed);
+    }
+
+    g_dynamicMemoryAllocator->Free_Bytes(m_buffer);
+    m_buffer = nullptr;
+
+    // The string must not outlive the memory manager, the thread object is only destroyed on exit.
+    m_filename.Clear();
+
+    return status;
+}
+} // namespace
+
+XferSave::XferSave() : m_buffer(nullptr), m_bufferSize(0), m_bufferCapacity(0), m_compression(COMPRESSION_NONE)
+{
+    m_type = XFER_SAVE;
+}
+
+XferSave::~XferSave()
+{
+    if (m_buffer != nullptr) {
+        captainslog_dbgassert(false, "Warning: Xfer file '%s' was left open", m_filename.Str());
+        Close();
+    }
+}
+
+void XferSave::Open(Utf8String filename)
+{
+    captainslog_relassert(m_buffer == nullptr,
+        XFER_STATUS_FILE_ALREADY_OPEN,
+        "Cannot open file '%s' cause we've already got '%s' open",
+        filename.Str(),
+        m_filename.Str());
+    Xfer::Open(filename);
+    m_bufferSize = 0;
+    m_bufferCapacity = XFER_SAVE_MIN_CAPACITY;
+    m_buffer = static_cast<uint8_t *>(g_dynamicMemoryAllocator->Allocate_Bytes_No_Zero(m_bufferCapacity));
+    m_blockStack.clear();
+}
+
+/**
+ * Hands the collected data to a worker thread to be compressed and written, so closing doesn't wait on the disk.
+ */
+void XferSave::Close()
+{
+    captainslog_relassert(m_buffer != nullptr, XFER_STATUS_FILE_NOT_OPEN, "Xfer close called, but no file was open");
+    captainslog_dbgassert(m_blockStack.empty(), "XferSave - File '%s' closed with blocks still open", m_filename.Str());
+
+    // Waits for the previous save, which may be of the same file, before handing this one over.
+    g_flushThread.Flush(m_filename.Str(), m_buffer, m_bufferSize, m_compression);
+
+    m_buffer = nullptr;
+    m_bufferSize = 0;
+    m_bufferCapacity = 0;
+    m_blockStack.clear();
+    m_filename.Clear();
+}
+
+/**
+ * Closes the file without writing it, whatever was on disk is left as it was.
+ */
+void XferSave::Discard()
+{
+    captainslog_relassert(m_buffer != nullptr, XFER_STATUS_FILE_NOT_OPEN, "Xfer discard called, but no file was open");
+    g_dynamicMemoryAllocator->Free_Bytes(m_buffer);
+    m_buffer = nullptr;
+    m_bufferSize = 0;
+    m_bufferCapacity = 0;
+    m_blockStack.clear();
+    m_filename.Clear();
+}
+
+/**
+ * Blocks until the last closed save is on disk and returns whether it was written. Must be called before reading a
+ * save back.
+ */
+XferStatus XferSave::Wait_For_Flush()
+{
+    return g_flushThread.Wait();
+}
+
+/**
+ * Finishes writing the last closed save and stops the thread that writes them. Call before shutting down the memory
+ * manager.
+ */
+void XferSave::Shutdown_Flush()
+{
+    g_flushThread.Shutdown();
+}
+
+/**
+ * Returns the data written since pos, which is Get_Position() - pos bytes long.
+ */
+const uint8_t *XferSave::Get_Data(int pos) const
+{
+    captainslog_dbgassert(pos >= 0 && pos <= m_bufferSize, "XferSave - Position %d is out of range", pos);
+    return &m_buffer[pos];
+}
+
+/**
+ * Drops the data written since pos.
+ */
+void XferSave::Truncate(int pos)
+{
+    captainslog_dbgassert(pos >= 0 && pos <= m_bufferSize, "XferSave - Position %d is out of range", pos);
+    captainslog_dbgassert(m_blockStack.empty() || m_blockStack.back() < pos, "XferSave - Cannot truncate an open block");
+    m_bufferSize = pos;
+}
+
+/**
+ * 64 bit FNV-1a over whole words with extra mixing, fast enough to hash every block of a save as it is written.
+ */
+uint64_t XferSave::Hash_Data(const void *data, int size)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint64_t hash = 0xCBF29CE484222325ull ^ uint64_t(size);
+    int i = 0;
+
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, &bytes[i], sizeof(word));
+        hash = (hash ^ word) * 0x100000001B3ull;
+        hash ^= hash >> 32;
+    }
+
+    for (; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+    }
+
+    return hash ^ (hash >> 29);
+}
+
+/**
+ * Writes a placeholder for the block size which End_Block fills in once the size is known.
+ */
+int XferSave::Begin_Block()
+{
+    captainslog_dbgassert(m_buffer != nullptr, "Xfer begin block - file pointer for '%s' is NULL", m_filename.Str());
+    int size = 0;
+    m_blockStack.push_back(m_bufferSize);
+    xferImplementation(&size, sizeof(size));
+
+    return 0;
+}
+
+void XferSave::End_Block()
+{
+    captainslog_relassert(
+        !m_blockStack.empty(), XFER_STATUS_NO_BEGIN_BLOCK, "Xfer end block called, but no matching begin block was found");
+    int pos = m_blockStack.back();
+    int size = m_bufferSize - pos - sizeof(size);
+    m_blockStack.pop_back();
+    memcpy(&m_buffer[pos], &size, sizeof(size));
+}
+
+void XferSave::Skip(int offset)
+{
+    captainslog_relassert(
+        offset >= 0, XFER_STATUS_FILE_SEEK_ERROR, "XferSave - Cannot skip backwards in '%s'", m_filename.Str());
+    Reserve(offset);
+    memset(&m_buffer[m_bufferSize], 0, offset);
+    m_bufferSize += offset;
+}
+
+void XferSave::xferSnapshot(SnapShot *thing)
+{
+    if (thing != nullptr) {
+        thing->Xfer_Snapshot(this);
+    }
+}
+
+void XferSave::xferAsciiString(Utf8String *thing)
+{
+    captainslog_relassert(thing->Get_Length() <= 16385,
+        XFER_STATUS_STRING_TOO_LONG,
+        "XferSave cannot save this ascii string because it's too long.  Change the size of the length header (but be sure "
+        "to preserve save file compatability");
+    uint16_t len = thing->Get_Length();
+    xferUnsignedShort(&len);
+
+    if (len != 0) {
+        xferUser(const_cast<char *>(thing->Str()), len);
+    }
+}
+
+void XferSave::xferUnicodeString(Utf16String *thing)
+{
+    captainslog_relassert(thing->Get_Length() <= 255,
+        XFER_STATUS_STRING_TOO_LONG,
+        "XferSave cannot save this unicode string because it's too long.  Change the size of the length header (but be sure "
+        "to preserve save file compatability");
+    uint8_t len = thing->Get_Length();
+    xferUnsignedByte(&len);
+
+    if (len != 0) {
+        xferUser(const_cast<unichar_t *>(thing->Str()), len * sizeof(unichar_t));
+    }
+}
+
+void XferSave::xferImplementation(void *thing, int size)
+{
+    if (thing != nullptr && size >= 1) {
+        captainslog_dbgassert(m_buffer != nullptr, "XferSave - file pointer for '%s' is NULL", m_filename.Str());
+        Reserve(size);
+        memcpy(&m_buffer[m_bufferSize], thing, size);
+        m_bufferSize += size;
+    }
+}
+
+/**
+ * Makes room for size more bytes, growing the buffer geometrically so saving large games copies little.
+ */
+void XferSave::Reserve(int size)
+{
+    if (m_bufferSize + size <= m_bufferCapacity) {
+        return;
+    }
+
+    int capacity = std::max(m_bufferCapacity * 2, m_bufferSize + size);
+    uint8_t *buffer = static_cast<uint8_t *>(g_dynamicMemoryAllocator->Allocate_Bytes_No_Zero(capacity));
+    memcpy(buffer, m_buffer, m_bufferSize);
+    g_dynamicMemoryAllocator->Free_Bytes(m_buffer);
+    m_buffer = buffer;
+    m_bufferCapacity = capacity;
+}
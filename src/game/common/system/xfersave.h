@@ -0,0 +1,63 @@
+/**
+ * @file
+ *
+ * @author agent
+ *
+ * @brief Xfer implementation for saving game state to a file.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#pragma once
+
+#include "always.h"
+#include "compressionmanager.h"
+#include "xfer.h"
+#include <vector>
+
+// Thyme specific: Unlike the original, which wrote every value to the file as it went, the data is collected in memory
+// and written out in one go on a worker thread once the file is closed.
+class XferSave : public Xfer
+{
+public:
+    XferSave();
+    virtual ~XferSave() override;
+
+    virtual void Open(Utf8String filename) override;
+    virtual void Close() override;
+    void Discard();
+    virtual int Begin_Block() override;
+    virtual void End_Block() override;
+    virtual void Skip(int offset) override;
+
+    virtual void xferSnapshot(SnapShot *thing) override;
+    virtual void xferAsciiString(Utf8String *thing) override;
+    virtual void xferUnicodeString(Utf16String *thing) override;
+    virtual void xferImplementation(void *thing, int size) override;
+
+    // Compresses the whole file when it is written, the original game can only read COMPRESSION_NONE files.
+    void Set_Compression(CompressionType type) { m_compression = type; }
+    CompressionType Get_Compression() const { return m_compression; }
+
+    // Access to the data written so far, so that blocks can be compared against earlier saves.
+    int Get_Position() const { return m_bufferSize; }
+    const uint8_t *Get_Data(int pos) const;
+    void Truncate(int pos);
+
+    static XferStatus Wait_For_Flush();
+    static void Shutdown_Flush();
+    static uint64_t Hash_Data(const void *data, int size);
+
+private:
+    void Reserve(int size);
+
+    uint8_t *m_buffer;
+    int m_bufferSize;
+    int m_bufferCapacity;
+    std::vector<int> m_blockStack;
+    CompressionType m_compression;
+};
@@ -370,7 +370,7 @@ ScriptAction *ScriptAction::Parse_Action(DataChunkInput &input, DataChunkInfo *i
                 action->m_numParams = 2;
                 action->m_params[1] = action->m_params[0];
                 action->m_params[0] = new Parameter(Parameter::SIDE);
-                action->m_params[0]->Set_String("<This Player>");
+                action->m_params[0]->Set_String(UTF8_LITERAL("<This Player>"));
             }
 
             break;
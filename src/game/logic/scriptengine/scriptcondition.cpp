@@ -207,7 +207,7 @@ bool Condition::Parse_Condition_Data_Chunk(DataChunkInput &input, DataChunkInfo
         new_condition->m_numParams = 2;
         new_condition->m_params[1] = new_condition->m_params[0];
         new_condition->m_params[0] = new Parameter(Parameter::SIDE);
-        new_condition->m_params[0]->Set_String("<This Player>");
+        new_condition->m_params[0]->Set_String(UTF8_LITERAL("<This Player>"));
     }
 
     if (condition_template->Get_Num_Parameters() != new_condition->Get_Num_Parameters()) {
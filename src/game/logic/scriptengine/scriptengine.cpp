@@ -5404,7 +5404,7 @@ Player *ScriptEngine::Get_Player_From_AsciiString(const Utf8String &player_name)
         return g_thePlayerList->Get_Local_Player();
     }
 
-    if (player_name == "<This Player>") {
+    if (player_name == UTF8_LITERAL("<This Player>")) {
         return Get_Current_Player();
     }
 
@@ -5508,7 +5508,7 @@ Team *ScriptEngine::Get_Team_Named(const Utf8String &team_name)
 
     if (team_name == "teamThePlayer" && is_challenge_campaign) {
         return g_thePlayerList->Get_Local_Player()->Get_Default_Team();
-    } else if (team_name == "<This Team>") {
+    } else if (team_name == UTF8_LITERAL("<This Team>")) {
         if (m_callingTeam != nullptr) {
             return m_callingTeam;
         } else {
@@ -33,6 +33,7 @@
 #include "w3ddisplay.h"
 #include "win32compat.h"
 #include "win32mouse.h"
+#include "xfersave.h"
 #include <algorithm>
 #include <captainslog.h>
 #include <cstdio>
@@ -700,6 +701,8 @@ int main(int argc, char **argv)
     Game_Main(argc, argv);
     captainslog_info("Game shutting down.");
 
+    XferSave::Shutdown_Flush();
+
     delete g_theVersion;
     g_theVersion = nullptr;
 
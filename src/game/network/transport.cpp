@@ -19,6 +19,50 @@
 #include "rtsutils.h"
 #include "sockets.h"
 
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define TRANSPORT_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/**
+ * Returns the index of the lowest set bit, value must not be 0.
+ */
+static inline int Lowest_Bit(uint32_t value)
+{
+#if defined __GNUC__ || defined __clang__
+    return __builtin_ctz(value);
+#elif defined _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return int(index);
+#else
+    int index = 0;
+
+    while ((value & 1) == 0) {
+        value >>= 1;
+        ++index;
+    }
+
+    return index;
+#endif
+}
+
+#ifdef TRANSPORT_USE_SSE2
+/**
+ * Swaps the byte order of each 32 bit lane, the same as htobe32 does on the little endian targets that have SSE2.
+ */
+static inline __m128i Byte_Swap_32(__m128i value)
+{
+    value = _mm_shufflehi_epi16(_mm_shufflelo_epi16(value, 0xB1), 0xB1);
+
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+#endif
+
 /**
  * Initialises the packet transport system.
  *
@@ -75,10 +119,7 @@ bool Transport::Init(uint32_t address, uint16_t port)
         return false;
     }
 
-    for (int i = 0; i < BUFFER_COUNT; ++i) {
-        m_inBuffer[i].length = 0;
-        m_outBuffer[i].length = 0;
-    }
+    Clear_Buffers();
 
     for (int i = 0; i < STATS_COUNT; ++i) {
         m_incomingBytes[i] = 0;
@@ -160,23 +201,60 @@ bool Transport::Do_Send()
         m_unknownBytes[m_statisticsSlot] = 0;
     }
 
-    for (int i = 0; i < BUFFER_COUNT; ++i) {
-        if (m_outBuffer[i].length != 0) {
-            // Send the packet and free up the buffer if it succeeds, otherwise return that not all packets sent.
-            if (m_udpsock->Write(reinterpret_cast<uint8_t *>(&m_outBuffer[i]),
-                    m_outBuffer[i].length + sizeof(TransportMessageHeader),
-                    m_outBuffer[i].addr,
-                    m_outBuffer[i].port)
-                <= 0) {
-                all_sent = false;
-            } else {
-                ++m_outgoingPackets[m_statisticsSlot];
-                m_outgoingBytes[m_statisticsSlot] += m_outBuffer[i].length + sizeof(TransportMessageHeader);
-                m_outBuffer[i].length = 0;
+    UDPDatagram datagrams[UDP::MAX_BATCH];
+    int slots[UDP::MAX_BATCH];
+    int count = 0;
+
+    // Gather the queued packets in slot order and hand them to the socket a batch at a time.
+    for (int word = 0; word < BITMAP_WORDS; ++word) {
+        for (uint32_t bits = m_outUsed[word]; bits != 0; bits &= bits - 1) {
+            int slot = word * 32 + Lowest_Bit(bits);
+            slots[count] = slot;
+            datagrams[count].buffer = reinterpret_cast<uint8_t *>(&m_outBuffer[slot]);
+            datagrams[count].length = m_outBuffer[slot].length + sizeof(TransportMessageHeader);
+            datagrams[count].address = m_outBuffer[slot].addr;
+            datagrams[count].port = m_outBuffer[slot].port;
+
+            if (++count == UDP::MAX_BATCH) {
+                all_sent = Send_Batch(datagrams, slots, count) && all_sent;
+                count = 0;
             }
         }
     }
 
+    if (count != 0) {
+        all_sent = Send_Batch(datagrams, slots, count) && all_sent;
+    }
+
+    return all_sent;
+}
+
+/**
+ * Sends a batch of queued packets and frees up the buffers of those that were sent.
+ */
+bool Transport::Send_Batch(const UDPDatagram *datagrams, const int *slots, int count)
+{
+    bool all_sent = true;
+
+    for (int i = 0; i < count;) {
+        int sent = m_udpsock->Write_Batch(&datagrams[i], count - i);
+
+        // A packet that fails to send stays queued for the next update, carry on with the ones after it.
+        if (sent <= 0) {
+            all_sent = false;
+            ++i;
+
+            continue;
+        }
+
+        for (int end = i + sent; i < end; ++i) {
+            ++m_outgoingPackets[m_statisticsSlot];
+            m_outgoingBytes[m_statisticsSlot] += datagrams[i].length;
+            m_outBuffer[slots[i]].length = 0;
+            m_outUsed[slots[i] / 32] &= ~(1u << (slots[i] % 32));
+        }
+    }
+
     return all_sent;
 }
 
@@ -187,47 +265,109 @@ bool Transport::Do_Send()
  */
 bool Transport::Do_Recv()
 {
-    sockaddr_in from;
-    TransportMessage incoming;
-    int now = rts::Get_Time();
-    int len;
+    // #BUGFIX Don't use the socket if Init failed, Do_Send already checks this.
+    if (m_udpsock == nullptr) {
+        return false;
+    }
+
+    for (;;) {
+        UDPDatagram datagrams[UDP::MAX_BATCH];
+        int slots[UDP::MAX_BATCH];
+        TransportMessage overflow;
+        int count = 0;
+
+        // #BUGFIX Look for free slots in the incoming buffers rather than the outgoing ones, packets are received
+        // straight into them. A slot is in use while its length is set, the network code frees slots by clearing it.
+        for (int i = 0; i < BUFFER_COUNT && count < UDP::MAX_BATCH; ++i) {
+            if (m_inBuffer[i].length == 0) {
+                slots[count++] = i;
+            }
+        }
+
+        // With every slot in use packets are still read one at a time for the stats, but then dropped.
+        if (count == 0) {
+            slots[count++] = -1;
+        }
 
-    for (len = m_udpsock->Read(reinterpret_cast<uint8_t *>(&incoming), 1024, &from); len > 0;
-         len = m_udpsock->Read(reinterpret_cast<uint8_t *>(&incoming), sizeof(incoming), &from)) {
-        Reveal(&incoming, len);
-        incoming.length = len - sizeof(TransportMessageHeader);
+        for (int i = 0; i < count; ++i) {
+            TransportMessage *msg = slots[i] >= 0 ? &m_inBuffer[slots[i]] : &overflow;
+            datagrams[i].buffer = reinterpret_cast<uint8_t *>(msg);
+            datagrams[i].length = sizeof(msg->header) + sizeof(msg->data);
+        }
 
-        // If we don't have a packet that looks like it was meant for us, ignore it and log it for stats.
-        if (len <= 6 || !Is_Thyme_Packet(&incoming)) {
-            ++m_unknownPackets[m_statisticsSlot];
-            m_unknownBytes[m_statisticsSlot] += len;
+        int received = m_udpsock->Read_Batch(datagrams, count);
 
-            continue;
+        if (received == SOCKET_ERROR) {
+            return false;
         }
 
-        ++m_incomingPackets[m_statisticsSlot];
-        m_incomingBytes[m_statisticsSlot] += len;
-        int free_slot = 0;
+        for (int i = 0; i < received; ++i) {
+            TransportMessage *msg = reinterpret_cast<TransportMessage *>(datagrams[i].buffer);
+            int len = datagrams[i].length;
+            Reveal(msg, len);
+            msg->length = len - sizeof(TransportMessageHeader);
+
+            // If we don't have a packet that looks like it was meant for us, ignore it and log it for stats.
+            if (len <= 6 || !Is_Thyme_Packet(msg)) {
+                ++m_unknownPackets[m_statisticsSlot];
+                m_unknownBytes[m_statisticsSlot] += len;
+                msg->length = 0;
 
-        // Find a free slot
-        while (m_outBuffer[free_slot++].length != 0) {
-            if (free_slot == BUFFER_COUNT) {
                 continue;
             }
+
+            ++m_incomingPackets[m_statisticsSlot];
+            m_incomingBytes[m_statisticsSlot] += len;
+
+            if (slots[i] >= 0) {
+                msg->addr = datagrams[i].address;
+                msg->port = datagrams[i].port;
+            }
         }
 
-        // Copy the data into it.
-        m_inBuffer[free_slot].length = incoming.length;
-        m_inBuffer[free_slot].addr = be32toh(from.sin_addr.s_addr);
-        m_inBuffer[free_slot].port = be16toh(from.sin_port);
-        memcpy(&m_inBuffer[free_slot], &incoming, len);
+        // The socket had no more packets waiting.
+        if (received < count) {
+            return true;
+        }
     }
+}
 
-    if (len == SOCKET_ERROR) {
-        return false;
+/**
+ * Finds the next incoming buffer slot at or after the one provided that holds a received message. Returns -1 when
+ * there are none.
+ */
+int Transport::Next_Incoming(int slot) const
+{
+    for (; slot < BUFFER_COUNT; ++slot) {
+        if (m_inBuffer[slot].length != 0) {
+            return slot;
+        }
     }
 
-    return true;
+    return -1;
+}
+
+/**
+ * Frees up an incoming buffer slot once its message has been handled.
+ */
+void Transport::Release_Incoming(int slot)
+{
+    m_inBuffer[slot].length = 0;
+}
+
+/**
+ * Marks all buffer slots as free.
+ */
+void Transport::Clear_Buffers()
+{
+    for (int i = 0; i < BUFFER_COUNT; ++i) {
+        m_inBuffer[i].length = 0;
+        m_outBuffer[i].length = 0;
+    }
+
+    for (int i = 0; i < BITMAP_WORDS; ++i) {
+        m_outUsed[i] = 0;
+    }
 }
 
 /**
@@ -241,14 +381,22 @@ bool Transport::Queue_Send(uint32_t addr, uint16_t port, const char *buf, int le
         return false;
     }
 
-    int free_slot = 0;
+    // #BUGFIX Use the free slot that was found rather than the one after it.
+    int free_slot = -1;
 
-    while (m_outBuffer[free_slot++].length != 0) {
-        if (free_slot == BUFFER_COUNT) {
-            return false;
+    for (int word = 0; word < BITMAP_WORDS; ++word) {
+        if (m_outUsed[word] != 0xFFFFFFFFu) {
+            free_slot = word * 32 + Lowest_Bit(~m_outUsed[word]);
+            break;
         }
     }
 
+    if (free_slot < 0) {
+        return false;
+    }
+
+    m_outUsed[free_slot / 32] |= 1u << (free_slot % 32);
+
     // Prepare our chosen buffer slot with the data to send and where to send it.
     m_outBuffer[free_slot].length = len;
     memcpy(m_outBuffer[free_slot].data, buf, len);
@@ -289,6 +437,20 @@ void Transport::Obfuscate(void *data, int len)
     int mix_magic = OBFUSCATE_NUM;
     uint32_a *block = static_cast<uint32_a *>(data); // Using aliasing type to keep GCC/Clang from doing the wrong thing.
 
+#ifdef TRANSPORT_USE_SSE2
+    // Four words at a time, each lane keeps its own magic.
+    __m128i mix = _mm_setr_epi32(mix_magic, mix_magic + 801, mix_magic + 801 * 2, mix_magic + 801 * 3);
+    const __m128i step = _mm_set1_epi32(801 * 4);
+
+    for (; count >= 4; count -= 4) {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(block), Byte_Swap_32(_mm_xor_si128(mix, words)));
+        mix = _mm_add_epi32(mix, step);
+        mix_magic += 801 * 4;
+        block += 4;
+    }
+#endif
+
     while (count--) {
         *block = htobe32(mix_magic ^ *block);
         ++block;
@@ -305,6 +467,19 @@ void Transport::Reveal(void *data, int len)
     int mix_magic = OBFUSCATE_NUM;
     uint32_a *block = static_cast<uint32_a *>(data); // Using aliasing type to keep GCC/Clang from doing the wrong thing.
 
+#ifdef TRANSPORT_USE_SSE2
+    __m128i mix = _mm_setr_epi32(mix_magic, mix_magic + 801, mix_magic + 801 * 2, mix_magic + 801 * 3);
+    const __m128i step = _mm_set1_epi32(801 * 4);
+
+    for (; count >= 4; count -= 4) {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(block), _mm_xor_si128(mix, Byte_Swap_32(words)));
+        mix = _mm_add_epi32(mix, step);
+        mix_magic += 801 * 4;
+        block += 4;
+    }
+#endif
+
     while (count--) {
         *block = mix_magic ^ htobe32(*block);
         ++block;
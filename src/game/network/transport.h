@@ -39,13 +39,18 @@ class Transport
     enum
     {
         BUFFER_COUNT = 128,
+        BITMAP_WORDS = BUFFER_COUNT / 32,
         STATS_COUNT = 30,
         MAGIC_NUM = 0xF00D,
         OBFUSCATE_NUM = 0xFADE,
     };
 
 public:
-    Transport() : m_winsockInit(false), m_udpsock(nullptr) {}
+    Transport() : m_winsockInit(false), m_udpsock(nullptr)
+    {
+        // #BUGFIX Initialize all members
+        Clear_Buffers();
+    }
     ~Transport() { Reset(); }
 
     bool Init(uint32_t address, uint16_t port);
@@ -60,9 +65,28 @@ public:
             m_udpsock->Allow_Broadcasts(allow);
     }
 
-private:
+    // The port the socket is bound to, chosen by the system when Init was given port 0.
+    uint16_t Get_Local_Port() const
+    {
+        uint32_t address = 0;
+        uint16_t port = 0;
+
+        if (m_udpsock != nullptr)
+            m_udpsock->Get_Local_Addr(address, port);
+
+        return port;
+    }
+
+    int Next_Incoming(int slot) const;
+    TransportMessage &Get_Incoming(int slot) { return m_inBuffer[slot]; }
+    void Release_Incoming(int slot);
+
     static void Obfuscate(void *data, int len);
     static void Reveal(void *data, int len);
+
+private:
+    void Clear_Buffers();
+    bool Send_Batch(const UDPDatagram *datagrams, const int *slots, int count);
     static bool Is_Thyme_Packet(const TransportMessage *msg);
 
 private:
@@ -81,4 +105,5 @@ private:
     uint32_t m_outgoingPackets[STATS_COUNT];
     int32_t m_statisticsSlot;
     uint32_t m_lastSecond;
+    uint32_t m_outUsed[BITMAP_WORDS]; // Set bits mark buffer slots that hold a message.
 };
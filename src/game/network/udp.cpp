@@ -120,6 +120,123 @@ int UDP::Read(const uint8_t *buffer, int length, sockaddr_in *from)
     return 0;
 }
 
+/**
+ * Sends several datagrams with as few calls into the socket api as the platform allows. Returns how many datagrams
+ * from the start of the list were sent before the first one that failed, or -1 if the first one failed. Call
+ * Get_Status for the reason of a failure.
+ */
+int UDP::Write_Batch(const UDPDatagram *datagrams, int count)
+{
+    if (count > MAX_BATCH) {
+        count = MAX_BATCH;
+    }
+
+    Clear_Status();
+
+#ifdef PLATFORM_LINUX
+    mmsghdr headers[MAX_BATCH];
+    iovec vectors[MAX_BATCH];
+    sockaddr_in to[MAX_BATCH];
+
+    for (int i = 0; i < count; ++i) {
+        to[i] = sockaddr_in{};
+        to[i].sin_family = AF_INET;
+        to[i].sin_port = htobe16(datagrams[i].port);
+        to[i].sin_addr.s_addr = htobe32(datagrams[i].address);
+        vectors[i].iov_base = datagrams[i].buffer;
+        vectors[i].iov_len = datagrams[i].length;
+        headers[i] = mmsghdr{};
+        headers[i].msg_hdr.msg_name = &to[i];
+        headers[i].msg_hdr.msg_namelen = sizeof(to[i]);
+        headers[i].msg_hdr.msg_iov = &vectors[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int result = sendmmsg(m_fd, headers, count, 0);
+
+    if (result == SOCKET_ERROR) {
+        m_status = LastSocketError;
+    }
+
+    return result;
+#else
+    int sent = 0;
+
+    for (; sent < count; ++sent) {
+        if (Write(datagrams[sent].buffer, datagrams[sent].length, datagrams[sent].address, datagrams[sent].port)
+            == SOCKET_ERROR) {
+            return sent != 0 ? sent : SOCKET_ERROR;
+        }
+    }
+
+    return sent;
+#endif
+}
+
+/**
+ * Receives as many waiting datagrams as fit in the list, filling in the length and sender of each. Returns the number
+ * received, 0 if nothing was waiting or -1 on all other errors.
+ */
+int UDP::Read_Batch(UDPDatagram *datagrams, int count)
+{
+    if (count > MAX_BATCH) {
+        count = MAX_BATCH;
+    }
+
+#ifdef PLATFORM_LINUX
+    mmsghdr headers[MAX_BATCH];
+    iovec vectors[MAX_BATCH];
+    sockaddr_in from[MAX_BATCH];
+
+    for (int i = 0; i < count; ++i) {
+        vectors[i].iov_base = datagrams[i].buffer;
+        vectors[i].iov_len = datagrams[i].length;
+        headers[i] = mmsghdr{};
+        headers[i].msg_hdr.msg_name = &from[i];
+        headers[i].msg_hdr.msg_namelen = sizeof(from[i]);
+        headers[i].msg_hdr.msg_iov = &vectors[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int result = recvmmsg(m_fd, headers, count, MSG_DONTWAIT, nullptr);
+
+    if (result == SOCKET_ERROR) {
+        if (LastSocketError != SOCKEWOULDBLOCK && LastSocketError != SOCKEAGAIN) {
+            m_status = LastSocketError;
+
+            return SOCKET_ERROR;
+        }
+
+        return 0;
+    }
+
+    for (int i = 0; i < result; ++i) {
+        datagrams[i].length = headers[i].msg_len;
+        datagrams[i].address = be32toh(from[i].sin_addr.s_addr);
+        datagrams[i].port = be16toh(from[i].sin_port);
+    }
+
+    return result;
+#else
+    int received = 0;
+
+    for (; received < count; ++received) {
+        sockaddr_in from;
+        int result = Read(datagrams[received].buffer, datagrams[received].length, &from);
+
+        if (result <= 0) {
+            return received != 0 ? received : result;
+        }
+
+        datagrams[received].length = result;
+        datagrams[received].address = be32toh(from.sin_addr.s_addr);
+        datagrams[received].port = be16toh(from.sin_port);
+    }
+
+    return received;
+#endif
+}
+
 /**
  * Retrieves the last error set by UDP operations. See UDP::SockStatus enum for possible values.
  *
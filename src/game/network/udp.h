@@ -17,9 +17,23 @@
 #include "always.h"
 #include "sockets.h"
 
+// One datagram of a batched read or write. Addresses and ports are in host byte order.
+struct UDPDatagram
+{
+    uint8_t *buffer;
+    int length;
+    uint32_t address;
+    uint16_t port;
+};
+
 class UDP
 {
 public:
+    enum
+    {
+        MAX_BATCH = 32,
+    };
+
     enum SockStatus
     {
         OK = 0,
@@ -53,6 +67,8 @@ public:
     int Bind(uint32_t address, uint16_t port);
     int Write(const uint8_t *buffer, int length, uint32_t address, uint16_t port);
     int Read(const uint8_t *buffer, int length, sockaddr_in *from);
+    int Write_Batch(const UDPDatagram *datagrams, int count);
+    int Read_Batch(UDPDatagram *datagrams, int count);
     int Get_Status();
     void Clear_Status() { m_status = 0; }
     bool Allow_Broadcasts(bool allow);
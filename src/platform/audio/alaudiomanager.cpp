@@ -20,6 +20,8 @@
 #include "globaldata.h"
 #include "playingaudio.h"
 #include "videoplayer.h"
+#include <algorithm>
+#include <chrono>
 
 namespace Thyme
 {
@@ -31,8 +33,16 @@ ALAudioManager::ALAudioManager() :
 #endif
     m_2dSampleCount(0),
     m_3dSampleCount(0),
-    m_streamCount(0)
+    m_streamCount(0),
+    m_sourceEventsEnabled(false),
+    m_sourceEventMutex("ALSourceEventMutex"),
+    m_listenerMoved(true),
+    m_frameStats(),
+    m_positionalSourceCount(0),
+    m_lastPlayingUpdate(std::chrono::steady_clock::now())
 {
+    m_devicePosition.Zero();
+    m_deviceFacing.Zero();
 }
 
 ALAudioManager::~ALAudioManager()
@@ -73,12 +83,18 @@ void ALAudioManager::Reset()
  */
 void ALAudioManager::Update()
 {
+    auto start = std::chrono::steady_clock::now();
+    m_frameStats.source_updates = 0;
+
     AudioManager::Update();
     Set_Device_Listener_Position();
     Process_Request_List();
     Process_Playing_List();
     Process_Fading_List();
     Process_Stopped_List();
+
+    m_frameStats.update_ms =
+        std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
 
 /**
@@ -98,7 +114,10 @@ void ALAudioManager::Stop_Audio(AudioAffect affect)
     if (affect & AUDIOAFFECT_3DSOUND) {
         for (auto it = m_positionalAudioList.begin(); it != m_positionalAudioList.end(); ++it) {
             if (*it != nullptr) {
-                alSourceStop((*it)->openal.source);
+                if (!(*it)->openal.is_virtual) {
+                    alSourceStop((*it)->openal.source);
+                }
+
                 (*it)->openal.stopped = 1;
             }
         }
@@ -134,7 +153,11 @@ void ALAudioManager::Pause_Audio(AudioAffect affect)
     if (affect & AUDIOAFFECT_3DSOUND) {
         for (auto it = m_positionalAudioList.begin(); it != m_positionalAudioList.end(); ++it) {
             if (*it != nullptr) {
-                alSourcePause((*it)->openal.source);
+                if ((*it)->openal.is_virtual) {
+                    (*it)->openal.paused = true;
+                } else {
+                    alSourcePause((*it)->openal.source);
+                }
             }
         }
     }
@@ -177,7 +200,11 @@ void ALAudioManager::Resume_Audio(AudioAffect affect)
     if (affect & AUDIOAFFECT_3DSOUND) {
         for (auto it = m_positionalAudioList.begin(); it != m_positionalAudioList.end(); ++it) {
             if (*it != nullptr) {
-                alSourcePlay((*it)->openal.source);
+                if ((*it)->openal.is_virtual) {
+                    (*it)->openal.paused = false;
+                } else {
+                    alSourcePlay((*it)->openal.source);
+                }
             }
         }
     }
@@ -201,13 +228,8 @@ void ALAudioManager::Resume_Audio(AudioAffect affect)
 void ALAudioManager::Kill_Event_Immediately(uintptr_t event)
 {
     // Iterate the various lists until a matching handle is found.
-    for (auto it = m_audioRequestList.begin(); it != m_audioRequestList.end(); ++it) {
-        if (*it != nullptr && (*it)->Request_Type() == AR_PLAY && (*it)->Event_Handle() == event) {
-            (*it)->Delete_Instance();
-            m_audioRequestList.erase(it);
-
-            return;
-        }
+    if (Cancel_Play_Request(event)) {
+        return;
     }
 
     for (auto it = m_positionalAudioList.begin(); it != m_positionalAudioList.end(); ++it) {
@@ -403,6 +425,8 @@ void ALAudioManager::Open_Device()
 
     Select_Provider(Get_Provider_Index(m_preferredProvider));
     Refresh_Cached_Variables();
+    Enable_Source_Events();
+    m_listenerMoved = true;
 
     captainslog_dbgassert(Check_AL_Error(), "OpenAL error before starting");
     captainslog_dbgassert(Supports_Float_Samples(), "OpenAL implementation doesn't support float samples");
@@ -413,6 +437,7 @@ void ALAudioManager::Open_Device()
  */
 void ALAudioManager::Close_Device()
 {
+    Disable_Source_Events();
     Unselect_Provider();
 
     alcMakeContextCurrent(nullptr);
@@ -957,9 +982,17 @@ void ALAudioManager::Close_Any_Sample_Using_File(const AudioDataHandle handle)
  */
 void ALAudioManager::Set_Device_Listener_Position()
 {
+    // Thyme specific: The listener only moves with the camera, so most frames there is nothing to send.
+    if (!m_listenerMoved && m_listenerPosition == m_devicePosition && m_listenerFacing == m_deviceFacing) {
+        return;
+    }
+
     ALfloat listenerOri[] = { m_listenerFacing.x, m_listenerFacing.y, m_listenerFacing.z, 0.0f, 0.0f, -1.0f };
     alListener3f(AL_POSITION, m_listenerPosition.x, m_listenerPosition.y, m_listenerPosition.z);
     alListenerfv(AL_ORIENTATION, listenerOri);
+    m_devicePosition = m_listenerPosition;
+    m_deviceFacing = m_listenerFacing;
+    m_listenerMoved = true;
 }
 
 /**
@@ -1001,103 +1034,156 @@ PlayingAudio *ALAudioManager::Find_Playing_Audio_From(uintptr_t handle, unsigned
 
 /**
  * Processes the playing audio lists.
+ *
+ * Thyme specific: Finished samples are found through OpenAL source events where available rather than by querying
+ * every source, the lists are compacted in one pass and only positions that changed are sent to OpenAL. Positional
+ * sounds that can't be heard are made virtual instead of being dropped, and get a source again once they are audible.
  */
 void ALAudioManager::Process_Playing_List()
 {
+    bool poll_sources = !m_sourceEventsEnabled;
     ALint source_state;
-    for (auto it = m_globalAudioList.begin(); it != m_globalAudioList.end();) {
-        if (*it != nullptr) {
-            // Check if the audio has finished playing
-            if ((*it)->openal.source) {
-                alGetSourcei((*it)->openal.source, AL_SOURCE_STATE, &source_state);
-                if (source_state == AL_STOPPED)
-                    Notify_Of_Audio_Completion((*it)->openal.source, PAT_2DSAMPLE);
-            }
+    m_frameStats.culled_voices = 0;
+    m_frameStats.state_queries = 0;
 
-            if ((*it)->openal.stopped == 1) {
-                Release_Playing_Audio(*it);
-                it = m_globalAudioList.erase(it);
-            } else {
-                if (m_volumeSet) {
-                    Adjust_Playing_Volume(*it);
-                }
+    if (m_sourceEventsEnabled) {
+        Process_Source_Events();
+    }
 
-                ++it;
-            }
-        } else {
-            it = m_globalAudioList.erase(it);
+    // Released entries are cleared rather than erased, as completion handling may search the lists while they are walked.
+    for (auto it = m_globalAudioList.begin(); it != m_globalAudioList.end(); ++it) {
+        PlayingAudio *audio = *it;
+
+        if (audio == nullptr) {
+            continue;
+        }
+
+        // Check if the audio has finished playing
+        if (poll_sources && audio->openal.source) {
+            alGetSourcei(audio->openal.source, AL_SOURCE_STATE, &source_state);
+            ++m_frameStats.state_queries;
+
+            if (source_state == AL_STOPPED)
+                Notify_Of_Audio_Completion(audio->openal.source, PAT_2DSAMPLE);
+        }
+
+        if (audio->openal.stopped == 1) {
+            *it = nullptr;
+            Release_Playing_Audio(audio);
+        } else if (m_volumeSet) {
+            Adjust_Playing_Volume(audio);
         }
     }
 
-    for (auto it = m_positionalAudioList.begin(); it != m_positionalAudioList.end();) {
-        if (*it != nullptr) {
+    m_globalAudioList.erase(
+        std::remove(m_globalAudioList.begin(), m_globalAudioList.end(), nullptr), m_globalAudioList.end());
+
+    auto now = std::chrono::steady_clock::now();
+    float elapsed_ms = std::chrono::duration<float, std::milli>(now - m_lastPlayingUpdate).count();
+    m_lastPlayingUpdate = now;
+    m_promotableVoices.clear();
+    m_demotableVoices.clear();
+
+    for (auto it = m_positionalAudioList.begin(); it != m_positionalAudioList.end(); ++it) {
+        PlayingAudio *audio = *it;
+
+        if (audio == nullptr) {
+            continue;
+        }
+
+        if (audio->openal.is_virtual) {
+            Advance_Virtual_Voice(audio, elapsed_ms);
+        } else if (poll_sources && audio->openal.source) {
             // Check if the audio has finished playing
-            if ((*it)->openal.source) {
-                alGetSourcei((*it)->openal.source, AL_SOURCE_STATE, &source_state);
-                if (source_state == AL_STOPPED)
-                    Notify_Of_Audio_Completion((*it)->openal.source, PAT_3DSAMPLE);
-            }
+            alGetSourcei(audio->openal.source, AL_SOURCE_STATE, &source_state);
+            ++m_frameStats.state_queries;
 
-            if ((*it)->openal.stopped == 1) {
-                Release_Playing_Audio(*it);
-                it = m_positionalAudioList.erase(it);
-            } else {
-                if (m_volumeSet) {
-                    Adjust_Playing_Volume(*it);
-                }
+            if (source_state == AL_STOPPED)
+                Notify_Of_Audio_Completion(audio->openal.source, PAT_3DSAMPLE);
+        }
 
-                Coord3D *current_pos = (*it)->openal.audio_event->Get_Current_Pos();
+        if (audio->openal.stopped == 1) {
+            *it = nullptr;
+            Release_Playing_Audio(audio);
+            continue;
+        }
 
-                if (current_pos != nullptr) {
-                    if ((*it)->openal.audio_event->Get_Event_Type() == EVENT_UNKVAL3) {
-                        Stop_Audio_Event((*it)->openal.audio_event->Get_Playing_Handle());
-                        ++it;
-                    } else {
-                        float sample_vol = Get_Effective_Volume((*it)->openal.audio_event);
-                        // Is this conditional check incorrect? Original does this but makes no sense.
-                        // BUGFIX TODO should be m3dSoundVolume for the result as well?
-                        sample_vol /= m_3dSoundVolume > 0.0f ? m_soundVolume : 1.0f;
-
-                        if (sample_vol < m_audioSettings->Get_Min_Sample_Vol()
-                            && !(((*it)->openal.audio_event->Get_Event_Info()->Get_Visibility() & VISIBILITY_GLOBAL)
-                                || ((*it)->openal.audio_event->Get_Event_Info()->Get_Priority() == 4))) {
-                            Release_Playing_Audio(*it);
-                            it = m_positionalAudioList.erase(it);
-                        } else {
-                            alSource3f((*it)->openal.source, AL_POSITION, current_pos->x, current_pos->y, current_pos->z);
-                            ++it;
-                        }
-                    }
-                } else {
-                    Release_Playing_Audio(*it);
-                    it = m_positionalAudioList.erase(it);
-                }
+        if (m_volumeSet) {
+            Adjust_Playing_Volume(audio);
+        }
+
+        Coord3D *current_pos = audio->openal.audio_event->Get_Current_Pos();
+
+        if (current_pos == nullptr) {
+            *it = nullptr;
+            Release_Playing_Audio(audio);
+            continue;
+        }
+
+        if (audio->openal.audio_event->Get_Event_Type() == EVENT_UNKVAL3) {
+            Stop_Audio_Event(audio->openal.audio_event->Get_Playing_Handle());
+            continue;
+        }
+
+        bool moved = current_pos->x != audio->openal.position[0] || current_pos->y != audio->openal.position[1]
+            || current_pos->z != audio->openal.position[2];
+
+        // The volume only changes when the sound, the listener or the volume settings do.
+        if (moved || m_listenerMoved || audio->openal.effective_volume < 0.0f) {
+            audio->openal.effective_volume = Get_Sample_Volume(audio->openal.audio_event);
+        }
+
+        if (Is_Inaudible(audio->openal.audio_event, audio->openal.effective_volume)) {
+            // Sounds that can't be heard keep running virtually, or are dropped if their length isn't known.
+            if (!audio->openal.is_virtual && !Virtualize_Voice(audio)) {
+                *it = nullptr;
+                Release_Playing_Audio(audio);
+                ++m_frameStats.culled_voices;
+                continue;
             }
-        } else {
-            it = m_positionalAudioList.erase(it);
+        } else if (audio->openal.is_virtual) {
+            if (!audio->openal.paused) {
+                m_promotableVoices.push_back(audio);
+            }
+        } else if (!(audio->openal.audio_event->Get_Event_Info()->Get_Visibility() & VISIBILITY_GLOBAL)
+            && audio->openal.audio_event->Get_Event_Info()->Get_Priority() != 4) {
+            m_demotableVoices.push_back(audio);
+        }
+
+        if (moved) {
+            Set_Source_Position(audio, *current_pos);
         }
     }
 
-    for (auto it = m_streamList.begin(); it != m_streamList.end();) {
-        if (*it != nullptr) {
-            if ((*it)->openal.stopped == 1) {
-                Release_Playing_Audio(*it);
-                it = m_streamList.erase(it);
-            } else {
-                if (m_volumeSet) {
-                    Adjust_Playing_Volume(*it);
-                }
+    Promote_Virtual_Voices();
 
-                ++it;
-            }
-        } else {
-            it = m_streamList.erase(it);
+    m_positionalAudioList.erase(
+        std::remove(m_positionalAudioList.begin(), m_positionalAudioList.end(), nullptr), m_positionalAudioList.end());
+
+    for (auto it = m_streamList.begin(); it != m_streamList.end(); ++it) {
+        PlayingAudio *audio = *it;
+
+        if (audio == nullptr) {
+            continue;
+        }
+
+        if (audio->openal.stopped == 1) {
+            *it = nullptr;
+            Release_Playing_Audio(audio);
+        } else if (m_volumeSet) {
+            Adjust_Playing_Volume(audio);
         }
     }
 
+    m_streamList.erase(std::remove(m_streamList.begin(), m_streamList.end(), nullptr), m_streamList.end());
+
     if (m_volumeSet) {
         m_volumeSet = false;
     }
+
+    m_listenerMoved = false;
+    m_frameStats.virtualized_voices = int(m_positionalAudioList.size()) - m_positionalSourceCount;
+    m_frameStats.active_voices = int(m_globalAudioList.size() + m_streamList.size()) + m_positionalSourceCount;
 }
 
 /**
@@ -1115,7 +1201,7 @@ void ALAudioManager::Process_Fading_List()
             ++(*it)->openal.time_fading;
             float adjustment = (float)(*it)->openal.time_fading / (float)Get_Audio_Settings()->Get_Time_To_Fade();
             float effective_vol = (float)(1.0f - adjustment) * Get_Effective_Volume((*it)->openal.audio_event);
-            alSourcef((*it)->openal.source, AL_GAIN, effective_vol);
+            Set_Source_Gain(*it, effective_vol);
             ++it;
         } else {
             (*it)->openal.stopped = 1;
@@ -1131,11 +1217,40 @@ void ALAudioManager::Process_Fading_List()
  */
 void ALAudioManager::Process_Stopped_List()
 {
-    for (auto it = m_stoppedList.begin(); it != m_stoppedList.end(); it = m_stoppedList.erase(it)) {
+    for (auto it = m_stoppedList.begin(); it != m_stoppedList.end(); ++it) {
         if (*it != nullptr) {
             Release_Playing_Audio(*it);
         }
     }
+
+    m_stoppedList.clear();
+}
+
+/**
+ * Starts decoding the samples of a sound event so they are ready when it first plays.
+ */
+void ALAudioManager::Prefetch_Audio_Event(const Utf8String &event_name)
+{
+    AudioEventRTS event(event_name);
+    Get_Info_For_Audio_Event(&event);
+    const AudioEventInfo *info = event.Get_Event_Info();
+
+    // Speech and music are streamed, there is nothing to decode ahead for them.
+    if (info == nullptr || info->Get_Event_Type() != EVENT_SOUND) {
+        return;
+    }
+
+    for (size_t i = 0; i < info->Sound_Count(); ++i) {
+        m_audioFileCache->Prefetch_File(event.Generate_Sample_Filename(info->Get_Sound(i)), info);
+    }
+
+    for (size_t i = 0; i < info->Attack_Count(); ++i) {
+        m_audioFileCache->Prefetch_File(event.Generate_Sample_Filename(info->Get_Attack(i)), info);
+    }
+
+    for (size_t i = 0; i < info->Decay_Count(); ++i) {
+        m_audioFileCache->Prefetch_File(event.Generate_Sample_Filename(info->Get_Decay(i)), info);
+    }
 }
 
 /**
@@ -1173,12 +1288,29 @@ void ALAudioManager::Release_Playing_Audio(PlayingAudio *audio)
  */
 void ALAudioManager::Release_OpenAL_Handles(PlayingAudio *audio)
 {
-    if (audio->openal.buffer)
-        alDeleteBuffers(1, &audio->openal.buffer);
-    if (audio->openal.source)
+    Release_Source(audio);
+    audio->openal.playing_type = PAT_NONE;
+}
+
+/**
+ * Deletes the OpenAL source and buffer of a playing audio object.
+ */
+void ALAudioManager::Release_Source(PlayingAudio *audio)
+{
+    // #BUGFIX The source has to go first, OpenAL refuses to delete a buffer that is still attached to one.
+    if (audio->openal.source) {
         alDeleteSources(1, &audio->openal.source);
+        audio->openal.source = 0;
 
-    audio->openal.playing_type = PAT_NONE;
+        if (audio->openal.playing_type == PAT_3DSAMPLE) {
+            --m_positionalSourceCount;
+        }
+    }
+
+    if (audio->openal.buffer) {
+        alDeleteBuffers(1, &audio->openal.buffer);
+        audio->openal.buffer = 0;
+    }
 }
 
 /**
@@ -1198,29 +1330,37 @@ void ALAudioManager::Free_All_OpenAL_Handles()
  */
 void ALAudioManager::Stop_All_Audio_Immediately()
 {
-    for (auto it = m_globalAudioList.begin(); it != m_globalAudioList.end(); it = m_globalAudioList.erase(it)) {
+    for (auto it = m_globalAudioList.begin(); it != m_globalAudioList.end(); ++it) {
         if (*it != nullptr) {
             Release_Playing_Audio(*it);
         }
     }
 
-    for (auto it = m_positionalAudioList.begin(); it != m_positionalAudioList.end(); it = m_positionalAudioList.erase(it)) {
+    m_globalAudioList.clear();
+
+    for (auto it = m_positionalAudioList.begin(); it != m_positionalAudioList.end(); ++it) {
         if (*it != nullptr) {
             Release_Playing_Audio(*it);
         }
     }
 
-    for (auto it = m_streamList.begin(); it != m_streamList.end(); it = m_streamList.erase(it)) {
+    m_positionalAudioList.clear();
+
+    for (auto it = m_streamList.begin(); it != m_streamList.end(); ++it) {
         if (*it != nullptr) {
             Release_Playing_Audio(*it);
         }
     }
 
-    for (auto it = m_fadingList.begin(); it != m_fadingList.end(); it = m_fadingList.erase(it)) {
+    m_streamList.clear();
+
+    for (auto it = m_fadingList.begin(); it != m_fadingList.end(); ++it) {
         if (*it != nullptr) {
             Release_Playing_Audio(*it);
         }
     }
+
+    m_fadingList.clear();
 }
 
 /**
@@ -1259,7 +1399,10 @@ AudioDataHandle ALAudioManager::Play_Sample3D(AudioEventRTS *event, PlayingAudio
             alSourcef(openal.source, AL_REFERENCE_DISTANCE, event->Get_Event_Info()->Min_Range());
             alSourcef(openal.source, AL_MAX_DISTANCE, event->Get_Event_Info()->Max_Range());
         }
-        alSource3f(openal.source, AL_POSITION, pos->x, pos->y, pos->z);
+        Set_Source_Position(audio, *pos);
+#if BUILD_WITH_FFMPEG
+        audio->openal.length_ms = m_audioFileCache->Get_File_Length_MS(handle);
+#endif
     }
 
     return handle;
@@ -1275,8 +1418,10 @@ AudioDataHandle ALAudioManager::Play_Sample2D(AudioEventRTS *event, PlayingAudio
 
     if (handle != nullptr) {
         auto openal = audio->openal;
+        Coord3D origin;
+        origin.Zero();
         alSourcei(openal.source, AL_SOURCE_RELATIVE, AL_TRUE);
-        alSource3f(openal.source, AL_POSITION, 0.0f, 0.0f, 0.0f);
+        Set_Source_Position(audio, origin);
     }
     return handle;
 }
@@ -1297,7 +1442,15 @@ AudioDataHandle ALAudioManager::Play_Sample(AudioEventRTS *event, PlayingAudio *
 #if BUILD_WITH_FFMPEG
         FFmpegAudioFileCache::Get_Wave_Data(handle, data, size, freq, channels, bits_per_sample);
 #endif
-        auto openal = audio->openal;
+        // #BUGFIX Keep the buffer so that it can be deleted again, the previous loop's buffer is done with.
+        auto &openal = audio->openal;
+
+        if (openal.buffer != 0) {
+            alSourcei(openal.source, AL_BUFFER, 0);
+            alDeleteBuffers(1, &openal.buffer);
+            openal.buffer = 0;
+        }
+
         alGenBuffers(1, &openal.buffer);
         captainslog_dbgassert(Check_AL_Error(), "Failed to generate buffer");
         alBufferData(openal.buffer, Get_AL_Format(channels, bits_per_sample), data, size, freq);
@@ -1430,10 +1583,18 @@ void ALAudioManager::Play_Audio_Event(AudioEventRTS *event)
                     }
                 }
 
-                if (kill_handle != 0 && !killed) {
-                    source_handle = 0;
-                } else {
+                bool can_play = kill_handle == 0 || killed;
+
+                // Thyme specific: Sounds that can't be heard or would take a source from louder ones start out virtual.
+                bool is_virtual = can_play
+                    && (m_positionalSourceCount >= Get_Max_3D_Sources() || Is_Inaudible(event, Get_Sample_Volume(event)));
+
+                if (can_play && !is_virtual) {
                     alGenSources(1, &source_handle);
+
+                    if (source_handle != 0) {
+                        ++m_positionalSourceCount;
+                    }
                 }
 
                 pa->openal.audio_event = event;
@@ -1442,9 +1603,16 @@ void ALAudioManager::Play_Audio_Event(AudioEventRTS *event)
                 pa->openal.file_handle = nullptr;
                 m_positionalAudioList.push_back(pa);
 
-                if (source_handle != 0) {
-                    pa->openal.file_handle = Play_Sample3D(event, pa);
-                    m_soundManager->Notify_Of_3D_Sample_Start();
+                if (source_handle != 0 || is_virtual) {
+                    if (is_virtual) {
+                        pa->openal.file_handle = Start_Virtual_Voice(event, pa);
+                    } else {
+                        pa->openal.file_handle = Play_Sample3D(event, pa);
+                    }
+
+                    // #BUGFIX Check for the sound manager like the 2D samples do.
+                    if (m_soundManager)
+                        m_soundManager->Notify_Of_3D_Sample_Start();
                 }
 
                 if (pa->openal.file_handle == nullptr) {
@@ -1514,6 +1682,9 @@ void ALAudioManager::Pause_Audio_Event(uintptr_t handle)
  */
 void ALAudioManager::Stop_Audio_Event(uintptr_t handle)
 {
+    // A play request can still be waiting on its delay or its sample, it must not start after being stopped.
+    Cancel_Play_Request(handle);
+
     if (handle == 4 || handle == 5) {
         for (auto it = m_streamList.begin(); it != m_streamList.end(); ++it) {
             if ((*it)->openal.audio_event->Get_Event_Info()->Get_Event_Type() == EVENT_MUSIC) {
@@ -1552,6 +1723,27 @@ void ALAudioManager::Stop_Audio_Event(uintptr_t handle)
     }
 }
 
+/**
+ * Drops a play request that hasn't been processed yet along with its event. Returns true if one was found.
+ */
+bool ALAudioManager::Cancel_Play_Request(uintptr_t handle)
+{
+    for (auto it = m_audioRequestList.begin(); it != m_audioRequestList.end(); ++it) {
+        // #BUGFIX Play requests hold the event rather than a handle, compare against the handle of the event and free
+        // it with the request.
+        if (*it != nullptr && (*it)->Request_Type() == AR_PLAY
+            && (*it)->Event_Object()->Get_Playing_Handle() == handle) {
+            Release_Audio_Event_RTS((*it)->Event_Object());
+            Release_Audio_Request(*it);
+            m_audioRequestList.erase(it);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
 /**
  * Process an audio request.
  */
@@ -1597,12 +1789,14 @@ void ALAudioManager::Stop_All_Speech()
 void ALAudioManager::Adjust_Playing_Volume(PlayingAudio *audio)
 {
     float adjusted_vol = audio->openal.audio_event->Get_Volume() * audio->openal.audio_event->Get_Volume_Shift();
+    audio->openal.effective_volume = -1.0f;
+
     switch (audio->openal.playing_type) {
         case PAT_2DSAMPLE: {
-            alSourcef(audio->openal.source, AL_GAIN, adjusted_vol * m_soundVolume);
+            Set_Source_Gain(audio, adjusted_vol * m_soundVolume);
         } break;
         case PAT_3DSAMPLE:
-            alSourcef(audio->openal.source, AL_GAIN, adjusted_vol * m_3dSoundVolume);
+            Set_Source_Gain(audio, adjusted_vol * m_3dSoundVolume);
             break;
         case PAT_STREAM: {
             float vol;
@@ -1613,13 +1807,361 @@ void ALAudioManager::Adjust_Playing_Volume(PlayingAudio *audio)
                 vol = adjusted_vol * m_speechVolume;
             }
 
-            alSourcef(audio->openal.source, AL_GAIN, vol * m_3dSoundVolume);
+            Set_Source_Gain(audio, vol * m_3dSoundVolume);
         } break;
         default:
             break;
     }
 }
 
+/**
+ * Sets the gain of a source, unless OpenAL already has it.
+ */
+void ALAudioManager::Set_Source_Gain(PlayingAudio *audio, float gain)
+{
+    if (audio->openal.gain != gain) {
+        // Virtual voices only remember it for when they get a source.
+        if (audio->openal.source) {
+            alSourcef(audio->openal.source, AL_GAIN, gain);
+            ++m_frameStats.source_updates;
+        }
+
+        audio->openal.gain = gain;
+    }
+}
+
+/**
+ * Sets the position of a source, unless OpenAL already has it.
+ */
+void ALAudioManager::Set_Source_Position(PlayingAudio *audio, const Coord3D &pos)
+{
+    if (audio->openal.position[0] != pos.x || audio->openal.position[1] != pos.y || audio->openal.position[2] != pos.z) {
+        if (audio->openal.source) {
+            alSource3f(audio->openal.source, AL_POSITION, pos.x, pos.y, pos.z);
+            ++m_frameStats.source_updates;
+        }
+
+        audio->openal.position[0] = pos.x;
+        audio->openal.position[1] = pos.y;
+        audio->openal.position[2] = pos.z;
+    }
+}
+
+/**
+ * Asks OpenAL to report sources that stop playing, so they don't have to be polled every frame.
+ */
+void ALAudioManager::Enable_Source_Events()
+{
+#ifdef AL_SOFT_events
+    if (alIsExtensionPresent("AL_SOFT_events") != AL_TRUE) {
+        return;
+    }
+
+    auto event_control = reinterpret_cast<LPALEVENTCONTROLSOFT>(alGetProcAddress("alEventControlSOFT"));
+    auto event_callback = reinterpret_cast<LPALEVENTCALLBACKSOFT>(alGetProcAddress("alEventCallbackSOFT"));
+
+    if (event_control == nullptr || event_callback == nullptr) {
+        return;
+    }
+
+    ALenum types[] = { AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT };
+    event_callback(Source_Event_Callback, this);
+    event_control(1, types, AL_TRUE);
+    m_sourceEventsEnabled = true;
+#endif
+}
+
+void ALAudioManager::Disable_Source_Events()
+{
+#ifdef AL_SOFT_events
+    if (!m_sourceEventsEnabled) {
+        return;
+    }
+
+    auto event_callback = reinterpret_cast<LPALEVENTCALLBACKSOFT>(alGetProcAddress("alEventCallbackSOFT"));
+    event_callback(nullptr, nullptr);
+    m_sourceEventsEnabled = false;
+
+    ScopedMutexClass lock(&m_sourceEventMutex);
+    m_pendingStoppedSources.clear();
+#endif
+}
+
+/**
+ * Called by OpenAL from its own thread, so only queues the source for the next update.
+ */
+void AL_APIENTRY ALAudioManager::Source_Event_Callback(
+    ALenum type, ALuint object, ALuint param, ALsizei length, const ALchar *message, void *user_param) noexcept
+{
+#ifdef AL_SOFT_events
+    if (type != AL_EVENT_TYPE_SOURCE_STATE_CHANGED_SOFT || param != AL_STOPPED) {
+        return;
+    }
+
+    ALAudioManager *manager = static_cast<ALAudioManager *>(user_param);
+    ScopedMutexClass lock(&manager->m_sourceEventMutex);
+    manager->m_pendingStoppedSources.push_back(object);
+#endif
+}
+
+/**
+ * Handles the completion of the sources OpenAL reported as stopped since the last update.
+ */
+void ALAudioManager::Process_Source_Events()
+{
+    {
+        ScopedMutexClass lock(&m_sourceEventMutex);
+        m_stoppedSources.swap(m_pendingStoppedSources);
+    }
+
+    for (auto it = m_stoppedSources.begin(); it != m_stoppedSources.end(); ++it) {
+        // The source may have been restarted or deleted since the event was queued.
+        if (!alIsSource(*it)) {
+            continue;
+        }
+
+        ALint source_state;
+        alGetSourcei(*it, AL_SOURCE_STATE, &source_state);
+        ++m_frameStats.state_queries;
+
+        if (source_state != AL_STOPPED) {
+            continue;
+        }
+
+        if (Find_Playing_Audio_From(*it, PAT_2DSAMPLE) != nullptr) {
+            Notify_Of_Audio_Completion(*it, PAT_2DSAMPLE);
+        } else {
+            Notify_Of_Audio_Completion(*it, PAT_3DSAMPLE);
+        }
+    }
+
+    m_stoppedSources.clear();
+}
+
+/**
+ * Gets the volume a positional sample is judged by when deciding whether it can be heard.
+ */
+float ALAudioManager::Get_Sample_Volume(AudioEventRTS *event) const
+{
+    float sample_vol = Get_Effective_Volume(event);
+    // Is this conditional check incorrect? Original does this but makes no sense.
+    // BUGFIX TODO should be m3dSoundVolume for the result as well?
+    sample_vol /= m_3dSoundVolume > 0.0f ? m_soundVolume : 1.0f;
+
+    return sample_vol;
+}
+
+/**
+ * Checks if a positional sample is too quiet to be worth a source. Global and critical sounds are always heard.
+ */
+bool ALAudioManager::Is_Inaudible(AudioEventRTS *event, float sample_vol) const
+{
+    if ((event->Get_Event_Info()->Get_Visibility() & VISIBILITY_GLOBAL) || event->Get_Event_Info()->Get_Priority() == 4) {
+        return false;
+    }
+
+    return sample_vol <= 0.0f || sample_vol < m_audioSettings->Get_Min_Sample_Vol();
+}
+
+/**
+ * Gets how many positional samples may play on real sources at once.
+ */
+int ALAudioManager::Get_Max_3D_Sources() const
+{
+    int count = m_audioSettings->Get_3D_Sample_Count();
+
+    return count > 0 ? count : AL_DEFAULT_3D_SOURCES;
+}
+
+/**
+ * Starts a positional sample without a source. The file is still opened for its length and to have it ready.
+ */
+AudioDataHandle ALAudioManager::Start_Virtual_Voice(AudioEventRTS *event, PlayingAudio *audio)
+{
+    Coord3D *pos = Get_Current_Position_From_Event(event);
+
+    if (pos == nullptr) {
+        return nullptr;
+    }
+
+    AudioDataHandle handle = Open_File(event);
+
+    if (handle == nullptr) {
+        return nullptr;
+    }
+
+#if BUILD_WITH_FFMPEG
+    audio->openal.length_ms = m_audioFileCache->Get_File_Length_MS(handle);
+#endif
+
+    // Without a length there is no telling when it ends, so it is dropped like the original drops inaudible sounds.
+    if (audio->openal.length_ms <= 0.0f) {
+        Close_File(handle);
+        return nullptr;
+    }
+
+    audio->openal.is_virtual = true;
+    audio->openal.play_time_ms = 0.0f;
+    Set_Source_Position(audio, *pos);
+
+    return handle;
+}
+
+/**
+ * Takes the source away from a playing positional sample, keeping track of how far it got.
+ */
+bool ALAudioManager::Virtualize_Voice(PlayingAudio *audio)
+{
+    if (audio->openal.length_ms <= 0.0f) {
+        return false;
+    }
+
+    ALfloat offset = 0.0f;
+    ALint source_state = AL_PLAYING;
+    alGetSourcef(audio->openal.source, AL_SEC_OFFSET, &offset);
+    alGetSourcei(audio->openal.source, AL_SOURCE_STATE, &source_state);
+    Release_Source(audio);
+
+    audio->openal.is_virtual = true;
+    audio->openal.paused = source_state == AL_PAUSED;
+    audio->openal.play_time_ms = offset * 1000.0f;
+
+    return true;
+}
+
+/**
+ * Gives a virtual positional sample a source again, continuing where it would be by now.
+ */
+bool ALAudioManager::Realize_Voice(PlayingAudio *audio)
+{
+    ALuint source = 0;
+    alGenSources(1, &source);
+
+    if (!Check_AL_Error() || source == 0) {
+        return false;
+    }
+
+    ++m_positionalSourceCount;
+    float gain = audio->openal.gain;
+    Coord3D pos;
+    pos.Set(audio->openal.position[0], audio->openal.position[1], audio->openal.position[2]);
+
+    // A new source starts out with the OpenAL defaults.
+    audio->openal.source = source;
+    audio->openal.is_virtual = false;
+    audio->openal.gain = 1.0f;
+    audio->openal.position[0] = 0.0f;
+    audio->openal.position[1] = 0.0f;
+    audio->openal.position[2] = 0.0f;
+
+    Close_File(audio->openal.file_handle);
+    audio->openal.file_handle = Play_Sample3D(audio->openal.audio_event, audio);
+
+    if (audio->openal.file_handle == nullptr) {
+        audio->openal.stopped = 1;
+        return true;
+    }
+
+    alSourcef(source, AL_SEC_OFFSET, audio->openal.play_time_ms / 1000.0f);
+    Set_Source_Gain(audio, gain);
+    Set_Source_Position(audio, pos);
+
+    return true;
+}
+
+/**
+ * Moves the play time of a virtual sample on, looping or finishing it the way a real one would. Attack and decay
+ * portions are not tracked, a virtual sample only ever plays its main sound.
+ */
+void ALAudioManager::Advance_Virtual_Voice(PlayingAudio *audio, float elapsed_ms)
+{
+    if (audio->openal.paused) {
+        return;
+    }
+
+    AudioEventRTS *event = audio->openal.audio_event;
+    audio->openal.play_time_ms += elapsed_ms;
+
+    while (audio->openal.play_time_ms >= audio->openal.length_ms) {
+        if (!audio->openal.disable_loops && (event->Get_Event_Info()->Get_Control() & CONTROL_LOOP)) {
+            event->Decrease_Loop_Count();
+
+            if (event->Has_More_Loops()) {
+                audio->openal.play_time_ms -= audio->openal.length_ms;
+                continue;
+            }
+        }
+
+        audio->openal.stopped = 1;
+        break;
+    }
+}
+
+/**
+ * Orders samples by priority first and then by how loud they are, the loudest first.
+ */
+bool ALAudioManager::Is_More_Audible(const PlayingAudio *a, const PlayingAudio *b)
+{
+    int a_priority = a->openal.audio_event->Get_Event_Info()->Get_Priority();
+    int b_priority = b->openal.audio_event->Get_Event_Info()->Get_Priority();
+
+    if (a_priority != b_priority) {
+        return a_priority > b_priority;
+    }
+
+    return a->openal.effective_volume > b->openal.effective_volume;
+}
+
+/**
+ * Hands free sources to the most audible virtual samples and takes them from clearly quieter real ones.
+ */
+void ALAudioManager::Promote_Virtual_Voices()
+{
+    // Keeps two samples of about the same volume from swapping their source back and forth every frame.
+    constexpr float SWAP_VOLUME_RATIO = 1.5f;
+
+    if (m_promotableVoices.empty()) {
+        return;
+    }
+
+    std::sort(m_promotableVoices.begin(), m_promotableVoices.end(), Is_More_Audible);
+    std::sort(m_demotableVoices.begin(), m_demotableVoices.end(), [](const PlayingAudio *a, const PlayingAudio *b) {
+        return Is_More_Audible(b, a);
+    });
+
+    auto demote = m_demotableVoices.begin();
+
+    for (auto it = m_promotableVoices.begin(); it != m_promotableVoices.end(); ++it) {
+        PlayingAudio *audio = *it;
+
+        if (m_positionalSourceCount >= Get_Max_3D_Sources()) {
+            if (demote == m_demotableVoices.end()) {
+                break;
+            }
+
+            PlayingAudio *quieter = *demote;
+            int priority = audio->openal.audio_event->Get_Event_Info()->Get_Priority();
+            int quieter_priority = quieter->openal.audio_event->Get_Event_Info()->Get_Priority();
+
+            if (priority < quieter_priority
+                || (priority == quieter_priority
+                    && audio->openal.effective_volume < quieter->openal.effective_volume * SWAP_VOLUME_RATIO)) {
+                break;
+            }
+
+            ++demote;
+
+            if (!Virtualize_Voice(quieter)) {
+                continue;
+            }
+        }
+
+        if (!Realize_Voice(audio)) {
+            break;
+        }
+    }
+}
+
 /**
  * Gets the effective volume of the event.s
  */
@@ -1720,6 +2262,15 @@ void ALAudioManager::Init_Playing_Audio(PlayingAudio *audio)
         audio->openal.disable_loops = false;
         audio->openal.release_event = true;
         audio->openal.time_fading = 0;
+        audio->openal.gain = 1.0f;
+        audio->openal.position[0] = 0.0f;
+        audio->openal.position[1] = 0.0f;
+        audio->openal.position[2] = 0.0f;
+        audio->openal.effective_volume = -1.0f;
+        audio->openal.is_virtual = false;
+        audio->openal.paused = false;
+        audio->openal.play_time_ms = 0.0f;
+        audio->openal.length_ms = 0.0f;
     }
 }
 
@@ -1731,7 +2282,17 @@ void ALAudioManager::Init_Playing_Audio(PlayingAudio *audio)
 bool ALAudioManager::Process_Request_This_Frame(AudioRequest *request)
 {
     if (request->m_isAdding) {
-        return request->m_event.object->Get_Delay() < MSEC_PER_LOGICFRAME_REAL;
+        AudioEventRTS *event = request->m_event.object;
+
+        if (event->Get_Delay() >= MSEC_PER_LOGICFRAME_REAL) {
+            return false;
+        }
+
+        // A sample that was prefetched is left to the decode thread rather than stall the frame on decoding it, the
+        // request waits until its data is ready. Anything else is decoded when it first plays.
+        const AudioEventInfo *info = event->Get_Event_Info();
+
+        return info == nullptr || info->Get_Event_Type() != EVENT_SOUND || !m_audioFileCache->Is_File_Pending(event);
     }
 
     return true;
@@ -1745,7 +2306,11 @@ bool ALAudioManager::Process_Request_This_Frame(AudioRequest *request)
 void ALAudioManager::Adjust_Request(AudioRequest *request)
 {
     if (request->m_isAdding) {
-        request->m_event.object->Decrement_Delay(MSEC_PER_LOGICFRAME_REAL);
+        // Requests waiting on a prefetched sample have no delay left to count down.
+        if (request->m_event.object->Get_Delay() >= MSEC_PER_LOGICFRAME_REAL) {
+            request->m_event.object->Decrement_Delay(MSEC_PER_LOGICFRAME_REAL);
+        }
+
         request->m_isProcessed = true;
     }
 }
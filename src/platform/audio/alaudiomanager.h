@@ -16,7 +16,10 @@
 
 #include "always.h"
 #include "audiomanager.h"
+#include "mutex.h"
+#include <chrono>
 #include <new>
+#include <vector>
 
 #ifdef BUILD_WITH_FFMPEG
 #include "ffmpegaudiofilecache.h"
@@ -30,11 +33,23 @@
 
 #define MSEC_PER_LOGICFRAME_REAL (1000.0f / 30.0f)
 #define AL_MAX_PLAYBACK_DEVICES 64
+#define AL_DEFAULT_3D_SOURCES 32
 
 struct PlayingAudio;
 
 namespace Thyme
 {
+// Thyme specific: Cost of the last audio update and what became of the voices, for profiling overlays and logs.
+struct ALAudioFrameStats
+{
+    float update_ms;
+    int active_voices;
+    int culled_voices;
+    int virtualized_voices;
+    int state_queries;
+    int source_updates;
+};
+
 class ALAudioStream;
 class ALAudioManager final : public AudioManager
 {
@@ -97,9 +112,11 @@ public:
     virtual void Process_Playing_List() override;
     virtual void Process_Fading_List() override;
     virtual void Process_Stopped_List() override;
+    virtual void Prefetch_Audio_Event(const Utf8String &event_name) override;
 
     bool Is_Device_Open() const { return m_alcDevice != nullptr; }
     bool Supports_Float_Samples() const { return alIsExtensionPresent("AL_EXT_float32") == AL_TRUE; }
+    const ALAudioFrameStats &Get_Frame_Stats() const { return m_frameStats; }
 
     static ALenum Get_AL_Format(uint8_t channels, uint8_t bits_per_sample);
     static bool Check_AL_Error();
@@ -118,11 +135,26 @@ private:
     AudioDataHandle Play_Sample2D(AudioEventRTS *event, PlayingAudio *audio);
     AudioDataHandle Play_Sample(AudioEventRTS *event, PlayingAudio *audio);
     void Adjust_Playing_Volume(PlayingAudio *audio);
+    void Set_Source_Gain(PlayingAudio *audio, float gain);
+    void Set_Source_Position(PlayingAudio *audio, const Coord3D &pos);
+    void Enable_Source_Events();
+    void Disable_Source_Events();
+    void Process_Source_Events();
+    float Get_Sample_Volume(AudioEventRTS *event) const;
+    bool Is_Inaudible(AudioEventRTS *event, float sample_vol) const;
+    int Get_Max_3D_Sources() const;
+    AudioDataHandle Start_Virtual_Voice(AudioEventRTS *event, PlayingAudio *audio);
+    bool Virtualize_Voice(PlayingAudio *audio);
+    bool Realize_Voice(PlayingAudio *audio);
+    void Advance_Virtual_Voice(PlayingAudio *audio, float elapsed_ms);
+    void Promote_Virtual_Voices();
+    void Release_Source(PlayingAudio *audio);
     float Get_Effective_Volume(AudioEventRTS *event) const;
     bool Start_Next_Loop(PlayingAudio *audio);
     void Play_Audio_Event(AudioEventRTS *event);
     void Pause_Audio_Event(uintptr_t handle);
     void Stop_Audio_Event(uintptr_t handle);
+    bool Cancel_Play_Request(uintptr_t handle);
     void Process_Request(AudioRequest *request);
     void Stop_All_Speech();
     Coord3D *Get_Current_Position_From_Event(AudioEventRTS *event);
@@ -135,6 +167,9 @@ private:
     bool Check_ALC_Error();
 
     static void Init_Playing_Audio(PlayingAudio *audio);
+    static bool Is_More_Audible(const PlayingAudio *a, const PlayingAudio *b);
+    static void AL_APIENTRY Source_Event_Callback(
+        ALenum type, ALuint object, ALuint param, ALsizei length, const ALchar *message, void *user_param) noexcept;
 
 private:
     Utf8String m_alDevicesList[AL_MAX_PLAYBACK_DEVICES];
@@ -143,11 +178,11 @@ private:
     unsigned m_speakerType;
     Utf8String m_preferredProvider;
     Utf8String m_preferredSpeaker;
-    std::list<PlayingAudio *> m_globalAudioList;
-    std::list<PlayingAudio *> m_positionalAudioList;
-    std::list<PlayingAudio *> m_streamList;
-    std::list<PlayingAudio *> m_fadingList;
-    std::list<PlayingAudio *> m_stoppedList;
+    std::vector<PlayingAudio *> m_globalAudioList;
+    std::vector<PlayingAudio *> m_positionalAudioList;
+    std::vector<PlayingAudio *> m_streamList;
+    std::vector<PlayingAudio *> m_fadingList;
+    std::vector<PlayingAudio *> m_stoppedList;
 #ifdef BUILD_WITH_FFMPEG
     Thyme::FFmpegAudioFileCache *m_audioFileCache;
 #endif
@@ -155,6 +190,23 @@ private:
     int m_3dSampleCount;
     int m_streamCount;
 
+    // Thyme specific: Stopped sources are reported by OpenAL events where the extension exists, instead of asking every
+    // source for its state every frame. The listener and the stats are cached per frame.
+    bool m_sourceEventsEnabled;
+    SimpleMutexClass m_sourceEventMutex;
+    std::vector<ALuint> m_pendingStoppedSources;
+    std::vector<ALuint> m_stoppedSources;
+    Coord3D m_devicePosition;
+    Coord3D m_deviceFacing;
+    bool m_listenerMoved;
+    ALAudioFrameStats m_frameStats;
+
+    // Thyme specific: Real sources are handed to the most audible positional sounds, the rest are virtual.
+    int m_positionalSourceCount;
+    std::chrono::steady_clock::time_point m_lastPlayingUpdate;
+    std::vector<PlayingAudio *> m_promotableVoices;
+    std::vector<PlayingAudio *> m_demotableVoices;
+
     ALCdevice *m_alcDevice = nullptr;
     ALCcontext *m_alcContext = nullptr;
 };
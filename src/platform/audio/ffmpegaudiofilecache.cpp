@@ -21,6 +21,7 @@ extern "C" {
 #include "audiomanager.h"
 #include "ffmpegaudiofilecache.h"
 #include "filesystem.h"
+#include <algorithm>
 #include <captainslog.h>
 #include <list>
 
@@ -45,8 +46,54 @@ struct WavHeader
     uint32_t subchunk2_size; // Sampled data length
 };
 
+/**
+ * Estimates the size of the wave data a file decodes to from the duration of its stream.
+ */
+static int Estimate_Wave_Size(const FFmpegFile *ffmpeg_file)
+{
+    return sizeof(WavHeader) + std::max(ffmpeg_file->Get_Size_For_Samples(ffmpeg_file->Get_Num_Samples()), 0);
+}
+
+/**
+ * Grows the wave data buffer to hold at least size bytes.
+ */
+static bool Reserve_Wave_Data(FFmpegOpenAudioFile *open_audio, int size)
+{
+    if (size <= open_audio->buffer_size) {
+        return true;
+    }
+
+    uint8_t *wave_data = static_cast<uint8_t *>(av_realloc(open_audio->wave_data, size));
+
+    if (wave_data == nullptr) {
+        return false;
+    }
+
+    open_audio->wave_data = wave_data;
+    open_audio->buffer_size = size;
+
+    return true;
+}
+
+void FFmpegDecodeThreadClass::Thread_Function()
+{
+    while (m_isRunning && m_cache->Wait_For_Decode()) {
+        m_cache->Decode_Next();
+    }
+}
+
 FFmpegAudioFileCache::~FFmpegAudioFileCache()
 {
+    // Let the decode thread finish the file it is working on, anything still queued is released with the rest.
+    {
+        std::lock_guard<std::mutex> decode_lock(m_decodeLock);
+        m_decodeQueue.clear();
+        m_stopDecoding = true;
+    }
+
+    m_decodeQueued.notify_one();
+    m_decodeThread.Stop(5000);
+
     ScopedMutexClass lock(&m_mutex);
 
     for (auto it = m_cacheMap.begin(); it != m_cacheMap.end(); ++it) {
@@ -73,7 +120,15 @@ bool FFmpegAudioFileCache::Decode_FFmpeg(FFmpegOpenAudioFile *file)
         }
 
         const int frame_data_size = file->ffmpeg_file->Get_Size_For_Samples(frame->nb_samples);
-        file->wave_data = static_cast<uint8_t *>(av_realloc(file->wave_data, file->data_size + frame_data_size));
+        const int required = file->data_size + frame_data_size;
+
+        // Only needed when the stream duration was short of the real length. Growing geometrically keeps the copying
+        // linear in the length of the sample.
+        if (required > file->buffer_size && !Reserve_Wave_Data(file, std::max(required, file->buffer_size * 2))) {
+            captainslog_error("Failed to allocate %d bytes for audio data", required);
+            return;
+        }
+
         memcpy(file->wave_data + file->data_size, frame->data[0], frame_data_size);
         file->data_size += frame_data_size;
         file->total_samples += frame->nb_samples;
@@ -82,10 +137,23 @@ bool FFmpegAudioFileCache::Decode_FFmpeg(FFmpegOpenAudioFile *file)
     file->ffmpeg_file->Set_Frame_Callback(on_frame);
     file->ffmpeg_file->Set_User_Data(file);
 
+    // Size the buffer for the whole sample up front rather than growing it with every decoded frame.
+    Reserve_Wave_Data(file, Estimate_Wave_Size(file->ffmpeg_file));
+
     // Read all packets inside the file
     while (file->ffmpeg_file->Decode_Packet()) {
     }
 
+    // Give back what the estimate had left over, the cache only accounts for the data size.
+    if (file->buffer_size > file->data_size) {
+        uint8_t *wave_data = static_cast<uint8_t *>(av_realloc(file->wave_data, file->data_size));
+
+        if (wave_data != nullptr) {
+            file->wave_data = wave_data;
+            file->buffer_size = file->data_size;
+        }
+    }
+
     // Calculate the duration in MS
     file->duration = (file->total_samples / (float)file->ffmpeg_file->Get_Sample_Rate()) * 1000.0f;
 
@@ -134,7 +202,7 @@ AudioDataHandle FFmpegAudioFileCache::Open_File(const Utf8String &filename)
     captainslog_trace("FFmpegAudioFileCache: opening file %s", filename.Str());
 
     // Try to find existing data for this file to avoid loading it if unneeded.
-    auto it = m_cacheMap.find(filename);
+    auto it = Find_File(filename);
 
     if (it != m_cacheMap.end()) {
         ++(it->second.ref_count);
@@ -156,6 +224,7 @@ AudioDataHandle FFmpegAudioFileCache::Open_File(const Utf8String &filename)
     FFmpegOpenAudioFile open_audio;
     open_audio.wave_data = static_cast<uint8_t *>(av_malloc(sizeof(WavHeader)));
     open_audio.data_size = sizeof(WavHeader);
+    open_audio.buffer_size = sizeof(WavHeader);
     open_audio.ffmpeg_file = new FFmpegFile();
 
     // This transfer ownership of file
@@ -196,29 +265,16 @@ AudioDataHandle FFmpegAudioFileCache::Open_File(const Utf8String &filename)
 AudioDataHandle FFmpegAudioFileCache::Open_File(AudioEventRTS *audio_event)
 {
     ScopedMutexClass lock(&m_mutex);
-    Utf8String filename;
+    Utf8String filename = Get_Play_Portion_Filename(audio_event);
 
-    // What part of an event are we playing?
-    switch (audio_event->Get_Next_Play_Portion()) {
-        case 0:
-            filename = audio_event->Get_Attack_Name();
-            break;
-        case 1:
-            filename = audio_event->Get_File_Name();
-            break;
-        case 2:
-            filename = audio_event->Get_Decay_Name();
-            break;
-        case 3:
-            return nullptr;
-        default:
-            break;
+    if (filename.Is_Empty()) {
+        return nullptr;
     }
 
     captainslog_trace("FFmpegAudioFileCache: opening file %s", filename.Str());
 
     // Try to find existing data for this file to avoid loading it if unneeded.
-    auto it = m_cacheMap.find(filename);
+    auto it = Find_File(filename);
 
     if (it != m_cacheMap.end()) {
         ++(it->second.ref_count);
@@ -240,6 +296,7 @@ AudioDataHandle FFmpegAudioFileCache::Open_File(AudioEventRTS *audio_event)
     FFmpegOpenAudioFile open_audio;
     open_audio.wave_data = static_cast<uint8_t *>(av_malloc(sizeof(WavHeader)));
     open_audio.data_size = sizeof(WavHeader);
+    open_audio.buffer_size = sizeof(WavHeader);
     open_audio.audio_event_info = audio_event->Get_Event_Info();
     open_audio.ffmpeg_file = new FFmpegFile();
 
@@ -279,6 +336,105 @@ AudioDataHandle FFmpegAudioFileCache::Open_File(AudioEventRTS *audio_event)
     return static_cast<AudioDataHandle>(open_audio.wave_data);
 }
 
+/**
+ * Queues a file to be decoded on the decode thread so that opening it later doesn't stall on decoding. Returns true while
+ * the file is queued or being decoded, false once it is cached or if it could not be prefetched.
+ */
+bool FFmpegAudioFileCache::Prefetch_File(const Utf8String &filename, const AudioEventInfo *event_info)
+{
+    if (filename.Is_Empty()) {
+        return false;
+    }
+
+    ScopedMutexClass lock(&m_mutex);
+    Collect_Decoded();
+
+    auto it = m_cacheMap.find(filename);
+
+    if (it != m_cacheMap.end()) {
+        return it->second.decoding;
+    }
+
+    File *file = g_theFileSystem->Open_File(filename.Str(), File::READ | File::BINARY | File::BUFFERED);
+
+    if (file == nullptr) {
+        captainslog_warn("Missing audio file '%s', could not cache.", filename.Str());
+        return false;
+    }
+
+    FFmpegOpenAudioFile open_audio;
+    open_audio.wave_data = static_cast<uint8_t *>(av_malloc(sizeof(WavHeader)));
+    open_audio.data_size = sizeof(WavHeader);
+    open_audio.buffer_size = sizeof(WavHeader);
+    open_audio.audio_event_info = event_info;
+    open_audio.ffmpeg_file = new FFmpegFile();
+
+    if (!open_audio.ffmpeg_file->Open(file)) {
+        captainslog_warn("Failed to load audio file '%s', could not cache.", filename.Str());
+        Release_Open_Audio(&open_audio);
+        return false;
+    }
+
+    // Only prefetch what fits in the cache. Samples that don't are left to Open_File, which can also make room by
+    // dropping lower priority samples that are playing.
+    open_audio.estimated_size = Estimate_Wave_Size(open_audio.ffmpeg_file);
+    unsigned required = m_currentSize + m_pendingSize + open_audio.estimated_size;
+
+    if (required > m_maxSize && Free_Space(required - m_maxSize) < required - m_maxSize) {
+        Release_Open_Audio(&open_audio);
+        return false;
+    }
+
+    open_audio.decoding = true;
+    open_audio.decode_state = DECODE_QUEUED;
+    m_pendingSize += open_audio.estimated_size;
+
+    FFmpegOpenAudioFile &queued = m_cacheMap[filename];
+    queued = open_audio;
+
+    {
+        std::lock_guard<std::mutex> decode_lock(m_decodeLock);
+        m_decodeQueue.push_back(&queued);
+    }
+
+    m_decodeQueued.notify_one();
+
+    if (!m_decodeThread.Is_Running()) {
+        m_decodeThread.Execute();
+    }
+
+    return true;
+}
+
+/**
+ * Prefetches the file for the portion of an event that plays next.
+ */
+bool FFmpegAudioFileCache::Prefetch_File(AudioEventRTS *audio_event)
+{
+    return Prefetch_File(Get_Play_Portion_Filename(audio_event), audio_event->Get_Event_Info());
+}
+
+/**
+ * Checks if a prefetched file is still waiting to be decoded.
+ */
+bool FFmpegAudioFileCache::Is_File_Pending(const Utf8String &filename)
+{
+    ScopedMutexClass lock(&m_mutex);
+    Collect_Decoded();
+
+    auto it = m_cacheMap.find(filename);
+
+    return it != m_cacheMap.end() && it->second.decoding;
+}
+
+/**
+ * Checks if the file for the portion of an event that plays next is still waiting to be decoded.
+ */
+bool FFmpegAudioFileCache::Is_File_Pending(AudioEventRTS *audio_event)
+{
+    return Is_File_Pending(Get_Play_Portion_Filename(audio_event));
+}
+
 /**
  * Closes a file, reducing the references to it. Does not actually free the cache.
  */
@@ -291,7 +447,7 @@ void FFmpegAudioFileCache::Close_File(AudioDataHandle file)
     ScopedMutexClass lock(&m_mutex);
 
     for (auto it = m_cacheMap.begin(); it != m_cacheMap.end(); ++it) {
-        if (static_cast<AudioDataHandle>(it->second.wave_data) == file) {
+        if (!it->second.decoding && static_cast<AudioDataHandle>(it->second.wave_data) == file) {
             --(it->second.ref_count);
 
             break;
@@ -311,7 +467,7 @@ float FFmpegAudioFileCache::Get_File_Length_MS(AudioDataHandle file) const
     ScopedMutexClass lock(&m_mutex);
 
     for (auto it = m_cacheMap.begin(); it != m_cacheMap.end(); ++it) {
-        if (static_cast<AudioDataHandle>(it->second.wave_data) == file) {
+        if (!it->second.decoding && static_cast<AudioDataHandle>(it->second.wave_data) == file) {
             return it->second.duration;
         }
     }
@@ -336,9 +492,10 @@ unsigned FFmpegAudioFileCache::Free_Space(unsigned required)
     std::list<Utf8String> to_free;
     unsigned freed = 0;
 
-    // First check for samples that don't have any references.
+    // First check for samples that don't have any references. Prefetched samples that are still being decoded are left
+    // alone.
     for (const auto &cached : m_cacheMap) {
-        if (cached.second.ref_count == 0) {
+        if (cached.second.ref_count == 0 && !cached.second.decoding) {
             to_free.push_back(cached.first);
             freed += cached.second.data_size;
 
@@ -408,6 +565,162 @@ bool FFmpegAudioFileCache::Free_Space_For_Sample(const FFmpegOpenAudioFile &file
     return true;
 }
 
+/**
+ * Finds a cached file. If it was prefetched and isn't decoded yet this waits for it, or decodes it right away if the
+ * decode thread hasn't got to it.
+ */
+ffmpegaudiocachemap_t::iterator FFmpegAudioFileCache::Find_File(const Utf8String &filename)
+{
+    Collect_Decoded();
+
+    auto it = m_cacheMap.find(filename);
+
+    if (it != m_cacheMap.end() && it->second.decoding) {
+        Finish_Decoding(&it->second);
+
+        // Files that failed to decode have been dropped from the cache.
+        it = m_cacheMap.find(filename);
+    }
+
+    return it;
+}
+
+/**
+ * Gets the filename for the portion of an event that plays next.
+ */
+Utf8String FFmpegAudioFileCache::Get_Play_Portion_Filename(AudioEventRTS *audio_event)
+{
+    // What part of an event are we playing?
+    switch (audio_event->Get_Next_Play_Portion()) {
+        case 0:
+            return audio_event->Get_Attack_Name();
+        case 1:
+            return audio_event->Get_File_Name();
+        case 2:
+            return audio_event->Get_Decay_Name();
+        default:
+            return Utf8String();
+    }
+}
+
+/**
+ * Blocks the decode thread until a file is queued. Returns false once the cache is being destroyed.
+ */
+bool FFmpegAudioFileCache::Wait_For_Decode()
+{
+    std::unique_lock<std::mutex> decode_lock(m_decodeLock);
+    m_decodeQueued.wait(decode_lock, [this] { return !m_decodeQueue.empty() || m_stopDecoding; });
+
+    return !m_stopDecoding;
+}
+
+/**
+ * Takes the next file off the decode queue and decodes it. Called from the decode thread, returns false if the queue was
+ * empty.
+ */
+bool FFmpegAudioFileCache::Decode_Next()
+{
+    FFmpegOpenAudioFile *open_audio;
+
+    {
+        std::lock_guard<std::mutex> decode_lock(m_decodeLock);
+
+        if (m_decodeQueue.empty()) {
+            return false;
+        }
+
+        open_audio = m_decodeQueue.front();
+        m_decodeQueue.pop_front();
+        open_audio->decode_state = DECODE_RUNNING;
+    }
+
+    Decode_File(open_audio);
+
+    return true;
+}
+
+/**
+ * Decodes a file taken from the decode queue and hands it back for the cache to collect.
+ */
+void FFmpegAudioFileCache::Decode_File(FFmpegOpenAudioFile *open_audio)
+{
+    bool decoded = Decode_FFmpeg(open_audio);
+
+    if (decoded) {
+        Fill_Wave_Data(open_audio);
+    }
+
+    open_audio->ffmpeg_file->Close();
+
+    {
+        std::lock_guard<std::mutex> decode_lock(m_decodeLock);
+        open_audio->decode_state = decoded ? DECODE_FINISHED : DECODE_FAILED;
+        m_decodedList.push_back(open_audio);
+    }
+
+    m_decodeFinished.notify_all();
+}
+
+/**
+ * Makes sure a prefetched file is decoded. If the decode thread hasn't started on it the file is decoded right here,
+ * otherwise this waits for the thread to finish it.
+ */
+void FFmpegAudioFileCache::Finish_Decoding(FFmpegOpenAudioFile *open_audio)
+{
+    bool decode_here = false;
+
+    {
+        std::lock_guard<std::mutex> decode_lock(m_decodeLock);
+
+        if (open_audio->decode_state == DECODE_QUEUED) {
+            m_decodeQueue.remove(open_audio);
+            open_audio->decode_state = DECODE_RUNNING;
+            decode_here = true;
+        }
+    }
+
+    if (decode_here) {
+        Decode_File(open_audio);
+    } else {
+        std::unique_lock<std::mutex> decode_lock(m_decodeLock);
+        m_decodeFinished.wait(decode_lock, [open_audio] { return open_audio->decode_state != DECODE_RUNNING; });
+    }
+
+    Collect_Decoded();
+}
+
+/**
+ * Takes the files that finished decoding into account for the cache size and drops those that failed.
+ */
+void FFmpegAudioFileCache::Collect_Decoded()
+{
+    std::list<FFmpegOpenAudioFile *> decoded;
+
+    {
+        std::lock_guard<std::mutex> decode_lock(m_decodeLock);
+        decoded.swap(m_decodedList);
+    }
+
+    for (FFmpegOpenAudioFile *open_audio : decoded) {
+        open_audio->decoding = false;
+        m_pendingSize -= open_audio->estimated_size;
+
+        if (open_audio->decode_state == DECODE_FINISHED) {
+            m_currentSize += open_audio->data_size;
+            continue;
+        }
+
+        for (auto it = m_cacheMap.begin(); it != m_cacheMap.end(); ++it) {
+            if (&it->second == open_audio) {
+                captainslog_warn("Failed to decode audio file '%s', could not cache.", it->first.Str());
+                Release_Open_Audio(open_audio);
+                m_cacheMap.erase(it);
+                break;
+            }
+        }
+    }
+}
+
 /**
  * Closes any playing instances of an audio file and then frees the memory for it.
  */
@@ -20,6 +20,10 @@
 #include "ffmpegfile.h"
 #include "mutex.h"
 #include "rtsutils.h"
+#include "thread.h"
+#include <condition_variable>
+#include <list>
+#include <mutex>
 
 #ifdef THYME_USE_STLPORT
 #include <hash_map>
@@ -36,6 +40,14 @@ struct AVCodecContext;
 
 namespace Thyme
 {
+enum FFmpegDecodeState
+{
+    DECODE_QUEUED, // Waiting for the decode thread.
+    DECODE_RUNNING, // Being decoded, only the decoding thread may touch the data.
+    DECODE_FINISHED, // Decoded, waiting to be collected by the cache.
+    DECODE_FAILED,
+};
+
 struct FFmpegOpenAudioFile
 {
     // FFmpeg handles
@@ -46,6 +58,23 @@ struct FFmpegOpenAudioFile
     int data_size = 0;
     const AudioEventInfo *audio_event_info = nullptr;
     int total_samples = 0;
+    int buffer_size = 0;
+    // Set from queuing a prefetch until the cache collects it, the decode thread owns the data meanwhile.
+    bool decoding = false;
+    FFmpegDecodeState decode_state = DECODE_QUEUED;
+    int estimated_size = 0;
+};
+
+class FFmpegAudioFileCache;
+
+class FFmpegDecodeThreadClass : public ThreadClass
+{
+public:
+    FFmpegDecodeThreadClass(FFmpegAudioFileCache *cache) : ThreadClass("FFmpeg audio decode thread"), m_cache(cache) {}
+    virtual void Thread_Function() override;
+
+private:
+    FFmpegAudioFileCache *m_cache;
 };
 
 #ifdef THYME_USE_STLPORT
@@ -58,12 +87,28 @@ typedef std::unordered_map<const Utf8String, FFmpegOpenAudioFile, rts::hash<Utf8
 
 class FFmpegAudioFileCache
 {
+    friend class FFmpegDecodeThreadClass;
+
 public:
-    FFmpegAudioFileCache() : m_currentSize(0), m_maxSize(0), m_mutex("AudioFileCacheMutex") {}
+    FFmpegAudioFileCache() :
+        m_currentSize(0),
+        m_maxSize(0),
+        m_pendingSize(0),
+        m_mutex("AudioFileCacheMutex"),
+        m_stopDecoding(false),
+        m_decodeThread(this)
+    {
+    }
     virtual ~FFmpegAudioFileCache();
     AudioDataHandle Open_File(AudioEventRTS *file);
     AudioDataHandle Open_File(const Utf8String &filename);
 
+    // Starts decoding a file on the decode thread if it isn't cached yet. Returns true while it is being decoded.
+    bool Prefetch_File(const Utf8String &filename, const AudioEventInfo *event_info = nullptr);
+    bool Prefetch_File(AudioEventRTS *audio_event);
+    bool Is_File_Pending(const Utf8String &filename);
+    bool Is_File_Pending(AudioEventRTS *audio_event);
+
     void Close_File(AudioDataHandle file);
     void Set_Max_Size(unsigned size);
     inline unsigned Get_Max_Size() const { return m_maxSize; }
@@ -87,6 +132,15 @@ public:
 private:
     bool Free_Space_For_Sample(const FFmpegOpenAudioFile &open_audio);
     void Release_Open_Audio(FFmpegOpenAudioFile *open_audio);
+    ffmpegaudiocachemap_t::iterator Find_File(const Utf8String &filename);
+    static Utf8String Get_Play_Portion_Filename(AudioEventRTS *audio_event);
+
+    // Decode thread handling
+    bool Wait_For_Decode();
+    bool Decode_Next();
+    void Decode_File(FFmpegOpenAudioFile *open_audio);
+    void Finish_Decoding(FFmpegOpenAudioFile *open_audio);
+    void Collect_Decoded();
 
     // FFmpeg utilities
     static bool Decode_FFmpeg(FFmpegOpenAudioFile *open_audio);
@@ -95,6 +149,14 @@ private:
     ffmpegaudiocachemap_t m_cacheMap;
     unsigned m_currentSize;
     unsigned m_maxSize;
+    unsigned m_pendingSize;
     mutable SimpleMutexClass m_mutex;
+    std::mutex m_decodeLock;
+    std::condition_variable m_decodeQueued; // Signalled when a file is queued or the thread has to stop.
+    std::condition_variable m_decodeFinished; // Signalled when the thread finishes a file.
+    bool m_stopDecoding;
+    std::list<FFmpegOpenAudioFile *> m_decodeQueue;
+    std::list<FFmpegOpenAudioFile *> m_decodedList;
+    FFmpegDecodeThreadClass m_decodeThread;
 };
 } // namespace Thyme
@@ -58,6 +58,15 @@ struct OpenALPlayingAudio
     bool disable_loops;
     bool release_event;
     int time_fading;
+    // Thyme specific: Values last handed to OpenAL, so that unchanged ones are not pushed again every frame.
+    float gain;
+    float position[3];
+    float effective_volume;
+    // Thyme specific: Inaudible positional sounds run without an OpenAL source, only their play time advances.
+    bool is_virtual;
+    bool paused;
+    float play_time_ms;
+    float length_ms;
 };
 #endif
 
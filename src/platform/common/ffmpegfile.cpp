@@ -300,6 +300,23 @@ int FFmpegFile::Get_Bytes_Per_Sample() const
     return av_get_bytes_per_sample(stream->codec_ctx->sample_fmt);
 }
 
+int FFmpegFile::Get_Num_Samples() const
+{
+    const FFmpegStream *stream = Find_Match(AVMEDIA_TYPE_AUDIO);
+    if (m_fmt_ctx == nullptr || stream == nullptr || m_fmt_ctx->streams[stream->stream_idx] == nullptr)
+        return 0;
+
+    // Prefer the stream duration, containers without one only know the duration of the whole file.
+    const AVStream *av_stream = m_fmt_ctx->streams[stream->stream_idx];
+    if (av_stream->duration != AV_NOPTS_VALUE)
+        return av_stream->duration * av_q2d(av_stream->time_base) * stream->codec_ctx->sample_rate;
+
+    if (m_fmt_ctx->duration != AV_NOPTS_VALUE)
+        return (m_fmt_ctx->duration / (double)AV_TIME_BASE) * stream->codec_ctx->sample_rate;
+
+    return 0;
+}
+
 int FFmpegFile::Get_Size_For_Samples(int numSamples) const
 {
     const FFmpegStream *stream = Find_Match(AVMEDIA_TYPE_AUDIO);
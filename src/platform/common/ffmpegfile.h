@@ -46,6 +46,8 @@ public:
 
     // Audio specific
     int Get_Size_For_Samples(int numSamples) const;
+    // Estimated from the container, 0 if it doesn't know the duration
+    int Get_Num_Samples() const;
     int Get_Num_Channels() const;
     int Get_Sample_Rate() const;
     int Get_Bytes_Per_Sample() const;
@@ -111,6 +111,9 @@ W3DDisplay::W3DDisplay() :
         str = nullptr;
     }
     m_nativeDebugDisplay = nullptr;
+#ifndef GAME_DLL
+    m_collectModelPreloads = false;
+#endif
 }
 
 // 0x0073C453
@@ -1378,12 +1381,37 @@ void W3DDisplay::Set_Border_Shroud_Level(uint8_t level)
 void W3DDisplay::Preload_Model_Assets(Utf8String model)
 {
     if (s_assetManager != nullptr) {
+#ifndef GAME_DLL
+        if (m_collectModelPreloads) {
+            m_modelPreloads.Add(model.Str());
+            return;
+        }
+#endif
         Utf8String filename;
         filename.Format("%s.w3d", model.Str());
         s_assetManager->Load_3D_Assets(filename.Str());
     }
 }
 
+#ifndef GAME_DLL
+// Thyme specific: Collects the models preloaded until End_Model_Preloads so their files can be parsed on several threads.
+void W3DDisplay::Begin_Model_Preloads()
+{
+    m_collectModelPreloads = true;
+}
+
+void W3DDisplay::End_Model_Preloads()
+{
+    m_collectModelPreloads = false;
+
+    if (s_assetManager != nullptr && m_modelPreloads.Count() != 0) {
+        s_assetManager->Prefetch_3D_Assets(m_modelPreloads);
+    }
+
+    m_modelPreloads.Delete_All();
+}
+#endif
+
 // 0x007412D0
 void W3DDisplay::Preload_Texture_Assets(Utf8String texture)
 {
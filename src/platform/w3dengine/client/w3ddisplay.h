@@ -20,6 +20,8 @@
 #include "light.h"
 #include "render2d.h"
 #include "scene.h"
+#include "vector.h"
+#include "wwstring.h"
 
 class GameAssetManager;
 class RTS3DScene;
@@ -79,6 +81,10 @@ public:
 #endif
     virtual void Preload_Model_Assets(Utf8String model) override;
     virtual void Preload_Texture_Assets(Utf8String texture) override;
+#ifndef GAME_DLL
+    virtual void Begin_Model_Preloads() override;
+    virtual void End_Model_Preloads() override;
+#endif
     virtual void Take_ScreenShot() override;
     virtual void Toggle_Movie_Capture() override;
     virtual void Toggle_LetterBox() override;
@@ -123,6 +129,10 @@ private:
     DisplayString *m_displayStrings[16];
     DisplayString *m_benchmarkDisplayString[1];
     W3DDebugDisplay *m_nativeDebugDisplay;
+#ifndef GAME_DLL
+    bool m_collectModelPreloads;
+    DynamicVectorClass<StringClass> m_modelPreloads;
+#endif
 };
 
 void Reset_D3D_Device(bool restore_assets);
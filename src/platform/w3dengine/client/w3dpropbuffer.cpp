@@ -46,14 +46,25 @@ W3DPropBuffer::~W3DPropBuffer()
 
 void W3DPropBuffer::Cull(CameraClass *camera)
 {
+#ifndef GAME_DLL
+    m_propCull.Cull(camera->Get_Frustum());
+
+    for (int i = 0; i < m_numProps; i++) {
+        m_props[i].is_visible = m_propCull.Is_Visible(i);
+    }
+#else
     for (int i = 0; i < m_numProps; i++) {
         m_props[i].is_visible = !camera->Cull_Sphere(m_props[i].bounding_sphere);
     }
+#endif
 }
 
 void W3DPropBuffer::Clear_All_Props()
 {
     m_numProps = 0;
+#ifndef GAME_DLL
+    m_propCull.Reset();
+#endif
 
     for (int i = 0; i < MAX_PROP_TYPES; i++) {
         Ref_Ptr_Release(m_propTypes[i].render_obj);
@@ -109,6 +120,9 @@ void W3DPropBuffer::Add_Prop(int id, Coord3D position, float orientation, float
             m_props[m_numProps].bounding_sphere = m_propTypes[index].bounding_sphere;
             m_props[m_numProps].bounding_sphere.Center += Vector3(position.x, position.y, position.z);
             m_props[m_numProps].is_visible = false;
+#ifndef GAME_DLL
+            m_propCull.Add(m_props[m_numProps].bounding_sphere);
+#endif
             m_numProps++;
         }
     }
@@ -127,6 +141,9 @@ bool W3DPropBuffer::Update_Prop_Position(int id, const Coord3D &position, float
             m_props[i].render_obj->Set_ObjectScale(scale);
             m_props[i].bounding_sphere = m_propTypes[m_props[i].prop_type].bounding_sphere;
             m_props[i].bounding_sphere.Center += Vector3(position.x, position.y, position.z);
+#ifndef GAME_DLL
+            m_propCull.Set(i, m_props[i].bounding_sphere);
+#endif
             m_propsUpdated = true;
             return true;
         }
@@ -144,6 +161,9 @@ void W3DPropBuffer::Remove_Prop(int id)
             Ref_Ptr_Release(m_props[i].render_obj);
             m_props[i].bounding_sphere.Center = Vector3(0.0f, 0.0f, 0.0f);
             m_props[i].bounding_sphere.Radius = 1.0f;
+#ifndef GAME_DLL
+            m_propCull.Remove(i);
+#endif
             m_propsUpdated = true;
         }
     }
@@ -163,6 +183,9 @@ void W3DPropBuffer::Remove_Props_For_Construction(const Coord3D *position, const
                 Ref_Ptr_Release(m_props[i].render_obj);
                 m_props[i].bounding_sphere.Center = Vector3(0.0f, 0.0f, 0.0f);
                 m_props[i].bounding_sphere.Radius = 1.0f;
+#ifndef GAME_DLL
+                m_propCull.Remove(i);
+#endif
                 m_propsUpdated = true;
             }
         }
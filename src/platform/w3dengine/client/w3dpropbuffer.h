@@ -17,6 +17,7 @@
 #include "asciistring.h"
 #include "partitionmanager.h"
 #include "sphere.h"
+#include "spherecull.h"
 #include "xfer.h"
 
 class CameraClass;
@@ -92,4 +93,7 @@ private:
     int m_numPropTypes;
     W3DShroudMaterialPassClass *m_shroudMaterial;
     LightClass *m_light;
+#ifndef GAME_DLL
+    SphereCullGridClass m_propCull;
+#endif
 };
@@ -30,6 +30,7 @@
 #include "playerlist.h"
 #include "rinfo.h"
 #include "sortingrenderer.h"
+#include "spherecull.h"
 #include "view.h"
 #include "w3ddynamiclight.h"
 #include "w3dparticlesys.h"
@@ -39,6 +40,9 @@
 
 ShaderClass g_playerColorShader(0x84417);
 
+// Scratch storage for batch culling the render list, kept between frames to avoid reallocating.
+static SphereCullListClass s_visibilitySpheres;
+
 RTS3DScene::RTS3DScene() : m_drawTerrainOnly(false), m_numGlobalLights(0)
 {
     Set_Name("RTS3DScene");
@@ -261,6 +265,20 @@ void RTS3DScene::Visibility_Check(CameraClass *camera)
     }
 
     if (!ShaderClass::Is_Backface_Culling_Inverted()) {
+        // Gather the bounding spheres of everything that needs a frustum test so they can be culled in one batch.
+        s_visibilitySpheres.Reset();
+
+        for (iter.First(); !iter.Is_Done(); iter.Next()) {
+            RenderObjClass *robj = iter.Peek_Obj();
+
+            if (!robj->Is_Force_Visible() && !robj->Is_Hidden()) {
+                s_visibilitySpheres.Add(robj->Get_Bounding_Sphere());
+            }
+        }
+
+        s_visibilitySpheres.Cull(camera->Get_Frustum());
+        int sphere_index = 0;
+
         for (iter.First(); !iter.Is_Done(); iter.Next()) {
             RenderObjClass *robj = iter.Peek_Obj();
 
@@ -274,7 +292,7 @@ void RTS3DScene::Visibility_Check(CameraClass *camera)
                 continue;
             }
 
-            bool cull = camera->Cull_Sphere(robj->Get_Bounding_Sphere());
+            bool cull = !s_visibilitySpheres.Is_Visible(sphere_index++);
             bool visible = !cull;
 
             if (cull) {
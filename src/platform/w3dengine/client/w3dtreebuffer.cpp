@@ -138,6 +138,9 @@ void W3DTreeBuffer::Xfer_Snapshot(Xfer *xfer)
 
     if (xfer->Get_Mode() == XFER_LOAD) {
         m_numTrees = 0;
+#ifndef GAME_DLL
+        m_treeCull.Reset();
+#endif
 
         for (int i = 0; i < MAX_PARTITON_INDICES; i++) {
             m_partitionIndices[i] = -1;
@@ -271,6 +274,9 @@ void W3DTreeBuffer::Add_Tree(
         m_trees[m_numTrees].push_aside_location.y = 1.0f;
         m_trees[m_numTrees].push_aside_location.x = 1.0f;
         m_trees[m_numTrees].topple_state = TTree::TOPPLE_UPRIGHT;
+#ifndef GAME_DLL
+        m_treeCull.Add(m_trees[m_numTrees].bounds);
+#endif
         m_numTrees++;
     }
 }
@@ -394,6 +400,9 @@ W3DTreeBuffer::~W3DTreeBuffer()
 void W3DTreeBuffer::Clear_All_Trees()
 {
     m_numTrees = 0;
+#ifndef GAME_DLL
+    m_treeCull.Reset();
+#endif
     m_partitionRegion.lo.y = 0.0f;
     m_partitionRegion.lo.x = 0.0f;
     m_partitionRegion.hi.y = 1.0f;
@@ -478,6 +487,9 @@ void W3DTreeBuffer::Remove_Tree(DrawableID drawable)
             m_trees[i].tree_type = -2;
             m_trees[i].bounds.Center = Vector3(0.0f, 0.0f, 0.0f);
             m_trees[i].bounds.Radius = 1.0f;
+#ifndef GAME_DLL
+            m_treeCull.Remove(i);
+#endif
             m_anythingChanged = true;
         }
     }
@@ -493,6 +505,9 @@ void W3DTreeBuffer::Remove_Trees_For_Construction(const Coord3D *pos, const Geom
 
             if (g_thePartitionManager->Geom_Collides_With_Geom(pos, geom, angle, &pos2, geom2, 0.0f)) {
                 m_trees[i].tree_type = -2;
+#ifndef GAME_DLL
+                m_treeCull.Remove(i);
+#endif
                 m_anythingChanged = true;
             }
         }
@@ -510,6 +525,9 @@ bool W3DTreeBuffer::Update_Tree_Position(DrawableID drawable, Coord3D pos, float
             m_trees[i].bounds.Center *= m_trees[i].scale;
             m_trees[i].bounds.Radius *= m_trees[i].scale;
             m_trees[i].bounds.Center += m_trees[i].location;
+#ifndef GAME_DLL
+            m_treeCull.Set(i, m_trees[i].bounds);
+#endif
             m_anythingChanged = true;
             return true;
         }
@@ -844,9 +862,18 @@ void W3DTreeBuffer::Cull(const CameraClass *camera)
     float z = -1.0f * tm[2][2];
     m_cameraLookAtVector.Set(x, y, z);
 
+#ifndef GAME_DLL
+    // Trees rarely move, so they are kept in a grid that lets whole blocks of them be rejected at once.
+    m_treeCull.Cull(camera->Get_Frustum());
+#endif
+
     for (int i = 0; i < m_numTrees; i++) {
         bool sort = false;
+#ifndef GAME_DLL
+        bool visible = m_treeCull.Is_Visible(i);
+#else
         bool visible = !camera->Cull_Sphere(m_trees[i].bounds);
+#endif
 
         if (visible != m_trees[i].visible) {
             m_trees[i].visible = visible;
@@ -21,6 +21,7 @@
 #include "object.h"
 #include "snapshot.h"
 #include "sphere.h"
+#include "spherecull.h"
 #include "texture.h"
 #include "vector3.h"
 
@@ -213,4 +214,7 @@ private:
     float m_swayPeriods[10];
     float m_swayLeanAngles[10];
     W3DProjectedShadow *m_decalShadow;
+#ifndef GAME_DLL
+    SphereCullGridClass m_treeCull;
+#endif
 };
@@ -1,6 +1,8 @@
 #include "bufffile.h"
 #include "compressionmanager.h"
 #include "rtsutils.h"
+#include <algorithm>
+#include <chrono>
 #include <cxxopts.hpp>
 
 int main(int argc, char **argv)
@@ -16,6 +18,7 @@ int main(int argc, char **argv)
     ("o,output", "output file", cxxopts::value<std::string>())
     ("d,decompress", "decompress the input")
     ("t,type", "specify the encoding format (EAR, ZL1-ZL9)", cxxopts::value<std::string>())
+    ("b,benchmark", "compress N times and print the throughput", cxxopts::value<int>())
     ("h,help", "print usage")
     ("v,verbose", "verbose output", cxxopts::value<bool>()->default_value("false"))
     ;
@@ -97,15 +100,30 @@ int main(int argc, char **argv)
             }
         }
 
-        auto output_size = CompressionManager::Get_Max_Compressed_Size(input_size, type);
-        const std::unique_ptr<uint8_t[]> output_data(new uint8_t[output_size]);
+        const auto max_size = CompressionManager::Get_Max_Compressed_Size(input_size, type);
+        const std::unique_ptr<uint8_t[]> output_data(new uint8_t[max_size]);
+        const int repeats = result.count("benchmark") > 0 ? std::max(result["benchmark"].as<int>(), 1) : 1;
+        int output_size = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; ++i) {
+            output_size =
+                CompressionManager::Compress_Data(type, input_data.get(), input_size, output_data.get(), max_size);
+        }
+        const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
 
-        output_size = CompressionManager::Compress_Data(type, input_data.get(), input_size, output_data.get(), output_size);
         if (output_size == 0) {
             std::cerr << "Failed to compress data correctly" << std::endl;
             return EXIT_FAILURE;
         }
 
+        if (result.count("benchmark") > 0) {
+            std::cout << "Compressed " << input_size << " bytes to " << output_size << " bytes " << repeats
+                      << " times in " << time.count() << " s, "
+                      << double(input_size) * repeats / (1024.0 * 1024.0) / std::max(time.count(), 1e-9) << " MiB/s"
+                      << std::endl;
+        }
+
         if (output_file.Write(output_data.get(), output_size) != output_size) {
             std::cerr << "Failed to write output data completely" << std::endl;
             return EXIT_FAILURE;
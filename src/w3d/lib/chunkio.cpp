@@ -15,8 +15,10 @@
 #include "chunkio.h"
 #include "wwfile.h"
 #include <captainslog.h>
+#include <algorithm>
 #include <cstring>
 
+using std::memcpy;
 using std::memset;
 
 // TODO
@@ -204,8 +206,35 @@ ChunkLoadClass::ChunkLoadClass(FileClass *file) :
     memset(m_positionStack, 0, sizeof(m_positionStack));
     // TODO Cleanup, do we need to memset since default ctor does this anyhow?
     memset(m_headerStack, 0, sizeof(m_headerStack));
+#ifndef GAME_DLL
+    m_buffer = nullptr;
+    m_bufferSize = 0;
+    m_bufferPos = 0;
+#endif
 }
 
+#ifndef GAME_DLL
+/**
+ * Thyme specific: Reads chunks from a whole file already in memory. The buffer must outlive the loader.
+ *
+ * @param buffer Pointer to the start of the data.
+ * @param size Size of the data in bytes.
+ */
+ChunkLoadClass::ChunkLoadClass(const void *buffer, unsigned size) :
+    m_file(nullptr),
+    m_stackIndex(0),
+    m_inMicroChunk(false),
+    m_microChunkPos(0),
+    m_microChunkHeader(),
+    m_buffer(static_cast<const uint8_t *>(buffer)),
+    m_bufferSize(size),
+    m_bufferPos(0)
+{
+    memset(m_positionStack, 0, sizeof(m_positionStack));
+    memset(m_headerStack, 0, sizeof(m_headerStack));
+}
+#endif
+
 /**
  * @brief Opens the chunk at the current file position.
  * @return Bool indicating if a chunk was opened.
@@ -219,7 +248,7 @@ bool ChunkLoadClass::Open_Chunk()
         return false;
     }
 
-    if (m_file->Read(&m_headerStack[m_stackIndex], sizeof(m_headerStack[0])) == sizeof(m_headerStack[0])) {
+    if (Read_Bytes(&m_headerStack[m_stackIndex], sizeof(m_headerStack[0])) == sizeof(m_headerStack[0])) {
         m_positionStack[m_stackIndex++] = 0;
 
         return true;
@@ -241,7 +270,7 @@ bool ChunkLoadClass::Close_Chunk()
     int position = m_positionStack[m_stackIndex - 1];
 
     if (position < chunksize) {
-        m_file->Seek(chunksize - position);
+        Skip_Bytes(chunksize - position);
     }
 
     --m_stackIndex;
@@ -313,7 +342,7 @@ bool ChunkLoadClass::Close_Micro_Chunk()
     m_inMicroChunk = false;
 
     if (m_microChunkPos < m_microChunkHeader.Get_Size()) {
-        m_file->Seek(m_microChunkHeader.Get_Size() - m_microChunkPos);
+        Skip_Bytes(m_microChunkHeader.Get_Size() - m_microChunkPos);
 
         if (m_stackIndex > 0) {
             m_positionStack[m_stackIndex - 1] += m_microChunkHeader.Get_Size() - m_microChunkPos;
@@ -353,7 +382,6 @@ unsigned ChunkLoadClass::Cur_Micro_Chunk_Length()
 unsigned ChunkLoadClass::Seek(unsigned bytes)
 {
     captainslog_dbgassert(m_stackIndex > 0, "Stack index less than 1.");
-    captainslog_dbgassert(m_file->Is_Open(), "File is not open for seeking.");
 
     if (bytes + m_positionStack[m_stackIndex - 1] > m_headerStack[m_stackIndex - 1].Get_Size()) {
         return 0;
@@ -363,6 +391,24 @@ unsigned ChunkLoadClass::Seek(unsigned bytes)
         return 0;
     }
 
+#ifndef GAME_DLL
+    if (m_buffer != nullptr) {
+        if (bytes > m_bufferSize - m_bufferPos) {
+            return 0;
+        }
+
+        m_bufferPos += bytes;
+        m_positionStack[m_stackIndex - 1] += bytes;
+
+        if (m_inMicroChunk) {
+            m_microChunkPos += bytes;
+        }
+
+        return bytes;
+    }
+#endif
+
+    captainslog_dbgassert(m_file->Is_Open(), "File is not open for seeking.");
     int current = m_file->Tell();
 
     if (m_file->Seek(bytes) - current == bytes) {
@@ -387,7 +433,6 @@ unsigned ChunkLoadClass::Seek(unsigned bytes)
 unsigned ChunkLoadClass::Read(void *buf, unsigned bytes)
 {
     captainslog_dbgassert(m_stackIndex > 0, "Stack index less than 1.");
-    captainslog_dbgassert(m_file->Is_Open(), "File is not open for reading.");
 
     if (bytes + m_positionStack[m_stackIndex - 1] > m_headerStack[m_stackIndex - 1].Get_Size()) {
         return 0;
@@ -397,7 +442,7 @@ unsigned ChunkLoadClass::Read(void *buf, unsigned bytes)
         return 0;
     }
 
-    if (m_file->Read(buf, bytes) != bytes) {
+    if (Read_Bytes(buf, bytes) != bytes) {
         return 0;
     }
 
@@ -410,6 +455,30 @@ unsigned ChunkLoadClass::Read(void *buf, unsigned bytes)
     return bytes;
 }
 
+/**
+ * @brief Thyme specific: Reads data without copying it when the loader reads from memory.
+ * @param buf Buffer the data is read into when it can't be returned in place, must hold the requested bytes.
+ * @param bytes Number of bytes to read.
+ * @return Pointer to the data, either in the loaders buffer or buf, or nullptr if the bytes couldn't be read.
+ *
+ * The data is only returned in place when it is 4 byte aligned, so it can be used as an array of any of the W3D
+ * structures. It stays valid as long as the buffer the loader was created with.
+ */
+const void *ChunkLoadClass::Read_View(void *buf, unsigned bytes)
+{
+    captainslog_dbgassert(m_stackIndex > 0, "Stack index less than 1.");
+
+#ifndef GAME_DLL
+    if (m_buffer != nullptr && (reinterpret_cast<uintptr_t>(m_buffer + m_bufferPos) & 3) == 0) {
+        const void *view = m_buffer + m_bufferPos;
+
+        return Seek(bytes) == bytes ? view : nullptr;
+    }
+#endif
+
+    return Read(buf, bytes) == bytes ? buf : nullptr;
+}
+
 /**
  * @brief Reads a 2D vector from the file.
  * @param vect Pointer to a vector that data will be loaded into.
@@ -451,3 +520,43 @@ unsigned ChunkLoadClass::Read(IOQuaternionStruct *quat)
 {
     return Read(quat, sizeof(*quat));
 }
+
+/**
+ * @brief Reads from the file or the buffer, without checking the chunk bounds.
+ * @return Number of bytes actually read.
+ */
+unsigned ChunkLoadClass::Read_Bytes(void *buf, unsigned bytes)
+{
+#ifndef GAME_DLL
+    if (m_buffer != nullptr) {
+        if (bytes > m_bufferSize - m_bufferPos) {
+            return 0;
+        }
+
+        memcpy(buf, m_buffer + m_bufferPos, bytes);
+        m_bufferPos += bytes;
+
+        return bytes;
+    }
+#endif
+
+    captainslog_dbgassert(m_file->Is_Open(), "File is not open for reading.");
+
+    return m_file->Read(buf, bytes);
+}
+
+/**
+ * @brief Skips forward in the file or the buffer, without checking the chunk bounds.
+ */
+void ChunkLoadClass::Skip_Bytes(unsigned bytes)
+{
+#ifndef GAME_DLL
+    if (m_buffer != nullptr) {
+        m_bufferPos += std::min(bytes, m_bufferSize - m_bufferPos);
+
+        return;
+    }
+#endif
+
+    m_file->Seek(bytes);
+}
@@ -149,6 +149,9 @@ private:
 public:
     // TODO check return types
     ChunkLoadClass(FileClass *file);
+#ifndef GAME_DLL
+    ChunkLoadClass(const void *buffer, unsigned size);
+#endif
 
     bool Open_Chunk();
     bool Close_Chunk();
@@ -171,10 +174,14 @@ public:
     unsigned Read(IOVector3Struct *vect);
     unsigned Read(IOVector4Struct *vect);
     unsigned Read(IOQuaternionStruct *quat);
+    const void *Read_View(void *buf, unsigned bytes);
 
     int Cur_Chunk_Depth() { return m_stackIndex; }
 
 private:
+    unsigned Read_Bytes(void *buf, unsigned bytes);
+    void Skip_Bytes(unsigned bytes);
+
     FileClass *m_file;
     int m_stackIndex;
     int m_positionStack[MAX_STACK_DEPTH];
@@ -182,4 +189,10 @@ private:
     bool m_inMicroChunk;
     int m_microChunkPos;
     MicroChunkHeader m_microChunkHeader;
+#ifndef GAME_DLL
+    // Thyme specific: Reads from a file already in memory are served straight from it, without a virtual call each.
+    const uint8_t *m_buffer;
+    unsigned m_bufferSize;
+    unsigned m_bufferPos;
+#endif
 };
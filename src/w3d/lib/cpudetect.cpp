@@ -333,6 +333,8 @@ bool CPUDetectClass::HasCPUIDInstruction = false;
 bool CPUDetectClass::HasRDTSCInstruction = false;
 bool CPUDetectClass::HasSSESupport = false;
 bool CPUDetectClass::HasSSE2Support = false;
+bool CPUDetectClass::HasSSE41Support = false;
+bool CPUDetectClass::HasAVX2Support = false;
 bool CPUDetectClass::HasCMOVSupport = false;
 bool CPUDetectClass::HasMMXSupport = false;
 bool CPUDetectClass::Has3DNowSupport = false;
@@ -1268,6 +1270,23 @@ void CPUDetectClass::Init_CPUID_Instruction()
 #endif
 }
 
+// Thyme specific: Reads which register states the OS saves, only valid when CPUID reports OSXSAVE.
+static uint64_t Get_XCR0()
+{
+#if defined _MSC_VER && (defined PROCESSOR_X86 || defined PROCESSOR_X86_64)
+    return _xgetbv(0);
+#elif (defined __GNUC__ || defined __clang__) && (defined PROCESSOR_X86 || defined PROCESSOR_X86_64)
+    uint32_t eax;
+    uint32_t edx;
+    // XGETBV, spelled out for assemblers that don't know it.
+    __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+
+    return (uint64_t(edx) << 32) | eax;
+#else
+    return 0;
+#endif
+}
+
 void CPUDetectClass::Init_Processor_Features()
 {
     if (!CPUDetectClass::Has_CPUID_Instruction()) {
@@ -1281,6 +1300,15 @@ void CPUDetectClass::Init_Processor_Features()
     HasMMXSupport = (!!(FeatureBits & (1 << 23)));
     HasSSESupport = !!(FeatureBits & (1 << 25));
     HasSSE2Support = !!(FeatureBits & (1 << 26));
+    HasSSE41Support = !!(id.ecx & (1 << 19));
+    HasAVX2Support = false;
+
+    // AVX2 also needs the OS to save the upper halves of the registers, checked through XGETBV when OSXSAVE is set.
+    if ((id.ecx & (1 << 27)) && (id.ecx & (1 << 28)) && CPUIDStruct(0).eax >= 7) {
+        CPUIDCountStruct ext_id(7, 0);
+        HasAVX2Support = !!(ext_id.ebx & (1 << 5)) && (Get_XCR0() & 6) == 6;
+    }
+
     Has3DNowSupport = false;
     ExtendedFeatureBits = 0;
 
@@ -1421,7 +1449,7 @@ bool CPUDetectClass::CPUID_Count(
 
     int32_t regs[4] = { 0 };
 
-#ifdef HAVE__CPUIDEX
+#if defined HAVE__CPUIDEX || defined HAVE_CPUIDEX
     __cpuidex(regs, cpuid_type, count);
 #endif
 
@@ -1513,6 +1541,8 @@ void CPUDetectClass::Init_Processor_Log()
     CPU_LOG("MMX: %s\n", CPUDetectClass::Has_MMX_Instruction_Set() ? "Yes" : "No");
     CPU_LOG("SSE: %s\n", CPUDetectClass::Has_SSE_Instruction_Set() ? "Yes" : "No");
     CPU_LOG("SSE2: %s\n", CPUDetectClass::Has_SSE2_Instruction_Set() ? "Yes" : "No");
+    CPU_LOG("SSE4.1: %s\n", CPUDetectClass::Has_SSE41_Instruction_Set() ? "Yes" : "No");
+    CPU_LOG("AVX2: %s\n", CPUDetectClass::Has_AVX2_Instruction_Set() ? "Yes" : "No");
     CPU_LOG("3DNow!: %s\n", CPUDetectClass::Has_3DNow_Instruction_Set() ? "Yes" : "No");
     CPU_LOG("Extended 3DNow!: %s\n", CPUDetectClass::Has_Extended_3DNow_Instruction_Set() ? "Yes" : "No");
     CPU_LOG("CPU Feature bits: 0x%x\n", CPUDetectClass::Get_Feature_Bits());
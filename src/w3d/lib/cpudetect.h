@@ -130,6 +130,9 @@ public:
     static bool Has_MMX_Instruction_Set() { return HasMMXSupport; }
     static bool Has_SSE_Instruction_Set() { return HasSSESupport; }
     static bool Has_SSE2_Instruction_Set() { return HasSSE2Support; }
+    // Thyme specific: Newer instruction sets used by VectorProcessorClass.
+    static bool Has_SSE41_Instruction_Set() { return HasSSE41Support; }
+    static bool Has_AVX2_Instruction_Set() { return HasAVX2Support; }
     static bool Has_3DNow_Instruction_Set() { return Has3DNowSupport; }
     static bool Has_Extended_3DNow_Instruction_Set() { return HasExtended3DNowSupport; }
 
@@ -264,6 +267,8 @@ private:
     static bool HasRDTSCInstruction;
     static bool HasSSESupport;
     static bool HasSSE2Support;
+    static bool HasSSE41Support;
+    static bool HasAVX2Support;
     static bool HasCMOVSupport;
     static bool HasMMXSupport;
     static bool Has3DNowSupport;
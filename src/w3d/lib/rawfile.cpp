@@ -128,7 +128,8 @@ bool RawFileClass::Delete()
             return false;
         }
 #else
-        if (remove(m_filename)) {
+        // #BUGFIX remove returns 0 when it succeeds.
+        if (remove(m_filename) == 0) {
             return true;
         } else {
             Error(errno, 0, m_filename);
@@ -13,44 +13,276 @@
  *            LICENSE
  */
 #include "vp.h"
+#include "cpudetect.h"
 #include "gamemath.h"
 #include "matrix3d.h"
 #include "matrix4.h"
+#include "quat.h"
 #include "vector2.h"
 #include "vector3.h"
 #include "vector4.h"
+#include "vpkernels.h"
 #include <algorithm>
+#include <atomic>
+#include <captainslog.h>
 #include <cstring>
 
+#if defined __GNUC__ || defined __clang__
+#define VP_PREFETCH(address) __builtin_prefetch(address)
+#elif defined _M_IX86 || defined _M_X64
+#include <xmmintrin.h>
+#define VP_PREFETCH(address) _mm_prefetch(static_cast<const char *>(address), _MM_HINT_T0)
+#else
+#define VP_PREFETCH(address)
+#endif
+
 using std::memcpy;
 using std::memset;
 
-void VectorProcessorClass::Prefetch(void *address)
+namespace
+{
+// The original scalar loops, also the reference the other backends are tested against.
+void Scalar_Transform(
+    float *dst_vert, float *dst_norm, const float *src_vert, const float *src_norm, const float *mtx, int count)
 {
-    // Nothing in checked binaries, if found fill it in
+    const Matrix3D &tm = *reinterpret_cast<const Matrix3D *>(mtx);
+    Vector3 *dv = reinterpret_cast<Vector3 *>(dst_vert);
+    Vector3 *dn = reinterpret_cast<Vector3 *>(dst_norm);
+    const Vector3 *sv = reinterpret_cast<const Vector3 *>(src_vert);
+    const Vector3 *sn = reinterpret_cast<const Vector3 *>(src_norm);
+
+    for (int i = 0; i < count; ++i) {
+        dv[i] = tm * sv[i];
+
+        if (dn != nullptr) {
+            dn[i] = tm.Rotate_Vector(sn[i]);
+        }
+    }
 }
 
-void VectorProcessorClass::TransformNoW(Vector3 *dst, const Vector3 *src, const Matrix3D &mtx, int count)
+void Scalar_Transform_No_W(float *dst, const float *src, const float *mtx, int count)
 {
+    const Matrix3D &tm = *reinterpret_cast<const Matrix3D *>(mtx);
+    Vector3 *d = reinterpret_cast<Vector3 *>(dst);
+    const Vector3 *s = reinterpret_cast<const Vector3 *>(src);
+
     for (int i = 0; i < count; i++) {
-        dst[i] = mtx.Rotate_Vector(src[i]);
+        d[i] = tm.Rotate_Vector(s[i]);
     }
 }
 
-void VectorProcessorClass::Transform(Vector3 *dst, const Vector3 *src, const Matrix3D &mtx, int count)
+void Scalar_Transform4(float *dst, const float *src, const float *mtx, int count)
 {
-    while (count--) {
-        dst[count] = mtx * src[count];
+    const Matrix4 &tm = *reinterpret_cast<const Matrix4 *>(mtx);
+    Vector4 *d = reinterpret_cast<Vector4 *>(dst);
+    const Vector3 *s = reinterpret_cast<const Vector3 *>(src);
+
+    for (int i = 0; i < count; i++) {
+        d[i] = tm * s[i];
     }
 }
 
-void VectorProcessorClass::Transform(Vector4 *dst, const Vector3 *src, const Matrix4 &mtx, int count)
+void Scalar_Copy_Indexed(uint32_t *dst, const uint32_t *src, const uint32_t *index, int words, int count)
+{
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < words; j++) {
+            dst[i * words + j] = src[index[i] * words + j];
+        }
+    }
+}
+
+void Scalar_Clamp(float *dst, const float *src, float min, float max, int count)
 {
-    while (count--) {
-        dst[count] = mtx * src[count];
+    for (int i = 0; i < count; i++) {
+        dst[i] = std::clamp(src[i], min, max);
+    }
+}
+
+void Scalar_Normalize(float *dst, int count)
+{
+    Vector3 *d = reinterpret_cast<Vector3 *>(dst);
+
+    for (int i = 0; i < count; i++) {
+        d[i].Normalize();
     }
 }
 
+// This has a bugfix where it always set minf value only dunno what consequences fixing this could cause
+void Scalar_Min_Max(const float *src, float *min, float *max, int count)
+{
+    const Vector3 *s = reinterpret_cast<const Vector3 *>(src);
+
+    if (count > 0) {
+        Vector3 lo = s[0];
+        Vector3 hi = s[0];
+
+        for (int i = 1; i < count; ++i) {
+            lo.Update_Min(s[i]);
+            hi.Update_Max(s[i]);
+        }
+
+        memcpy(min, &lo, sizeof(lo));
+        memcpy(max, &hi, sizeof(hi));
+    }
+}
+
+void Scalar_Mul_Add(float *dst, float multiplier, float add, int count)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = (dst[i] * multiplier) + add;
+    }
+}
+
+void Scalar_Dot_Product(float *dst, const float *a, const float *b, int count)
+{
+    const Vector3 &v = *reinterpret_cast<const Vector3 *>(a);
+    const Vector3 *s = reinterpret_cast<const Vector3 *>(b);
+
+    for (int i = 0; i < count; i++) {
+        dst[i] = v * s[i];
+    }
+}
+
+void Scalar_Clamp_Min(float *dst, const float *src, float min, int count)
+{
+    for (int i = 0; i < count; i++) {
+        dst[i] = GameMath::Max(src[i], min);
+    }
+}
+
+void Scalar_Build_Matrices(float *dst, const float *quat, const float *trans, int count)
+{
+    Matrix3D *d = reinterpret_cast<Matrix3D *>(dst);
+    const Quaternion *q = reinterpret_cast<const Quaternion *>(quat);
+    const Vector3 *t = reinterpret_cast<const Vector3 *>(trans);
+
+    for (int i = 0; i < count; i++) {
+        d[i] = Build_Matrix3D(q[i]);
+        d[i].Set_Translation(t[i]);
+    }
+}
+
+const VectorProcessorKernels g_scalarKernels = {
+    &Scalar_Transform,
+    &Scalar_Transform_No_W,
+    &Scalar_Transform4,
+    &Scalar_Copy_Indexed,
+    &Scalar_Clamp,
+    &Scalar_Normalize,
+    &Scalar_Min_Max,
+    &Scalar_Mul_Add,
+    &Scalar_Dot_Product,
+    &Scalar_Clamp_Min,
+    &Scalar_Build_Matrices,
+};
+
+std::atomic<const VectorProcessorKernels *> g_vpKernels(nullptr);
+VectorProcessorClass::KernelType g_vpKernelType = VectorProcessorClass::KERNEL_SCALAR;
+
+const VectorProcessorKernels *Get_Kernels(VectorProcessorClass::KernelType type)
+{
+    switch (type) {
+        case VectorProcessorClass::KERNEL_SSE41:
+            return CPUDetectClass::Has_SSE41_Instruction_Set() ? Get_SSE41_Vector_Kernels() : nullptr;
+        case VectorProcessorClass::KERNEL_AVX2:
+            return CPUDetectClass::Has_AVX2_Instruction_Set() ? Get_AVX2_Vector_Kernels() : nullptr;
+        case VectorProcessorClass::KERNEL_SCALAR:
+            return &g_scalarKernels;
+        default:
+            return nullptr;
+    }
+}
+
+// Picks the fastest backend the CPU supports the first time any of the functions is used.
+const VectorProcessorKernels &Kernels()
+{
+    const VectorProcessorKernels *kernels = g_vpKernels.load(std::memory_order_acquire);
+
+    if (kernels == nullptr) {
+        VectorProcessorClass::KernelType type = VectorProcessorClass::KERNEL_COUNT;
+
+        do {
+            type = VectorProcessorClass::KernelType(type - 1);
+        } while (!VectorProcessorClass::Set_Kernel_Type(type));
+
+        captainslog_info("VectorProcessorClass using %s kernels", VectorProcessorClass::Get_Kernel_Name(type));
+        kernels = g_vpKernels.load(std::memory_order_acquire);
+    }
+
+    return *kernels;
+}
+} // namespace
+
+/**
+ * Thyme specific: Selects which instruction set the functions use, fails if the CPU or build doesn't support it.
+ */
+bool VectorProcessorClass::Set_Kernel_Type(KernelType type)
+{
+    const VectorProcessorKernels *kernels = Get_Kernels(type);
+
+    if (kernels == nullptr) {
+        return false;
+    }
+
+    g_vpKernelType = type;
+    g_vpKernels.store(kernels, std::memory_order_release);
+
+    return true;
+}
+
+VectorProcessorClass::KernelType VectorProcessorClass::Get_Kernel_Type()
+{
+    Kernels();
+
+    return g_vpKernelType;
+}
+
+const char *VectorProcessorClass::Get_Kernel_Name(KernelType type)
+{
+    static const char *const names[KERNEL_COUNT] = { "scalar", "SSE4.1", "AVX2" };
+
+    return type >= 0 && type < KERNEL_COUNT ? names[type] : "unknown";
+}
+
+void VectorProcessorClass::Prefetch(void *address)
+{
+    // Nothing in checked binaries.
+    // Thyme specific: Hint the cache to load the address.
+    VP_PREFETCH(address);
+}
+
+void VectorProcessorClass::TransformNoW(Vector3 *dst, const Vector3 *src, const Matrix3D &mtx, int count)
+{
+    Kernels().transform_no_w(
+        reinterpret_cast<float *>(dst), reinterpret_cast<const float *>(src), reinterpret_cast<const float *>(&mtx), count);
+}
+
+void VectorProcessorClass::Transform(Vector3 *dst, const Vector3 *src, const Matrix3D &mtx, int count)
+{
+    Transform(dst, nullptr, src, nullptr, mtx, count);
+}
+
+/**
+ * Thyme specific: Transforms skinned positions and rotates their normals by the same bone matrix in one pass.
+ * Pass nullptr for the normals to only transform positions.
+ */
+void VectorProcessorClass::Transform(
+    Vector3 *dst_vert, Vector3 *dst_norm, const Vector3 *src_vert, const Vector3 *src_norm, const Matrix3D &mtx, int count)
+{
+    Kernels().transform(reinterpret_cast<float *>(dst_vert),
+        reinterpret_cast<float *>(dst_norm),
+        reinterpret_cast<const float *>(src_vert),
+        reinterpret_cast<const float *>(src_norm),
+        reinterpret_cast<const float *>(&mtx),
+        count);
+}
+
+void VectorProcessorClass::Transform(Vector4 *dst, const Vector3 *src, const Matrix4 &mtx, int count)
+{
+    Kernels().transform4(
+        reinterpret_cast<float *>(dst), reinterpret_cast<const float *>(src), reinterpret_cast<const float *>(&mtx), count);
+}
+
 void VectorProcessorClass::Copy(Vector2 *dst, const Vector2 *src, int count)
 {
     if (count > 0) {
@@ -111,33 +343,28 @@ void VectorProcessorClass::Copy(Vector4 *dst, const Vector3 &src, const float *s
 
 void VectorProcessorClass::CopyIndexed(unsigned *dst, const unsigned *src, const unsigned *index, int count)
 {
-    for (int i = 0; i < count; i++) {
-        dst[i] = src[index[i]];
-    }
+    Kernels().copy_indexed(dst, src, index, 1, count);
 }
 
 // i think this is right
 void VectorProcessorClass::CopyIndexed(Vector2 *dst, const Vector2 *src, const unsigned *index, int count)
 {
-    for (int i = 0; i < count; i++) {
-        dst[i] = src[index[i]];
-    }
+    Kernels().copy_indexed(
+        reinterpret_cast<uint32_t *>(dst), reinterpret_cast<const uint32_t *>(src), index, sizeof(Vector2) / 4, count);
 }
 
 // i think this is right
 void VectorProcessorClass::CopyIndexed(Vector3 *dst, const Vector3 *src, const unsigned *index, int count)
 {
-    for (int i = 0; i < count; i++) {
-        dst[i] = src[index[i]];
-    }
+    Kernels().copy_indexed(
+        reinterpret_cast<uint32_t *>(dst), reinterpret_cast<const uint32_t *>(src), index, sizeof(Vector3) / 4, count);
 }
 
 // i think this is right
 void VectorProcessorClass::CopyIndexed(Vector4 *dst, const Vector4 *src, const unsigned *index, int count)
 {
-    for (int i = 0; i < count; i++) {
-        dst[i] = src[index[i]];
-    }
+    Kernels().copy_indexed(
+        reinterpret_cast<uint32_t *>(dst), reinterpret_cast<const uint32_t *>(src), index, sizeof(Vector4) / 4, count);
 }
 
 void VectorProcessorClass::CopyIndexed(unsigned char *dst, unsigned char *src, const unsigned *index, int count)
@@ -149,19 +376,12 @@ void VectorProcessorClass::CopyIndexed(unsigned char *dst, unsigned char *src, c
 
 void VectorProcessorClass::CopyIndexed(float *dst, float *src, const unsigned *index, int count)
 {
-    for (int i = 0; i < count; i++) {
-        dst[i] = src[index[i]];
-    }
+    Kernels().copy_indexed(reinterpret_cast<uint32_t *>(dst), reinterpret_cast<const uint32_t *>(src), index, 1, count);
 }
 
 void VectorProcessorClass::Clamp(Vector4 *dst, const Vector4 *src, float min, float max, int count)
 {
-    for (int i = 0; i < count; i++) {
-        dst[i].X = std::clamp(src[i].X, min, max);
-        dst[i].Y = std::clamp(src[i].Y, min, max);
-        dst[i].Z = std::clamp(src[i].Z, min, max);
-        dst[i].W = std::clamp(src[i].W, min, max);
-    }
+    Kernels().clamp(reinterpret_cast<float *>(dst), reinterpret_cast<const float *>(src), min, max, count * 4);
 }
 
 void VectorProcessorClass::Clear(Vector3 *dst, int count)
@@ -173,44 +393,39 @@ void VectorProcessorClass::Clear(Vector3 *dst, int count)
 
 void VectorProcessorClass::Normalize(Vector3 *dst, int count)
 {
-    for (int i = 0; i < count; i++) {
-        dst[i].Normalize();
-    }
+    Kernels().normalize(reinterpret_cast<float *>(dst), count);
 }
 
-// This has a bugfix where it always set minf value only dunno what consequences fixing this could cause
 void VectorProcessorClass::MinMax(Vector3 *src, Vector3 &min, Vector3 &max, int count)
 {
-    if (count > 0) {
-        min = src[0];
-        max = src[0];
-
-        for (int i = 1; i < count; ++i) {
-            min.Update_Min(src[i]);
-            max.Update_Max(src[i]);
-        }
-    }
+    Kernels().min_max(reinterpret_cast<const float *>(src), &min.X, &max.X, count);
 }
 
 void VectorProcessorClass::MulAdd(float *dest, float multiplier, float add, int count)
 {
-    for (int i = 0; i < count; i++) {
-        dest[i] = (dest[i] * multiplier) + add;
-    }
+    Kernels().mul_add(dest, multiplier, add, count);
 }
 
 void VectorProcessorClass::DotProduct(float *dst, const Vector3 &a, const Vector3 *b, int count)
 {
-    for (int i = 0; i < count; i++) {
-        dst[i] = a * b[i];
-    }
+    Kernels().dot_product(dst, &a.X, reinterpret_cast<const float *>(b), count);
 }
 
 void VectorProcessorClass::ClampMin(float *dst, float *src, float min, int count)
 {
-    for (int i = 0; i < count; i++) {
-        dst[i] = GameMath::Max(src[i], min);
-    }
+    Kernels().clamp_min(dst, src, min, count);
+}
+
+/**
+ * Thyme specific: Builds a transform per quaternion and translation, used to turn a sampled animation pose into the
+ * pivot matrices in one pass.
+ */
+void VectorProcessorClass::BuildMatrices(Matrix3D *dst, const Quaternion *q, const Vector3 *t, int count)
+{
+    Kernels().build_matrices(reinterpret_cast<float *>(dst),
+        reinterpret_cast<const float *>(q),
+        reinterpret_cast<const float *>(t),
+        count);
 }
 
 void VectorProcessorClass::Power(float *dst, float *src, float pow, int count)
@@ -21,13 +21,33 @@ class Vector3;
 class Vector4;
 class Matrix3D;
 class Matrix4;
+class Quaternion;
 
 class VectorProcessorClass
 {
 public:
+    // Thyme specific: The instruction sets the functions can use, the best one the CPU supports is picked on first use.
+    enum KernelType
+    {
+        KERNEL_SCALAR,
+        KERNEL_SSE41,
+        KERNEL_AVX2,
+        KERNEL_COUNT,
+    };
+
+    static bool Set_Kernel_Type(KernelType type);
+    static KernelType Get_Kernel_Type();
+    static const char *Get_Kernel_Name(KernelType type);
+
     static void Prefetch(void *address);
     static void TransformNoW(Vector3 *dst, const Vector3 *src, const Matrix3D &mtx, int count);
     static void Transform(Vector3 *dst, const Vector3 *src, const Matrix3D &mtx, int count);
+    static void Transform(Vector3 *dst_vert,
+        Vector3 *dst_norm,
+        const Vector3 *src_vert,
+        const Vector3 *src_norm,
+        const Matrix3D &mtx,
+        int count);
     static void Transform(Vector4 *dst, const Vector3 *src, const Matrix4 &mtx, int count);
     static void Copy(Vector2 *dst, const Vector2 *src, int count);
     static void Copy(unsigned *dst, const unsigned *src, int count);
@@ -50,4 +70,5 @@ public:
     static void DotProduct(float *dst, const Vector3 &a, const Vector3 *b, int count);
     static void ClampMin(float *dst, float *src, float min, int count);
     static void Power(float *dst, float *src, float pow, int count);
+    static void BuildMatrices(Matrix3D *dst, const Quaternion *q, const Vector3 *t, int count);
 };
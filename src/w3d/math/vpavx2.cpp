@@ -0,0 +1,30 @@
+/**
+ * @file
+ *
+ * @author tomsons26
+ *
+ * @brief AVX2 backend for VectorProcessorClass.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include "vpkernels.h"
+
+// Only built with AVX2 enabled, which implies SSE4.1 for what the wide registers leave over.
+#ifdef __AVX2__
+#include "vpsimd.h"
+
+const VectorProcessorKernels *Get_AVX2_Vector_Kernels()
+{
+    return Get_Vector_Kernels<AVX2Ops, SSE41Ops>();
+}
+#else
+const VectorProcessorKernels *Get_AVX2_Vector_Kernels()
+{
+    return nullptr;
+}
+#endif
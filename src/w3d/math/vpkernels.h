@@ -0,0 +1,43 @@
+/**
+ * @file
+ *
+ * @author tomsons26
+ *
+ * @brief Backends for VectorProcessorClass, one per instruction set.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#pragma once
+
+#include <stdint.h>
+
+// Thyme specific: The SIMD backends are built with extra instruction set flags, so they only see plain floats and this
+// header. Including engine headers there could let the linker pick inline functions that won't run on older CPUs.
+// Vector3 arrays are passed as 3 floats per element, Matrix3D as 12 and Matrix4 as 16 floats in row order.
+struct VectorProcessorKernels
+{
+    // dst_norm and src_norm may be null to only transform positions.
+    void (*transform)(
+        float *dst_vert, float *dst_norm, const float *src_vert, const float *src_norm, const float *mtx, int count);
+    void (*transform_no_w)(float *dst, const float *src, const float *mtx, int count);
+    void (*transform4)(float *dst, const float *src, const float *mtx, int count);
+    // Copies elements made of words 32 bit words each.
+    void (*copy_indexed)(uint32_t *dst, const uint32_t *src, const uint32_t *index, int words, int count);
+    void (*clamp)(float *dst, const float *src, float min, float max, int count);
+    void (*normalize)(float *dst, int count);
+    void (*min_max)(const float *src, float *min, float *max, int count);
+    void (*mul_add)(float *dst, float multiplier, float add, int count);
+    void (*dot_product)(float *dst, const float *a, const float *b, int count);
+    void (*clamp_min)(float *dst, const float *src, float min, int count);
+    // Quaternions are 4 floats, dst gets a Matrix3D per quaternion with the translation in the last column.
+    void (*build_matrices)(float *dst, const float *quat, const float *trans, int count);
+};
+
+// Return nullptr when the backend wasn't built for this target.
+const VectorProcessorKernels *Get_SSE41_Vector_Kernels();
+const VectorProcessorKernels *Get_AVX2_Vector_Kernels();
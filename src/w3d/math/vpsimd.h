@@ -0,0 +1,755 @@
+/**
+ * @file
+ *
+ * @author tomsons26
+ *
+ * @brief Kernels shared by the SIMD backends of VectorProcessorClass.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#pragma once
+
+#include "vpkernels.h"
+#include <smmintrin.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Only included by the backend translation units. Everything is kept in an anonymous namespace so the code built for
+// one instruction set is never merged with that of another by the linker.
+namespace
+{
+enum
+{
+    // How far ahead linear loops prefetch, in floats.
+    VP_PREFETCH_FLOATS = 64,
+    // How many elements ahead indexed copies prefetch.
+    VP_PREFETCH_INDICES = 16,
+};
+
+template<int D, int C, int B, int A> inline __m128 Shuffle(__m128 a, __m128 b)
+{
+    return _mm_shuffle_ps(a, b, _MM_SHUFFLE(D, C, B, A));
+}
+
+inline __m128 Unpack_Lo(__m128 a, __m128 b)
+{
+    return _mm_unpacklo_ps(a, b);
+}
+
+inline __m128 Unpack_Hi(__m128 a, __m128 b)
+{
+    return _mm_unpackhi_ps(a, b);
+}
+
+#ifdef __AVX2__
+template<int D, int C, int B, int A> inline __m256 Shuffle(__m256 a, __m256 b)
+{
+    return _mm256_shuffle_ps(a, b, _MM_SHUFFLE(D, C, B, A));
+}
+
+inline __m256 Unpack_Lo(__m256 a, __m256 b)
+{
+    return _mm256_unpacklo_ps(a, b);
+}
+
+inline __m256 Unpack_Hi(__m256 a, __m256 b)
+{
+    return _mm256_unpackhi_ps(a, b);
+}
+#endif
+
+// Turns x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3 into one register per component, works within 128 bit lanes.
+template<typename T> inline void Split(T a, T b, T c, T &x, T &y, T &z)
+{
+    x = Shuffle<2, 0, 3, 0>(a, Shuffle<1, 1, 2, 2>(b, c));
+    y = Shuffle<2, 0, 2, 0>(Shuffle<0, 0, 1, 1>(a, b), Shuffle<2, 2, 3, 3>(b, c));
+    z = Shuffle<3, 0, 2, 0>(Shuffle<1, 1, 2, 2>(a, b), c);
+}
+
+template<typename T> inline void Merge(T x, T y, T z, T &a, T &b, T &c)
+{
+    a = Shuffle<2, 0, 2, 0>(Shuffle<0, 0, 0, 0>(x, y), Shuffle<1, 1, 0, 0>(z, x));
+    b = Shuffle<2, 0, 2, 0>(Shuffle<1, 1, 1, 1>(y, z), Shuffle<2, 2, 2, 2>(x, y));
+    c = Shuffle<2, 0, 2, 0>(Shuffle<3, 3, 2, 2>(z, x), Shuffle<3, 3, 3, 3>(y, z));
+}
+
+template<typename T> inline void Transpose(T &x, T &y, T &z, T &w)
+{
+    T xy_lo = Unpack_Lo(x, y);
+    T zw_lo = Unpack_Lo(z, w);
+    T xy_hi = Unpack_Hi(x, y);
+    T zw_hi = Unpack_Hi(z, w);
+    x = Shuffle<1, 0, 1, 0>(xy_lo, zw_lo);
+    y = Shuffle<3, 2, 3, 2>(xy_lo, zw_lo);
+    z = Shuffle<1, 0, 1, 0>(xy_hi, zw_hi);
+    w = Shuffle<3, 2, 3, 2>(xy_hi, zw_hi);
+}
+
+// Four floats at a time.
+struct SSE41Ops
+{
+    typedef __m128 Reg;
+
+    enum
+    {
+        WIDTH = 4,
+    };
+
+    static Reg Set(float value) { return _mm_set1_ps(value); }
+    static Reg Add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+    static Reg Div(Reg a, Reg b) { return _mm_div_ps(a, b); }
+    static Reg Sqrt(Reg a) { return _mm_sqrt_ps(a); }
+    static Reg Min(Reg a, Reg b) { return _mm_min_ps(a, b); }
+    static Reg Max(Reg a, Reg b) { return _mm_max_ps(a, b); }
+
+    static Reg Select_Non_Zero(Reg test, Reg a, Reg b)
+    {
+        return _mm_blendv_ps(b, a, _mm_cmpneq_ps(test, _mm_setzero_ps()));
+    }
+
+    static Reg Load(const float *src) { return _mm_loadu_ps(src); }
+    static void Store(float *dst, Reg a) { _mm_storeu_ps(dst, a); }
+    static void Prefetch(const void *address) { _mm_prefetch(static_cast<const char *>(address), _MM_HINT_T0); }
+
+    static float Reduce_Min(Reg a)
+    {
+        a = _mm_min_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_min_ss(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1))));
+    }
+
+    static float Reduce_Max(Reg a)
+    {
+        a = _mm_max_ps(a, _mm_movehl_ps(a, a));
+        return _mm_cvtss_f32(_mm_max_ss(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1))));
+    }
+
+    static void Load3(const float *src, Reg &x, Reg &y, Reg &z)
+    {
+        Split(_mm_loadu_ps(src), _mm_loadu_ps(src + 4), _mm_loadu_ps(src + 8), x, y, z);
+    }
+
+    static void Store3(float *dst, Reg x, Reg y, Reg z)
+    {
+        Reg a;
+        Reg b;
+        Reg c;
+        Merge(x, y, z, a, b, c);
+        _mm_storeu_ps(dst, a);
+        _mm_storeu_ps(dst + 4, b);
+        _mm_storeu_ps(dst + 8, c);
+    }
+
+    static void Store4(float *dst, Reg x, Reg y, Reg z, Reg w)
+    {
+        Transpose(x, y, z, w);
+        _mm_storeu_ps(dst, x);
+        _mm_storeu_ps(dst + 4, y);
+        _mm_storeu_ps(dst + 8, z);
+        _mm_storeu_ps(dst + 12, w);
+    }
+};
+
+#ifdef __AVX2__
+// Eight floats at a time, vectors are split so the low lane holds the first four and the high lane the next four.
+struct AVX2Ops
+{
+    typedef __m256 Reg;
+
+    enum
+    {
+        WIDTH = 8,
+    };
+
+    static Reg Set(float value) { return _mm256_set1_ps(value); }
+    static Reg Add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+    static Reg Sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+    static Reg Mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+    static Reg Div(Reg a, Reg b) { return _mm256_div_ps(a, b); }
+    static Reg Sqrt(Reg a) { return _mm256_sqrt_ps(a); }
+    static Reg Min(Reg a, Reg b) { return _mm256_min_ps(a, b); }
+    static Reg Max(Reg a, Reg b) { return _mm256_max_ps(a, b); }
+
+    static Reg Select_Non_Zero(Reg test, Reg a, Reg b)
+    {
+        return _mm256_blendv_ps(b, a, _mm256_cmp_ps(test, _mm256_setzero_ps(), _CMP_NEQ_UQ));
+    }
+
+    static Reg Load(const float *src) { return _mm256_loadu_ps(src); }
+    static void Store(float *dst, Reg a) { _mm256_storeu_ps(dst, a); }
+    static void Prefetch(const void *address) { _mm_prefetch(static_cast<const char *>(address), _MM_HINT_T0); }
+
+    static float Reduce_Min(Reg a)
+    {
+        return SSE41Ops::Reduce_Min(_mm_min_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+    }
+
+    static float Reduce_Max(Reg a)
+    {
+        return SSE41Ops::Reduce_Max(_mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1)));
+    }
+
+    static void Load3(const float *src, Reg &x, Reg &y, Reg &z)
+    {
+        Reg l0 = _mm256_loadu_ps(src);
+        Reg l1 = _mm256_loadu_ps(src + 8);
+        Reg l2 = _mm256_loadu_ps(src + 16);
+        Split(_mm256_permute2f128_ps(l0, l1, 0x30),
+            _mm256_permute2f128_ps(l0, l2, 0x21),
+            _mm256_permute2f128_ps(l1, l2, 0x30),
+            x,
+            y,
+            z);
+    }
+
+    static void Store3(float *dst, Reg x, Reg y, Reg z)
+    {
+        Reg a;
+        Reg b;
+        Reg c;
+        Merge(x, y, z, a, b, c);
+        _mm256_storeu_ps(dst, _mm256_permute2f128_ps(a, b, 0x20));
+        _mm256_storeu_ps(dst + 8, _mm256_permute2f128_ps(c, a, 0x30));
+        _mm256_storeu_ps(dst + 16, _mm256_permute2f128_ps(b, c, 0x31));
+    }
+
+    static void Store4(float *dst, Reg x, Reg y, Reg z, Reg w)
+    {
+        Transpose(x, y, z, w);
+        _mm256_storeu_ps(dst, _mm256_permute2f128_ps(x, y, 0x20));
+        _mm256_storeu_ps(dst + 8, _mm256_permute2f128_ps(z, w, 0x20));
+        _mm256_storeu_ps(dst + 16, _mm256_permute2f128_ps(x, y, 0x31));
+        _mm256_storeu_ps(dst + 24, _mm256_permute2f128_ps(z, w, 0x31));
+    }
+};
+#endif
+
+// The batch functions do as many whole registers as fit and return how many elements they did. Sums are done in the
+// same order as the scalar code so results match it.
+template<typename Ops, bool Translate>
+inline void Transform_Step(float *dst, const float *src, const typename Ops::Reg (&m)[4][4])
+{
+    typedef typename Ops::Reg Reg;
+    Reg x;
+    Reg y;
+    Reg z;
+    Ops::Load3(src, x, y, z);
+    Reg out[3];
+
+    for (int row = 0; row < 3; ++row) {
+        out[row] = Ops::Add(Ops::Add(Ops::Mul(m[row][0], x), Ops::Mul(m[row][1], y)), Ops::Mul(m[row][2], z));
+
+        if (Translate) {
+            out[row] = Ops::Add(out[row], m[row][3]);
+        }
+    }
+
+    Ops::Store3(dst, out[0], out[1], out[2]);
+}
+
+template<typename Ops> inline void Load_Matrix(typename Ops::Reg (&m)[4][4], const float *mtx, int rows)
+{
+    for (int row = 0; row < rows; ++row) {
+        for (int col = 0; col < 4; ++col) {
+            m[row][col] = Ops::Set(mtx[row * 4 + col]);
+        }
+    }
+}
+
+template<typename Ops>
+int Transform_Batch(
+    float *dst_vert, float *dst_norm, const float *src_vert, const float *src_norm, const float *mtx, int count)
+{
+    typename Ops::Reg m[4][4];
+    Load_Matrix<Ops>(m, mtx, 3);
+    int i = 0;
+
+    for (; i + Ops::WIDTH <= count; i += Ops::WIDTH) {
+        if (i * 3 + VP_PREFETCH_FLOATS < count * 3) {
+            Ops::Prefetch(&src_vert[i * 3 + VP_PREFETCH_FLOATS]);
+
+            if (src_norm != nullptr) {
+                Ops::Prefetch(&src_norm[i * 3 + VP_PREFETCH_FLOATS]);
+            }
+        }
+
+        Transform_Step<Ops, true>(&dst_vert[i * 3], &src_vert[i * 3], m);
+
+        if (dst_norm != nullptr) {
+            Transform_Step<Ops, false>(&dst_norm[i * 3], &src_norm[i * 3], m);
+        }
+    }
+
+    return i;
+}
+
+template<typename Ops> int Transform_No_W_Batch(float *dst, const float *src, const float *mtx, int count)
+{
+    typename Ops::Reg m[4][4];
+    Load_Matrix<Ops>(m, mtx, 3);
+    int i = 0;
+
+    for (; i + Ops::WIDTH <= count; i += Ops::WIDTH) {
+        if (i * 3 + VP_PREFETCH_FLOATS < count * 3) {
+            Ops::Prefetch(&src[i * 3 + VP_PREFETCH_FLOATS]);
+        }
+
+        Transform_Step<Ops, false>(&dst[i * 3], &src[i * 3], m);
+    }
+
+    return i;
+}
+
+template<typename Ops> int Transform4_Batch(float *dst, const float *src, const float *mtx, int count)
+{
+    typedef typename Ops::Reg Reg;
+    Reg m[4][4];
+    Load_Matrix<Ops>(m, mtx, 4);
+    int i = 0;
+
+    for (; i + Ops::WIDTH <= count; i += Ops::WIDTH) {
+        if (i * 3 + VP_PREFETCH_FLOATS < count * 3) {
+            Ops::Prefetch(&src[i * 3 + VP_PREFETCH_FLOATS]);
+        }
+
+        Reg x;
+        Reg y;
+        Reg z;
+        Ops::Load3(&src[i * 3], x, y, z);
+        Reg out[4];
+
+        for (int row = 0; row < 4; ++row) {
+            out[row] = Ops::Add(
+                Ops::Add(Ops::Add(Ops::Mul(m[row][0], x), Ops::Mul(m[row][1], y)), Ops::Mul(m[row][2], z)), m[row][3]);
+        }
+
+        Ops::Store4(&dst[i * 4], out[0], out[1], out[2], out[3]);
+    }
+
+    return i;
+}
+
+template<typename Ops> int Clamp_Batch(float *dst, const float *src, float min, float max, int count)
+{
+    typename Ops::Reg lo = Ops::Set(min);
+    typename Ops::Reg hi = Ops::Set(max);
+    int i = 0;
+
+    for (; i + Ops::WIDTH <= count; i += Ops::WIDTH) {
+        Ops::Store(&dst[i], Ops::Min(Ops::Max(Ops::Load(&src[i]), lo), hi));
+    }
+
+    return i;
+}
+
+template<typename Ops> int Normalize_Batch(float *dst, int count)
+{
+    typedef typename Ops::Reg Reg;
+    Reg one = Ops::Set(1.0f);
+    int i = 0;
+
+    for (; i + Ops::WIDTH <= count; i += Ops::WIDTH) {
+        if (i * 3 + VP_PREFETCH_FLOATS < count * 3) {
+            Ops::Prefetch(&dst[i * 3 + VP_PREFETCH_FLOATS]);
+        }
+
+        Reg x;
+        Reg y;
+        Reg z;
+        Ops::Load3(&dst[i * 3], x, y, z);
+        Reg len2 = Ops::Add(Ops::Add(Ops::Mul(x, x), Ops::Mul(y, y)), Ops::Mul(z, z));
+        Reg oolen = Ops::Div(one, Ops::Sqrt(len2));
+        // Zero length vectors are left alone.
+        x = Ops::Select_Non_Zero(len2, Ops::Mul(x, oolen), x);
+        y = Ops::Select_Non_Zero(len2, Ops::Mul(y, oolen), y);
+        z = Ops::Select_Non_Zero(len2, Ops::Mul(z, oolen), z);
+        Ops::Store3(&dst[i * 3], x, y, z);
+    }
+
+    return i;
+}
+
+// Grows the bounds in min and max, which must already hold a vector of the array.
+template<typename Ops> int Min_Max_Batch(const float *src, float *min, float *max, int count)
+{
+    typedef typename Ops::Reg Reg;
+
+    if (count < Ops::WIDTH) {
+        return 0;
+    }
+
+    Reg lo[3] = { Ops::Set(min[0]), Ops::Set(min[1]), Ops::Set(min[2]) };
+    Reg hi[3] = { Ops::Set(max[0]), Ops::Set(max[1]), Ops::Set(max[2]) };
+    int i = 0;
+
+    for (; i + Ops::WIDTH <= count; i += Ops::WIDTH) {
+        if (i * 3 + VP_PREFETCH_FLOATS < count * 3) {
+            Ops::Prefetch(&src[i * 3 + VP_PREFETCH_FLOATS]);
+        }
+
+        Reg v[3];
+        Ops::Load3(&src[i * 3], v[0], v[1], v[2]);
+
+        for (int j = 0; j < 3; ++j) {
+            lo[j] = Ops::Min(v[j], lo[j]);
+            hi[j] = Ops::Max(v[j], hi[j]);
+        }
+    }
+
+    for (int j = 0; j < 3; ++j) {
+        min[j] = Ops::Reduce_Min(lo[j]);
+        max[j] = Ops::Reduce_Max(hi[j]);
+    }
+
+    return i;
+}
+
+template<typename Ops> int Mul_Add_Batch(float *dst, float multiplier, float add, int count)
+{
+    typename Ops::Reg mul = Ops::Set(multiplier);
+    typename Ops::Reg offset = Ops::Set(add);
+    int i = 0;
+
+    for (; i + Ops::WIDTH <= count; i += Ops::WIDTH) {
+        Ops::Store(&dst[i], Ops::Add(Ops::Mul(Ops::Load(&dst[i]), mul), offset));
+    }
+
+    return i;
+}
+
+template<typename Ops> int Dot_Product_Batch(float *dst, const float *a, const float *b, int count)
+{
+    typedef typename Ops::Reg Reg;
+    Reg ax = Ops::Set(a[0]);
+    Reg ay = Ops::Set(a[1]);
+    Reg az = Ops::Set(a[2]);
+    int i = 0;
+
+    for (; i + Ops::WIDTH <= count; i += Ops::WIDTH) {
+        if (i * 3 + VP_PREFETCH_FLOATS < count * 3) {
+            Ops::Prefetch(&b[i * 3 + VP_PREFETCH_FLOATS]);
+        }
+
+        Reg x;
+        Reg y;
+        Reg z;
+        Ops::Load3(&b[i * 3], x, y, z);
+        Ops::Store(&dst[i], Ops::Add(Ops::Add(Ops::Mul(ax, x), Ops::Mul(ay, y)), Ops::Mul(az, z)));
+    }
+
+    return i;
+}
+
+template<typename Ops> int Clamp_Min_Batch(float *dst, const float *src, float min, int count)
+{
+    typename Ops::Reg lo = Ops::Set(min);
+    int i = 0;
+
+    for (; i + Ops::WIDTH <= count; i += Ops::WIDTH) {
+        Ops::Store(&dst[i], Ops::Max(Ops::Load(&src[i]), lo));
+    }
+
+    return i;
+}
+
+// Builds four matrices at a time. The quaternions are turned into one register per component and the rows are turned
+// back into whole matrix rows with 4x4 transposes, which is why this only runs on four wide registers.
+template<typename Ops> int Build_Matrices_Batch(float *dst, const float *quat, const float *trans, int count)
+{
+    typedef typename Ops::Reg Reg;
+    static_assert(Ops::WIDTH == 4, "Matrices are built from 4x4 transposes.");
+    Reg one = Ops::Set(1.0f);
+    Reg two = Ops::Set(2.0f);
+    int i = 0;
+
+    for (; i + Ops::WIDTH <= count; i += Ops::WIDTH) {
+        Reg x = Ops::Load(&quat[i * 4]);
+        Reg y = Ops::Load(&quat[i * 4 + 4]);
+        Reg z = Ops::Load(&quat[i * 4 + 8]);
+        Reg w = Ops::Load(&quat[i * 4 + 12]);
+        Transpose(x, y, z, w);
+        Reg row[3][4];
+        Ops::Load3(&trans[i * 3], row[0][3], row[1][3], row[2][3]);
+
+        Reg xx = Ops::Mul(x, x);
+        Reg yy = Ops::Mul(y, y);
+        Reg zz = Ops::Mul(z, z);
+        Reg xy = Ops::Mul(x, y);
+        Reg yz = Ops::Mul(y, z);
+        Reg zx = Ops::Mul(z, x);
+        Reg xw = Ops::Mul(x, w);
+        Reg yw = Ops::Mul(y, w);
+        Reg zw = Ops::Mul(z, w);
+
+        row[0][0] = Ops::Sub(one, Ops::Mul(two, Ops::Add(yy, zz)));
+        row[0][1] = Ops::Mul(two, Ops::Sub(xy, zw));
+        row[0][2] = Ops::Mul(two, Ops::Add(zx, yw));
+        row[1][0] = Ops::Mul(two, Ops::Add(xy, zw));
+        row[1][1] = Ops::Sub(one, Ops::Mul(two, Ops::Add(zz, xx)));
+        row[1][2] = Ops::Mul(two, Ops::Sub(yz, xw));
+        row[2][0] = Ops::Mul(two, Ops::Sub(zx, yw));
+        row[2][1] = Ops::Mul(two, Ops::Add(yz, xw));
+        row[2][2] = Ops::Sub(one, Ops::Mul(two, Ops::Add(yy, xx)));
+
+        for (int r = 0; r < 3; ++r) {
+            Transpose(row[r][0], row[r][1], row[r][2], row[r][3]);
+
+            for (int j = 0; j < 4; ++j) {
+                Ops::Store(&dst[(i + j) * 12 + r * 4], row[r][j]);
+            }
+        }
+    }
+
+    return i;
+}
+
+// Transforms a single vector, dst may be the same as src.
+template<bool Translate> inline void Transform_Vector(float *dst, const float *src, const float *mtx)
+{
+    float out[3];
+
+    for (int row = 0; row < 3; ++row) {
+        const float *m = &mtx[row * 4];
+        out[row] = m[0] * src[0] + m[1] * src[1] + m[2] * src[2];
+
+        if (Translate) {
+            out[row] += m[3];
+        }
+    }
+
+    dst[0] = out[0];
+    dst[1] = out[1];
+    dst[2] = out[2];
+}
+
+// Kernels for the dispatch table. The wide registers do the bulk, the narrow ones what is left over and plain floats
+// the last few elements.
+template<typename Wide, typename Narrow>
+void Transform(float *dst_vert, float *dst_norm, const float *src_vert, const float *src_norm, const float *mtx, int count)
+{
+    int i = Transform_Batch<Wide>(dst_vert, dst_norm, src_vert, src_norm, mtx, count);
+
+    if (dst_norm != nullptr) {
+        i += Transform_Batch<Narrow>(&dst_vert[i * 3], &dst_norm[i * 3], &src_vert[i * 3], &src_norm[i * 3], mtx, count - i);
+    } else {
+        i += Transform_Batch<Narrow>(&dst_vert[i * 3], nullptr, &src_vert[i * 3], nullptr, mtx, count - i);
+    }
+
+    for (; i < count; ++i) {
+        Transform_Vector<true>(&dst_vert[i * 3], &src_vert[i * 3], mtx);
+
+        if (dst_norm != nullptr) {
+            Transform_Vector<false>(&dst_norm[i * 3], &src_norm[i * 3], mtx);
+        }
+    }
+}
+
+template<typename Wide, typename Narrow> void Transform_No_W(float *dst, const float *src, const float *mtx, int count)
+{
+    int i = Transform_No_W_Batch<Wide>(dst, src, mtx, count);
+    i += Transform_No_W_Batch<Narrow>(&dst[i * 3], &src[i * 3], mtx, count - i);
+
+    for (; i < count; ++i) {
+        Transform_Vector<false>(&dst[i * 3], &src[i * 3], mtx);
+    }
+}
+
+template<typename Wide, typename Narrow> void Transform4(float *dst, const float *src, const float *mtx, int count)
+{
+    int i = Transform4_Batch<Wide>(dst, src, mtx, count);
+    i += Transform4_Batch<Narrow>(&dst[i * 4], &src[i * 3], mtx, count - i);
+
+    for (; i < count; ++i) {
+        const float *v = &src[i * 3];
+
+        for (int row = 0; row < 4; ++row) {
+            const float *m = &mtx[row * 4];
+            dst[i * 4 + row] = m[0] * v[0] + m[1] * v[1] + m[2] * v[2] + m[3];
+        }
+    }
+}
+
+// Indexed copies jump around in the source, so the elements needed a few iterations later are prefetched.
+template<typename Ops, int Words>
+void Copy_Indexed_Words(uint32_t *dst, const uint32_t *src, const uint32_t *index, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (i + VP_PREFETCH_INDICES < count) {
+            Ops::Prefetch(&src[index[i + VP_PREFETCH_INDICES] * Words]);
+        }
+
+        const uint32_t *from = &src[index[i] * Words];
+
+        if (Words == 4) {
+            __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(from));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(&dst[i * 4]), value);
+        } else {
+            for (int j = 0; j < Words; ++j) {
+                dst[i * Words + j] = from[j];
+            }
+        }
+    }
+}
+
+template<typename Ops> void Copy_Indexed(uint32_t *dst, const uint32_t *src, const uint32_t *index, int words, int count)
+{
+    switch (words) {
+        case 1:
+            Copy_Indexed_Words<Ops, 1>(dst, src, index, count);
+            break;
+        case 2:
+            Copy_Indexed_Words<Ops, 2>(dst, src, index, count);
+            break;
+        case 3:
+            Copy_Indexed_Words<Ops, 3>(dst, src, index, count);
+            break;
+        case 4:
+            Copy_Indexed_Words<Ops, 4>(dst, src, index, count);
+            break;
+        default:
+            for (int i = 0; i < count; ++i) {
+                for (int j = 0; j < words; ++j) {
+                    dst[i * words + j] = src[index[i] * words + j];
+                }
+            }
+            break;
+    }
+}
+
+template<typename Wide, typename Narrow> void Clamp(float *dst, const float *src, float min, float max, int count)
+{
+    int i = Clamp_Batch<Wide>(dst, src, min, max, count);
+    i += Clamp_Batch<Narrow>(&dst[i], &src[i], min, max, count - i);
+
+    for (; i < count; ++i) {
+        float value = src[i];
+        dst[i] = value < min ? min : (max < value ? max : value);
+    }
+}
+
+template<typename Wide, typename Narrow> void Normalize(float *dst, int count)
+{
+    int i = Normalize_Batch<Wide>(dst, count);
+    i += Normalize_Batch<Narrow>(&dst[i * 3], count - i);
+
+    for (; i < count; ++i) {
+        float *v = &dst[i * 3];
+        float len2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+
+        if (len2 != 0.0f) {
+            float oolen = 1.0f / _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(len2)));
+            v[0] *= oolen;
+            v[1] *= oolen;
+            v[2] *= oolen;
+        }
+    }
+}
+
+template<typename Wide, typename Narrow> void Min_Max(const float *src, float *min, float *max, int count)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    for (int j = 0; j < 3; ++j) {
+        min[j] = src[j];
+        max[j] = src[j];
+    }
+
+    int i = Min_Max_Batch<Wide>(src, min, max, count);
+    i += Min_Max_Batch<Narrow>(&src[i * 3], min, max, count - i);
+
+    for (; i < count; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            float value = src[i * 3 + j];
+
+            if (value < min[j]) {
+                min[j] = value;
+            }
+
+            if (value > max[j]) {
+                max[j] = value;
+            }
+        }
+    }
+}
+
+template<typename Wide, typename Narrow> void Mul_Add(float *dst, float multiplier, float add, int count)
+{
+    int i = Mul_Add_Batch<Wide>(dst, multiplier, add, count);
+    i += Mul_Add_Batch<Narrow>(&dst[i], multiplier, add, count - i);
+
+    for (; i < count; ++i) {
+        dst[i] = (dst[i] * multiplier) + add;
+    }
+}
+
+template<typename Wide, typename Narrow> void Dot_Product(float *dst, const float *a, const float *b, int count)
+{
+    int i = Dot_Product_Batch<Wide>(dst, a, b, count);
+    i += Dot_Product_Batch<Narrow>(&dst[i], a, &b[i * 3], count - i);
+
+    for (; i < count; ++i) {
+        dst[i] = a[0] * b[i * 3] + a[1] * b[i * 3 + 1] + a[2] * b[i * 3 + 2];
+    }
+}
+
+template<typename Wide, typename Narrow> void Clamp_Min(float *dst, const float *src, float min, int count)
+{
+    int i = Clamp_Min_Batch<Wide>(dst, src, min, count);
+    i += Clamp_Min_Batch<Narrow>(&dst[i], &src[i], min, count - i);
+
+    for (; i < count; ++i) {
+        dst[i] = src[i] > min ? src[i] : min;
+    }
+}
+
+template<typename Wide, typename Narrow> void Build_Matrices(float *dst, const float *quat, const float *trans, int count)
+{
+    int i = Build_Matrices_Batch<Narrow>(dst, quat, trans, count);
+
+    for (; i < count; ++i) {
+        const float *q = &quat[i * 4];
+        const float *t = &trans[i * 3];
+        float *m = &dst[i * 12];
+        m[0] = 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]);
+        m[1] = 2.0f * (q[0] * q[1] - q[2] * q[3]);
+        m[2] = 2.0f * (q[2] * q[0] + q[1] * q[3]);
+        m[3] = t[0];
+        m[4] = 2.0f * (q[0] * q[1] + q[2] * q[3]);
+        m[5] = 1.0f - 2.0f * (q[2] * q[2] + q[0] * q[0]);
+        m[6] = 2.0f * (q[1] * q[2] - q[0] * q[3]);
+        m[7] = t[1];
+        m[8] = 2.0f * (q[2] * q[0] - q[1] * q[3]);
+        m[9] = 2.0f * (q[1] * q[2] + q[0] * q[3]);
+        m[10] = 1.0f - 2.0f * (q[1] * q[1] + q[0] * q[0]);
+        m[11] = t[2];
+    }
+}
+
+template<typename Wide, typename Narrow> const VectorProcessorKernels *Get_Vector_Kernels()
+{
+    static const VectorProcessorKernels kernels = {
+        &Transform<Wide, Narrow>,
+        &Transform_No_W<Wide, Narrow>,
+        &Transform4<Wide, Narrow>,
+        &Copy_Indexed<Wide>,
+        &Clamp<Wide, Narrow>,
+        &Normalize<Wide, Narrow>,
+        &Min_Max<Wide, Narrow>,
+        &Mul_Add<Wide, Narrow>,
+        &Dot_Product<Wide, Narrow>,
+        &Clamp_Min<Wide, Narrow>,
+        &Build_Matrices<Wide, Narrow>,
+    };
+
+    return &kernels;
+}
+} // namespace
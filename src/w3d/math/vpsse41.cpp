@@ -0,0 +1,30 @@
+/**
+ * @file
+ *
+ * @author tomsons26
+ *
+ * @brief SSE4.1 backend for VectorProcessorClass.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include "vpkernels.h"
+
+// Built with SSE4.1 enabled where the compiler needs a flag for it, MSVC allows the intrinsics without one.
+#if defined __SSE4_1__ || (defined _MSC_VER && !defined __clang__ && (defined _M_IX86 || defined _M_X64))
+#include "vpsimd.h"
+
+const VectorProcessorKernels *Get_SSE41_Vector_Kernels()
+{
+    return Get_Vector_Kernels<SSE41Ops, SSE41Ops>();
+}
+#else
+const VectorProcessorKernels *Get_SSE41_Vector_Kernels()
+{
+    return nullptr;
+}
+#endif
@@ -21,8 +21,52 @@
 #include "meshgeometry.h"
 #include "tri.h"
 #include "w3d_file.h"
+#include <algorithm>
 
-AABTreeClass::AABTreeClass() : m_nodeCount(0), m_nodes(nullptr), m_polyCount(0), m_polyIndices(nullptr), m_mesh(nullptr) {}
+#if defined __SSE__ || defined _M_X64 || defined _M_IX86
+#define AABTREE_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifndef GAME_DLL
+bool AABTreeClass::s_quadNodesEnabled = true;
+
+/**
+ * Returns the index of the lowest set bit, value must not be 0.
+ */
+static inline int Lowest_Bit(uint32_t value)
+{
+#if defined __GNUC__ || defined __clang__
+    return __builtin_ctz(value);
+#elif defined _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return int(index);
+#else
+    int index = 0;
+
+    while ((value & 1) == 0) {
+        value >>= 1;
+        ++index;
+    }
+
+    return index;
+#endif
+}
+#endif
+
+AABTreeClass::AABTreeClass() : m_nodeCount(0), m_nodes(nullptr), m_polyCount(0), m_polyIndices(nullptr), m_mesh(nullptr)
+{
+#ifndef GAME_DLL
+    m_quadNodeCount = 0;
+    m_quadNodes = nullptr;
+    m_quadPad = 0.0f;
+#endif
+}
 
 AABTreeClass::AABTreeClass(AABTreeBuilderClass *builder)
 {
@@ -34,11 +78,22 @@ AABTreeClass::AABTreeClass(AABTreeBuilderClass *builder)
 
     int curpolyindex = 0;
     Build_Tree_Recursive(builder->m_root, curpolyindex);
+
+#ifndef GAME_DLL
+    m_quadNodeCount = 0;
+    m_quadNodes = nullptr;
+    Build_Quad_Nodes();
+#endif
 }
 
 AABTreeClass::AABTreeClass(const AABTreeClass &that) :
     m_nodeCount(0), m_nodes(nullptr), m_polyCount(0), m_polyIndices(0), m_mesh(nullptr)
 {
+#ifndef GAME_DLL
+    m_quadNodeCount = 0;
+    m_quadNodes = nullptr;
+    m_quadPad = 0.0f;
+#endif
     *this = that;
 }
 
@@ -65,6 +120,9 @@ AABTreeClass &AABTreeClass::operator=(const AABTreeClass &that)
     }
 
     m_mesh = that.m_mesh;
+#ifndef GAME_DLL
+    Build_Quad_Nodes();
+#endif
     return *this;
 }
 
@@ -87,6 +145,15 @@ void AABTreeClass::Reset()
     if (m_mesh) {
         m_mesh = nullptr;
     }
+
+#ifndef GAME_DLL
+    m_quadNodeCount = 0;
+
+    if (m_quadNodes) {
+        delete[] m_quadNodes;
+        m_quadNodes = nullptr;
+    }
+#endif
 }
 
 void AABTreeClass::Build_Tree_Recursive(AABTreeBuilderClass::CullNodeStruct *node, int &curpolyindex)
@@ -636,6 +703,10 @@ void AABTreeClass::Load_W3D(ChunkLoadClass &cload)
 
         cload.Close_Chunk();
     }
+
+#ifndef GAME_DLL
+    Build_Quad_Nodes();
+#endif
 }
 
 void AABTreeClass::Read_Poly_Indices(ChunkLoadClass &cload)
@@ -669,4 +740,375 @@ void AABTreeClass::Scale(float scale)
         m_nodes[i].m_min *= scale;
         m_nodes[i].m_max *= scale;
     }
+
+#ifndef GAME_DLL
+    Build_Quad_Nodes();
+#endif
+}
+
+#ifndef GAME_DLL
+/**
+ * Thyme specific: Collects the binary tree into nodes of up to four children for the iterative queries. A tree that is
+ * a single leaf or too deep for the fixed traversal stack keeps using the recursive code.
+ */
+void AABTreeClass::Build_Quad_Nodes()
+{
+    m_quadNodeCount = 0;
+    delete[] m_quadNodes;
+    m_quadNodes = nullptr;
+
+    if (m_nodeCount == 0 || m_nodes[0].Is_Leaf()) {
+        return;
+    }
+
+    // There is at most one quad node per inner node.
+    m_quadNodes = new QuadNodeStruct[m_nodeCount];
+
+    if (Build_Quad_Nodes_Recursive(0, 1) < 0) {
+        m_quadNodeCount = 0;
+        delete[] m_quadNodes;
+        m_quadNodes = nullptr;
+        return;
+    }
+
+    // The boxes are only used to skip nodes early so they are grown by a little more than the rounding errors of the
+    // slab test. Leaves still go through the exact test of the query.
+    float size = 1.0f;
+
+    for (int i = 0; i < 3; ++i) {
+        size = std::max(size, std::max(GameMath::Fabs(m_nodes[0].m_min[i]), GameMath::Fabs(m_nodes[0].m_max[i])));
+    }
+
+    m_quadPad = size * 1e-4f;
+}
+
+int AABTreeClass::Build_Quad_Nodes_Recursive(int index, int depth)
+{
+    if (depth > QUAD_MAX_DEPTH) {
+        return -1;
+    }
+
+    CullNodeStruct &node = m_nodes[index];
+    int slots[4];
+    int count = 0;
+
+    for (int child : { node.Get_Front_Child(), node.Get_Back_Child() }) {
+        if (m_nodes[child].Is_Leaf()) {
+            slots[count++] = child;
+        } else {
+            slots[count++] = m_nodes[child].Get_Front_Child();
+            slots[count++] = m_nodes[child].Get_Back_Child();
+        }
+    }
+
+    int quad_index = m_quadNodeCount++;
+    QuadNodeStruct &quad = m_quadNodes[quad_index];
+
+    for (int i = 0; i < 4; ++i) {
+        if (i >= count) {
+            quad.m_minX[i] = quad.m_minY[i] = quad.m_minZ[i] = FLT_MAX;
+            quad.m_maxX[i] = quad.m_maxY[i] = quad.m_maxZ[i] = -FLT_MAX;
+            quad.m_child[i] = QUAD_EMPTY;
+            continue;
+        }
+
+        const CullNodeStruct &child = m_nodes[slots[i]];
+        quad.m_minX[i] = child.m_min.X;
+        quad.m_minY[i] = child.m_min.Y;
+        quad.m_minZ[i] = child.m_min.Z;
+        quad.m_maxX[i] = child.m_max.X;
+        quad.m_maxY[i] = child.m_max.Y;
+        quad.m_maxZ[i] = child.m_max.Z;
+
+        if ((child.m_frontOrPoly0 & AABTREE_LEAF_FLAG) != 0) {
+            quad.m_child[i] = slots[i] | AABTREE_LEAF_FLAG;
+        } else {
+            int child_quad = Build_Quad_Nodes_Recursive(slots[i], depth + 1);
+
+            if (child_quad < 0) {
+                return -1;
+            }
+
+            quad.m_child[i] = child_quad;
+        }
+    }
+
+    return quad_index;
+}
+
+void AABTreeClass::Init_Quad_Ray(const RayCollisionTestClass &raytest, QuadRayStruct &ray) const
+{
+    const Vector3 &start = raytest.m_ray.Get_P0();
+    const Vector3 &dir = raytest.m_ray.Get_DP();
+    const Vector3 &end = raytest.m_ray.Get_P1();
+    float size = 0.0f;
+    ray.m_start = start;
+
+    for (int i = 0; i < 3; ++i) {
+        // Axis parallel rays get a huge but finite factor, an infinite one could make a NaN out of 0 * inf.
+        ray.m_invDir[i] = GameMath::Fabs(dir[i]) > 1e-30f ? 1.0f / dir[i] : 1e30f;
+        size = std::max(size, std::max(GameMath::Fabs(start[i]), GameMath::Fabs(end[i])));
+    }
+
+    ray.m_pad = m_quadPad + size * 1e-5f;
+}
+
+/**
+ * Thyme specific: Returns a bit for each child box the ray may touch. The boxes are grown by the pad of the ray so that
+ * no box is missed that CollisionMath::Overlap_Test would have accepted.
+ */
+int AABTreeClass::Overlap_Quad(const QuadNodeStruct &quad, const QuadRayStruct &ray)
+{
+#ifdef AABTREE_USE_SSE
+    __m128 pad = _mm_set1_ps(ray.m_pad);
+    __m128 start = _mm_set1_ps(ray.m_start.X);
+    __m128 inv = _mm_set1_ps(ray.m_invDir.X);
+    __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(quad.m_minX), pad), start), inv);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(quad.m_maxX), pad), start), inv);
+    __m128 t_near = _mm_min_ps(t0, t1);
+    __m128 t_far = _mm_max_ps(t0, t1);
+
+    start = _mm_set1_ps(ray.m_start.Y);
+    inv = _mm_set1_ps(ray.m_invDir.Y);
+    t0 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(quad.m_minY), pad), start), inv);
+    t1 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(quad.m_maxY), pad), start), inv);
+    t_near = _mm_max_ps(t_near, _mm_min_ps(t0, t1));
+    t_far = _mm_min_ps(t_far, _mm_max_ps(t0, t1));
+
+    start = _mm_set1_ps(ray.m_start.Z);
+    inv = _mm_set1_ps(ray.m_invDir.Z);
+    t0 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(quad.m_minZ), pad), start), inv);
+    t1 = _mm_mul_ps(_mm_sub_ps(_mm_add_ps(_mm_loadu_ps(quad.m_maxZ), pad), start), inv);
+    t_near = _mm_max_ps(t_near, _mm_min_ps(t0, t1));
+    t_far = _mm_min_ps(t_far, _mm_max_ps(t0, t1));
+
+    __m128 hit = _mm_and_ps(_mm_cmple_ps(t_near, t_far),
+        _mm_and_ps(_mm_cmpge_ps(t_far, _mm_setzero_ps()), _mm_cmple_ps(t_near, _mm_set1_ps(1.0f))));
+
+    return _mm_movemask_ps(hit);
+#else
+    const float *mins[3] = { quad.m_minX, quad.m_minY, quad.m_minZ };
+    const float *maxs[3] = { quad.m_maxX, quad.m_maxY, quad.m_maxZ };
+    int mask = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        float t_near = -FLT_MAX;
+        float t_far = FLT_MAX;
+
+        for (int axis = 0; axis < 3; ++axis) {
+            float t0 = (mins[axis][i] - ray.m_pad - ray.m_start[axis]) * ray.m_invDir[axis];
+            float t1 = (maxs[axis][i] + ray.m_pad - ray.m_start[axis]) * ray.m_invDir[axis];
+            t_near = std::max(t_near, std::min(t0, t1));
+            t_far = std::min(t_far, std::max(t0, t1));
+        }
+
+        if (t_near <= t_far && t_far >= 0.0f && t_near <= 1.0f) {
+            mask |= 1 << i;
+        }
+    }
+
+    return mask;
+#endif
+}
+
+/**
+ * Thyme specific: Returns a bit for each child box that overlaps the box from min to max. This is exactly the test of
+ * the Cull functions of the box queries.
+ */
+int AABTreeClass::Overlap_Quad(const QuadNodeStruct &quad, const Vector3 &min, const Vector3 &max)
+{
+#ifdef AABTREE_USE_SSE
+    __m128 out = _mm_or_ps(_mm_cmpgt_ps(_mm_set1_ps(min.X), _mm_loadu_ps(quad.m_maxX)),
+        _mm_cmplt_ps(_mm_set1_ps(max.X), _mm_loadu_ps(quad.m_minX)));
+    out = _mm_or_ps(out, _mm_cmpgt_ps(_mm_set1_ps(min.Y), _mm_loadu_ps(quad.m_maxY)));
+    out = _mm_or_ps(out, _mm_cmplt_ps(_mm_set1_ps(max.Y), _mm_loadu_ps(quad.m_minY)));
+    out = _mm_or_ps(out, _mm_cmpgt_ps(_mm_set1_ps(min.Z), _mm_loadu_ps(quad.m_maxZ)));
+    out = _mm_or_ps(out, _mm_cmplt_ps(_mm_set1_ps(max.Z), _mm_loadu_ps(quad.m_minZ)));
+
+    return ~_mm_movemask_ps(out) & 0xF;
+#else
+    int mask = 0;
+
+    for (int i = 0; i < 4; ++i) {
+        if (!(min.X > quad.m_maxX[i] || max.X < quad.m_minX[i] || min.Y > quad.m_maxY[i] || max.Y < quad.m_minY[i]
+                || min.Z > quad.m_maxZ[i] || max.Z < quad.m_minZ[i])) {
+            mask |= 1 << i;
+        }
+    }
+
+    return mask;
+#endif
+}
+
+/**
+ * Thyme specific: Visits the leaves in the same order as the recursive functions, so that queries that keep the last
+ * of equally close hits give the same result.
+ */
+template<typename CullType, typename LeafType> bool AABTreeClass::Traverse_Quad_Nodes(CullType cull, LeafType leaf)
+{
+    uint32_t stack[QUAD_STACK_SIZE];
+    int top = 0;
+    bool res = false;
+    stack[top++] = 0;
+
+    while (top > 0) {
+        uint32_t code = stack[--top];
+
+        if ((code & AABTREE_LEAF_FLAG) != 0) {
+            res |= leaf(&m_nodes[code & ~AABTREE_LEAF_FLAG]);
+            continue;
+        }
+
+        const QuadNodeStruct &quad = m_quadNodes[code];
+        int mask = cull(quad);
+
+        for (int i = 3; i >= 0; --i) {
+            if ((mask & (1 << i)) != 0 && quad.m_child[i] != QUAD_EMPTY) {
+                stack[top++] = quad.m_child[i];
+            }
+        }
+    }
+
+    return res;
+}
+
+bool AABTreeClass::Cast_Ray_Quad(RayCollisionTestClass &raytest)
+{
+    if (raytest.Cull(m_nodes[0].m_min, m_nodes[0].m_max)) {
+        return false;
+    }
+
+    QuadRayStruct ray;
+    Init_Quad_Ray(raytest, ray);
+
+    return Traverse_Quad_Nodes([&](const QuadNodeStruct &quad) { return Overlap_Quad(quad, ray); },
+        [&](CullNodeStruct *node) {
+            return !raytest.Cull(node->m_min, node->m_max) && Cast_Ray_To_Polys(node, raytest);
+        });
+}
+
+bool AABTreeClass::Cast_AABox_Quad(AABoxCollisionTestClass &boxtest)
+{
+    if (boxtest.Cull(m_nodes[0].m_min, m_nodes[0].m_max)) {
+        return false;
+    }
+
+    return Traverse_Quad_Nodes(
+        [&](const QuadNodeStruct &quad) { return Overlap_Quad(quad, boxtest.m_sweepMin, boxtest.m_sweepMax); },
+        [&](CullNodeStruct *node) { return Cast_AABox_To_Polys(node, boxtest); });
+}
+
+bool AABTreeClass::Cast_OBBox_Quad(OBBoxCollisionTestClass &boxtest)
+{
+    if (boxtest.Cull(m_nodes[0].m_min, m_nodes[0].m_max)) {
+        return false;
+    }
+
+    return Traverse_Quad_Nodes(
+        [&](const QuadNodeStruct &quad) { return Overlap_Quad(quad, boxtest.m_sweepMin, boxtest.m_sweepMax); },
+        [&](CullNodeStruct *node) { return Cast_OBBox_To_Polys(node, boxtest); });
+}
+
+bool AABTreeClass::Intersect_OBBox_Quad(OBBoxIntersectionTestClass &boxtest)
+{
+    if (boxtest.Cull(m_nodes[0].m_min, m_nodes[0].m_max)) {
+        return false;
+    }
+
+    Vector3 box_min = boxtest.m_boundingBox.m_center - boxtest.m_boundingBox.m_extent;
+    Vector3 box_max = boxtest.m_boundingBox.m_center + boxtest.m_boundingBox.m_extent;
+
+    return Traverse_Quad_Nodes([&](const QuadNodeStruct &quad) { return Overlap_Quad(quad, box_min, box_max); },
+        [&](CullNodeStruct *node) { return Intersect_OBBox_With_Polys(node, boxtest); });
+}
+
+/**
+ * Thyme specific: Casts several rays at once, every node is fetched once for all rays of a packet that reach it. Each
+ * test gets the same result as from Cast_Ray, returns how many of them hit something.
+ */
+int AABTreeClass::Cast_Rays(RayCollisionTestClass *const *raytests, int count)
+{
+    captainslog_assert(m_nodes != nullptr);
+    int hits = 0;
+
+    if (m_quadNodes == nullptr || !s_quadNodesEnabled) {
+        for (int i = 0; i < count; ++i) {
+            hits += Cast_Ray(*raytests[i]) ? 1 : 0;
+        }
+
+        return hits;
+    }
+
+    struct PacketEntryStruct
+    {
+        uint32_t code;
+        uint32_t rays;
+    };
+
+    QuadRayStruct rays[QUAD_RAY_PACKET];
+    PacketEntryStruct stack[QUAD_STACK_SIZE];
+
+    for (int first = 0; first < count; first += QUAD_RAY_PACKET) {
+        RayCollisionTestClass *const *tests = &raytests[first];
+        int packet = std::min<int>(count - first, QUAD_RAY_PACKET);
+        uint32_t active = 0;
+        uint32_t hit = 0;
+
+        for (int i = 0; i < packet; ++i) {
+            if (!tests[i]->Cull(m_nodes[0].m_min, m_nodes[0].m_max)) {
+                Init_Quad_Ray(*tests[i], rays[i]);
+                active |= 1u << i;
+            }
+        }
+
+        int top = 0;
+
+        if (active != 0) {
+            stack[top++] = { 0, active };
+        }
+
+        while (top > 0) {
+            PacketEntryStruct entry = stack[--top];
+
+            if ((entry.code & AABTREE_LEAF_FLAG) != 0) {
+                CullNodeStruct *node = &m_nodes[entry.code & ~AABTREE_LEAF_FLAG];
+
+                for (uint32_t bits = entry.rays; bits != 0; bits &= bits - 1) {
+                    int i = Lowest_Bit(bits);
+
+                    if (!tests[i]->Cull(node->m_min, node->m_max) && Cast_Ray_To_Polys(node, *tests[i])) {
+                        hit |= 1u << i;
+                    }
+                }
+
+                continue;
+            }
+
+            const QuadNodeStruct &quad = m_quadNodes[entry.code];
+            uint32_t child_rays[4] = { 0, 0, 0, 0 };
+
+            for (uint32_t bits = entry.rays; bits != 0; bits &= bits - 1) {
+                int i = Lowest_Bit(bits);
+                int mask = Overlap_Quad(quad, rays[i]);
+                uint32_t ray_bit = 1u << i;
+                child_rays[0] |= (mask & 1) != 0 ? ray_bit : 0;
+                child_rays[1] |= (mask & 2) != 0 ? ray_bit : 0;
+                child_rays[2] |= (mask & 4) != 0 ? ray_bit : 0;
+                child_rays[3] |= (mask & 8) != 0 ? ray_bit : 0;
+            }
+
+            for (int j = 3; j >= 0; --j) {
+                if (child_rays[j] != 0 && quad.m_child[j] != QUAD_EMPTY) {
+                    stack[top++] = { quad.m_child[j], child_rays[j] };
+                }
+            }
+        }
+
+        for (int i = 0; i < packet; ++i) {
+            hits += (hit >> i) & 1;
+        }
+    }
+
+    return hits;
 }
+#endif
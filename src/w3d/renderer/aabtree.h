@@ -63,6 +63,12 @@ public:
     bool Cast_OBBox(OBBoxCollisionTestClass &boxtest);
     bool Intersect_OBBox(OBBoxIntersectionTestClass &boxtest);
     void Scale(float scale);
+#ifndef GAME_DLL
+    int Cast_Rays(RayCollisionTestClass *const *raytests, int count);
+
+    // Thyme specific: Lets tests compare the flattened queries against the recursive ones.
+    static void Set_Quad_Nodes_Enabled(bool enabled) { s_quadNodesEnabled = enabled; }
+#endif
 
 private:
     AABTreeClass &operator=(const AABTreeClass &that);
@@ -146,11 +152,61 @@ private:
 
     void Update_Bounding_Boxes_Recursive(CullNodeStruct *node);
 
+#ifndef GAME_DLL
+    enum
+    {
+        QUAD_EMPTY = 0xFFFFFFFF,
+        QUAD_MAX_DEPTH = 48,
+        QUAD_STACK_SIZE = QUAD_MAX_DEPTH * 3 + 1,
+        QUAD_RAY_PACKET = 32,
+    };
+
+    // Thyme specific: Up to four nodes of the binary tree collected below one node, in the order the recursive code
+    // visits them. The boxes are stored per component so that all four are tested at once. Leaf children are
+    // AABTREE_LEAF_FLAG and the index of the CullNodeStruct that holds their polygons, others index m_quadNodes.
+    struct QuadNodeStruct
+    {
+        float m_minX[4];
+        float m_minY[4];
+        float m_minZ[4];
+        float m_maxX[4];
+        float m_maxY[4];
+        float m_maxZ[4];
+        uint32_t m_child[4];
+    };
+
+    struct QuadRayStruct
+    {
+        Vector3 m_start;
+        Vector3 m_invDir;
+        float m_pad;
+    };
+
+    void Build_Quad_Nodes();
+    int Build_Quad_Nodes_Recursive(int index, int depth);
+    void Init_Quad_Ray(const RayCollisionTestClass &raytest, QuadRayStruct &ray) const;
+    static int Overlap_Quad(const QuadNodeStruct &quad, const QuadRayStruct &ray);
+    static int Overlap_Quad(const QuadNodeStruct &quad, const Vector3 &min, const Vector3 &max);
+    template<typename CullType, typename LeafType> bool Traverse_Quad_Nodes(CullType cull, LeafType leaf);
+
+    bool Cast_Ray_Quad(RayCollisionTestClass &raytest);
+    bool Cast_AABox_Quad(AABoxCollisionTestClass &boxtest);
+    bool Cast_OBBox_Quad(OBBoxCollisionTestClass &boxtest);
+    bool Intersect_OBBox_Quad(OBBoxIntersectionTestClass &boxtest);
+#endif
+
     int m_nodeCount;
     CullNodeStruct *m_nodes;
     int m_polyCount;
     uint32_t *m_polyIndices;
     MeshGeometryClass *m_mesh;
+#ifndef GAME_DLL
+    int m_quadNodeCount;
+    QuadNodeStruct *m_quadNodes;
+    float m_quadPad;
+
+    static bool s_quadNodesEnabled;
+#endif
 
     friend class MeshClass;
     friend class MeshGeometryClass;
@@ -160,12 +216,22 @@ private:
 
 inline int AABTreeClass::Compute_Ram_Size()
 {
+#ifndef GAME_DLL
+    return m_nodeCount * sizeof(CullNodeStruct) + m_quadNodeCount * sizeof(QuadNodeStruct) + m_polyCount * sizeof(int)
+        + sizeof(AABTreeClass);
+#else
     return m_nodeCount * sizeof(CullNodeStruct) + m_polyCount * sizeof(int) + sizeof(AABTreeClass);
+#endif
 }
 
 inline bool AABTreeClass::Cast_Ray(RayCollisionTestClass &raytest)
 {
     captainslog_assert(m_nodes != nullptr);
+#ifndef GAME_DLL
+    if (m_quadNodes != nullptr && s_quadNodesEnabled) {
+        return Cast_Ray_Quad(raytest);
+    }
+#endif
     return Cast_Ray_Recursive(&(m_nodes[0]), raytest);
 }
 
@@ -188,18 +254,33 @@ inline int AABTreeClass::Cast_Semi_Infinite_Axis_Aligned_Ray(const Vector3 &star
 inline bool AABTreeClass::Cast_AABox(AABoxCollisionTestClass &boxtest)
 {
     captainslog_assert(m_nodes != nullptr);
+#ifndef GAME_DLL
+    if (m_quadNodes != nullptr && s_quadNodesEnabled) {
+        return Cast_AABox_Quad(boxtest);
+    }
+#endif
     return Cast_AABox_Recursive(&(m_nodes[0]), boxtest);
 }
 
 inline bool AABTreeClass::Cast_OBBox(OBBoxCollisionTestClass &boxtest)
 {
     captainslog_assert(m_nodes != nullptr);
+#ifndef GAME_DLL
+    if (m_quadNodes != nullptr && s_quadNodesEnabled) {
+        return Cast_OBBox_Quad(boxtest);
+    }
+#endif
     return Cast_OBBox_Recursive(&(m_nodes[0]), boxtest);
 }
 
 inline bool AABTreeClass::Intersect_OBBox(OBBoxIntersectionTestClass &boxtest)
 {
     captainslog_assert(m_nodes != nullptr);
+#ifndef GAME_DLL
+    if (m_quadNodes != nullptr && s_quadNodesEnabled) {
+        return Intersect_OBBox_Quad(boxtest);
+    }
+#endif
     return Intersect_OBBox_Recursive(&(m_nodes[0]), boxtest);
 }
 
@@ -207,6 +288,9 @@ inline void AABTreeClass::Update_Bounding_Boxes()
 {
     captainslog_assert(m_nodes != nullptr);
     Update_Bounding_Boxes_Recursive(&(m_nodes[0]));
+#ifndef GAME_DLL
+    Build_Quad_Nodes();
+#endif
 }
 
 inline bool AABTreeClass::CullNodeStruct::Is_Leaf()
@@ -14,12 +14,35 @@
  */
 #include "aabtreebuilder.h"
 #include "chunkio.h"
+#include "colmath.h"
+#include "lineseg.h"
 #include "w3d_file.h"
+#include <algorithm>
+#include <thread>
 
 const float COINCIDENCE_EPSILON = 0.001f;
 
+AABTreeBuilderClass::BuildMethodType AABTreeBuilderClass::s_buildMethod = AABTreeBuilderClass::BUILD_BINNED_SAH;
+
+namespace
+{
+// Half of the surface area, the probability of a ray hitting a box is proportional to it.
+float Half_Area(const Vector3 &min, const Vector3 &max)
+{
+    Vector3 d = max - min;
+    return d.X * d.Y + d.Y * d.Z + d.Z * d.X;
+}
+} // namespace
+
 AABTreeBuilderClass::AABTreeBuilderClass() :
-    m_root(nullptr), m_curPolyIndex(0), m_polyCount(0), m_polys(nullptr), m_vertCount(0), m_verts(nullptr)
+    m_root(nullptr),
+    m_curPolyIndex(0),
+    m_polyCount(0),
+    m_polys(nullptr),
+    m_vertCount(0),
+    m_verts(nullptr),
+    m_polyMin(nullptr),
+    m_polyMax(nullptr)
 {
 }
 
@@ -74,12 +97,7 @@ void AABTreeBuilderClass::Build_AABTree(int polycount, TriIndex *polys, int vert
         polyindices[i] = i;
     }
 
-    m_root = new CullNodeStruct;
-    Build_Tree(m_root, m_polyCount, polyindices);
-    polyindices = nullptr;
-
-    Compute_Bounding_Box(m_root);
-    Assign_Index(m_root, 0);
+    Build_Root(polyindices);
 }
 
 void AABTreeBuilderClass::Build_AABTree(int polycount, Vector3i *polys, int vertcount, Vector3 *verts)
@@ -112,9 +130,33 @@ void AABTreeBuilderClass::Build_AABTree(int polycount, Vector3i *polys, int vert
         polyindices[i] = i;
     }
 
+    Build_Root(polyindices);
+}
+
+void AABTreeBuilderClass::Build_Root(int *polyindices)
+{
     m_root = new CullNodeStruct;
-    Build_Tree(m_root, m_polyCount, polyindices);
-    polyindices = nullptr;
+
+    if (s_buildMethod == BUILD_BINNED_SAH) {
+        m_polyMin = new Vector3[m_polyCount];
+        m_polyMax = new Vector3[m_polyCount];
+
+        for (int i = 0; i < m_polyCount; i++) {
+            m_polyMin[i] = m_verts[m_polys[i].I];
+            m_polyMax[i] = m_polyMin[i];
+            Update_Min_Max(i, m_polyMin[i], m_polyMax[i]);
+        }
+
+        // The leaves copy their part of the indices, so the array is only used as scratch space for partitioning.
+        Build_Tree_SAH(m_root, m_polyCount, polyindices, 0);
+        delete[] polyindices;
+        delete[] m_polyMin;
+        delete[] m_polyMax;
+        m_polyMin = nullptr;
+        m_polyMax = nullptr;
+    } else {
+        Build_Tree(m_root, m_polyCount, polyindices);
+    }
 
     Compute_Bounding_Box(m_root);
     Assign_Index(m_root, 0);
@@ -158,6 +200,150 @@ void AABTreeBuilderClass::Build_Tree(CullNodeStruct *node, int polycount, int *p
     }
 }
 
+/**
+ * Thyme specific: Splits the polygons with a binned surface area heuristic. Every level only does a linear pass over
+ * the polygons and the result doesn't depend on rand(), large subtrees are built on worker threads.
+ */
+void AABTreeBuilderClass::Build_Tree_SAH(CullNodeStruct *node, int polycount, int *polyindices, int depth)
+{
+    if (polycount <= MIN_POLYS_PER_NODE) {
+        node->m_polyCount = polycount;
+        node->m_polyIndices = new int[polycount];
+
+        for (int i = 0; i < polycount; i++) {
+            node->m_polyIndices[i] = polyindices[i];
+        }
+
+        return;
+    }
+
+    int front_count = Split_Polys_SAH(polycount, polyindices);
+    captainslog_assert(front_count > 0 && front_count < polycount);
+
+    node->m_front = new CullNodeStruct;
+    node->m_back = new CullNodeStruct;
+
+    // The halves never share polygon indices or nodes, so a large front half can be built on another thread without
+    // any locking. ThreadClass isn't used as the thread tracker it registers with isn't thread safe.
+    if (polycount >= SAH_PARALLEL_MIN_POLYS && depth < SAH_PARALLEL_MAX_DEPTH) {
+        std::thread thread(
+            &AABTreeBuilderClass::Build_Tree_SAH, this, node->m_front, front_count, polyindices, depth + 1);
+        Build_Tree_SAH(node->m_back, polycount - front_count, polyindices + front_count, depth + 1);
+        thread.join();
+    } else {
+        Build_Tree_SAH(node->m_front, front_count, polyindices, depth + 1);
+        Build_Tree_SAH(node->m_back, polycount - front_count, polyindices + front_count, depth + 1);
+    }
+}
+
+/**
+ * Thyme specific: Sorts the polygon centers of all three axes into bins and picks the boundary between two bins with
+ * the lowest surface area cost. Moves the front polygons to the start of the array and returns how many there are.
+ */
+int AABTreeBuilderClass::Split_Polys_SAH(int polycount, int *polyindices)
+{
+    const float really_big = GAMEMATH_FLOAT_MAX;
+
+    // Centers are kept doubled, min + max, which doesn't change what goes into which bin.
+    Vector3 center_min(really_big, really_big, really_big);
+    Vector3 center_max(-really_big, -really_big, -really_big);
+
+    for (int i = 0; i < polycount; i++) {
+        Vector3 center = m_polyMin[polyindices[i]] + m_polyMax[polyindices[i]];
+        center_min.Update_Min(center);
+        center_max.Update_Max(center);
+    }
+
+    float scale[3];
+
+    for (int axis = 0; axis < 3; axis++) {
+        float extent = center_max[axis] - center_min[axis];
+        scale[axis] = extent > 0.0f ? SAH_BIN_COUNT / extent : 0.0f;
+    }
+
+    int bin_count[3][SAH_BIN_COUNT] = {};
+    Vector3 bin_min[3][SAH_BIN_COUNT];
+    Vector3 bin_max[3][SAH_BIN_COUNT];
+
+    for (int axis = 0; axis < 3; axis++) {
+        for (int bin = 0; bin < SAH_BIN_COUNT; bin++) {
+            bin_min[axis][bin].Set(really_big, really_big, really_big);
+            bin_max[axis][bin].Set(-really_big, -really_big, -really_big);
+        }
+    }
+
+    for (int i = 0; i < polycount; i++) {
+        const Vector3 &min = m_polyMin[polyindices[i]];
+        const Vector3 &max = m_polyMax[polyindices[i]];
+        Vector3 center = min + max;
+
+        for (int axis = 0; axis < 3; axis++) {
+            int bin = std::min(int((center[axis] - center_min[axis]) * scale[axis]), SAH_BIN_COUNT - 1);
+            bin_count[axis][bin]++;
+            bin_min[axis][bin].Update_Min(min);
+            bin_max[axis][bin].Update_Max(max);
+        }
+    }
+
+    float best_cost = FLT_MAX;
+    int best_axis = -1;
+    int best_bin = 0;
+
+    for (int axis = 0; axis < 3; axis++) {
+        if (scale[axis] == 0.0f) {
+            continue;
+        }
+
+        // Cost of everything above each bin boundary, gathered from the top down.
+        float back_cost[SAH_BIN_COUNT];
+        Vector3 min(really_big, really_big, really_big);
+        Vector3 max(-really_big, -really_big, -really_big);
+        int count = 0;
+
+        for (int bin = SAH_BIN_COUNT - 1; bin > 0; bin--) {
+            count += bin_count[axis][bin];
+            min.Update_Min(bin_min[axis][bin]);
+            max.Update_Max(bin_max[axis][bin]);
+            back_cost[bin] = count > 0 ? Half_Area(min, max) * count : FLT_MAX;
+        }
+
+        min.Set(really_big, really_big, really_big);
+        max.Set(-really_big, -really_big, -really_big);
+        count = 0;
+
+        for (int bin = 0; bin < SAH_BIN_COUNT - 1; bin++) {
+            count += bin_count[axis][bin];
+            min.Update_Min(bin_min[axis][bin]);
+            max.Update_Max(bin_max[axis][bin]);
+
+            if (count == 0 || back_cost[bin + 1] == FLT_MAX) {
+                continue;
+            }
+
+            float cost = Half_Area(min, max) * count + back_cost[bin + 1];
+
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = bin;
+            }
+        }
+    }
+
+    // All centers are in the same spot, any split is as good as another.
+    if (best_axis == -1) {
+        return polycount / 2;
+    }
+
+    int *split = std::partition(polyindices, polyindices + polycount, [&](int poly_index) {
+        Vector3 center = m_polyMin[poly_index] + m_polyMax[poly_index];
+        int bin = std::min(int((center[best_axis] - center_min[best_axis]) * scale[best_axis]), SAH_BIN_COUNT - 1);
+        return bin <= best_bin;
+    });
+
+    return int(split - polyindices);
+}
+
 AABTreeBuilderClass::SplitChoiceStruct AABTreeBuilderClass::Select_Splitting_Plane(int polycount, int *polyindices)
 {
     captainslog_assert(polyindices != nullptr);
@@ -411,6 +597,37 @@ int AABTreeBuilderClass::Poly_Count()
     return m_polyCount;
 }
 
+/**
+ * Thyme specific: Counts the nodes a ray cast with this tree would visit, to compare the quality of trees.
+ */
+int AABTreeBuilderClass::Count_Ray_Visits(const LineSegClass &ray)
+{
+    if (m_root) {
+        return Count_Ray_Visits_Recursive(m_root, ray);
+    } else {
+        return 0;
+    }
+}
+
+int AABTreeBuilderClass::Count_Ray_Visits_Recursive(CullNodeStruct *node, const LineSegClass &ray)
+{
+    int count = 1;
+
+    if (CollisionMath::Overlap_Test(node->m_min, node->m_max, ray) == CollisionMath::POS) {
+        return count;
+    }
+
+    if (node->m_front) {
+        count += Count_Ray_Visits_Recursive(node->m_front, ray);
+    }
+
+    if (node->m_back) {
+        count += Count_Ray_Visits_Recursive(node->m_back, ray);
+    }
+
+    return count;
+}
+
 int AABTreeBuilderClass::Node_Count_Recursive(CullNodeStruct *node, int curcount)
 {
     curcount++;
@@ -22,6 +22,7 @@
 
 class AABTreeClass;
 class ChunkSaveClass;
+class LineSegClass;
 struct W3dMeshAABTreeNode;
 
 #define AABTREE_LEAF_FLAG 0x80000000
@@ -43,9 +44,23 @@ public:
     {
         MIN_POLYS_PER_NODE = 4,
         SMALL_VERTEX = -100000,
-        BIG_VERTEX = 100000
+        BIG_VERTEX = 100000,
+        SAH_BIN_COUNT = 16,
+        SAH_PARALLEL_MIN_POLYS = 4096,
+        SAH_PARALLEL_MAX_DEPTH = 3,
     };
 
+    enum BuildMethodType
+    {
+        BUILD_RANDOM_PLANES,
+        BUILD_BINNED_SAH,
+    };
+
+    // Thyme specific: The original builder tries random vertex planes, which is slow and gives a different tree each
+    // time. It is kept so the binned surface area heuristic builder can be compared against it.
+    static void Set_Build_Method(BuildMethodType method) { s_buildMethod = method; }
+    int Count_Ray_Visits(const LineSegClass &ray);
+
 private:
     struct CullNodeStruct
     {
@@ -131,7 +146,10 @@ private:
     };
 
     void Reset();
+    void Build_Root(int *polyindices);
     void Build_Tree(CullNodeStruct *node, int polycount, int *polyindices);
+    void Build_Tree_SAH(CullNodeStruct *node, int polycount, int *polyindices, int depth);
+    int Split_Polys_SAH(int polycount, int *polyindices);
     SplitChoiceStruct Select_Splitting_Plane(int polycount, int *polyindices);
     SplitChoiceStruct Compute_Plane_Score(int polycont, int *polyindices, const AAPlaneClass &plane);
     void Split_Polys(int polycount, int *polyindices, const SplitChoiceStruct &sc, SplitArraysStruct *arrays);
@@ -139,6 +157,7 @@ private:
     void Compute_Bounding_Box(CullNodeStruct *node);
     int Assign_Index(CullNodeStruct *node, int index);
     int Node_Count_Recursive(CullNodeStruct *node, int curcount);
+    int Count_Ray_Visits_Recursive(CullNodeStruct *node, const LineSegClass &ray);
     void Update_Min(int poly_index, Vector3 &set_min);
     void Update_Max(int poly_index, Vector3 &set_max);
     void Update_Min_Max(int poly_index, Vector3 &set_min, Vector3 &set_max);
@@ -153,5 +172,11 @@ private:
     int m_vertCount;
     Vector3 *m_verts;
 
+    // Bounds of each polygon, only kept while the binned builder runs.
+    Vector3 *m_polyMin;
+    Vector3 *m_polyMax;
+
+    static BuildMethodType s_buildMethod;
+
     friend class AABTreeClass;
 };
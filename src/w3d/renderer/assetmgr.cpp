@@ -20,9 +20,13 @@
 #include "dx8renderer.h"
 #include "ffactory.h"
 #include "hanim.h"
+#include "hcanim.h"
 #include "hlod.h"
+#include "hrawanim.h"
+#include "htree.h"
 #include "loaders.h"
 #include "matinfo.h"
+#include "memdynalloc.h"
 #include "mesh.h"
 #include "meshmdl.h"
 #include "part_ldr.h"
@@ -35,8 +39,12 @@
 #include "w3d_file.h"
 #include "w3dexclusionlist.h"
 #include "wwfile.h"
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <stdio.h>
+#include <thread>
+#include <vector>
 
 #ifndef GAME_DLL
 W3DAssetManager *W3DAssetManager::s_theInstance;
@@ -159,27 +167,325 @@ bool W3DAssetManager::Load_3D_Assets(FileClass &asset_file)
         return false;
     }
 
-    for (ChunkLoadClass chunk(&asset_file); chunk.Open_Chunk(); chunk.Close_Chunk()) {
-        auto chunk_id = chunk.Cur_Chunk_ID();
-        switch (chunk_id) {
+#ifndef GAME_DLL
+    // Thyme specific: Fetch the whole file with one read, the loaders then read their many small fields from memory
+    // instead of making a virtual file call for each one.
+    int size = asset_file.Size();
+
+    if (size > 0) {
+        uint8_t *buffer = new uint8_t[size];
+
+        if (asset_file.Read(buffer, size) == size) {
+            asset_file.Close();
+            ChunkLoadClass chunk(buffer, size);
+            Load_3D_Asset_Chunks(chunk);
+            delete[] buffer;
+            return true;
+        }
+
+        delete[] buffer;
+        asset_file.Seek(0, FS_SEEK_START);
+    }
+#endif
+
+    ChunkLoadClass chunk(&asset_file);
+    Load_3D_Asset_Chunks(chunk);
+    asset_file.Close();
+    return true;
+}
+
+void W3DAssetManager::Load_3D_Asset_Chunks(ChunkLoadClass &cload)
+{
+    while (cload.Open_Chunk()) {
+        switch (cload.Cur_Chunk_ID()) {
             case W3D_CHUNK_COMPRESSED_ANIMATION:
             case W3D_CHUNK_ANIMATION:
             case W3D_CHUNK_MORPH_ANIMATION:
-                m_hAnimManager.Load_Anim(chunk);
+                m_hAnimManager.Load_Anim(cload);
                 break;
             case W3D_CHUNK_HIERARCHY:
-                m_hTreeManager.Load_Tree(chunk);
+                m_hTreeManager.Load_Tree(cload);
                 break;
             default:
-                Load_Prototype(chunk);
+                Load_Prototype(cload);
                 break;
         }
+
+        cload.Close_Chunk();
     }
+}
 
-    asset_file.Close();
-    return true;
+#ifndef GAME_DLL
+namespace
+{
+// A top level chunk of a prefetched file. Trees and animations are created up front on the calling thread so the
+// workers only run Load_W3D on them.
+struct PrefetchChunkStruct
+{
+    uint32_t id;
+    HTreeClass *tree;
+    HAnimClass *anim;
+    bool loaded;
+};
+
+struct PrefetchFileStruct
+{
+    uint8_t *buffer;
+    int size;
+    std::vector<PrefetchChunkStruct> chunks;
+};
+
+uint8_t *Read_Asset_File(const char *filename, int &size)
+{
+    auto file = g_theFileFactory->Get_File(filename);
+
+    if (file == nullptr) {
+        return nullptr;
+    }
+
+    uint8_t *buffer = nullptr;
+
+    if (file->Is_Available() && file->Open()) {
+        size = file->Size();
+
+        if (size > 0) {
+            buffer = new uint8_t[size];
+
+            if (file->Read(buffer, size) != size) {
+                delete[] buffer;
+                buffer = nullptr;
+            }
+        }
+
+        file->Close();
+    }
+
+    g_theFileFactory->Return_File(file);
+
+    return buffer;
+}
+
+bool Contains_Name(const DynamicVectorClass<StringClass> &names, const char *name)
+{
+    for (int i = 0; i < names.Count(); ++i) {
+        if (strcasecmp(names[i], name) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Loads either the trees or the animations of each file the thread claims from next_file.
+void Parse_Prefetch_Files(std::vector<PrefetchFileStruct> &files, std::atomic<size_t> &next_file, bool anims)
+{
+    for (size_t i = next_file++; i < files.size(); i = next_file++) {
+        ChunkLoadClass cload(files[i].buffer, files[i].size);
+
+        for (PrefetchChunkStruct &chunk : files[i].chunks) {
+            if (!cload.Open_Chunk()) {
+                break;
+            }
+
+            if (!anims && chunk.tree != nullptr) {
+                chunk.loaded = chunk.tree->Load_W3D(cload) == 0;
+            } else if (anims && chunk.id == W3D_CHUNK_ANIMATION) {
+                chunk.loaded = static_cast<HRawAnimClass *>(chunk.anim)->Load_W3D(cload) == W3D_ERROR_OK;
+            } else if (anims && chunk.id == W3D_CHUNK_COMPRESSED_ANIMATION) {
+                chunk.loaded = static_cast<HCompressedAnimClass *>(chunk.anim)->Load_W3D(cload) == W3D_ERROR_OK;
+            }
+
+            cload.Close_Chunk();
+        }
+    }
 }
 
+// The calling thread is expected to run Parse_Prefetch_Files as well before joining the returned threads.
+std::vector<std::thread> Start_Prefetch_Threads(
+    std::vector<PrefetchFileStruct> &files, std::atomic<size_t> &next_file, bool anims)
+{
+    size_t count = std::min<size_t>(files.size(), std::max(std::thread::hardware_concurrency(), 1u));
+    std::vector<std::thread> threads;
+
+    for (size_t i = 1; i < count; ++i) {
+        threads.emplace_back(Parse_Prefetch_Files, std::ref(files), std::ref(next_file), anims);
+    }
+
+    return threads;
+}
+} // namespace
+
+// Thyme specific: Loads the files behind a list of render object, hierarchy and animation names ahead of their first
+// use, parsing trees and animations on several threads. The file system, the textures and the managers themselves are
+// not thread safe, so files are read, meshes and other prototypes are loaded and every result is added on the calling
+// thread. Names that are already loaded are skipped.
+void W3DAssetManager::Prefetch_3D_Assets(const DynamicVectorClass<StringClass> &names)
+{
+    // The parsing threads allocate through the dynamic memory allocator, which is only thread safe with its lock set.
+    captainslog_assert(g_dmaCriticalSection != nullptr);
+
+    std::vector<PrefetchFileStruct> files;
+    DynamicVectorClass<StringClass> filenames;
+    DynamicVectorClass<StringClass> hierarchies;
+
+    for (int i = 0; i < names.Count(); ++i) {
+        const char *name = names[i];
+
+        if (Find_Prototype(name) != nullptr || m_hTreeManager.Get_Tree(name) != nullptr
+            || m_hAnimManager.Peek_Anim(name) != nullptr || m_hAnimManager.Is_Missing(name)) {
+            continue;
+        }
+
+        char asset_filename[256]{};
+        const char *period = strchr(name, '.');
+        snprintf(asset_filename, ARRAY_SIZE(asset_filename), "%s.w3d", period == nullptr ? name : period + 1);
+
+        if (Contains_Name(filenames, asset_filename)) {
+            continue;
+        }
+
+        filenames.Add(asset_filename);
+        PrefetchFileStruct file{ nullptr, 0 };
+        file.buffer = Read_Asset_File(asset_filename, file.size);
+
+        if (file.buffer == nullptr) {
+            StringClass new_filename = StringClass{ "..\\", true } + asset_filename;
+            file.buffer = Read_Asset_File(new_filename, file.size);
+        }
+
+        if (file.buffer == nullptr) {
+            captainslog_debug("Missing asset %s", asset_filename);
+            continue;
+        }
+
+        ChunkLoadClass cload(file.buffer, file.size);
+
+        while (cload.Open_Chunk()) {
+            PrefetchChunkStruct chunk{ cload.Cur_Chunk_ID(), nullptr, nullptr, false };
+
+            if (chunk.id == W3D_CHUNK_HIERARCHY) {
+                chunk.tree = new HTreeClass();
+            } else if (chunk.id == W3D_CHUNK_ANIMATION || chunk.id == W3D_CHUNK_COMPRESSED_ANIMATION) {
+                if (chunk.id == W3D_CHUNK_ANIMATION) {
+                    chunk.anim = new HRawAnimClass();
+                } else {
+                    chunk.anim = new HCompressedAnimClass();
+                }
+
+                // Both animation headers start with the same fields, the tree they animate has to be loaded before
+                // the animation is.
+                W3dAnimHeaderStruct header;
+
+                if (cload.Open_Chunk()) {
+                    if (cload.Cur_Chunk_ID() == W3D_CHUNK_ANIMATION_HEADER
+                        || cload.Cur_Chunk_ID() == W3D_CHUNK_COMPRESSED_ANIMATION_HEADER) {
+                        if (cload.Read(&header, sizeof(header)) == sizeof(header)) {
+                            char hierarchy[sizeof(header.HierarchyName) + 1]{};
+                            memcpy(hierarchy, header.HierarchyName, sizeof(header.HierarchyName));
+
+                            if (hierarchy[0] != '\0' && !Contains_Name(hierarchies, hierarchy)) {
+                                hierarchies.Add(hierarchy);
+                            }
+                        }
+                    }
+
+                    cload.Close_Chunk();
+                }
+            }
+
+            file.chunks.push_back(chunk);
+            cload.Close_Chunk();
+        }
+
+        files.push_back(std::move(file));
+    }
+
+    if (files.empty()) {
+        return;
+    }
+
+    std::atomic<size_t> next_file(0);
+    std::vector<std::thread> threads = Start_Prefetch_Threads(files, next_file, false);
+    Parse_Prefetch_Files(files, next_file, false);
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (PrefetchFileStruct &file : files) {
+        for (PrefetchChunkStruct &chunk : file.chunks) {
+            if (chunk.tree == nullptr) {
+                continue;
+            }
+
+            if (chunk.loaded) {
+                m_hTreeManager.Add_Tree(chunk.tree);
+            } else {
+                delete chunk.tree;
+            }
+        }
+    }
+
+    // Trees that were not in the list are loaded here, the animation threads then only look trees up and never load
+    // on demand.
+    for (int i = 0; i < hierarchies.Count(); ++i) {
+        Get_HTree(hierarchies[i]);
+    }
+
+    bool load_on_demand = m_loadOnDemand;
+    m_loadOnDemand = false;
+    next_file = 0;
+    threads = Start_Prefetch_Threads(files, next_file, true);
+
+    // The prototypes are loaded while the other threads work on the animations, nothing in them looks at the trees or
+    // the animations.
+    for (PrefetchFileStruct &file : files) {
+        ChunkLoadClass cload(file.buffer, file.size);
+
+        while (cload.Open_Chunk()) {
+            switch (cload.Cur_Chunk_ID()) {
+                case W3D_CHUNK_COMPRESSED_ANIMATION:
+                case W3D_CHUNK_ANIMATION:
+                case W3D_CHUNK_HIERARCHY:
+                    break;
+                case W3D_CHUNK_MORPH_ANIMATION:
+                    m_hAnimManager.Load_Anim(cload);
+                    break;
+                default:
+                    Load_Prototype(cload);
+                    break;
+            }
+
+            cload.Close_Chunk();
+        }
+    }
+
+    Parse_Prefetch_Files(files, next_file, true);
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    m_loadOnDemand = load_on_demand;
+
+    for (PrefetchFileStruct &file : files) {
+        for (PrefetchChunkStruct &chunk : file.chunks) {
+            if (chunk.anim == nullptr) {
+                continue;
+            }
+
+            if (chunk.loaded && m_hAnimManager.Peek_Anim(chunk.anim->Get_Name()) == nullptr) {
+                m_hAnimManager.Add_Anim(chunk.anim);
+            }
+
+            chunk.anim->Release_Ref();
+        }
+
+        delete[] file.buffer;
+    }
+}
+#endif
+
 // 0x008147C0
 void W3DAssetManager::Free_Assets()
 {
@@ -558,6 +864,9 @@ void W3DAssetManager::Release_Unused_Font3DDatas()
 // 0x008164C0
 void W3DAssetManager::Release_All_FontChars()
 {
+    // Cached sentences hold references to their fonts.
+    Render2DSentenceClass::Flush_Sentence_Cache();
+
     for (auto i = 0; i < m_fontCharsList.Count(); ++i) {
         m_fontCharsList[i]->Release_Ref();
     }
@@ -118,6 +118,9 @@ public:
     PrototypeClass *Find_Prototype(const char *name);
     void Remove_Prototype(PrototypeClass *proto);
     void Remove_Prototype(const char *name);
+#ifndef GAME_DLL
+    void Prefetch_3D_Assets(const DynamicVectorClass<StringClass> &names);
+#endif
 
     bool Get_W3D_Load_On_Demand() const { return m_loadOnDemand; }
     void Set_W3D_Load_On_Demand(bool state) { m_loadOnDemand = state; }
@@ -156,6 +159,7 @@ protected:
 
     PrototypeLoaderClass *Find_Prototype_Loader(int chunk_id);
     bool Load_Prototype(ChunkLoadClass &cload);
+    void Load_3D_Asset_Chunks(ChunkLoadClass &cload);
 
 protected:
     DynamicVectorClass<PrototypeLoaderClass *> m_prototypeLoaders;
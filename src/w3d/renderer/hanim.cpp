@@ -0,0 +1,77 @@
+/**
+ * @file
+ *
+ * @author OmniBlade
+ * @author tomsons26
+ *
+ * @brief Hashed animation base class.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include "hanim.h"
+#include <algorithm>
+
+#ifndef GAME_DLL
+void HAnimClass::Get_Pose(HAnimPoseClass &pose, int count, float frame)
+{
+    Vector3 *translations = pose.Get_Translations();
+    Quaternion *orientations = pose.Get_Orientations();
+
+    for (int i = 0; i < count; ++i) {
+        Get_Translation(translations[i], i, frame);
+        Get_Orientation(orientations[i], i, frame);
+        pose.Set_Visible(i, Get_Visibility(i, frame));
+    }
+}
+
+void HAnimPoseClass::Sample(HAnimClass *anim, int count, float frame)
+{
+    captainslog_assert(count <= anim->Get_Num_Pivots());
+    Resize(count);
+    anim->Get_Pose(*this, count, frame);
+}
+
+/**
+ * Blends pose into this one, a percentage of 0 keeps this pose and 1 gives the other one.
+ */
+void HAnimPoseClass::Blend(const HAnimPoseClass &pose, float percentage)
+{
+    int count = std::min(m_count, pose.m_count);
+    Resize(count);
+
+    for (int i = 0; i < count; ++i) {
+        Vector3::Lerp(m_translations[i], pose.m_translations[i], percentage, &m_translations[i]);
+        Fast_Slerp(m_orientations[i], Quaternion(m_orientations[i]), pose.m_orientations[i], percentage);
+        m_visibility[i] = m_visibility[i] || pose.m_visibility[i];
+    }
+}
+
+/**
+ * Gets count cursors for the channels of anim, they start over when the animation changes.
+ */
+unsigned int *HAnimPoseClass::Get_Cursors(const HAnimClass *anim, int count)
+{
+    if (anim != m_anim || m_cursors.size() != static_cast<size_t>(count)) {
+        m_anim = anim;
+        m_cursors.assign(count, 0);
+    }
+
+    return m_cursors.data();
+}
+
+void HAnimPoseClass::Resize(int count)
+{
+    m_count = count;
+
+    if (m_translations.size() < static_cast<size_t>(count)) {
+        m_translations.resize(count);
+        m_orientations.resize(count);
+        m_visibility.resize(count);
+    }
+}
+#endif
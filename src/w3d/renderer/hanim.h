@@ -18,10 +18,47 @@
 #include "always.h"
 #include "hash.h"
 #include "refcount.h"
+#ifndef GAME_DLL
+#include "quat.h"
+#include "vector3.h"
+#include <vector>
+#endif
 
 class Vector3;
 class Quaternion;
 class Matrix3D;
+class HAnimClass;
+
+#ifndef GAME_DLL
+// Thyme specific: The translation, orientation and visibility of every pivot of an animation at one frame. It also keeps
+// the key cursors of the animation's channels, so it belongs to the object playing the animation and is reused on the
+// following frames.
+class HAnimPoseClass
+{
+public:
+    HAnimPoseClass() : m_anim(nullptr), m_count(0) {}
+
+    void Sample(HAnimClass *anim, int count, float frame);
+    void Blend(const HAnimPoseClass &pose, float percentage);
+
+    int Get_Count() const { return m_count; }
+    Vector3 *Get_Translations() { return m_translations.data(); }
+    Quaternion *Get_Orientations() { return m_orientations.data(); }
+    bool Is_Visible(int pivot) const { return m_visibility[pivot] != 0; }
+    void Set_Visible(int pivot, bool visible) { m_visibility[pivot] = visible; }
+    unsigned int *Get_Cursors(const HAnimClass *anim, int count);
+
+private:
+    void Resize(int count);
+
+    const HAnimClass *m_anim;
+    int m_count;
+    std::vector<Vector3> m_translations;
+    std::vector<Quaternion> m_orientations;
+    std::vector<unsigned char> m_visibility;
+    std::vector<unsigned int> m_cursors;
+};
+#endif
 
 class HAnimClass : public RefCountClass, public HashableClass
 {
@@ -57,6 +94,10 @@ public:
     virtual bool Has_Embedded_Sounds() const { return m_embeddedSoundBoneIndex >= 0; }
     virtual void Set_Embedded_Sound_Bone_Index(int index) { m_embeddedSoundBoneIndex = index; };
     virtual int Get_Embedded_Sound_Bone_Index() { return m_embeddedSoundBoneIndex; }
+#ifndef GAME_DLL
+    // Thyme specific: Samples the first count pivots in one call, animations override it to read their channels directly.
+    virtual void Get_Pose(HAnimPoseClass &pose, int count, float frame);
+#endif
 
 protected:
     int m_embeddedSoundBoneIndex;
@@ -347,6 +347,65 @@ bool HCompressedAnimClass::Get_Visibility(int pividx, float frame)
     return true;
 }
 
+#ifndef GAME_DLL
+/**
+ * Thyme specific: Samples the pivots without a virtual call per pivot and channel. Time coded channels continue the key
+ * search from where the pose found the keys on the last frame.
+ */
+void HCompressedAnimClass::Get_Pose(HAnimPoseClass &pose, int count, float frame)
+{
+    captainslog_assert(count <= m_numNodes);
+    Vector3 *translations = pose.Get_Translations();
+    Quaternion *orientations = pose.Get_Orientations();
+    unsigned int *cursors = pose.Get_Cursors(this, count * CURSOR_COUNT);
+
+    for (int i = 0; i < count; ++i, cursors += CURSOR_COUNT) {
+        NodeCompressedMotionStruct *mot = &m_nodeMotion[i];
+        Vector3 &trans = translations[i];
+        trans.Set(0, 0, 0);
+        orientations[i].Set();
+
+        if (m_flavor == ANIM_FLAVOR_TIMECODED) {
+            if (mot->tc.X) {
+                mot->tc.X->Get_Vector(frame, &trans.X, cursors[CURSOR_X]);
+            }
+
+            if (mot->tc.Y) {
+                mot->tc.Y->Get_Vector(frame, &trans.Y, cursors[CURSOR_Y]);
+            }
+
+            if (mot->tc.Z) {
+                mot->tc.Z->Get_Vector(frame, &trans.Z, cursors[CURSOR_Z]);
+            }
+
+            if (mot->tc.Q) {
+                orientations[i] = mot->tc.Q->Get_Quat_Vector(frame, cursors[CURSOR_Q]);
+            }
+        } else if (m_flavor == ANIM_FLAVOR_ADAPTIVE_DELTA) {
+            if (mot->ad.X) {
+                mot->ad.X->Get_Vector(frame, &trans.X);
+            }
+
+            if (mot->ad.Y) {
+                mot->ad.Y->Get_Vector(frame, &trans.Y);
+            }
+
+            if (mot->ad.Z) {
+                mot->ad.Z->Get_Vector(frame, &trans.Z);
+            }
+
+            if (mot->ad.Q) {
+                orientations[i] = mot->ad.Q->Get_Quat_Vector(frame);
+            }
+        } else {
+            captainslog_assert(0);
+        }
+
+        pose.Set_Visible(i, mot->Vis == nullptr || mot->Vis->Get_Bit(frame, cursors[CURSOR_VIS]) == 1);
+    }
+}
+#endif
+
 bool HCompressedAnimClass::Is_Node_Motion_Present(int pividx)
 {
     captainslog_assert((pividx >= 0) && (pividx < m_numNodes));
@@ -80,6 +80,9 @@ public:
     virtual bool Has_Z_Translation(int pividx) override;
     virtual bool Has_Rotation(int pividx) override;
     virtual bool Has_Visibility(int pividx) override;
+#ifndef GAME_DLL
+    virtual void Get_Pose(HAnimPoseClass &pose, int count, float frame) override;
+#endif
 
     HCompressedAnimClass();
     W3DErrorType Load_W3D(ChunkLoadClass &cload);
@@ -94,6 +97,17 @@ public:
     int Get_Flavor() { return m_flavor; }
 
 private:
+    enum
+    {
+        // Thyme specific: Key cursors a pose keeps for each pivot, one per channel.
+        CURSOR_X,
+        CURSOR_Y,
+        CURSOR_Z,
+        CURSOR_Q,
+        CURSOR_VIS,
+        CURSOR_COUNT,
+    };
+
     char m_name[32];
     char m_hierarchyName[16];
     int m_numFrames;
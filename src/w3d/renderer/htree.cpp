@@ -17,17 +17,193 @@
 #include "hanim.h"
 #include "hrawanim.h"
 #include "quat.h"
+#include "vp.h"
+#include "w3d.h"
 #include "w3d_file.h"
+#include <algorithm>
 #include <cstring>
 #include <strings.h>
 
 using std::memcpy;
 using std::strcpy;
 
+#ifndef GAME_DLL
+/**
+ * Thyme specific: Object space pivot transforms of a tree posed by an animation at one frame. Units playing the same
+ * animation in step all end up in the same pose, so it only has to be worked out once and each tree applies its root.
+ */
+struct HTreePoseCacheEntryStruct
+{
+    const HAnimClass *motion;
+    const HTreeClass *tree;
+    float frame;
+    int num_pivots;
+    float scale_factor;
+    unsigned int generation;
+    std::vector<Matrix3D> transforms;
+    std::vector<unsigned char> visible; // Only for the pivots the animation has.
+};
+
+namespace
+{
+/**
+ * Thyme specific: Open addressing table of the poses worked out during the current W3D frame. Slots of an older generation
+ * are free, so moving on to the next frame doesn't have to touch the entries.
+ */
+class HTreePoseCacheClass
+{
+public:
+    enum
+    {
+        MIN_SLOTS = 64,
+        MAX_ENTRIES = 1024,
+    };
+
+    HTreePoseCacheClass() : m_enabled(true), m_steps(0), m_generation(1), m_used(0), m_frame(0), m_slots(MIN_SLOTS)
+    {
+        m_stats.hits = 0;
+        m_stats.misses = 0;
+    }
+
+    bool Is_Enabled() const { return m_enabled; }
+    int Get_Steps() const { return m_steps; }
+    const HTreePoseCacheStatsStruct &Get_Stats() const { return m_stats; }
+
+    void Set_Enabled(bool enabled)
+    {
+        m_enabled = enabled;
+        Invalidate();
+    }
+
+    void Set_Steps(int steps)
+    {
+        m_steps = std::max(steps, 0);
+        Invalidate();
+    }
+
+    void Reset()
+    {
+        Invalidate();
+        m_stats.hits = 0;
+        m_stats.misses = 0;
+    }
+
+    // Returns the entry for the key, found is false when the caller has to fill in the transforms.
+    HTreePoseCacheEntryStruct *Find(const HAnimClass *motion,
+        const HTreeClass *tree,
+        float frame_time,
+        int num_pivots,
+        float scale_factor,
+        bool &found)
+    {
+        unsigned int frame = W3D::Get_Frame_Count();
+
+        if (frame != m_frame) {
+            m_frame = frame;
+            Invalidate();
+        }
+
+        size_t mask = m_slots.size() - 1;
+
+        for (size_t i = Hash(motion, tree, frame_time) & mask;; i = (i + 1) & mask) {
+            HTreePoseCacheEntryStruct &entry = m_slots[i];
+
+            if (entry.generation != m_generation) {
+                break;
+            }
+
+            if (entry.motion == motion && entry.tree == tree && entry.frame == frame_time
+                && entry.num_pivots == num_pivots && entry.scale_factor == scale_factor) {
+                ++m_stats.hits;
+                found = true;
+                return &entry;
+            }
+        }
+
+        // Lots of different poses in a frame mean the units aren't in step, stop keeping them rather than growing on.
+        if (m_used >= MAX_ENTRIES) {
+            Invalidate();
+        } else if (2 * (m_used + 1) > m_slots.size()) {
+            Grow();
+        }
+
+        HTreePoseCacheEntryStruct &entry = *Free_Slot(Hash(motion, tree, frame_time));
+        entry.motion = motion;
+        entry.tree = tree;
+        entry.frame = frame_time;
+        entry.num_pivots = num_pivots;
+        entry.scale_factor = scale_factor;
+        entry.generation = m_generation;
+        ++m_used;
+        ++m_stats.misses;
+        found = false;
+
+        return &entry;
+    }
+
+private:
+    static size_t Hash(const HAnimClass *motion, const HTreeClass *tree, float frame_time)
+    {
+        uint32_t frame_bits;
+        memcpy(&frame_bits, &frame_time, sizeof(frame_bits));
+        uint32_t hash = uint32_t(reinterpret_cast<uintptr_t>(motion) >> 4) * 0x9E3779B1u;
+        hash ^= uint32_t(reinterpret_cast<uintptr_t>(tree) >> 4) * 0x85EBCA6Bu;
+        hash ^= frame_bits * 0xC2B2AE35u;
+
+        return hash ^ (hash >> 15);
+    }
+
+    HTreePoseCacheEntryStruct *Free_Slot(size_t hash)
+    {
+        size_t mask = m_slots.size() - 1;
+        size_t i = hash & mask;
+
+        while (m_slots[i].generation == m_generation) {
+            i = (i + 1) & mask;
+        }
+
+        return &m_slots[i];
+    }
+
+    void Invalidate()
+    {
+        ++m_generation;
+        m_used = 0;
+    }
+
+    void Grow()
+    {
+        std::vector<HTreePoseCacheEntryStruct> slots(m_slots.size() * 2);
+        slots.swap(m_slots);
+
+        for (HTreePoseCacheEntryStruct &entry : slots) {
+            if (entry.generation == m_generation) {
+                HTreePoseCacheEntryStruct &slot = *Free_Slot(Hash(entry.motion, entry.tree, entry.frame));
+                slot = std::move(entry);
+            }
+        }
+    }
+
+    bool m_enabled;
+    int m_steps;
+    unsigned int m_generation;
+    size_t m_used;
+    unsigned int m_frame;
+    std::vector<HTreePoseCacheEntryStruct> m_slots;
+    HTreePoseCacheStatsStruct m_stats;
+};
+
+HTreePoseCacheClass g_poseCache;
+} // namespace
+#endif
+
 HTreeClass::HTreeClass() : m_numPivots(0), m_pivot(nullptr), m_scaleFactor(1.0f)
 {
     // #BUGFIX Initialize all members
     m_name[0] = '\0';
+#ifndef GAME_DLL
+    m_poseSource = nullptr;
+#endif
 }
 
 void HTreeClass::Init_Default()
@@ -62,6 +238,9 @@ HTreeClass::HTreeClass(HTreeClass const &src)
     }
 
     m_scaleFactor = src.m_scaleFactor;
+#ifndef GAME_DLL
+    m_poseSource = src.Get_Pose_Source();
+#endif
 }
 
 int HTreeClass::Load_W3D(ChunkLoadClass &cload)
@@ -252,6 +431,36 @@ void HTreeClass::Base_Update(Matrix3D const &root)
 
 void HTreeClass::Anim_Update(Matrix3D const &root, HAnimClass *motion, float frame)
 {
+#ifndef GAME_DLL
+    // Thyme specific: Trees that are posed alike in this frame share the pivot transforms relative to the root.
+    HTreePoseCacheEntryStruct *entry = nullptr;
+
+    if (g_poseCache.Is_Enabled() && !Has_Captured_Bones()) {
+        int steps = g_poseCache.Get_Steps();
+
+        if (steps > 0) {
+            frame = float(int(frame * steps + 0.5f)) / steps;
+        }
+
+        bool found;
+        entry = Find_Cached_Pose(motion, frame, found);
+
+        if (found) {
+            Apply_Cached_Pose(root, *entry);
+            return;
+        }
+    }
+
+    m_pose[0].Sample(motion, std::min(motion->Get_Num_Pivots(), m_numPivots), frame);
+
+    if (entry != nullptr) {
+        Pose_Update(Matrix3D::Identity, m_pose[0]);
+        Store_Cached_Pose(*entry);
+        Apply_Cached_Pose(root, *entry);
+    } else {
+        Pose_Update(root, m_pose[0]);
+    }
+#else
     m_pivot[0].transform = root;
     m_pivot[0].is_visible = true;
     int num_anim_pivots = motion->Get_Num_Pivots();
@@ -276,20 +485,38 @@ void HTreeClass::Anim_Update(Matrix3D const &root, HAnimClass *motion, float fra
             pivot->is_visible = true;
         }
     }
+#endif
 }
 
 void HTreeClass::Anim_Update(Matrix3D const &root, HRawAnimClass *motion, float frame)
 {
-    m_pivot[0].transform = root;
-    m_pivot[0].is_visible = true;
-    int num_anim_pivots = motion->Get_Num_Pivots();
-
     int fr = frame;
 
     if (frame >= motion->Get_Num_Frames()) {
         fr = 0;
     }
 
+#ifndef GAME_DLL
+    // Thyme specific: See the other Anim_Update, raw animations are only sampled at whole frames.
+    HTreePoseCacheEntryStruct *entry = nullptr;
+
+    if (g_poseCache.Is_Enabled() && !Has_Captured_Bones()) {
+        bool found;
+        entry = Find_Cached_Pose(motion, float(fr), found);
+
+        if (found) {
+            Apply_Cached_Pose(root, *entry);
+            return;
+        }
+    }
+
+    m_pivot[0].transform = entry != nullptr ? Matrix3D::Identity : root;
+#else
+    m_pivot[0].transform = root;
+#endif
+    m_pivot[0].is_visible = true;
+    int num_anim_pivots = motion->Get_Num_Pivots();
+
     PivotClass *pivot = m_pivot;
     NodeMotionStruct *node = &motion->Get_Node_Motion()[1];
     PivotClass *pivot2 = &pivot[1];
@@ -341,11 +568,24 @@ void HTreeClass::Anim_Update(Matrix3D const &root, HRawAnimClass *motion, float
         pivot2++;
         node++;
     }
+
+#ifndef GAME_DLL
+    if (entry != nullptr) {
+        Store_Cached_Pose(*entry);
+        Apply_Cached_Pose(root, *entry);
+    }
+#endif
 }
 
 void HTreeClass::Blend_Update(
     Matrix3D const &root, HAnimClass *motion0, float frame0, HAnimClass *motion1, float frame1, float percentage)
 {
+#ifndef GAME_DLL
+    m_pose[0].Sample(motion0, std::min(motion0->Get_Num_Pivots(), m_numPivots), frame0);
+    m_pose[1].Sample(motion1, std::min(motion1->Get_Num_Pivots(), m_numPivots), frame1);
+    m_pose[0].Blend(m_pose[1], percentage);
+    Pose_Update(root, m_pose[0]);
+#else
     m_pivot->transform = root;
     m_pivot->is_visible = true;
     int num_anim_pivots = motion0->Get_Num_Pivots();
@@ -386,7 +626,130 @@ void HTreeClass::Blend_Update(
             pivot->is_visible = true;
         }
     }
+#endif
+}
+
+#ifndef GAME_DLL
+/**
+ * Thyme specific: Builds the matrices of all animated pivots in one pass and then applies them down the hierarchy.
+ */
+void HTreeClass::Pose_Update(Matrix3D const &root, HAnimPoseClass &pose)
+{
+    int num_anim_pivots = pose.Get_Count();
+    m_poseTransforms.resize(num_anim_pivots);
+    VectorProcessorClass::BuildMatrices(
+        m_poseTransforms.data(), pose.Get_Orientations(), pose.Get_Translations(), num_anim_pivots);
+
+    m_pivot[0].transform = root;
+    m_pivot[0].is_visible = true;
+
+    for (int i = 1; i < m_numPivots; i++) {
+        PivotClass *pivot = &m_pivot[i];
+        Matrix3D::Multiply(pivot->parent->transform, pivot->base_transform, &pivot->transform);
+
+        if (i < num_anim_pivots) {
+            pivot->transform.Post_Mul(m_poseTransforms[i]);
+            pivot->is_visible = pose.Is_Visible(i);
+        }
+
+        if (pivot->is_captured) {
+            pivot->Capture_Update();
+            pivot->is_visible = true;
+        }
+    }
+}
+
+bool HTreeClass::Has_Captured_Bones() const
+{
+    for (int i = 1; i < m_numPivots; i++) {
+        if (m_pivot[i].is_captured) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Thyme specific: Trees are only posed alike if they were copied from the same tree, a tree with the same name may
+ * have a different skeleton.
+ */
+HTreePoseCacheEntryStruct *HTreeClass::Find_Cached_Pose(HAnimClass *motion, float frame, bool &found) const
+{
+    return g_poseCache.Find(motion, Get_Pose_Source(), frame, m_numPivots, m_scaleFactor, found);
+}
+
+/**
+ * Thyme specific: Keeps the pivots of a tree that was updated with an identity root.
+ */
+void HTreeClass::Store_Cached_Pose(HTreePoseCacheEntryStruct &entry) const
+{
+    int num_anim_pivots = std::min(entry.motion->Get_Num_Pivots(), m_numPivots);
+    entry.transforms.resize(m_numPivots);
+    entry.visible.resize(std::max(num_anim_pivots, 0));
+
+    for (int i = 0; i < m_numPivots; i++) {
+        entry.transforms[i] = m_pivot[i].transform;
+    }
+
+    for (int i = 0; i < num_anim_pivots; i++) {
+        entry.visible[i] = m_pivot[i].is_visible;
+    }
+}
+
+void HTreeClass::Apply_Cached_Pose(Matrix3D const &root, const HTreePoseCacheEntryStruct &entry)
+{
+    m_pivot[0].transform = root;
+    m_pivot[0].is_visible = true;
+
+    for (int i = 1; i < m_numPivots; i++) {
+        Matrix3D::Multiply(root, entry.transforms[i], &m_pivot[i].transform);
+    }
+
+    // Only the pivots the animation has take its visibility, the others keep what this tree gave them last.
+    for (int i = 1; i < int(entry.visible.size()); i++) {
+        m_pivot[i].is_visible = entry.visible[i] != 0;
+    }
+}
+
+/**
+ * Thyme specific: Turns sharing poses between trees copied from the same tree on or off, it is on by default.
+ */
+void HTreeClass::Set_Pose_Cache_Enabled(bool enabled)
+{
+    g_poseCache.Set_Enabled(enabled);
+}
+
+bool HTreeClass::Is_Pose_Cache_Enabled()
+{
+    return g_poseCache.Is_Enabled();
+}
+
+/**
+ * Thyme specific: Sets how many poses per frame Anim_Update tells apart when sharing them between trees. By default, 0,
+ * only trees at exactly the same frame share a pose. Otherwise frames are rounded to the nearest step, which shares
+ * more poses at the cost of smooth animation.
+ */
+void HTreeClass::Set_Pose_Cache_Steps(int steps)
+{
+    g_poseCache.Set_Steps(steps);
+}
+
+int HTreeClass::Get_Pose_Cache_Steps()
+{
+    return g_poseCache.Get_Steps();
+}
+
+HTreePoseCacheStatsStruct HTreeClass::Get_Pose_Cache_Stats()
+{
+    return g_poseCache.Get_Stats();
+}
+
+void HTreeClass::Reset_Pose_Cache()
+{
+    g_poseCache.Reset();
 }
+#endif
 
 int HTreeClass::Get_Bone_Index(char const *name)
 {
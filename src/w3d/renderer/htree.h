@@ -15,14 +15,27 @@
 #pragma once
 
 #include "always.h"
+#include "hanim.h"
 #include "matrix3d.h"
 #include "pivot.h"
 #include "w3dmpo.h"
+#ifndef GAME_DLL
+#include <vector>
+#endif
 
 class ChunkLoadClass;
-class HAnimClass;
 class HAnimComboClass;
 class HRawAnimClass;
+#ifndef GAME_DLL
+struct HTreePoseCacheEntryStruct;
+
+// Thyme specific: How often Anim_Update could reuse the pose of another tree since the last reset.
+struct HTreePoseCacheStatsStruct
+{
+    unsigned int hits;
+    unsigned int misses;
+};
+#endif
 
 class HTreeClass : public W3DMPO
 {
@@ -32,6 +45,21 @@ private:
     int m_numPivots;
     PivotClass *m_pivot;
     float m_scaleFactor;
+#ifndef GAME_DLL
+    // Thyme specific: Animations are sampled into poses that keep their key cursors between frames.
+    HAnimPoseClass m_pose[2];
+    std::vector<Matrix3D> m_poseTransforms;
+
+    void Pose_Update(Matrix3D const &root, HAnimPoseClass &pose);
+    bool Has_Captured_Bones() const;
+    // The tree this one was copied from, trees copied from the same tree can share poses.
+    const HTreeClass *m_poseSource;
+
+    const HTreeClass *Get_Pose_Source() const { return m_poseSource != nullptr ? m_poseSource : this; }
+    HTreePoseCacheEntryStruct *Find_Cached_Pose(HAnimClass *motion, float frame, bool &found) const;
+    void Store_Cached_Pose(HTreePoseCacheEntryStruct &entry) const;
+    void Apply_Cached_Pose(Matrix3D const &root, const HTreePoseCacheEntryStruct &entry);
+#endif
 
 public:
     virtual ~HTreeClass();
@@ -83,6 +111,15 @@ public:
     const Matrix3D &Get_Root_Transform() { return m_pivot[0].transform; }
     const char *Get_Name() const { return m_name; }
 
+#ifndef GAME_DLL
+    static void Set_Pose_Cache_Enabled(bool enabled);
+    static bool Is_Pose_Cache_Enabled();
+    static void Set_Pose_Cache_Steps(int steps);
+    static int Get_Pose_Cache_Steps();
+    static HTreePoseCacheStatsStruct Get_Pose_Cache_Stats();
+    static void Reset_Pose_Cache();
+#endif
+
     HTreeClass *Hook_Ctor() { return new (this) HTreeClass; }
     HTreeClass *Hook_Ctor2(const HTreeClass &src) { return new (this) HTreeClass(src); }
 };
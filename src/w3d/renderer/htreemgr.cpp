@@ -39,17 +39,27 @@ int HTreeManagerClass::Load_Tree(ChunkLoadClass &cload)
 {
     HTreeClass *tree = new HTreeClass();
 
-    if (tree->Load_W3D(cload) || Get_Tree_ID(tree->Get_Name()) != -1) {
+    if (tree->Load_W3D(cload)) {
         delete tree;
         return 1;
     }
 
+    return Add_Tree(tree) ? 0 : 1;
+}
+
+bool HTreeManagerClass::Add_Tree(HTreeClass *tree)
+{
+    if (Get_Tree_ID(tree->Get_Name()) != -1) {
+        delete tree;
+        return false;
+    }
+
     m_treePtr[m_numTrees] = tree;
     m_numTrees++;
     StringClass str = tree->Get_Name();
     str.To_Lower();
     m_hashTable.Insert(str, tree);
-    return 0;
+    return true;
 }
 
 // 0x00851930
@@ -28,6 +28,8 @@ public:
     HTreeManagerClass();
     ~HTreeManagerClass();
     int Load_Tree(ChunkLoadClass &cload);
+    // Takes ownership of a loaded tree, it is deleted when a tree of that name is already present.
+    bool Add_Tree(HTreeClass *tree);
     void Free_All_Trees();
     HTreeClass *Get_Tree(int id);
     HTreeClass *Get_Tree(const char *name);
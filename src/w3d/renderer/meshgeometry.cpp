@@ -25,6 +25,7 @@
 #include "sphere.h"
 #include "vp.h"
 #include "w3d_file.h"
+#include <algorithm>
 #ifdef GAME_DLL
 #include "hooker.h"
 #endif
@@ -983,21 +984,18 @@ W3DErrorType MeshGeometryClass::Read_Chunks(ChunkLoadClass &cload)
     return W3D_ERROR_OK;
 }
 
+// Thyme specific: Vector3 has the layout of W3dVectorStruct, so whole arrays are read with one call instead of a call
+// per vertex.
+static_assert(sizeof(Vector3) == sizeof(W3dVectorStruct), "Vector3 must match W3dVectorStruct");
+
 W3DErrorType MeshGeometryClass::Read_Vertices(ChunkLoadClass &cload)
 {
-    W3dVectorStruct vert;
     Vector3 *loc = m_vertex->Get_Array();
     captainslog_assert(loc);
+    unsigned size = Get_Vertex_Count() * sizeof(W3dVectorStruct);
 
-    for (int i = 0; i < Get_Vertex_Count(); i++) {
-
-        if (cload.Read(&vert, sizeof(W3dVectorStruct)) != sizeof(W3dVectorStruct)) {
-            return W3D_ERROR_LOAD_FAILED;
-        }
-
-        loc[i].X = vert.x;
-        loc[i].Y = vert.y;
-        loc[i].Z = vert.z;
+    if (cload.Read(loc, size) != size) {
+        return W3D_ERROR_LOAD_FAILED;
     }
 
     return W3D_ERROR_OK;
@@ -1005,16 +1003,12 @@ W3DErrorType MeshGeometryClass::Read_Vertices(ChunkLoadClass &cload)
 
 W3DErrorType MeshGeometryClass::Read_Vertex_Normals(ChunkLoadClass &cload)
 {
-    W3dVectorStruct norm;
     Vector3 *mdlnorms = Get_Vert_Normals();
     captainslog_assert(mdlnorms);
+    unsigned size = m_vertexCount * sizeof(W3dVectorStruct);
 
-    for (int i = 0; i < m_vertexCount; i++) {
-        if (cload.Read(&norm, sizeof(W3dVectorStruct)) != sizeof(W3dVectorStruct)) {
-            return W3D_ERROR_LOAD_FAILED;
-        }
-
-        mdlnorms[i].Set(norm.x, norm.y, norm.z);
+    if (cload.Read(mdlnorms, size) != size) {
+        return W3D_ERROR_LOAD_FAILED;
     }
 
     return W3D_ERROR_OK;
@@ -1022,30 +1016,37 @@ W3DErrorType MeshGeometryClass::Read_Vertex_Normals(ChunkLoadClass &cload)
 
 W3DErrorType MeshGeometryClass::Read_Triangles(ChunkLoadClass &cload)
 {
-    W3dTriStruct tri;
+    W3dTriStruct block[64];
 
     TriIndex *vi = Get_Polys();
     Set_Flag(DIRTY_PLANES, false);
     Vector4 *peq = Get_Planes();
     uint8_t *surface_types = Get_Poly_Surface_Type_Array();
 
-    for (int i = 0; i < Get_Polygon_Count(); i++) {
+    for (int i = 0; i < Get_Polygon_Count(); i += ARRAY_SIZE(block)) {
+        int count = std::min<int>(Get_Polygon_Count() - i, ARRAY_SIZE(block));
+        const W3dTriStruct *tris =
+            static_cast<const W3dTriStruct *>(cload.Read_View(block, count * sizeof(W3dTriStruct)));
 
-        if (cload.Read(&tri, sizeof(W3dTriStruct)) != sizeof(W3dTriStruct)) {
+        if (tris == nullptr) {
             return W3D_ERROR_LOAD_FAILED;
         }
 
-        vi[i].I = tri.Vindex[0];
-        vi[i].J = tri.Vindex[1];
-        vi[i].K = tri.Vindex[2];
+        for (int j = 0; j < count; j++) {
+            const W3dTriStruct &tri = tris[j];
+
+            vi[i + j].I = tri.Vindex[0];
+            vi[i + j].J = tri.Vindex[1];
+            vi[i + j].K = tri.Vindex[2];
 
-        peq[i].X = tri.Normal.x;
-        peq[i].Y = tri.Normal.y;
-        peq[i].Z = tri.Normal.z;
-        peq[i].W = -tri.Dist;
+            peq[i + j].X = tri.Normal.x;
+            peq[i + j].Y = tri.Normal.y;
+            peq[i + j].Z = tri.Normal.z;
+            peq[i + j].W = -tri.Dist;
 
-        captainslog_assert(tri.Attributes < 256);
-        surface_types[i] = (uint8_t)(tri.Attributes);
+            captainslog_assert(tri.Attributes < 256);
+            surface_types[i + j] = (uint8_t)(tri.Attributes);
+        }
     }
 
     return W3D_ERROR_OK;
@@ -1070,16 +1071,22 @@ W3DErrorType MeshGeometryClass::Read_User_Text(ChunkLoadClass &cload)
 
 W3DErrorType MeshGeometryClass::Read_Vertex_Influences(ChunkLoadClass &cload)
 {
-    W3dVertInfStruct vinf;
+    W3dVertInfStruct block[64];
     uint16_t *links = Get_Bone_Links(true);
     captainslog_assert(links);
 
-    for (int i = 0; i < Get_Vertex_Count(); i++) {
-        if (cload.Read(&vinf, sizeof(W3dVertInfStruct)) != sizeof(W3dVertInfStruct)) {
+    for (int i = 0; i < Get_Vertex_Count(); i += ARRAY_SIZE(block)) {
+        int count = std::min<int>(Get_Vertex_Count() - i, ARRAY_SIZE(block));
+        const W3dVertInfStruct *vinfs =
+            static_cast<const W3dVertInfStruct *>(cload.Read_View(block, count * sizeof(W3dVertInfStruct)));
+
+        if (vinfs == nullptr) {
             return W3D_ERROR_LOAD_FAILED;
         }
 
-        links[i] = vinf.BoneIdx[0];
+        for (int j = 0; j < count; j++) {
+            links[i + j] = vinfs[j].BoneIdx[0];
+        }
     }
 
     Set_Flag(SKIN, true);
@@ -1089,14 +1096,12 @@ W3DErrorType MeshGeometryClass::Read_Vertex_Influences(ChunkLoadClass &cload)
 W3DErrorType MeshGeometryClass::Read_Vertex_Shade_Indices(ChunkLoadClass &cload)
 {
     uint32_t *shade_index = Get_Shade_Indices(true);
-    uint32_t si;
+    unsigned size = Get_Vertex_Count() * sizeof(uint32_t);
 
-    for (int i = 0; i < Get_Vertex_Count(); i++) {
-        if (cload.Read(&si, sizeof(uint32_t)) != sizeof(uint32_t)) {
-            return W3D_ERROR_LOAD_FAILED;
-        }
-        shade_index[i] = si;
+    if (cload.Read(shade_index, size) != size) {
+        return W3D_ERROR_LOAD_FAILED;
     }
+
     return W3D_ERROR_OK;
 }
 
@@ -1108,9 +1113,6 @@ void MeshGeometryClass::Get_Deformed_Vertices(Vector3 *dst_vert, Vector3 *dst_no
     uint16_t *bonelink = m_vertexBoneLink->Get_Array();
 
     for (int vi = 0; vi < vertex_count;) {
-        const Matrix3D &tm = htree->Get_Transform(bonelink[vi]);
-        Matrix3D mytm = tm;
-
         int idx = bonelink[vi];
         int cnt;
 
@@ -1120,21 +1122,32 @@ void MeshGeometryClass::Get_Deformed_Vertices(Vector3 *dst_vert, Vector3 *dst_no
             }
         }
 
-        VectorProcessorClass::Transform(dst_vert + vi, src_vert + vi, mytm, cnt - vi);
-        mytm.Set_Translation(Vector3(0.0f, 0.0f, 0.0f));
-        VectorProcessorClass::Transform(dst_norm + vi, src_norm + vi, mytm, cnt - vi);
+        // Thyme specific: Positions and normals of the bone run are done in one pass.
+        VectorProcessorClass::Transform(
+            dst_vert + vi, dst_norm + vi, src_vert + vi, src_norm + vi, htree->Get_Transform(idx), cnt - vi);
         vi = cnt;
     }
 }
 
 void MeshGeometryClass::Get_Deformed_Vertices(Vector3 *dst_vert, const HTreeClass *htree)
 {
+    int vertex_count = Get_Vertex_Count();
     Vector3 *src_vert = m_vertex->Get_Array();
     uint16_t *bonelink = m_vertexBoneLink->Get_Array();
 
-    for (int vi = 0; vi < Get_Vertex_Count(); vi++) {
-        const Matrix3D &tm = htree->Get_Transform(bonelink[vi]);
-        Matrix3D::Transform_Vector(tm, src_vert[vi], &(dst_vert[vi]));
+    // Thyme specific: Vertices are sorted by bone, so whole runs can be transformed at once.
+    for (int vi = 0; vi < vertex_count;) {
+        int idx = bonelink[vi];
+        int cnt;
+
+        for (cnt = vi; cnt < vertex_count; cnt++) {
+            if (idx != bonelink[cnt]) {
+                break;
+            }
+        }
+
+        VectorProcessorClass::Transform(dst_vert + vi, src_vert + vi, htree->Get_Transform(idx), cnt - vi);
+        vi = cnt;
     }
 }
 
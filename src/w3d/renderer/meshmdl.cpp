@@ -25,6 +25,7 @@
 #include "matinfo.h"
 #include "vp.h"
 #include "w3d_util.h"
+#include <algorithm>
 
 static DynamicVectorClass<Vector4> _TempTransformedVertexBuffer;
 
@@ -750,9 +751,19 @@ W3DErrorType MeshModelClass::Read_Vertex_Material_Ids(ChunkLoadClass &cload, Mes
         cload.Read(&vmat, sizeof(uint32_t));
         matdesc->Set_Single_Material(context->Peek_Vertex_Material(vmat), context->m_curPass);
     } else {
-        for (int i = 0; i < Get_Vertex_Count(); i++) {
-            cload.Read(&vmat, sizeof(uint32_t));
-            matdesc->Set_Material(i, context->Peek_Vertex_Material(vmat), context->m_curPass);
+        uint32_t block[256];
+
+        for (int i = 0; i < Get_Vertex_Count(); i += ARRAY_SIZE(block)) {
+            int count = std::min<int>(Get_Vertex_Count() - i, ARRAY_SIZE(block));
+            const uint32_t *vmats = static_cast<const uint32_t *>(cload.Read_View(block, count * sizeof(uint32_t)));
+
+            if (vmats == nullptr) {
+                break;
+            }
+
+            for (int j = 0; j < count; j++) {
+                matdesc->Set_Material(i + j, context->Peek_Vertex_Material(vmats[j]), context->m_curPass);
+            }
         }
     }
 
@@ -779,14 +790,25 @@ W3DErrorType MeshModelClass::Read_Shader_Ids(ChunkLoadClass &cload, MeshLoadCont
             Set_Flag(SORT, true);
         }
     } else {
-        for (int i = 0; i < Get_Polygon_Count(); i++) {
-            cload.Read(&shaderid, sizeof(uint32_t));
-            ShaderClass shader = context->Peek_Shader(shaderid);
-            matdesc->Set_Shader(i, shader, context->m_curPass);
-
-            if ((context->m_curPass == 0) && (shader.Get_Dst_Blend_Func() != ShaderClass::DSTBLEND_ZERO)
-                && (shader.Get_Alpha_Test() == ShaderClass::ALPHATEST_DISABLE) && (m_sortLevel == SORT_LEVEL_NONE)) {
-                Set_Flag(SORT, true);
+        uint32_t block[256];
+
+        for (int i = 0; i < Get_Polygon_Count(); i += ARRAY_SIZE(block)) {
+            int count = std::min<int>(Get_Polygon_Count() - i, ARRAY_SIZE(block));
+            const uint32_t *shaderids = static_cast<const uint32_t *>(cload.Read_View(block, count * sizeof(uint32_t)));
+
+            if (shaderids == nullptr) {
+                break;
+            }
+
+            for (int j = 0; j < count; j++) {
+                ShaderClass shader = context->Peek_Shader(shaderids[j]);
+                matdesc->Set_Shader(i + j, shader, context->m_curPass);
+
+                if ((context->m_curPass == 0) && (shader.Get_Dst_Blend_Func() != ShaderClass::DSTBLEND_ZERO)
+                    && (shader.Get_Alpha_Test() == ShaderClass::ALPHATEST_DISABLE)
+                    && (m_sortLevel == SORT_LEVEL_NONE)) {
+                    Set_Flag(SORT, true);
+                }
             }
         }
     }
@@ -925,11 +947,20 @@ W3DErrorType MeshModelClass::Read_Texture_Ids(ChunkLoadClass &cload, MeshLoadCon
         cload.Read(&texid, sizeof(texid));
         matdesc->Set_Single_Texture(context->Peek_Texture(texid), pass, stage);
     } else {
-        for (int i = 0; i < Get_Polygon_Count(); i++) {
-            cload.Read(&texid, sizeof(uint32_t));
+        uint32_t block[256];
+
+        for (int i = 0; i < Get_Polygon_Count(); i += ARRAY_SIZE(block)) {
+            int count = std::min<int>(Get_Polygon_Count() - i, ARRAY_SIZE(block));
+            const uint32_t *texids = static_cast<const uint32_t *>(cload.Read_View(block, count * sizeof(uint32_t)));
+
+            if (texids == nullptr) {
+                break;
+            }
 
-            if (texid != 0xffffffff) {
-                matdesc->Set_Texture(i, context->Peek_Texture(texid), pass, stage);
+            for (int j = 0; j < count; j++) {
+                if (texids[j] != 0xffffffff) {
+                    matdesc->Set_Texture(i + j, context->Peek_Texture(texids[j]), pass, stage);
+                }
             }
         }
     }
@@ -941,7 +972,6 @@ W3DErrorType MeshModelClass::Read_Stage_Texcoords(ChunkLoadClass &cload, MeshLoa
 {
     unsigned elementcount;
     Vector2 *uvs;
-    W3dTexCoordStruct texcoord;
     MeshMatDescClass *matdesc = m_defMatDesc;
 
     if (m_defMatDesc->Has_UV(context->m_curPass, context->m_curTexStage)) {
@@ -951,11 +981,14 @@ W3DErrorType MeshModelClass::Read_Stage_Texcoords(ChunkLoadClass &cload, MeshLoa
     elementcount = cload.Cur_Chunk_Length() / sizeof(W3dTexCoordStruct);
     uvs = context->Get_Temporary_UV_Array(elementcount);
 
+    // Thyme specific: Vector2 has the layout of W3dTexCoordStruct, so the array is read with one call and flipped after.
+    static_assert(sizeof(Vector2) == sizeof(W3dTexCoordStruct), "Vector2 must match W3dTexCoordStruct");
+
     if (uvs != nullptr) {
+        cload.Read(uvs, elementcount * sizeof(W3dTexCoordStruct));
+
         for (unsigned i = 0; i < elementcount; i++) {
-            cload.Read(&texcoord, sizeof(texcoord));
-            uvs[i].X = texcoord.U;
-            uvs[i].Y = 1.0f - texcoord.V;
+            uvs[i].Y = 1.0f - uvs[i].Y;
         }
     }
 
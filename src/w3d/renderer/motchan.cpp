@@ -216,8 +216,26 @@ bool TimeCodedMotionChannelClass::Load_W3D(ChunkLoadClass &cload)
 
 void TimeCodedMotionChannelClass::Get_Vector(float frame, float *setvec)
 {
-    int index = Get_Index(frame);
+    Get_Vector_At(Get_Index(frame), frame, setvec);
+}
+
+Quaternion TimeCodedMotionChannelClass::Get_Quat_Vector(float frame_idx)
+{
+    return Get_Quat_Vector_At(Get_Index(frame_idx), frame_idx);
+}
+
+void TimeCodedMotionChannelClass::Get_Vector(float frame, float *setvec, unsigned int &cursor) const
+{
+    Get_Vector_At(Find_Index(frame, cursor), frame, setvec);
+}
 
+Quaternion TimeCodedMotionChannelClass::Get_Quat_Vector(float frame_idx, unsigned int &cursor) const
+{
+    return Get_Quat_Vector_At(Find_Index(frame_idx, cursor), frame_idx);
+}
+
+void TimeCodedMotionChannelClass::Get_Vector_At(unsigned int index, float frame, float *setvec) const
+{
     if (index == m_packetSize * (m_numTimeCodes - 1)) {
         float *data = (float *)&m_data[index + 1];
 
@@ -225,7 +243,7 @@ void TimeCodedMotionChannelClass::Get_Vector(float frame, float *setvec)
             setvec[i] = data[i];
         }
     } else {
-        int index2 = m_packetSize + index;
+        unsigned int index2 = m_packetSize + index;
         unsigned int val = m_data[index2];
 
         if (Get_Flag_From_Data(val)) {
@@ -248,19 +266,18 @@ void TimeCodedMotionChannelClass::Get_Vector(float frame, float *setvec)
     }
 }
 
-Quaternion TimeCodedMotionChannelClass::Get_Quat_Vector(float frame_idx)
+Quaternion TimeCodedMotionChannelClass::Get_Quat_Vector_At(unsigned int index, float frame_idx) const
 {
     captainslog_assert(m_vectorLen == 4);
 
     Quaternion q1(true);
-    int index = Get_Index(frame_idx);
 
     if (index == m_packetSize * (m_numTimeCodes - 1)) {
         Quaternion *dq1 = (Quaternion *)&m_data[index + 1];
         q1.Set(dq1->X, dq1->Y, dq1->Z, dq1->W);
         return q1;
     } else {
-        int index2 = m_packetSize + index;
+        unsigned int index2 = m_packetSize + index;
         unsigned int val = m_data[index2];
 
         if (Get_Flag_From_Data(val)) {
@@ -299,36 +316,41 @@ void TimeCodedMotionChannelClass::Set_Identity(float *setvec) const
 
 unsigned int TimeCodedMotionChannelClass::Get_Index(unsigned int timecode)
 {
-    captainslog_assert(m_cachedIdx <= m_lastTimeCodeIdx);
-
-    if (timecode < Get_Frame_From_Data(m_data[m_cachedIdx])) {
-        unsigned int result = TimeCodedMotionChannelClass::Binary_Search_Index(timecode);
-        m_cachedIdx = result;
-        return result;
-    }
+    return Find_Index(timecode, m_cachedIdx);
+}
 
-    if (m_cachedIdx == m_lastTimeCodeIdx) {
-        return m_cachedIdx;
-    }
+/**
+ * Thyme specific: Finds the data index of the last key at or before timecode. Playback mostly stays on the key of the
+ * last sample or moves on to the next one, so those are tried before searching all keys.
+ */
+unsigned int TimeCodedMotionChannelClass::Find_Index(unsigned int timecode, unsigned int &cursor) const
+{
+    // Any key in range gives the right result, so a cursor left over from another channel is only slower.
+    unsigned int key = cursor < m_numTimeCodes ? cursor : 0;
+    unsigned int index = key * m_packetSize;
 
-    unsigned int result = m_packetSize + m_cachedIdx;
+    if (timecode >= Get_Frame_From_Data(m_data[index])) {
+        for (int step = 0; step < 2; ++step) {
+            if (index == m_lastTimeCodeIdx || timecode < Get_Frame_From_Data(m_data[index + m_packetSize])) {
+                cursor = key;
+                return index;
+            }
 
-    if (timecode < Get_Frame_From_Data(m_data[m_packetSize + m_cachedIdx])) {
-        return m_cachedIdx;
+            ++key;
+            index += m_packetSize;
+        }
     }
 
-    m_cachedIdx = result;
-
-    if (result != m_lastTimeCodeIdx) {
-        int index = result + m_packetSize;
-
-        if (timecode >= Get_Frame_From_Data(m_data[index])) {
-            result = TimeCodedMotionChannelClass::Binary_Search_Index(timecode);
-            m_cachedIdx = result;
-        }
+    // #BUGFIX: The binary search never ends for times before the first key.
+    if (timecode < Get_Frame_From_Data(m_data[0])) {
+        cursor = 0;
+        return 0;
     }
 
-    return result;
+    index = Binary_Search_Index(timecode);
+    cursor = index / m_packetSize;
+
+    return index;
 }
 
 unsigned int TimeCodedMotionChannelClass::Binary_Search_Index(unsigned int timecode) const
@@ -417,14 +439,21 @@ bool TimeCodedBitChannelClass::Load_W3D(ChunkLoadClass &cload)
 }
 
 int TimeCodedBitChannelClass::Get_Bit(int frame)
+{
+    return Get_Bit(frame, m_cachedIdx);
+}
+
+/**
+ * Thyme specific: Like Get_Bit, but searches from and updates a cursor owned by the caller instead of the channel.
+ */
+int TimeCodedBitChannelClass::Get_Bit(int frame, unsigned int &cursor) const
 {
     captainslog_assert(frame >= 0);
-    captainslog_assert(m_cachedIdx < m_numTimeCodes);
 
     unsigned int count = 0;
 
-    if (frame >= static_cast<int>(Get_Frame_From_Data(m_bits[m_cachedIdx]))) {
-        count = m_cachedIdx + 1;
+    if (cursor < m_numTimeCodes && frame >= static_cast<int>(Get_Frame_From_Data(m_bits[cursor]))) {
+        count = cursor + 1;
     }
 
     while (count < m_numTimeCodes && frame >= static_cast<int>(Get_Frame_From_Data(m_bits[count]))) {
@@ -436,7 +465,7 @@ int TimeCodedBitChannelClass::Get_Bit(int frame)
         index = 0;
     }
 
-    m_cachedIdx = index;
+    cursor = index;
     return Get_Flag_From_Data(m_bits[index]);
 }
 
@@ -129,14 +129,23 @@ public:
     unsigned int Get_Index(unsigned int timecode);
     unsigned int Binary_Search_Index(unsigned int timecode) const;
 
+    // Thyme specific: The channel is shared by everything playing the animation, so callers sampling it for one object
+    // keep their own cursor. It holds the key the last sample was found at and is where the next search starts.
+    void Get_Vector(float frame, float *setvec, unsigned int &cursor) const;
+    Quaternion Get_Quat_Vector(float frame_idx, unsigned int &cursor) const;
+    unsigned int Find_Index(unsigned int timecode, unsigned int &cursor) const;
+
 private:
+    void Get_Vector_At(unsigned int index, float frame, float *setvec) const;
+    Quaternion Get_Quat_Vector_At(unsigned int index, float frame_idx) const;
+
     unsigned int m_pivotIdx;
     unsigned int m_type;
     int m_vectorLen;
     unsigned int m_packetSize;
     unsigned int m_numTimeCodes;
     unsigned int m_lastTimeCodeIdx;
-    unsigned int m_cachedIdx;
+    unsigned int m_cachedIdx; // Thyme specific: A key number like the cursors, not a data index.
     unsigned int *m_data;
 };
 
@@ -151,6 +160,7 @@ public:
     int Get_Type() const { return m_type; }
     int Get_Pivot() const { return m_pivotIdx; }
     int Get_Bit(int frame);
+    int Get_Bit(int frame, unsigned int &cursor) const;
 
 private:
     unsigned int m_pivotIdx;
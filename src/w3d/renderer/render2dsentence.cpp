@@ -68,6 +68,11 @@ FontCharsClass::FontCharsClass() :
     m_isBold(false)
 {
     std::memset(m_asciiCharArray, 0, sizeof(m_asciiCharArray));
+#ifndef GAME_DLL
+    m_glyphPageLimit = DEFAULT_GLYPH_PAGE_LIMIT;
+    m_currGlyphPage = 0;
+    m_glyphClock = 0;
+#endif
     // Use Fontconfig to locate system fonts
 #ifdef BUILD_WITH_FONTCONFIG
     if (FcInit() == FcTrue) {
@@ -132,7 +137,12 @@ const FontCharsClass::CharDataStruct *FontCharsClass::Get_Char_Data(unichar_t ch
 #endif
     }
 
-    captainslog_assert(retval->value == ch);
+    if (retval != nullptr) {
+        captainslog_assert(retval->value == ch);
+#ifndef GAME_DLL
+        font->m_glyphPageUse[retval->page] = ++font->m_glyphClock;
+#endif
+    }
 
     return retval;
 }
@@ -213,9 +223,10 @@ const FontCharsClass::CharDataStruct *FontCharsClass::Store_Freetype_Char(unicha
     }
     char_width += m_widthReduction + x_pos;
     Update_Current_Buffer(char_width);
-    uint16_t *curr_buffer = m_bufferList[m_bufferList.Count() - 1]->buffer;
+    uint16_t *curr_buffer = m_bufferList[Current_Glyph_Page()]->buffer;
     curr_buffer += m_currPixelOffset;
-    // We might need a memset
+    // Only the covered pixels are written below, clear the rest as the page may hold an evicted glyph.
+    std::memset(curr_buffer, 0, char_width * m_charHeight * sizeof(uint16_t));
 
     int x_offset = m_ftFace->glyph->bitmap_left;
     int descent = m_charHeight - m_ascent;
@@ -240,7 +251,10 @@ const FontCharsClass::CharDataStruct *FontCharsClass::Store_Freetype_Char(unicha
     CharDataStruct *char_data = new CharDataStruct;
     char_data->value = ch;
     char_data->width = (int16_t)char_width;
-    char_data->buffer = m_bufferList[m_bufferList.Count() - 1]->buffer + m_currPixelOffset;
+    char_data->buffer = m_bufferList[Current_Glyph_Page()]->buffer + m_currPixelOffset;
+#ifndef GAME_DLL
+    char_data->page = Current_Glyph_Page();
+#endif
 
     if (ch < 256) {
         m_asciiCharArray[ch] = char_data;
@@ -270,7 +284,7 @@ const FontCharsClass::CharDataStruct *FontCharsClass::Store_GDI_Char(unichar_t c
     GetTextExtentPoint32W(m_memDC, &ch, 1, &char_size);
     char_size.cx += m_widthReduction + x_pos;
     Update_Current_Buffer(char_size.cx);
-    uint16_t *curr_buffer = m_bufferList[m_bufferList.Count() - 1]->buffer;
+    uint16_t *curr_buffer = m_bufferList[Current_Glyph_Page()]->buffer;
     curr_buffer += m_currPixelOffset;
     int stride = ((width * 3 + 3) & ~3);
 
@@ -294,7 +308,10 @@ const FontCharsClass::CharDataStruct *FontCharsClass::Store_GDI_Char(unichar_t c
     CharDataStruct *char_data = new CharDataStruct;
     char_data->value = ch;
     char_data->width = (int16_t)char_size.cx;
-    char_data->buffer = m_bufferList[m_bufferList.Count() - 1]->buffer + m_currPixelOffset;
+    char_data->buffer = m_bufferList[Current_Glyph_Page()]->buffer + m_currPixelOffset;
+#ifndef GAME_DLL
+    char_data->page = Current_Glyph_Page();
+#endif
 
     if (ch < 256) {
         m_asciiCharArray[ch] = char_data;
@@ -321,11 +338,77 @@ void FontCharsClass::Update_Current_Buffer(int char_width)
     }
 
     if (needs_new_buffer) {
+#ifndef GAME_DLL
+        if (m_bufferList.Count() >= m_glyphPageLimit) {
+            m_currGlyphPage = Evict_Glyph_Page();
+            m_currPixelOffset = 0;
+
+            return;
+        }
+#endif
         m_bufferList.Add(new FontCharsBuffer);
         m_currPixelOffset = 0;
+#ifndef GAME_DLL
+        m_currGlyphPage = m_bufferList.Count() - 1;
+        m_glyphPageUse.Add(m_glyphClock);
+#endif
     }
 }
 
+int FontCharsClass::Current_Glyph_Page() const
+{
+#ifndef GAME_DLL
+    return m_currGlyphPage;
+#else
+    return m_bufferList.Count() - 1;
+#endif
+}
+
+// Frees the least recently used glyph page so it can be filled again. Its glyphs are rasterized again on next use.
+int FontCharsClass::Evict_Glyph_Page()
+{
+#ifndef GAME_DLL
+    int page = 0;
+
+    for (int i = 1; i < m_glyphPageUse.Count(); ++i) {
+        if (m_glyphPageUse[i] < m_glyphPageUse[page]) {
+            page = i;
+        }
+    }
+
+    for (int index = 0; index < 256; index++) {
+        if (m_asciiCharArray[index] != nullptr && m_asciiCharArray[index]->page == page) {
+            delete m_asciiCharArray[index];
+            m_asciiCharArray[index] = nullptr;
+        }
+    }
+
+    if (m_unicodeCharArray != nullptr) {
+        int count = (m_lastUnicodeChar - m_firstUnicodeChar) + 1;
+
+        for (int index = 0; index < count; index++) {
+            if (m_unicodeCharArray[index] != nullptr && m_unicodeCharArray[index]->page == page) {
+                delete m_unicodeCharArray[index];
+                m_unicodeCharArray[index] = nullptr;
+            }
+        }
+    }
+
+    m_glyphPageUse[page] = m_glyphClock;
+
+    return page;
+#else
+    return m_bufferList.Count() - 1;
+#endif
+}
+
+void FontCharsClass::Set_Glyph_Page_Limit(int limit)
+{
+#ifndef GAME_DLL
+    m_glyphPageLimit = std::max(limit, 1);
+#endif
+}
+
 #if defined BUILD_WITH_FONTCONFIG
 bool FontCharsClass::Locate_Font_FontConfig(const char *font_name, StringClass &font_file_path)
 {
@@ -672,6 +755,177 @@ void FontCharsClass::Free_Character_Arrays()
     }
 }
 
+#ifndef GAME_DLL
+static SentenceCacheClass s_sentenceCache;
+
+SentenceCacheClass::KeyStruct SentenceCacheClass::Make_Key(const Render2DSentenceClass &sentence, const unichar_t *text)
+{
+    KeyStruct key;
+    key.font = sentence.m_font;
+    key.text = text;
+    key.length = (int)u_strlen(text);
+    key.wrap_width = sentence.m_wrapWidth;
+    key.texture_size_hint = sentence.m_textureSizeHint;
+    key.flags = (sentence.m_centered ? FLAG_CENTERED : 0) | (sentence.m_processAmpersand ? FLAG_AMPERSAND : 0)
+        | (sentence.m_partialWords ? FLAG_PARTIAL_WORDS : 0);
+
+    // FNV-1a over the text, then fold in the layout.
+    uint32_t hash = 2166136261u;
+
+    for (int i = 0; i < key.length; ++i) {
+        hash = (hash ^ uint32_t(text[i])) * 16777619u;
+    }
+
+    uint32_t wrap_bits;
+    std::memcpy(&wrap_bits, &key.wrap_width, sizeof(wrap_bits));
+    hash = (hash ^ uint32_t(uintptr_t(key.font) >> 4)) * 16777619u;
+    hash = (hash ^ wrap_bits) * 16777619u;
+    hash = (hash ^ uint32_t(key.texture_size_hint)) * 16777619u;
+    hash = (hash ^ uint32_t(key.flags)) * 16777619u;
+    key.hash = hash;
+
+    return key;
+}
+
+int SentenceCacheClass::Find(const KeyStruct &key)
+{
+    for (int index = m_buckets[key.hash % HASH_SIZE]; index != -1; index = m_entries[index].next) {
+        const KeyStruct &other = m_entries[index].key;
+
+        if (other.hash == key.hash && other.font == key.font && other.length == key.length
+            && other.wrap_width == key.wrap_width && other.texture_size_hint == key.texture_size_hint
+            && other.flags == key.flags && std::memcmp(other.text, key.text, key.length * sizeof(unichar_t)) == 0) {
+            m_entries[index].last_used = ++m_clock;
+
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+int SentenceCacheClass::Insert(const KeyStruct &key, const Render2DSentenceClass &sentence, int x, int y)
+{
+    int index;
+
+    if (m_count < CACHE_SIZE) {
+        index = m_count++;
+    } else {
+        index = 0;
+
+        for (int i = 1; i < CACHE_SIZE; ++i) {
+            if (m_entries[i].last_used < m_entries[index].last_used) {
+                index = i;
+            }
+        }
+
+        Release_Entry(index);
+    }
+
+    EntryStruct &entry = m_entries[index];
+    entry.key = key;
+    entry.key.font->Add_Ref();
+    unichar_t *text = new unichar_t[key.length + 1];
+    std::memcpy(text, key.text, (key.length + 1) * sizeof(unichar_t));
+    entry.key.text = text;
+    entry.x = x;
+    entry.y = y;
+    entry.cursor = sentence.m_cursor;
+
+    entry.sentence_count = sentence.m_sentenceData.Count();
+    entry.sentence_data = new Render2DSentenceClass::SentenceDataStruct[std::max(entry.sentence_count, 1)];
+    entry.textures = new TextureDataStruct[std::max(entry.sentence_count, 1)];
+    entry.texture_count = 0;
+
+    for (int i = 0; i < entry.sentence_count; ++i) {
+        entry.sentence_data[i] = sentence.m_sentenceData[i];
+        entry.sentence_data[i].surface->Add_Ref();
+
+        // Consecutive chunks usually share a surface, only remember each surface once.
+        if (entry.texture_count == 0 || entry.textures[entry.texture_count - 1].surface != entry.sentence_data[i].surface) {
+            entry.textures[entry.texture_count].surface = entry.sentence_data[i].surface;
+            entry.textures[entry.texture_count].texture = nullptr;
+            ++entry.texture_count;
+        }
+    }
+
+    entry.last_used = ++m_clock;
+    entry.next = m_buckets[key.hash % HASH_SIZE];
+    m_buckets[key.hash % HASH_SIZE] = index;
+
+    return index;
+}
+
+TextureClass *SentenceCacheClass::Peek_Texture(int index, SurfaceClass *surface) const
+{
+    const EntryStruct &entry = m_entries[index];
+
+    for (int i = 0; i < entry.texture_count; ++i) {
+        if (entry.textures[i].surface == surface) {
+            return entry.textures[i].texture;
+        }
+    }
+
+    return nullptr;
+}
+
+void SentenceCacheClass::Set_Texture(int index, SurfaceClass *surface, TextureClass *texture)
+{
+    EntryStruct &entry = m_entries[index];
+
+    for (int i = 0; i < entry.texture_count; ++i) {
+        if (entry.textures[i].surface == surface && entry.textures[i].texture == nullptr) {
+            Ref_Ptr_Set(entry.textures[i].texture, texture);
+        }
+    }
+}
+
+void SentenceCacheClass::Flush()
+{
+    for (int i = 0; i < m_count; ++i) {
+        Release_Entry(i);
+    }
+
+    for (int i = 0; i < HASH_SIZE; ++i) {
+        m_buckets[i] = -1;
+    }
+
+    m_count = 0;
+}
+
+void SentenceCacheClass::Release_Entry(int index)
+{
+    EntryStruct &entry = m_entries[index];
+    int *link = &m_buckets[entry.key.hash % HASH_SIZE];
+
+    while (*link != -1 && *link != index) {
+        link = &m_entries[*link].next;
+    }
+
+    if (*link == index) {
+        *link = entry.next;
+    }
+
+    for (int i = 0; i < entry.sentence_count; ++i) {
+        Ref_Ptr_Release(entry.sentence_data[i].surface);
+    }
+
+    for (int i = 0; i < entry.texture_count; ++i) {
+        Ref_Ptr_Release(entry.textures[i].texture);
+    }
+
+    delete[] entry.sentence_data;
+    delete[] entry.textures;
+    delete[] entry.key.text;
+    Ref_Ptr_Release(entry.key.font);
+    entry.sentence_data = nullptr;
+    entry.textures = nullptr;
+    entry.sentence_count = 0;
+    entry.texture_count = 0;
+    entry.next = -1;
+}
+#endif
+
 Render2DSentenceClass::Render2DSentenceClass() :
     m_font(nullptr),
     m_baseLocation(0.0f, 0.0f),
@@ -695,6 +949,9 @@ Render2DSentenceClass::Render2DSentenceClass() :
     m_curTexture(nullptr),
     m_shader(Render2DClass::Get_Default_Shader())
 {
+#ifndef GAME_DLL
+    m_cacheEntry = -1;
+#endif
 }
 
 Render2DSentenceClass::~Render2DSentenceClass()
@@ -730,6 +987,9 @@ void Render2DSentenceClass::Reset()
     m_processAmpersand = false;
     Release_Pending_Surfaces();
     Reset_Sentence_Data();
+#ifndef GAME_DLL
+    m_cacheEntry = -1;
+#endif
 }
 
 void Render2DSentenceClass::Reset_Polys()
@@ -804,13 +1064,116 @@ void Render2DSentenceClass::Build_Sentence(const unichar_t *text, int *x, int *y
         return;
     }
 
+#ifndef GAME_DLL
+    if (Use_Cached_Sentence(text, x, y)) {
+        return;
+    }
+
+    // Only sentences built on fresh surfaces are shared, anything else may still be drawn into.
+    bool cacheable = m_font != nullptr && m_curSurface == nullptr && m_pendingSurfaces.Count() == 0;
+    int x_pos = 0;
+    int y_pos = 0;
+
+    if (m_centered && (m_wrapWidth > 0.0f || u_strchr(text, U_CHAR('\n')))) {
+        Build_Sentence_Centered(text, &x_pos, &y_pos);
+    } else {
+        Build_Sentence_Not_Centered(text, &x_pos, &y_pos);
+    }
+
+    if (cacheable) {
+        Cache_Sentence(text, x_pos, y_pos);
+    }
+
+    if (x != nullptr) {
+        *x = x_pos;
+    }
+
+    if (y != nullptr) {
+        *y = y_pos;
+    }
+#else
     if (m_centered && (m_wrapWidth > 0.0f || u_strchr(text, U_CHAR('\n')))) {
         Build_Sentence_Centered(text, x, y);
     } else {
         Build_Sentence_Not_Centered(text, x, y);
     }
+#endif
 }
 
+void Render2DSentenceClass::Flush_Sentence_Cache()
+{
+#ifndef GAME_DLL
+    s_sentenceCache.Flush();
+#endif
+}
+
+#ifndef GAME_DLL
+// Takes the chunks of an identical sentence built earlier. Surfaces that already have a texture are drawn with it,
+// the others are turned into textures on the next Render like freshly built ones.
+bool Render2DSentenceClass::Use_Cached_Sentence(const unichar_t *text, int *x, int *y)
+{
+    if (m_font == nullptr) {
+        return false;
+    }
+
+    int index = s_sentenceCache.Find(SentenceCacheClass::Make_Key(*this, text));
+
+    if (index == -1) {
+        return false;
+    }
+
+    SentenceCacheClass::EntryStruct &entry = s_sentenceCache.Get(index);
+    Reset_Sentence_Data();
+
+    for (int i = 0; i < entry.sentence_count; ++i) {
+        SentenceDataStruct sentence_data = entry.sentence_data[i];
+        sentence_data.surface->Add_Ref();
+        m_sentenceData.Add(sentence_data);
+    }
+
+    for (int i = 0; i < entry.texture_count; ++i) {
+        SurfaceClass *surface = entry.textures[i].surface;
+        bool pending = entry.textures[i].texture != nullptr;
+
+        for (int j = 0; !pending && j < m_pendingSurfaces.Count(); ++j) {
+            pending = m_pendingSurfaces[j].surface == surface;
+        }
+
+        if (!pending) {
+            PendingSurfaceStruct surface_info;
+            surface_info.surface = surface;
+            surface_info.surface->Add_Ref();
+            m_pendingSurfaces.Add(surface_info);
+        }
+    }
+
+    m_cursor = entry.cursor;
+    m_cacheEntry = index;
+
+    if (x != nullptr) {
+        *x = entry.x;
+    }
+
+    if (y != nullptr) {
+        *y = entry.y;
+    }
+
+    return true;
+}
+
+// Shares a freshly built sentence. The current surface is let go so that later builds can't draw over it.
+void Render2DSentenceClass::Cache_Sentence(const unichar_t *text, int x, int y)
+{
+    if (m_lockedPtr != nullptr) {
+        m_curSurface->Unlock();
+        m_lockedPtr = nullptr;
+    }
+
+    Ref_Ptr_Release(m_curSurface);
+    m_cacheEntry = s_sentenceCache.Insert(SentenceCacheClass::Make_Key(*this, text), *this, x, y);
+}
+#endif
+
 void Render2DSentenceClass::Draw_Sentence(uint32_t color)
 {
     Render2DClass *curr_renderer = nullptr;
@@ -835,6 +1198,15 @@ void Render2DSentenceClass::Draw_Sentence(uint32_t color)
                 curr_renderer = new Render2DClass;
                 curr_renderer->Set_Coordinate_Range(Render2DClass::Get_Screen_Resolution());
                 *curr_renderer->Get_Shader() = m_shader;
+#ifndef GAME_DLL
+                if (m_cacheEntry != -1) {
+                    TextureClass *cached_texture = s_sentenceCache.Peek_Texture(m_cacheEntry, curr_surface);
+
+                    if (cached_texture != nullptr) {
+                        curr_renderer->Set_Texture(cached_texture);
+                    }
+                }
+#endif
                 RendererDataStruct render_info;
                 render_info.renderer = curr_renderer;
                 render_info.surface = curr_surface;
@@ -938,6 +1310,12 @@ void Render2DSentenceClass::Build_Textures()
 #endif
         Ref_Ptr_Release(texture_surface);
 
+#ifndef GAME_DLL
+        if (m_cacheEntry != -1) {
+            s_sentenceCache.Set_Texture(m_cacheEntry, curr_surface, new_texture);
+        }
+#endif
+
         for (int renderer_index = 0; renderer_index < surface_info.renderers.Count(); renderer_index++) {
             Render2DClass *renderer = surface_info.renderers[renderer_index];
             renderer->Set_Texture(new_texture);
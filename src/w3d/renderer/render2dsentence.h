@@ -62,10 +62,18 @@ class FontCharsClass : public W3DMPO, public RefCountClass
         unichar_t value;
         int16_t width;
         uint16_t *buffer;
+#ifndef GAME_DLL
+        int16_t page;
+#endif
         IMPLEMENT_NAMED_W3D_POOL(CharDataStruct, FontCharsClassCharDataStruct)
     };
 
 public:
+    enum
+    {
+        DEFAULT_GLYPH_PAGE_LIMIT = 64, // 4MB of glyphs per font.
+    };
+
     FontCharsClass();
     virtual ~FontCharsClass();
 
@@ -76,6 +84,8 @@ public:
     int Get_Char_Width(unichar_t ch);
     int Get_Char_Spacing(unichar_t ch);
     void Blit_Char(unichar_t ch, uint16_t *dest_ptr, int dest_stride, int x, int y);
+    void Set_Glyph_Page_Limit(int limit);
+    int Get_Glyph_Page_Count() const { return m_bufferList.Count(); }
 
 #ifdef GAME_DLL
     FontCharsClass *Hook_Ctor() { return new (this) FontCharsClass; }
@@ -101,6 +111,8 @@ private:
     const CharDataStruct *Store_Freetype_Char(unichar_t ch);
 #endif
     void Update_Current_Buffer(int char_width);
+    int Current_Glyph_Page() const;
+    int Evict_Glyph_Page();
     const CharDataStruct *Get_Char_Data(unichar_t ch);
     void Grow_Unicode_Array(unichar_t ch);
     void Free_Character_Arrays();
@@ -136,11 +148,20 @@ private:
     unichar_t m_firstUnicodeChar;
     unichar_t m_lastUnicodeChar;
     bool m_isBold;
+#ifndef GAME_DLL
+    // Glyph pages are reused least recently used first once the limit is reached.
+    int m_glyphPageLimit;
+    int m_currGlyphPage;
+    unsigned m_glyphClock;
+    DynamicVectorClass<unsigned> m_glyphPageUse;
+#endif
 };
 
 class Render2DSentenceClass
 {
     ALLOW_HOOKING
+    friend class SentenceCacheClass;
+
     struct SentenceDataStruct
     {
         SurfaceClass *surface;
@@ -198,6 +219,8 @@ public:
     int Get_Texture_Size_Hint() const { return m_textureSizeHint; }
     void Set_Mono_Spaced(bool onoff) { m_monoSpaced = onoff; }
 
+    static void Flush_Sentence_Cache();
+
 private:
     void Reset_Sentence_Data();
     void Build_Textures();
@@ -207,6 +230,10 @@ private:
     void Build_Sentence_Centered(const unichar_t *text, int *x = nullptr, int *y = nullptr);
     Vector2 Build_Sentence_Not_Centered(
         const unichar_t *text, int *x = nullptr, int *y = nullptr, bool reuse_surface = false);
+#ifndef GAME_DLL
+    bool Use_Cached_Sentence(const unichar_t *text, int *x, int *y);
+    void Cache_Sentence(const unichar_t *text, int x, int y);
+#endif
 
 private:
     DynamicVectorClass<SentenceDataStruct> m_sentenceData;
@@ -233,5 +260,90 @@ private:
     int m_lockedStride;
     TextureClass *m_curTexture;
     ShaderClass m_shader;
+#ifndef GAME_DLL
+    int m_cacheEntry;
+#endif
     friend class W3DDisplayString;
 };
+
+#ifndef GAME_DLL
+/**
+ * Sentences built by any Render2DSentenceClass, keyed by font, text and layout. Labels, timers and chat keep cycling
+ * through the same strings, so a sentence that was built before reuses its surfaces and textures instead of blitting
+ * the glyphs and creating a texture again.
+ */
+class SentenceCacheClass
+{
+public:
+    enum
+    {
+        CACHE_SIZE = 128,
+        HASH_SIZE = 256,
+    };
+
+    enum
+    {
+        FLAG_CENTERED = 1 << 0,
+        FLAG_AMPERSAND = 1 << 1,
+        FLAG_PARTIAL_WORDS = 1 << 2,
+    };
+
+    struct KeyStruct
+    {
+        FontCharsClass *font;
+        const unichar_t *text;
+        int length;
+        float wrap_width;
+        int texture_size_hint;
+        int flags;
+        uint32_t hash;
+    };
+
+    struct TextureDataStruct
+    {
+        SurfaceClass *surface;
+        TextureClass *texture;
+    };
+
+    struct EntryStruct
+    {
+        KeyStruct key;
+        int x;
+        int y;
+        Vector2 cursor;
+        Render2DSentenceClass::SentenceDataStruct *sentence_data;
+        int sentence_count;
+        TextureDataStruct *textures;
+        int texture_count;
+        unsigned last_used;
+        int next;
+    };
+
+    SentenceCacheClass() : m_count(0), m_clock(0)
+    {
+        for (int i = 0; i < HASH_SIZE; ++i) {
+            m_buckets[i] = -1;
+        }
+    }
+
+    ~SentenceCacheClass() { Flush(); }
+
+    static KeyStruct Make_Key(const Render2DSentenceClass &sentence, const unichar_t *text);
+
+    int Find(const KeyStruct &key);
+    int Insert(const KeyStruct &key, const Render2DSentenceClass &sentence, int x, int y);
+    EntryStruct &Get(int index) { return m_entries[index]; }
+    int Count() const { return m_count; }
+    TextureClass *Peek_Texture(int index, SurfaceClass *surface) const;
+    void Set_Texture(int index, SurfaceClass *surface, TextureClass *texture);
+    void Flush();
+
+private:
+    void Release_Entry(int index);
+
+    EntryStruct m_entries[CACHE_SIZE];
+    int m_buckets[HASH_SIZE];
+    int m_count;
+    unsigned m_clock;
+};
+#endif
@@ -0,0 +1,451 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Batched frustum culling of bounding spheres.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include "spherecull.h"
+#include "frustum.h"
+#include <algorithm>
+
+#if defined __SSE__ || defined _M_X64 || defined _M_IX86
+#define SPHERECULL_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
+
+int SphereCullListClass::Add(const SphereClass &sphere)
+{
+    if (m_count >= m_x.Length()) {
+        Grow(m_count + 1);
+    }
+
+    Set(m_count++, sphere);
+
+    return m_count - 1;
+}
+
+void SphereCullListClass::Set(int index, const SphereClass &sphere)
+{
+    captainslog_assert(index < m_x.Length());
+    m_x[index] = sphere.Center.X;
+    m_y[index] = sphere.Center.Y;
+    m_z[index] = sphere.Center.Z;
+    m_radius[index] = sphere.Radius;
+}
+
+SphereClass SphereCullListClass::Get(int index) const
+{
+    return SphereClass(Vector3(m_x[index], m_y[index], m_z[index]), m_radius[index]);
+}
+
+void SphereCullListClass::Grow(int count)
+{
+    int size = std::max(std::max(count, m_x.Length() * 2), 64);
+    m_x.Resize(size);
+    m_y.Resize(size);
+    m_z.Resize(size);
+    m_radius.Resize(size);
+    m_result.Resize(size);
+}
+
+/**
+ * Tests a range of spheres against the frustum planes and stores the result per sphere. When classify is false only
+ * spheres outside are told apart from visible ones, which allows leaving the plane loop early. Returns the number
+ * of visible spheres in the range.
+ *
+ * Each plane test is the same sum of products as CollisionMath::Overlap_Test(PlaneClass, SphereClass) so the SIMD
+ * paths agree with the scalar path.
+ */
+int SphereCullListClass::Test(const FrustumClass &frustum, int start, int count, bool classify)
+{
+    captainslog_assert(start >= 0 && start + count <= m_count);
+
+    if (count <= 0) {
+        return 0;
+    }
+
+    const PlaneClass *planes = frustum.m_planes;
+    const float *x = &m_x[0];
+    const float *y = &m_y[0];
+    const float *z = &m_z[0];
+    const float *radius = &m_radius[0];
+    uint8_t *result = &m_result[0];
+    int end = start + count;
+    int visible = 0;
+    int i = start;
+
+#ifdef __AVX__
+    for (; i + 8 <= end; i += 8) {
+        __m256 cx = _mm256_loadu_ps(x + i);
+        __m256 cy = _mm256_loadu_ps(y + i);
+        __m256 cz = _mm256_loadu_ps(z + i);
+        __m256 r = _mm256_loadu_ps(radius + i);
+        __m256 neg_r = _mm256_sub_ps(_mm256_setzero_ps(), r);
+        __m256 outside = _mm256_setzero_ps();
+        __m256 inside = _mm256_cmp_ps(r, r, _CMP_EQ_OQ);
+
+        for (int p = 0; p < 6; ++p) {
+            __m256 dist = _mm256_add_ps(_mm256_mul_ps(cx, _mm256_set1_ps(planes[p].N.X)),
+                _mm256_mul_ps(cy, _mm256_set1_ps(planes[p].N.Y)));
+            dist = _mm256_add_ps(dist, _mm256_mul_ps(cz, _mm256_set1_ps(planes[p].N.Z)));
+            dist = _mm256_sub_ps(dist, _mm256_set1_ps(planes[p].D));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(dist, r, _CMP_GT_OQ));
+
+            if (classify) {
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(dist, neg_r, _CMP_LT_OQ));
+            } else if (_mm256_movemask_ps(outside) == 0xFF) {
+                break;
+            }
+        }
+
+        int outside_mask = _mm256_movemask_ps(outside);
+        int inside_mask = classify ? _mm256_movemask_ps(inside) : 0;
+
+        for (int j = 0; j < 8; ++j) {
+            if (outside_mask & (1 << j)) {
+                result[i + j] = CULL_OUTSIDE;
+            } else {
+                result[i + j] = (inside_mask & (1 << j)) ? CULL_INSIDE : CULL_OVERLAPPED;
+                ++visible;
+            }
+        }
+    }
+#endif
+
+#ifdef SPHERECULL_USE_SSE
+    __m128 plane_x[6];
+    __m128 plane_y[6];
+    __m128 plane_z[6];
+    __m128 plane_d[6];
+
+    for (int p = 0; p < 6; ++p) {
+        plane_x[p] = _mm_set1_ps(planes[p].N.X);
+        plane_y[p] = _mm_set1_ps(planes[p].N.Y);
+        plane_z[p] = _mm_set1_ps(planes[p].N.Z);
+        plane_d[p] = _mm_set1_ps(planes[p].D);
+    }
+
+    for (; i + 4 <= end; i += 4) {
+        __m128 cx = _mm_loadu_ps(x + i);
+        __m128 cy = _mm_loadu_ps(y + i);
+        __m128 cz = _mm_loadu_ps(z + i);
+        __m128 r = _mm_loadu_ps(radius + i);
+        __m128 neg_r = _mm_sub_ps(_mm_setzero_ps(), r);
+        __m128 outside = _mm_setzero_ps();
+        __m128 inside = _mm_cmpeq_ps(r, r);
+
+        for (int p = 0; p < 6; ++p) {
+            __m128 dist = _mm_add_ps(_mm_mul_ps(cx, plane_x[p]), _mm_mul_ps(cy, plane_y[p]));
+            dist = _mm_add_ps(dist, _mm_mul_ps(cz, plane_z[p]));
+            dist = _mm_sub_ps(dist, plane_d[p]);
+            outside = _mm_or_ps(outside, _mm_cmpgt_ps(dist, r));
+
+            if (classify) {
+                inside = _mm_and_ps(inside, _mm_cmplt_ps(dist, neg_r));
+            } else if (_mm_movemask_ps(outside) == 0xF) {
+                break;
+            }
+        }
+
+        int outside_mask = _mm_movemask_ps(outside);
+        int inside_mask = classify ? _mm_movemask_ps(inside) : 0;
+
+        for (int j = 0; j < 4; ++j) {
+            if (outside_mask & (1 << j)) {
+                result[i + j] = CULL_OUTSIDE;
+            } else {
+                result[i + j] = (inside_mask & (1 << j)) ? CULL_INSIDE : CULL_OVERLAPPED;
+                ++visible;
+            }
+        }
+    }
+#endif
+
+    for (; i < end; ++i) {
+        bool outside = false;
+        bool inside = true;
+
+        for (int p = 0; p < 6 && !outside; ++p) {
+            float dist = x[i] * planes[p].N.X + y[i] * planes[p].N.Y + z[i] * planes[p].N.Z - planes[p].D;
+            outside = dist > radius[i];
+            inside = inside && dist < -radius[i];
+        }
+
+        if (outside) {
+            result[i] = CULL_OUTSIDE;
+        } else {
+            result[i] = (classify && inside) ? CULL_INSIDE : CULL_OVERLAPPED;
+            ++visible;
+        }
+    }
+
+    return visible;
+}
+
+void SphereCullGridClass::Reset()
+{
+    m_spheres.Delete_All(false);
+    m_removed.Delete_All(false);
+    m_dirty = true;
+}
+
+int SphereCullGridClass::Add(const SphereClass &sphere)
+{
+    m_spheres.Add(sphere);
+    m_removed.Add(false);
+    m_dirty = true;
+
+    return m_spheres.Count() - 1;
+}
+
+/**
+ * Moves a sphere, bringing it back if it was removed. The sphere stays in the cell it was sorted into so the grid
+ * does not need a rebuild, objects that move far are expected to be rare for the static scenery this is used for.
+ */
+void SphereCullGridClass::Set(int handle, const SphereClass &sphere)
+{
+    m_spheres[handle] = sphere;
+    m_removed[handle] = false;
+
+    if (!m_dirty) {
+        m_slots.Set(m_handleSlot[handle], sphere);
+        Mark_Cell_Dirty(handle);
+    }
+}
+
+void SphereCullGridClass::Remove(int handle)
+{
+    m_removed[handle] = true;
+
+    if (!m_dirty) {
+        Mark_Cell_Dirty(handle);
+    }
+}
+
+void SphereCullGridClass::Mark_Cell_Dirty(int handle)
+{
+    m_cellState[m_handleCell[handle]] = CELL_DIRTY;
+    m_cellsDirty = true;
+}
+
+/**
+ * Computes the bounding sphere of the spheres in a cell that have not been removed.
+ */
+void SphereCullGridClass::Update_Cell_Bounds(int cell)
+{
+    Vector3 box_min;
+    Vector3 box_max;
+    bool empty = true;
+
+    for (int slot = m_cellStart[cell]; slot < m_cellStart[cell + 1]; ++slot) {
+        int handle = m_slotHandle[slot];
+
+        if (m_removed[handle]) {
+            continue;
+        }
+
+        const SphereClass &sphere = m_spheres[handle];
+        Vector3 extent(sphere.Radius, sphere.Radius, sphere.Radius);
+
+        if (empty) {
+            box_min = sphere.Center - extent;
+            box_max = sphere.Center + extent;
+            empty = false;
+        } else {
+            box_min.Update_Min(sphere.Center - extent);
+            box_max.Update_Max(sphere.Center + extent);
+        }
+    }
+
+    if (empty) {
+        m_cellState[cell] = CELL_EMPTY;
+        return;
+    }
+
+    Vector3 center = (box_min + box_max) * 0.5f;
+    m_cellBounds.Set(cell, SphereClass(center, (box_max - center).Length()));
+    m_cellState[cell] = CELL_VALID;
+}
+
+/**
+ * Sorts the spheres into the cells of a grid over their XY extent and computes a bounding sphere for each non empty
+ * cell.
+ */
+void SphereCullGridClass::Build()
+{
+    int count = m_spheres.Count();
+    m_dirty = false;
+    m_slots.Reset();
+    m_cellBounds.Reset();
+    m_cellStart.Delete_All(false);
+    m_handleCell.Delete_All(false);
+    m_handleSlot.Delete_All(false);
+    m_slotHandle.Delete_All(false);
+    m_visible.Resize(count);
+
+    if (count == 0) {
+        return;
+    }
+
+    // Removed spheres are left out of the grid extent, they still get a slot in case they are brought back.
+    float min_x = 0.0f;
+    float max_x = 0.0f;
+    float min_y = 0.0f;
+    float max_y = 0.0f;
+    bool first = true;
+
+    for (int i = 0; i < count; ++i) {
+        if (m_removed[i]) {
+            continue;
+        }
+
+        if (first) {
+            min_x = max_x = m_spheres[i].Center.X;
+            min_y = max_y = m_spheres[i].Center.Y;
+            first = false;
+        }
+
+        min_x = std::min(min_x, m_spheres[i].Center.X);
+        max_x = std::max(max_x, m_spheres[i].Center.X);
+        min_y = std::min(min_y, m_spheres[i].Center.Y);
+        max_y = std::max(max_y, m_spheres[i].Center.Y);
+    }
+
+    float cell_width = std::max(m_cellSize, (max_x - min_x) / (MAX_CELLS_PER_AXIS - 1));
+    float cell_height = std::max(m_cellSize, (max_y - min_y) / (MAX_CELLS_PER_AXIS - 1));
+    int cells_x = std::min(int((max_x - min_x) / cell_width) + 1, int(MAX_CELLS_PER_AXIS));
+    int cells_y = std::min(int((max_y - min_y) / cell_height) + 1, int(MAX_CELLS_PER_AXIS));
+
+    // Count the spheres per grid cell, then give every non empty cell a compact index.
+    SimpleVecClass<int> grid(cells_x * cells_y);
+    grid.Zero_Memory();
+    m_handleCell.Add_Multiple(count);
+
+    for (int i = 0; i < count; ++i) {
+        int cx = std::clamp(int((m_spheres[i].Center.X - min_x) / cell_width), 0, cells_x - 1);
+        int cy = std::clamp(int((m_spheres[i].Center.Y - min_y) / cell_height), 0, cells_y - 1);
+        m_handleCell[i] = cy * cells_x + cx;
+        ++grid[m_handleCell[i]];
+    }
+
+    int cells = 0;
+
+    for (int i = 0; i < cells_x * cells_y; ++i) {
+        if (grid[i] != 0) {
+            m_cellStart.Add(grid[i]);
+            grid[i] = cells++;
+        } else {
+            grid[i] = -1;
+        }
+    }
+
+    // Turn the counts into start offsets, with a terminating entry so each cell spans [start, next start).
+    int start = 0;
+    m_cellStart.Add(0);
+
+    for (int i = 0; i <= cells; ++i) {
+        int cell_count = m_cellStart[i];
+        m_cellStart[i] = start;
+        start += cell_count;
+    }
+
+    SimpleVecClass<int> fill(cells);
+
+    for (int i = 0; i < cells; ++i) {
+        fill[i] = m_cellStart[i];
+    }
+
+    m_handleSlot.Add_Multiple(count);
+    m_slotHandle.Add_Multiple(count);
+
+    for (int i = 0; i < count; ++i) {
+        int cell = grid[m_handleCell[i]];
+        int slot = fill[cell]++;
+        m_handleCell[i] = cell;
+        m_handleSlot[i] = slot;
+        m_slotHandle[slot] = i;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        m_slots.Add(m_spheres[m_slotHandle[i]]);
+    }
+
+    m_cellState.Resize(cells);
+    m_cellsDirty = false;
+
+    for (int cell = 0; cell < cells; ++cell) {
+        m_cellBounds.Add(SphereClass());
+        Update_Cell_Bounds(cell);
+    }
+}
+
+/**
+ * Culls all spheres in the grid, returns the number of visible spheres. Cells fully outside or fully inside the
+ * frustum resolve all of their spheres at once, only cells crossing a plane test their spheres individually.
+ */
+int SphereCullGridClass::Cull(const FrustumClass &frustum)
+{
+    if (m_dirty) {
+        Build();
+    }
+
+    if (m_cellsDirty) {
+        for (int cell = 0; cell < m_cellBounds.Count(); ++cell) {
+            if (m_cellState[cell] == CELL_DIRTY) {
+                Update_Cell_Bounds(cell);
+            }
+        }
+
+        m_cellsDirty = false;
+    }
+
+    int visible = 0;
+    m_cellsRejected = 0;
+    m_cellBounds.Classify(frustum);
+
+    for (int cell = 0; cell < m_cellBounds.Count(); ++cell) {
+        int start = m_cellStart[cell];
+        int end = m_cellStart[cell + 1];
+        SphereCullListClass::CullResult result = m_cellBounds.Get_Result(cell);
+
+        if (m_cellState[cell] == CELL_EMPTY) {
+            result = SphereCullListClass::CULL_OUTSIDE;
+        } else if (result == SphereCullListClass::CULL_OVERLAPPED) {
+            m_slots.Cull(frustum, start, end - start);
+        }
+
+        if (result == SphereCullListClass::CULL_OUTSIDE) {
+            ++m_cellsRejected;
+        }
+
+        for (int slot = start; slot < end; ++slot) {
+            int handle = m_slotHandle[slot];
+            bool is_visible;
+
+            if (m_removed[handle] || result == SphereCullListClass::CULL_OUTSIDE) {
+                is_visible = false;
+            } else if (result == SphereCullListClass::CULL_INSIDE) {
+                is_visible = true;
+            } else {
+                is_visible = m_slots.Is_Visible(slot);
+            }
+
+            m_visible[handle] = is_visible;
+            visible += is_visible;
+        }
+    }
+
+    return visible;
+}
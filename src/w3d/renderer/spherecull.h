@@ -0,0 +1,121 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Batched frustum culling of bounding spheres.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#pragma once
+
+#include "always.h"
+#include "simplevec.h"
+#include "sphere.h"
+
+class FrustumClass;
+
+/**
+ * Stores bounding spheres as contiguous arrays of each component so that they can be tested against the frustum
+ * planes several at a time. Gives the same answer as CameraClass::Cull_Sphere for every sphere.
+ */
+class SphereCullListClass
+{
+public:
+    enum CullResult
+    {
+        CULL_OUTSIDE,
+        CULL_OVERLAPPED,
+        CULL_INSIDE,
+    };
+
+    SphereCullListClass() : m_count(0) {}
+
+    void Reset() { m_count = 0; }
+    int Add(const SphereClass &sphere);
+    void Set(int index, const SphereClass &sphere);
+    SphereClass Get(int index) const;
+    int Count() const { return m_count; }
+
+    int Cull(const FrustumClass &frustum) { return Test(frustum, 0, m_count, false); }
+    int Cull(const FrustumClass &frustum, int start, int count) { return Test(frustum, start, count, false); }
+    int Classify(const FrustumClass &frustum) { return Test(frustum, 0, m_count, true); }
+
+    CullResult Get_Result(int index) const { return CullResult(m_result[index]); }
+    bool Is_Visible(int index) const { return m_result[index] != CULL_OUTSIDE; }
+
+private:
+    void Grow(int count);
+    int Test(const FrustumClass &frustum, int start, int count, bool classify);
+
+    SimpleVecClass<float> m_x;
+    SimpleVecClass<float> m_y;
+    SimpleVecClass<float> m_z;
+    SimpleVecClass<float> m_radius;
+    SimpleVecClass<uint8_t> m_result;
+    int m_count;
+};
+
+/**
+ * Groups mostly static spheres such as trees and props into cells of a 2D grid so that cells completely outside or
+ * completely inside the frustum are resolved with a single test. Spheres are referred to by the handle returned
+ * from Add, which is the order they were added in. Removed spheres keep their handle but are never visible and no
+ * longer count towards the bounds of their cell.
+ */
+class SphereCullGridClass
+{
+public:
+    enum
+    {
+        MAX_CELLS_PER_AXIS = 64,
+    };
+
+    SphereCullGridClass(float cell_size = 250.0f) :
+        m_cellSize(cell_size), m_dirty(false), m_cellsDirty(false), m_cellsRejected(0)
+    {
+    }
+
+    void Reset();
+    int Add(const SphereClass &sphere);
+    void Set(int handle, const SphereClass &sphere);
+    void Remove(int handle);
+    int Count() const { return m_spheres.Count(); }
+
+    int Cull(const FrustumClass &frustum);
+    bool Is_Visible(int handle) const { return m_visible[handle] != 0; }
+
+    int Get_Cell_Count() const { return m_cellBounds.Count(); }
+    int Get_Cells_Rejected() const { return m_cellsRejected; }
+
+private:
+    enum CellState
+    {
+        CELL_VALID,
+        CELL_DIRTY,
+        CELL_EMPTY,
+    };
+
+    void Build();
+    void Update_Cell_Bounds(int cell);
+    void Mark_Cell_Dirty(int handle);
+
+    float m_cellSize;
+    bool m_dirty;
+    bool m_cellsDirty;
+    int m_cellsRejected;
+    SimpleDynVecClass<SphereClass> m_spheres;
+    SimpleDynVecClass<uint8_t> m_removed;
+    SimpleDynVecClass<int> m_handleCell;
+    SimpleDynVecClass<int> m_handleSlot;
+    SimpleDynVecClass<int> m_slotHandle;
+    SimpleDynVecClass<int> m_cellStart;
+    SimpleVecClass<uint8_t> m_cellState;
+    SimpleVecClass<uint8_t> m_visible;
+    SphereCullListClass m_slots;
+    SphereCullListClass m_cellBounds;
+};
@@ -2,7 +2,17 @@
 #include <gtest/gtest.h>
 #include <iostream>
 
+#include "critsection.h"
 #include "gamememory.h"
+#include "memdynalloc.h"
+#include "mempool.h"
+#include "unicodestring.h"
+#include "xfersave.h"
+
+// Some tests allocate on worker threads, so the memory manager needs its locks like in the game.
+SimpleCriticalSectionClass critSec1;
+SimpleCriticalSectionClass critSec2;
+SimpleCriticalSectionClass critSec3;
 
 int main(int argc, char **argv)
 {
@@ -13,12 +23,21 @@ int main(int argc, char **argv)
     captains_settings.console = true;
     captainslog_init(&captains_settings);
 
+    g_unicodeStringCriticalSection = &critSec1;
+    g_dmaCriticalSection = &critSec2;
+    g_memoryPoolCriticalSection = &critSec3;
+
     Init_Memory_Manager();
 
     int result = RUN_ALL_TESTS();
 
+    XferSave::Shutdown_Flush();
     Shutdown_Memory_Manager();
 
+    g_unicodeStringCriticalSection = nullptr;
+    g_dmaCriticalSection = nullptr;
+    g_memoryPoolCriticalSection = nullptr;
+
     captainslog_deinit();
 
     return result;
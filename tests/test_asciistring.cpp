@@ -0,0 +1,200 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate the inline storage of short strings and to measure string allocations.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "asciistring.h"
+#include "memdynalloc.h"
+
+namespace
+{
+constexpr int BENCHMARK_FRAMES = 2000;
+
+std::string Make_Text(int len)
+{
+    std::string text;
+
+    for (int i = 0; i < len; ++i) {
+        text += char('A' + i % 26);
+    }
+
+    return text;
+}
+
+// Strings of the kind the engine juggles every frame, script and team names, archive paths and save block names.
+const char *const SCRIPT_NAMES[] = { "<This Team>", "teamPlayer_1", "Skirmish_AttackBase", "MyOuterPerimeter" };
+const char *const FILE_PATHS[] = {
+    "Art\\Textures\\AVHumvee.dds", "Data\\Audio\\Sounds\\VHumvMoveA.wav", "Art\\W3D\\AVHumvee_D1.w3d"
+};
+const char *const BLOCK_NAMES[] = { "CHUNK_GameState", "CHUNK_Campaign", "CHUNK_TerrainLogic", "CHUNK_Players" };
+
+// Runs one frame worth of string handling and returns something derived from it so it can't be optimized away.
+int Run_Frame(int frame)
+{
+    int sum = 0;
+
+    for (const char *name : SCRIPT_NAMES) {
+        Utf8String team(name);
+        Utf8String qualified = team;
+
+        if (qualified != UTF8_LITERAL("<This Team>")) {
+            qualified += "_1";
+        }
+
+        sum += qualified.Get_Length();
+    }
+
+    for (const char *path : FILE_PATHS) {
+        Utf8String remaining(path);
+        Utf8String token;
+        remaining.To_Lower();
+
+        while (remaining.Next_Token(&token, "\\/")) {
+            sum += token.Get_Length();
+        }
+    }
+
+    for (const char *block : BLOCK_NAMES) {
+        Utf8String name;
+        name.Format("%s", block);
+        sum += name.Compare_No_Case(UTF8_LITERAL("CHUNK_GameState")) == 0;
+    }
+
+    Utf8String eof(UTF8_LITERAL("SG_EOF"));
+    sum += eof.Get_Length() + frame % 2;
+    return sum;
+}
+} // namespace
+
+TEST(asciistring, small_strings)
+{
+    for (int len = 0; len < 40; ++len) {
+        std::string text = Make_Text(len);
+        Utf8String string(text.c_str());
+        EXPECT_STREQ(string.Str(), text.c_str()) << "Length " << len;
+        EXPECT_EQ(string.Get_Length(), len);
+        EXPECT_EQ(string.Is_Empty(), len == 0);
+
+        Utf8String copy = string;
+        EXPECT_TRUE(copy == string) << "Length " << len;
+
+        // Growing and shrinking across the inline limit.
+        copy += 'z';
+        EXPECT_STREQ(copy.Str(), (text + 'z').c_str()) << "Length " << len;
+        EXPECT_STREQ(string.Str(), text.c_str()) << "Length " << len;
+        copy.Remove_Last_Char();
+        EXPECT_TRUE(copy == string) << "Length " << len;
+
+        copy.Concat(text.c_str());
+        EXPECT_STREQ(copy.Str(), (text + text).c_str()) << "Length " << len;
+
+        Utf8String padded(("  " + text + "  ").c_str());
+        padded.Trim();
+        EXPECT_STREQ(padded.Str(), text.c_str()) << "Length " << len;
+
+        padded.To_Lower();
+        EXPECT_EQ(padded.Compare_No_Case(string), 0) << "Length " << len;
+
+        char *buf = copy.Get_Buffer_For_Read(len);
+        memcpy(buf, text.c_str(), len + 1);
+        EXPECT_STREQ(copy.Str(), text.c_str()) << "Length " << len;
+
+        // Strings are moved around as plain memory by some containers.
+        alignas(Utf8String) char moved[sizeof(Utf8String)];
+        memcpy(moved, static_cast<void *>(&string), sizeof(Utf8String));
+        new (&string) Utf8String();
+        EXPECT_STREQ(reinterpret_cast<Utf8String *>(moved)->Str(), text.c_str()) << "Length " << len;
+        reinterpret_cast<Utf8String *>(moved)->~Utf8String();
+    }
+
+    // Zeroed memory holds an empty string.
+    alignas(Utf8String) char zeroed[sizeof(Utf8String)] = {};
+    EXPECT_TRUE(reinterpret_cast<Utf8String *>(zeroed)->Is_Empty());
+    EXPECT_EQ(reinterpret_cast<Utf8String *>(zeroed)->Get_Length(), 0);
+}
+
+TEST(asciistring, next_token)
+{
+    Utf8String path("Data\\Audio\\Sounds\\AVeryLongSoundFileNameThatIsAllocated.wav");
+    Utf8String token;
+    std::vector<std::string> tokens;
+
+    while (path.Next_Token(&token, "\\/")) {
+        tokens.push_back(token.Str());
+    }
+
+    ASSERT_EQ(int(tokens.size()), 4);
+    EXPECT_STREQ(tokens[0].c_str(), "Data");
+    EXPECT_STREQ(tokens[1].c_str(), "Audio");
+    EXPECT_STREQ(tokens[2].c_str(), "Sounds");
+    EXPECT_STREQ(tokens[3].c_str(), "AVeryLongSoundFileNameThatIsAllocated.wav");
+}
+
+TEST(asciistring, literal)
+{
+    const Utf8String &literal = UTF8_LITERAL("A string constant too long to be stored inline");
+    unsigned allocations = g_dynamicMemoryAllocator->Get_Allocation_Count();
+
+    {
+        std::vector<Utf8String> copies(1000, literal);
+        Utf8String assigned;
+        assigned = literal;
+
+        // Only the vector itself allocates, the characters are shared.
+        EXPECT_LE(g_dynamicMemoryAllocator->Get_Allocation_Count() - allocations, 1u);
+        EXPECT_TRUE(assigned == literal);
+        EXPECT_TRUE(copies.back() == literal);
+        EXPECT_STREQ(copies.front().Str(), "A string constant too long to be stored inline");
+    }
+
+    EXPECT_STREQ(literal.Str(), "A string constant too long to be stored inline");
+
+    // Writing to a copy makes it its own.
+    Utf8String copy = literal;
+    copy.To_Lower();
+    EXPECT_STREQ(copy.Str(), "a string constant too long to be stored inline");
+    EXPECT_STREQ(literal.Str(), "A string constant too long to be stored inline");
+    EXPECT_TRUE(copy != literal);
+}
+
+TEST(asciistring, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    int sum = 0;
+    unsigned allocations = g_dynamicMemoryAllocator->Get_Allocation_Count();
+    auto start = steady_clock::now();
+
+    for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame) {
+        sum += Run_Frame(frame);
+    }
+
+    nanoseconds elapsed = steady_clock::now() - start;
+    allocations = g_dynamicMemoryAllocator->Get_Allocation_Count() - allocations;
+
+    EXPECT_GT(sum, 0);
+
+    // Every name and path in the scripted frames fits inline, only the lower cased long paths allocate.
+    EXPECT_LE(allocations, unsigned(BENCHMARK_FRAMES * ARRAY_SIZE(FILE_PATHS)));
+
+    captainslog_info("Ran %d scripted string frames.", BENCHMARK_FRAMES);
+    captainslog_info("Allocations: %u, %.2f per frame", allocations, double(allocations) / BENCHMARK_FRAMES);
+    captainslog_info("Time: %lld us", (long long)duration_cast<microseconds>(elapsed).count());
+}
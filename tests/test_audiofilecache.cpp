@@ -14,6 +14,9 @@
  */
 #include <audioeventinfo.h>
 #include <audioeventrts.h>
+#include <captainslog.h>
+#include <chrono>
+#include <cstring>
 #include <gtest/gtest.h>
 #include <win32localfilesystem.h>
 #ifdef BUILD_WITH_FFMPEG
@@ -23,6 +26,27 @@
 extern LocalFileSystem *g_theLocalFileSystem;
 
 #ifdef BUILD_WITH_FFMPEG
+namespace
+{
+constexpr int BENCHMARK_OPENS = 50;
+
+// Gives the decode thread time the way frames passing would, returns false if it took unreasonably long.
+bool Wait_For_Prefetch(Thyme::FFmpegAudioFileCache &cache, const Utf8String &filename)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    while (cache.Is_File_Pending(filename)) {
+        if (std::chrono::steady_clock::now() - start > std::chrono::seconds(10)) {
+            return false;
+        }
+
+        ThreadClass::Switch_Thread();
+    }
+
+    return true;
+}
+} // namespace
+
 TEST(audio, ffmpegaudiofilecache)
 {
     g_theLocalFileSystem = new Win32LocalFileSystem;
@@ -56,4 +80,101 @@ TEST(audio, ffmpegaudiofilecache)
 
     delete g_theLocalFileSystem;
 }
+
+TEST(audio, ffmpegaudiofilecache_prefetch)
+{
+    g_theLocalFileSystem = new Win32LocalFileSystem;
+    Thyme::FFmpegAudioFileCache cache;
+    auto filepath = Utf8String(TESTDATA_PATH) + "/audio/pcm1644m.wav";
+
+    // Nothing is prefetched while the cache can't hold the file
+    EXPECT_FALSE(cache.Prefetch_File(filepath));
+    EXPECT_FALSE(cache.Is_File_Pending(filepath));
+    EXPECT_EQ(cache.Get_Current_Size(), 0);
+
+    // Opening a file that is still queued or decoding waits for its data
+    cache.Set_Max_Size(0xFFFFF);
+    EXPECT_TRUE(cache.Prefetch_File(filepath));
+    void *data = cache.Open_File(filepath);
+    ASSERT_NE(data, nullptr);
+    EXPECT_FALSE(cache.Is_File_Pending(filepath));
+    EXPECT_FALSE(cache.Prefetch_File(filepath));
+    auto cache_size = cache.Get_Current_Size();
+    EXPECT_NE(cache_size, 0);
+
+    // The decode thread has to produce the same data as opening the file directly
+    Thyme::FFmpegAudioFileCache sync_cache;
+    sync_cache.Set_Max_Size(0xFFFFF);
+    void *sync_data = sync_cache.Open_File(filepath);
+    ASSERT_NE(sync_data, nullptr);
+    EXPECT_EQ(sync_cache.Get_Current_Size(), cache_size);
+    EXPECT_EQ(sync_cache.Get_File_Length_MS(sync_data), cache.Get_File_Length_MS(data));
+
+    uint8_t *samples[2];
+    uint32_t size[2];
+    uint32_t freq[2];
+    uint8_t channels[2];
+    uint8_t bits_per_sample[2];
+    Thyme::FFmpegAudioFileCache::Get_Wave_Data(data, samples[0], size[0], freq[0], channels[0], bits_per_sample[0]);
+    Thyme::FFmpegAudioFileCache::Get_Wave_Data(
+        sync_data, samples[1], size[1], freq[1], channels[1], bits_per_sample[1]);
+    ASSERT_EQ(size[0], size[1]);
+    EXPECT_EQ(freq[0], freq[1]);
+    EXPECT_EQ(channels[0], channels[1]);
+    EXPECT_EQ(bits_per_sample[0], bits_per_sample[1]);
+    EXPECT_EQ(memcmp(samples[0], samples[1], size[0]), 0);
+    sync_cache.Close_File(sync_data);
+
+    // Left alone, a prefetch is finished by the decode thread
+    cache.Close_File(data);
+    EXPECT_EQ(cache.Free_Space(), cache_size);
+    EXPECT_TRUE(cache.Prefetch_File(filepath));
+    EXPECT_TRUE(Wait_For_Prefetch(cache, filepath));
+    EXPECT_EQ(cache.Get_Current_Size(), cache_size);
+    EXPECT_EQ(cache.Free_Space(), cache_size);
+    EXPECT_EQ(cache.Get_Current_Size(), 0);
+
+    delete g_theLocalFileSystem;
+}
+
+TEST(audio, DISABLED_ffmpegaudiofilecache_benchmark)
+{
+    using namespace std::chrono;
+
+    g_theLocalFileSystem = new Win32LocalFileSystem;
+    Thyme::FFmpegAudioFileCache cache;
+    cache.Set_Max_Size(0xFFFFF);
+    auto filepath = Utf8String(TESTDATA_PATH) + "/audio/pcm1644m.wav";
+    nanoseconds sync_time(0);
+    nanoseconds prefetch_time(0);
+
+    for (int i = 0; i < BENCHMARK_OPENS; ++i) {
+        // A cold open decodes the whole sample on the calling thread
+        auto start = steady_clock::now();
+        void *data = cache.Open_File(filepath);
+        sync_time += steady_clock::now() - start;
+        ASSERT_NE(data, nullptr);
+        cache.Close_File(data);
+        cache.Free_Space();
+
+        // A prefetched one only costs the calling thread queuing it and picking up the decoded data
+        start = steady_clock::now();
+        cache.Prefetch_File(filepath);
+        prefetch_time += steady_clock::now() - start;
+        ASSERT_TRUE(Wait_For_Prefetch(cache, filepath));
+
+        start = steady_clock::now();
+        data = cache.Open_File(filepath);
+        prefetch_time += steady_clock::now() - start;
+        ASSERT_NE(data, nullptr);
+        cache.Close_File(data);
+        cache.Free_Space();
+    }
+
+    captainslog_info("Opened %s %d times.", filepath.Str(), BENCHMARK_OPENS);
+    captainslog_info("Decoded on open: %lld us", (long long)duration_cast<microseconds>(sync_time).count());
+    captainslog_info("Prefetched: %lld us", (long long)duration_cast<microseconds>(prefetch_time).count());
+
+    delete g_theLocalFileSystem;
+}
 #endif
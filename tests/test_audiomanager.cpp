@@ -14,6 +14,7 @@
  */
 #include <audioeventrts.h>
 #include <audiomanager.h>
+#include <captainslog.h>
 #include <gtest/gtest.h>
 #include <win32localfilesystem.h>
 #ifdef BUILD_WITH_OPENAL
@@ -35,6 +36,29 @@ public:
     }
 };
 
+class TestPositionalAudioEventInfo : public TestAudioEventInfo
+{
+public:
+    TestPositionalAudioEventInfo()
+    {
+        m_volume = 1.0f;
+        m_visibility = VISIBILITY_WORLD;
+        m_control = CONTROL_LOOP;
+        m_minRange = 10.0f;
+        m_maxRange = 100.0f;
+    }
+};
+
+class TestDelayedAudioEventInfo : public TestAudioEventInfo
+{
+public:
+    TestDelayedAudioEventInfo()
+    {
+        m_delayLow = 500;
+        m_delayHigh = 500;
+    }
+};
+
 #ifdef BUILD_WITH_OPENAL
 void test_audiomanager(Thyme::ALAudioManager &mngr)
 {
@@ -62,12 +86,17 @@ void test_audiomanager(Thyme::ALAudioManager &mngr)
     mngr.friend_Force_Play_Audio_Event(ev);
     EXPECT_TRUE(mngr.Is_Currently_Playing(ev->Get_Playing_Handle()));
 
+    mngr.Process_Playing_List();
+    EXPECT_EQ(mngr.Get_Frame_Stats().active_voices, 1);
+
     while (mngr.Is_Currently_Playing(ev->Get_Playing_Handle())) {
         std::this_thread::sleep_for(200ms);
         mngr.Process_Playing_List();
     }
 
     EXPECT_FALSE(mngr.Is_Currently_Playing(ev->Get_Playing_Handle()));
+    EXPECT_EQ(mngr.Get_Frame_Stats().active_voices, 0);
+    EXPECT_EQ(mngr.Get_Frame_Stats().culled_voices, 0);
 
     mngr.Close_Device();
 }
@@ -82,4 +111,158 @@ TEST(audio, alaudiomanager)
 
     delete g_theLocalFileSystem;
 }
+
+TEST(audio, alaudiomanager_requests)
+{
+    g_theLocalFileSystem = new Win32LocalFileSystem;
+    Thyme::ALAudioManager mngr;
+    mngr.Set_Cache_Max_Size(0xFFFFFF);
+    mngr.Open_Device();
+
+    if (!mngr.Is_Device_Open()) {
+        delete g_theLocalFileSystem;
+        return;
+    }
+
+    auto request_play = [&](AudioEventInfo *info, int handle) {
+        AudioEventRTS *ev = new AudioEventRTS(Utf8String("testevent"));
+        ev->Set_Event_Info_With_Filename(info);
+        ev->Generate_Play_Info();
+        ev->Set_Playing_Handle(handle);
+        AudioRequest *request = mngr.Allocate_Audio_Request(true);
+        request->Request_Play(ev);
+        mngr.Append_Audio_Request(request);
+    };
+
+    // A sample that wasn't prefetched is decoded when it first plays rather than a frame later.
+    TestAudioEventInfo test_info;
+    request_play(&test_info, 10);
+    mngr.Process_Request_List();
+    mngr.Process_Playing_List();
+    EXPECT_EQ(mngr.Get_Frame_Stats().active_voices, 1);
+
+    // Stopping a sound that is still waiting on its delay keeps it from starting later.
+    TestDelayedAudioEventInfo delayed_info;
+    request_play(&delayed_info, 11);
+    mngr.Process_Request_List();
+    EXPECT_TRUE(mngr.Is_Currently_Playing(11));
+    mngr.Remove_Audio_Event(11);
+
+    for (int i = 0; i < 100; ++i) {
+        mngr.Process_Request_List();
+    }
+
+    EXPECT_FALSE(mngr.Is_Currently_Playing(11));
+
+    // The same for killing it.
+    request_play(&delayed_info, 12);
+    mngr.Process_Request_List();
+    mngr.Kill_Event_Immediately(12);
+    EXPECT_FALSE(mngr.Is_Currently_Playing(12));
+
+    for (int i = 0; i < 100; ++i) {
+        mngr.Process_Request_List();
+    }
+
+    EXPECT_FALSE(mngr.Is_Currently_Playing(12));
+    mngr.Process_Playing_List();
+    EXPECT_EQ(mngr.Get_Frame_Stats().active_voices, 1);
+
+    mngr.Stop_Audio(AudioAffect(AUDIOAFFECT_SOUND | AUDIOAFFECT_3DSOUND));
+    mngr.Close_Device();
+    delete g_theLocalFileSystem;
+}
+
+TEST(audio, alaudiomanager_virtual_voices)
+{
+    using namespace std::chrono;
+
+    constexpr int SPREAD_EVENTS = 4000;
+    constexpr int CLUSTER_EVENTS = 100;
+    constexpr float EVENT_SPACING = 10.0f;
+    constexpr int BENCHMARK_FRAMES = 100;
+
+    g_theLocalFileSystem = new Win32LocalFileSystem;
+    Thyme::ALAudioManager mngr;
+    mngr.Set_Cache_Max_Size(0xFFFFFF);
+    mngr.Open_Device();
+
+    if (!mngr.Is_Device_Open()) {
+        delete g_theLocalFileSystem;
+        return;
+    }
+
+    mngr.Set_Volume(1.0f, AudioAffect(AUDIOAFFECT_SOUND | AUDIOAFFECT_3DSOUND | AUDIOAFFECT_BASEVOL));
+    mngr.Set_Volume(1.0f, AudioAffect(AUDIOAFFECT_SOUND | AUDIOAFFECT_3DSOUND));
+
+    TestPositionalAudioEventInfo test_info;
+    Coord3D listener;
+    Coord3D facing;
+    listener.Zero();
+    facing.Set(0.0f, 1.0f, 0.0f);
+    mngr.Set_Listener_Position(&listener, &facing);
+
+    auto play_at = [&](int handle, float x) {
+        Coord3D pos;
+        pos.Set(x, 0.0f, 0.0f);
+        AudioEventRTS *ev = new AudioEventRTS(Utf8String("testevent"));
+        ev->Set_Event_Info_With_Filename(&test_info);
+        ev->Generate_Play_Info();
+        ev->Set_Position(&pos);
+        ev->Set_Playing_Handle(handle);
+        mngr.friend_Force_Play_Audio_Event(ev);
+    };
+
+    // A line of looping sounds, only the first few are in range of the listener.
+    for (int i = 0; i < SPREAD_EVENTS; ++i) {
+        play_at(i + 1, i * EVENT_SPACING);
+    }
+
+    mngr.Process_Playing_List();
+    EXPECT_EQ(mngr.Get_Frame_Stats().active_voices, 10);
+    EXPECT_EQ(mngr.Get_Frame_Stats().virtualized_voices, SPREAD_EVENTS - 10);
+    EXPECT_TRUE(mngr.Is_Currently_Playing(SPREAD_EVENTS));
+
+    // Walking down the line swaps which sounds have a source.
+    listener.Set(SPREAD_EVENTS * EVENT_SPACING / 2, 0.0f, 0.0f);
+    mngr.Set_Listener_Position(&listener, &facing);
+    mngr.Set_Device_Listener_Position();
+    mngr.Process_Playing_List();
+    EXPECT_EQ(mngr.Get_Frame_Stats().active_voices, 19);
+    EXPECT_EQ(mngr.Get_Frame_Stats().active_voices + mngr.Get_Frame_Stats().virtualized_voices, SPREAD_EVENTS);
+
+    // More audible sounds than sources, the loudest ones get them.
+    for (int i = 0; i < CLUSTER_EVENTS; ++i) {
+        play_at(SPREAD_EVENTS + i + 1, listener.x);
+    }
+
+    mngr.Process_Playing_List();
+    EXPECT_EQ(mngr.Get_Frame_Stats().active_voices, AL_DEFAULT_3D_SOURCES);
+    EXPECT_EQ(
+        mngr.Get_Frame_Stats().active_voices + mngr.Get_Frame_Stats().virtualized_voices, SPREAD_EVENTS + CLUSTER_EVENTS);
+
+    auto start = steady_clock::now();
+
+    for (int i = 0; i < BENCHMARK_FRAMES; ++i) {
+        listener.x += (i & 1) ? -EVENT_SPACING : EVENT_SPACING;
+        mngr.Set_Listener_Position(&listener, &facing);
+        mngr.Set_Device_Listener_Position();
+        mngr.Process_Playing_List();
+        EXPECT_LE(mngr.Get_Frame_Stats().active_voices, AL_DEFAULT_3D_SOURCES);
+    }
+
+    auto time = duration_cast<microseconds>(steady_clock::now() - start);
+    captainslog_info("Updated %d voices for %d frames in %lld us",
+        SPREAD_EVENTS + CLUSTER_EVENTS,
+        BENCHMARK_FRAMES,
+        (long long)time.count());
+
+    mngr.Stop_Audio(AudioAffect(AUDIOAFFECT_SOUND | AUDIOAFFECT_3DSOUND));
+    mngr.Process_Playing_List();
+    EXPECT_EQ(mngr.Get_Frame_Stats().active_voices, 0);
+    EXPECT_EQ(mngr.Get_Frame_Stats().virtualized_voices, 0);
+
+    mngr.Close_Device();
+    delete g_theLocalFileSystem;
+}
 #endif
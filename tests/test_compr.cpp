@@ -12,9 +12,14 @@
  *            A full copy of the GNU General Public License can be found in
  *            LICENSE
  */
+#include <algorithm>
+#include <captainslog.h>
+#include <chrono>
 #include <fstream>
 #include <gtest/gtest.h>
+#include <random>
 #include <string>
+#include <vector>
 
 #include "always.h"
 #include "compressionmanager.h"
@@ -108,3 +113,304 @@ CompressionType compression_types[] = {
 
 INSTANTIATE_TEST_CASE_P(
     compression, CompressionTest, testing::ValuesIn(compression_types), CompressionTest::PrintToStringParamName());
+
+// Repeats the sample text so a stream is larger than the RefPack window.
+static std::vector<uint8_t> get_refpack_sample()
+{
+    auto filepath = std::string(TESTDATA_PATH) + "/compr/uncompr.txt";
+    std::ifstream src_file(filepath, std::ios::binary);
+    size_t src_size = get_filesize(src_file);
+    std::vector<uint8_t> text(src_size);
+    src_file.read(reinterpret_cast<char *>(text.data()), src_size);
+    std::vector<uint8_t> sample;
+
+    for (int i = 0; sample.size() < 1024 * 1024; ++i) {
+        sample.insert(sample.end(), text.begin(), text.end());
+        // Vary the copies a little so the matches have different lengths and offsets.
+        sample.push_back(uint8_t(i));
+        sample.insert(sample.end(), text.begin() + (i * 97) % src_size, text.end());
+    }
+
+    return sample;
+}
+
+TEST(compression, refpack_stream)
+{
+    std::vector<uint8_t> src = get_refpack_sample();
+    int src_size = int(src.size());
+    RefPackEncoder encoder;
+    int sizes[3];
+
+    for (int level = REFPACK_LEVEL_FAST; level <= REFPACK_LEVEL_LAZY; ++level) {
+        std::vector<uint8_t> whole(RefPackEncoder::Get_Max_Encoded_Size(src_size));
+        int whole_size = encoder.Compress(whole.data(), src.data(), src_size, RefPackLevel(level));
+        sizes[level] = whole_size;
+
+        // Feed the same data in uneven pieces, the output must not depend on how the input was split.
+        std::vector<uint8_t> stream(RefPackEncoder::Get_Max_Encoded_Size(src_size));
+        int stream_size = encoder.Begin(stream.data(), src_size, RefPackLevel(level));
+
+        for (int pos = 0, piece = 1; pos < src_size; piece = piece * 7 % 100003) {
+            int count = std::min(piece, src_size - pos);
+            stream_size += encoder.Encode(&stream[stream_size], &src[pos], count);
+            pos += count;
+        }
+
+        stream_size += encoder.End(&stream[stream_size]);
+        ASSERT_EQ(stream_size, whole_size);
+        EXPECT_EQ(memcmp(stream.data(), whole.data(), whole_size), 0);
+
+        std::vector<uint8_t> dst(src_size);
+        int read_size = 0;
+        EXPECT_EQ(RefPack_Uncompress(dst.data(), whole.data(), &read_size), src_size);
+        EXPECT_EQ(read_size, whole_size);
+        EXPECT_EQ(memcmp(dst.data(), src.data(), src_size), 0);
+    }
+
+    EXPECT_LE(sizes[REFPACK_LEVEL_LAZY], sizes[REFPACK_LEVEL_NORMAL]);
+    EXPECT_LE(sizes[REFPACK_LEVEL_NORMAL], sizes[REFPACK_LEVEL_FAST]);
+
+    // The original entry point still gives the normal level.
+    std::vector<uint8_t> dst(RefPackEncoder::Get_Max_Encoded_Size(src_size));
+    EXPECT_EQ(RefPack_Compress(dst.data(), src.data(), src_size, nullptr), sizes[REFPACK_LEVEL_NORMAL]);
+}
+
+TEST(compression, DISABLED_refpack_benchmark)
+{
+    using namespace std::chrono;
+
+    std::vector<uint8_t> src = get_refpack_sample();
+    int src_size = int(src.size());
+    std::vector<uint8_t> dst(RefPackEncoder::Get_Max_Encoded_Size(src_size));
+    RefPackEncoder encoder;
+
+    std::vector<uint8_t> out(src_size);
+
+    for (int level = REFPACK_LEVEL_FAST; level <= REFPACK_LEVEL_LAZY; ++level) {
+        auto start = steady_clock::now();
+        int dst_size = encoder.Compress(dst.data(), src.data(), src_size, RefPackLevel(level));
+        auto time = duration_cast<microseconds>(steady_clock::now() - start);
+        EXPECT_LT(dst_size, src_size);
+        captainslog_info("RefPack level %d compressed %d bytes to %d in %lld us, %.1f MB/s",
+            level,
+            src_size,
+            dst_size,
+            (long long)time.count(),
+            double(src_size) / std::max<long long>(time.count(), 1));
+
+        // Both decoders have to give back the sample.
+        std::fill(out.begin(), out.end(), 0);
+        start = steady_clock::now();
+        int read_size = 0;
+        int out_size = RefPack_Uncompress(out.data(), dst.data(), &read_size);
+        auto fast_time = duration_cast<microseconds>(steady_clock::now() - start);
+        EXPECT_EQ(out_size, src_size);
+        EXPECT_EQ(read_size, dst_size);
+        EXPECT_TRUE(out == src);
+
+        std::fill(out.begin(), out.end(), 0);
+        start = steady_clock::now();
+        out_size = RefPack_Uncompress_Safe(out.data(), src_size, dst.data(), dst_size);
+        auto safe_time = duration_cast<microseconds>(steady_clock::now() - start);
+        EXPECT_EQ(out_size, src_size);
+        EXPECT_TRUE(out == src);
+
+        captainslog_info("RefPack level %d decompressed in %lld us, %lld us checked",
+            level,
+            (long long)fast_time.count(),
+            (long long)safe_time.count());
+    }
+}
+
+// The original decoder, copying a byte at a time. The optimised decoders must match it.
+static int reference_refpack_uncompress(void *dst, const void *src, int *size)
+{
+    const uint8_t *getp = static_cast<const uint8_t *>(src);
+    uint8_t *putp = static_cast<uint8_t *>(dst);
+    uint8_t *ref;
+    uint32_t run;
+    uint16_t flags = (getp[0] << 8) | getp[1];
+    int out_length;
+    getp += 2;
+
+    if (flags & 0x8000) {
+        getp += (flags & 0x0100) ? 4 : 0;
+        out_length = (getp[0] << 24) | (getp[1] << 16) | (getp[2] << 8) | getp[3];
+        getp += 4;
+    } else {
+        getp += (flags & 0x0100) ? 3 : 0;
+        out_length = (getp[0] << 16) | (getp[1] << 8) | getp[2];
+        getp += 3;
+    }
+
+    while (true) {
+        uint8_t first = *getp++;
+
+        if (!(first & 0x80)) {
+            uint8_t second = *getp++;
+            for (run = first & 3; run > 0; --run) {
+                *putp++ = *getp++;
+            }
+
+            ref = putp - 1 - (((first & 0x60) << 3) + second);
+            run = ((first & 0x1c) >> 2) + 3;
+        } else if (!(first & 0x40)) {
+            uint8_t second = *getp++;
+            uint8_t third = *getp++;
+            for (run = second >> 6; run > 0; --run) {
+                *putp++ = *getp++;
+            }
+
+            ref = putp - 1 - (((second & 0x3f) << 8) + third);
+            run = (first & 0x3f) + 4;
+        } else if (!(first & 0x20)) {
+            uint8_t second = *getp++;
+            uint8_t third = *getp++;
+            uint8_t forth = *getp++;
+            for (run = first & 3; run > 0; --run) {
+                *putp++ = *getp++;
+            }
+
+            ref = putp - 1 - (((first & 0x10) >> 4 << 16) + (second << 8) + third);
+            run = ((first & 0x0c) >> 2 << 8) + forth + 5;
+        } else {
+            run = ((first & 0x1f) << 2) + 4;
+            bool end = run > 112;
+
+            for (run = end ? first & 3 : run; run > 0; --run) {
+                *putp++ = *getp++;
+            }
+
+            if (end) {
+                break;
+            }
+
+            continue;
+        }
+
+        for (; run > 0; --run) {
+            *putp++ = *ref++;
+        }
+    }
+
+    *size = getp - static_cast<const uint8_t *>(src);
+
+    return out_length;
+}
+
+// Writes a random but valid stream, mixing every command with offsets short enough to overlap the match.
+static std::vector<uint8_t> make_random_refpack(std::mt19937 &rng, int target)
+{
+    std::vector<uint8_t> cmds;
+    int pos = 0;
+
+    auto literals = [&](uint32_t run) {
+        for (uint32_t i = 0; i < run; ++i) {
+            cmds.push_back(uint8_t(rng()));
+        }
+
+        pos += run;
+    };
+
+    auto pick_offset = [&](uint32_t max_offset) {
+        uint32_t limit = std::min<uint32_t>(max_offset, pos);
+        return 1 + rng() % ((rng() & 1) ? std::min<uint32_t>(limit, 20) : limit);
+    };
+
+    while (pos < target) {
+        uint32_t type = pos == 0 ? 3 : rng() % 4;
+        uint32_t run = rng() % 4;
+
+        if (type == 0) {
+            uint32_t length = 3 + rng() % 8;
+            cmds.push_back(uint8_t(0));
+            cmds.push_back(uint8_t(0));
+            size_t at = cmds.size() - 2;
+            literals(run);
+            uint32_t offset = pick_offset(1024) - 1;
+            cmds[at] = uint8_t(((offset >> 8) << 5) + ((length - 3) << 2) + run);
+            cmds[at + 1] = uint8_t(offset);
+            pos += length;
+        } else if (type == 1) {
+            uint32_t length = 4 + rng() % 64;
+            cmds.insert(cmds.end(), 3, 0);
+            size_t at = cmds.size() - 3;
+            literals(run);
+            uint32_t offset = pick_offset(16384) - 1;
+            cmds[at] = uint8_t(0x80 + (length - 4));
+            cmds[at + 1] = uint8_t((run << 6) + (offset >> 8));
+            cmds[at + 2] = uint8_t(offset);
+            pos += length;
+        } else if (type == 2) {
+            uint32_t length = 5 + rng() % 1024;
+            cmds.insert(cmds.end(), 4, 0);
+            size_t at = cmds.size() - 4;
+            literals(run);
+            uint32_t offset = pick_offset(131072) - 1;
+            cmds[at] = uint8_t(0xc0 + ((offset >> 16) << 4) + (((length - 5) >> 8) << 2) + run);
+            cmds[at + 1] = uint8_t(offset >> 8);
+            cmds[at + 2] = uint8_t(offset);
+            cmds[at + 3] = uint8_t(length - 5);
+            pos += length;
+        } else {
+            run = 4 + 4 * (rng() % 28);
+            cmds.push_back(uint8_t(0xe0 + (run >> 2) - 1));
+            literals(run);
+        }
+    }
+
+    uint32_t run = rng() % 4;
+    cmds.push_back(uint8_t(0xfc + run));
+    literals(run);
+
+    std::vector<uint8_t> stream = { 0x10, 0xfb, uint8_t(pos >> 16), uint8_t(pos >> 8), uint8_t(pos) };
+    stream.insert(stream.end(), cmds.begin(), cmds.end());
+
+    return stream;
+}
+
+TEST(compression, refpack_decode_fuzz)
+{
+    std::mt19937 rng(0x5eed);
+
+    for (int i = 0; i < 500; ++i) {
+        std::vector<uint8_t> src = make_random_refpack(rng, 1 + rng() % 200000);
+        int out_length = (src[2] << 16) | (src[3] << 8) | src[4];
+        std::vector<uint8_t> expected(out_length);
+        std::vector<uint8_t> fast(out_length);
+        std::vector<uint8_t> safe(out_length);
+        int expected_read;
+        int fast_read;
+        int safe_read;
+
+        ASSERT_EQ(reference_refpack_uncompress(expected.data(), src.data(), &expected_read), out_length);
+        ASSERT_EQ(expected_read, int(src.size()));
+        EXPECT_EQ(RefPack_Uncompress(fast.data(), src.data(), &fast_read), out_length);
+        EXPECT_EQ(fast_read, expected_read);
+        EXPECT_TRUE(fast == expected);
+        EXPECT_EQ(RefPack_Uncompress_Safe(safe.data(), out_length, src.data(), int(src.size()), &safe_read), out_length);
+        EXPECT_EQ(safe_read, expected_read);
+        EXPECT_TRUE(safe == expected);
+
+        // Damaged streams must be rejected or decoded without touching anything outside of the buffers.
+        for (int j = 0; j < 20; ++j) {
+            std::vector<uint8_t> damaged(src);
+
+            if (j % 4 == 0) {
+                damaged.resize(rng() % damaged.size());
+            } else {
+                for (int k = 1 + rng() % 4; k > 0; --k) {
+                    damaged[rng() % damaged.size()] = uint8_t(rng());
+                }
+            }
+
+            std::vector<uint8_t> dst(out_length + 64, 0xcd);
+            int result = RefPack_Uncompress_Safe(dst.data(), out_length, damaged.data(), int(damaged.size()));
+            EXPECT_TRUE(result == 0 || result <= out_length);
+
+            for (int k = out_length; k < out_length + 64; ++k) {
+                ASSERT_EQ(dst[k], 0xcd);
+            }
+        }
+    }
+}
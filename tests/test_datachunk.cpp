@@ -0,0 +1,379 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate and benchmark parsing of the chunk format used by maps.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <algorithm>
+#include <captainslog.h>
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "datachunk.h"
+#include "namekeygenerator.h"
+
+namespace
+{
+constexpr int BENCHMARK_OBJECTS = 20000;
+constexpr int BENCHMARK_PARSES = 10;
+
+// The TOC IDs the generated files use.
+enum
+{
+    ID_OBJECTS_LIST = 1,
+    ID_OBJECT,
+    ID_UNPARSED,
+    ID_OBJECT_NAME,
+    ID_HEALTH,
+    ID_SELECTABLE,
+    ID_RADIUS,
+    ID_DISPLAY_NAME,
+};
+
+const char *const TOC_NAMES[] = {
+    "ObjectsList", "Object", "Unparsed", "objectName", "objectInitialHealth", "objectSelectable", "objectRadius", "name"
+};
+
+const unichar_t DISPLAY_NAME[] = { 'U', 'n', 'i', 't', 0 };
+
+struct TestObject
+{
+    float x;
+    float y;
+    int32_t flags;
+    Utf8String name;
+    int health;
+    bool selectable;
+    float radius;
+    Utf16String display_name;
+};
+
+// Serves the chunk file from memory, like the cached file stream maps are read from.
+class MemoryChunkInputStream : public ChunkInputStream
+{
+public:
+    MemoryChunkInputStream(const std::string &data) : m_data(data), m_pos(0) {}
+
+    virtual int Read(void *dst, int size) override
+    {
+        size = std::min<int>(size, int(m_data.size()) - m_pos);
+        memcpy(dst, m_data.data() + m_pos, size);
+        m_pos += size;
+        return size;
+    }
+
+    virtual unsigned Tell() override { return m_pos; }
+
+    virtual bool Absolute_Seek(unsigned pos) override
+    {
+        m_pos = std::min<unsigned>(pos, unsigned(m_data.size()));
+        return true;
+    }
+
+    virtual bool Eof() override { return m_pos == int(m_data.size()); }
+
+private:
+    const std::string &m_data;
+    int m_pos;
+};
+
+void Append_Int(std::string &data, int32_t value)
+{
+    for (int i = 0; i < 4; ++i) {
+        data += char((value >> (i * 8)) & 0xFF);
+    }
+}
+
+void Append_Short(std::string &data, int16_t value)
+{
+    data += char(value & 0xFF);
+    data += char((value >> 8) & 0xFF);
+}
+
+void Append_Real(std::string &data, float value)
+{
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    Append_Int(data, bits);
+}
+
+void Append_String(std::string &data, const Utf8String &string)
+{
+    Append_Short(data, int16_t(string.Get_Length()));
+    data += string.Str();
+}
+
+void Append_Chunk(std::string &data, int id, int version, const std::string &payload)
+{
+    Append_Int(data, id);
+    Append_Short(data, int16_t(version));
+    Append_Int(data, int32_t(payload.size()));
+    data += payload;
+}
+
+void Append_Dict_Key(std::string &data, int id, int type)
+{
+    Append_Int(data, (id << Dict::DICT_KEY_SHIFT) | type);
+}
+
+TestObject Make_Object(int index)
+{
+    TestObject object;
+    object.x = float(index) * 1.5f;
+    object.y = float(index) * -0.25f;
+    object.flags = index * 7;
+    object.name.Format("Object%05d", index);
+    object.health = index % 100;
+    object.selectable = index % 3 != 0;
+    object.radius = float(index % 50) + 0.5f;
+    object.display_name = DISPLAY_NAME;
+    return object;
+}
+
+std::string Make_Object_Chunk(const TestObject &object)
+{
+    std::string payload;
+    Append_Real(payload, object.x);
+    Append_Real(payload, object.y);
+    Append_Int(payload, object.flags);
+    Append_String(payload, object.name);
+
+    Append_Short(payload, 5);
+    Append_Dict_Key(payload, ID_OBJECT_NAME, Dict::DICT_ASCIISTRING);
+    Append_String(payload, object.name);
+    Append_Dict_Key(payload, ID_HEALTH, Dict::DICT_INT);
+    Append_Int(payload, object.health);
+    Append_Dict_Key(payload, ID_SELECTABLE, Dict::DICT_BOOL);
+    payload += char(object.selectable);
+    Append_Dict_Key(payload, ID_RADIUS, Dict::DICT_REAL);
+    Append_Real(payload, object.radius);
+    Append_Dict_Key(payload, ID_DISPLAY_NAME, Dict::DICT_UNICODESTRING);
+    Append_Short(payload, int16_t(object.display_name.Get_Length()));
+
+    for (int i = 0; i < object.display_name.Get_Length(); ++i) {
+        Append_Short(payload, int16_t(object.display_name.Get_Char(i)));
+    }
+
+    // Chunks may hold more than their parser reads, the rest is skipped.
+    payload += "padding";
+    return payload;
+}
+
+std::string Make_Map_File(int count)
+{
+    std::string data = "CkMp";
+    Append_Int(data, int32_t(ARRAY_SIZE(TOC_NAMES)));
+
+    for (int i = 0; i < int(ARRAY_SIZE(TOC_NAMES)); ++i) {
+        data += char(strlen(TOC_NAMES[i]));
+        data += TOC_NAMES[i];
+        Append_Int(data, i + 1);
+    }
+
+    std::string objects;
+
+    for (int i = 0; i < count; ++i) {
+        Append_Chunk(objects, ID_OBJECT, 3, Make_Object_Chunk(Make_Object(i)));
+
+        // A chunk nobody registered a parser for in between the objects.
+        if (i % 10 == 0) {
+            Append_Chunk(objects, ID_UNPARSED, 1, "unparsed");
+        }
+    }
+
+    Append_Chunk(data, ID_OBJECTS_LIST, 3, objects);
+    Append_Chunk(data, ID_UNPARSED, 1, std::string(10000, 'x'));
+
+    // An object outside of the list that the object parser must not be used for.
+    Append_Chunk(data, ID_OBJECT, 3, Make_Object_Chunk(Make_Object(count)));
+    return data;
+}
+
+bool Parse_Object(DataChunkInput &input, DataChunkInfo *info, void *user_data)
+{
+    TestObject object;
+    object.x = input.Read_Real32();
+    object.y = input.Read_Real32();
+    object.flags = input.Read_Int32();
+    object.name = input.Read_AsciiString();
+
+    Dict dict = input.Read_Dict();
+    object.health = dict.Get_Int(g_theNameKeyGenerator->Name_To_Key("objectInitialHealth"));
+    object.selectable = dict.Get_Bool(g_theNameKeyGenerator->Name_To_Key("objectSelectable"));
+    object.radius = dict.Get_Real(g_theNameKeyGenerator->Name_To_Key("objectRadius"));
+    object.display_name = dict.Get_UnicodeString(g_theNameKeyGenerator->Name_To_Key("name"));
+
+    if (dict.Get_AsciiString(g_theNameKeyGenerator->Name_To_Key("objectName")) != object.name) {
+        return false;
+    }
+
+    static_cast<std::vector<TestObject> *>(user_data)->push_back(object);
+    return true;
+}
+
+int g_strayObjects;
+
+bool Parse_Stray_Object(DataChunkInput &input, DataChunkInfo *info, void *user_data)
+{
+    ++g_strayObjects;
+    return true;
+}
+
+// Registers the object parser from within the list parser, the way the map loading code does.
+bool Parse_Objects_List(DataChunkInput &input, DataChunkInfo *info, void *user_data)
+{
+    input.Register_Parser("Object", info->label, Parse_Object, nullptr);
+    return input.Parse(user_data);
+}
+
+// A file with two chunks holding byte arrays, so a parser can read past the end of the input buffer at once.
+std::string Make_Blob_File(int size)
+{
+    std::string data = "CkMp";
+    Append_Int(data, 1);
+    data += char(strlen("Blob"));
+    data += "Blob";
+    Append_Int(data, 1);
+
+    std::string payload;
+    Append_Int(payload, size);
+
+    for (int i = 0; i < size; ++i) {
+        payload += char(i * 7);
+    }
+
+    Append_Chunk(data, 1, 1, payload);
+    Append_Chunk(data, 1, 1, payload);
+    return data;
+}
+
+bool Parse_Blob(DataChunkInput &input, DataChunkInfo *info, void *user_data)
+{
+    std::vector<uint8_t> blob(input.Read_Int32());
+    input.Read_Byte_Array(blob.data(), int(blob.size()));
+    static_cast<std::vector<std::vector<uint8_t>> *>(user_data)->push_back(blob);
+    return true;
+}
+
+class DataChunkTest : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        g_theNameKeyGenerator = new NameKeyGenerator;
+        g_theNameKeyGenerator->Init();
+    }
+
+    void TearDown() override
+    {
+        delete g_theNameKeyGenerator;
+        g_theNameKeyGenerator = nullptr;
+    }
+};
+} // namespace
+
+TEST_F(DataChunkTest, parse_objects)
+{
+    const int count = 500;
+    std::string data = Make_Map_File(count);
+    MemoryChunkInputStream stream(data);
+    DataChunkInput input(&stream);
+    std::vector<TestObject> objects;
+    g_strayObjects = 0;
+
+    ASSERT_TRUE(input.Is_Valid_File());
+    input.Register_Parser("Object", "", Parse_Stray_Object, nullptr);
+    input.Register_Parser("ObjectsList", "", Parse_Objects_List, nullptr);
+    input.Register_Parser("NotInThisFile", "", Parse_Stray_Object, nullptr);
+    ASSERT_TRUE(input.Parse(&objects));
+
+    EXPECT_TRUE(input.At_End_Of_File());
+    EXPECT_EQ(g_strayObjects, 1);
+    ASSERT_EQ(int(objects.size()), count);
+
+    for (int i = 0; i < count; ++i) {
+        TestObject expected = Make_Object(i);
+        EXPECT_EQ(objects[i].x, expected.x) << "Object " << i;
+        EXPECT_EQ(objects[i].y, expected.y) << "Object " << i;
+        EXPECT_EQ(objects[i].flags, expected.flags) << "Object " << i;
+        EXPECT_STREQ(objects[i].name.Str(), expected.name.Str()) << "Object " << i;
+        EXPECT_EQ(objects[i].health, expected.health) << "Object " << i;
+        EXPECT_EQ(objects[i].selectable, expected.selectable) << "Object " << i;
+        EXPECT_EQ(objects[i].radius, expected.radius) << "Object " << i;
+        EXPECT_TRUE(objects[i].display_name == expected.display_name) << "Object " << i;
+    }
+
+    // Starting over has to give the same result.
+    objects.clear();
+    g_strayObjects = 0;
+    input.Reset();
+    ASSERT_TRUE(input.Parse(&objects));
+    EXPECT_EQ(g_strayObjects, 1);
+    EXPECT_EQ(int(objects.size()), count);
+}
+
+// Arrays larger than the input buffer are read straight from the stream, seeking back afterwards must not use what the
+// buffer held before.
+TEST_F(DataChunkTest, large_reads)
+{
+    const int size = 3 * 4096 + 123;
+    std::string data = Make_Blob_File(size);
+    MemoryChunkInputStream stream(data);
+    DataChunkInput input(&stream);
+    std::vector<std::vector<uint8_t>> blobs;
+
+    ASSERT_TRUE(input.Is_Valid_File());
+    input.Register_Parser("Blob", "", Parse_Blob, nullptr);
+    ASSERT_TRUE(input.Parse(&blobs));
+    EXPECT_TRUE(input.At_End_Of_File());
+
+    input.Reset();
+    ASSERT_TRUE(input.Parse(&blobs));
+    ASSERT_EQ(blobs.size(), 4u);
+
+    for (const std::vector<uint8_t> &blob : blobs) {
+        ASSERT_EQ(int(blob.size()), size);
+
+        for (int i = 0; i < size; ++i) {
+            ASSERT_EQ(blob[i], uint8_t(i * 7)) << "Byte " << i;
+        }
+    }
+}
+
+TEST_F(DataChunkTest, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    std::string data = Make_Map_File(BENCHMARK_OBJECTS);
+    nanoseconds parse_time(0);
+    size_t parsed = 0;
+
+    for (int i = 0; i < BENCHMARK_PARSES; ++i) {
+        MemoryChunkInputStream stream(data);
+        std::vector<TestObject> objects;
+        objects.reserve(BENCHMARK_OBJECTS);
+
+        auto start = steady_clock::now();
+        DataChunkInput input(&stream);
+        input.Register_Parser("ObjectsList", "", Parse_Objects_List, nullptr);
+        input.Parse(&objects);
+        parse_time += steady_clock::now() - start;
+        parsed += objects.size();
+    }
+
+    EXPECT_EQ(parsed, size_t(BENCHMARK_OBJECTS) * BENCHMARK_PARSES);
+
+    captainslog_info("Parsed %d map objects %d times.", BENCHMARK_OBJECTS, BENCHMARK_PARSES);
+    captainslog_info("DataChunkInput: %lld us", (long long)duration_cast<microseconds>(parse_time).count());
+}
@@ -0,0 +1,253 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate and benchmark building and searching dictionaries.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "dict.h"
+
+namespace
+{
+constexpr int BENCHMARK_DICTS = 2000;
+constexpr int BENCHMARK_PAIRS = 60;
+
+struct TestPair
+{
+    NameKeyType key;
+    Dict::DataType type;
+    int value;
+};
+
+// Pairs the way map objects carry them, in no particular key order and with the odd key given twice.
+std::vector<TestPair> Make_Pairs(int count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> key(1, count * 4);
+    std::uniform_int_distribution<int> type(Dict::DICT_BOOL, Dict::DICT_UNICODESTRING);
+    std::vector<TestPair> pairs;
+
+    for (int i = 0; i < count; ++i) {
+        pairs.push_back({ NameKeyType(key(gen)), Dict::DataType(type(gen)), int(gen() % 1000) });
+    }
+
+    return pairs;
+}
+
+Utf8String Make_Ascii(int value)
+{
+    Utf8String string;
+    string.Format("value%d", value);
+    return string;
+}
+
+Utf16String Make_Unicode(int value)
+{
+    Utf16String string;
+    string.Translate(Make_Ascii(value));
+    return string;
+}
+
+void Set_Pair(Dict &dict, const TestPair &pair)
+{
+    switch (pair.type) {
+        case Dict::DICT_BOOL:
+            dict.Set_Bool(pair.key, pair.value % 2 != 0);
+            break;
+        case Dict::DICT_INT:
+            dict.Set_Int(pair.key, pair.value);
+            break;
+        case Dict::DICT_REAL:
+            dict.Set_Real(pair.key, float(pair.value) * 0.5f);
+            break;
+        case Dict::DICT_ASCIISTRING:
+            dict.Set_AsciiString(pair.key, Make_Ascii(pair.value));
+            break;
+        default:
+            dict.Set_UnicodeString(pair.key, Make_Unicode(pair.value));
+            break;
+    }
+}
+
+void Append_Pair(Dict &dict, const TestPair &pair)
+{
+    switch (pair.type) {
+        case Dict::DICT_BOOL:
+            dict.Append_Bool(pair.key, pair.value % 2 != 0);
+            break;
+        case Dict::DICT_INT:
+            dict.Append_Int(pair.key, pair.value);
+            break;
+        case Dict::DICT_REAL:
+            dict.Append_Real(pair.key, float(pair.value) * 0.5f);
+            break;
+        case Dict::DICT_ASCIISTRING:
+            dict.Append_AsciiString(pair.key, Make_Ascii(pair.value));
+            break;
+        default:
+            dict.Append_UnicodeString(pair.key, Make_Unicode(pair.value));
+            break;
+    }
+}
+
+Dict Build_Dict(const std::vector<TestPair> &pairs)
+{
+    Dict dict;
+    dict.Begin_Build(int(pairs.size()));
+
+    for (const TestPair &pair : pairs) {
+        Append_Pair(dict, pair);
+    }
+
+    dict.End_Build();
+    return dict;
+}
+
+bool Same_Value(const Dict &a, const Dict &b, NameKeyType key)
+{
+    switch (a.Get_Type(key)) {
+        case Dict::DICT_BOOL:
+            return a.Get_Bool(key) == b.Get_Bool(key);
+        case Dict::DICT_INT:
+            return a.Get_Int(key) == b.Get_Int(key);
+        case Dict::DICT_REAL:
+            return a.Get_Real(key) == b.Get_Real(key);
+        case Dict::DICT_ASCIISTRING:
+            return a.Get_AsciiString(key) == b.Get_AsciiString(key);
+        case Dict::DICT_UNICODESTRING:
+            return a.Get_UnicodeString(key) == b.Get_UnicodeString(key);
+        default:
+            return false;
+    }
+}
+
+void Expect_Same_Dict(const Dict &expected, const Dict &actual)
+{
+    ASSERT_EQ(actual.Get_Pair_Count(), expected.Get_Pair_Count());
+
+    for (int n = 1; n <= expected.Get_Pair_Count(); ++n) {
+        NameKeyType key = expected.Get_Nth_Key(n);
+        ASSERT_EQ(actual.Get_Nth_Key(n), key) << "Pair " << n;
+        ASSERT_EQ(actual.Get_Nth_Type(n), expected.Get_Nth_Type(n)) << "Pair " << n;
+        EXPECT_TRUE(Same_Value(expected, actual, key)) << "Pair " << n;
+    }
+}
+} // namespace
+
+TEST(dict, build_matches_set)
+{
+    // Sizes around the linear search and hash index limits.
+    for (int count : { 1, 5, 8, 9, 20, 100, 127, 128, 129, 1000 }) {
+        std::vector<TestPair> pairs = Make_Pairs(count, count);
+        Dict expected;
+
+        for (const TestPair &pair : pairs) {
+            Set_Pair(expected, pair);
+        }
+
+        Dict actual = Build_Dict(pairs);
+        Expect_Same_Dict(expected, actual);
+
+        for (int n = 2; n <= actual.Get_Pair_Count(); ++n) {
+            EXPECT_LT(actual.Get_Nth_Key(n - 1), actual.Get_Nth_Key(n)) << "Count " << count;
+        }
+
+        for (int key = 0; key <= count * 4 + 1; ++key) {
+            EXPECT_EQ(actual.Get_Type(NameKeyType(key)), expected.Get_Type(NameKeyType(key))) << "Key " << key;
+        }
+    }
+}
+
+TEST(dict, remove_and_copy)
+{
+    std::vector<TestPair> pairs = Make_Pairs(200, 1234);
+    Dict dict = Build_Dict(pairs);
+    Dict copy = dict;
+    int removed = 0;
+
+    for (const TestPair &pair : pairs) {
+        if (pair.key % 3 == 0 && copy.Get_Type(pair.key) != Dict::DICT_NONE) {
+            EXPECT_TRUE(copy.Remove(pair.key));
+            ++removed;
+        }
+    }
+
+    // The copy has its own pairs once it has been changed.
+    EXPECT_EQ(copy.Get_Pair_Count(), dict.Get_Pair_Count() - removed);
+
+    for (const TestPair &pair : pairs) {
+        EXPECT_NE(dict.Get_Type(pair.key), Dict::DICT_NONE);
+
+        if (pair.key % 3 == 0) {
+            EXPECT_EQ(copy.Get_Type(pair.key), Dict::DICT_NONE);
+        } else {
+            EXPECT_TRUE(Same_Value(dict, copy, pair.key));
+        }
+    }
+
+    copy.Set_Int(NameKeyType(1000000), 42);
+    EXPECT_EQ(copy.Get_Int(NameKeyType(1000000)), 42);
+    EXPECT_EQ(dict.Get_Type(NameKeyType(1000000)), Dict::DICT_NONE);
+}
+
+TEST(dict, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    std::vector<std::vector<TestPair>> sets;
+
+    for (int i = 0; i < BENCHMARK_DICTS; ++i) {
+        sets.push_back(Make_Pairs(BENCHMARK_PAIRS, i));
+    }
+
+    std::vector<Dict> set_dicts(BENCHMARK_DICTS);
+    std::vector<Dict> built_dicts(BENCHMARK_DICTS);
+
+    auto start = steady_clock::now();
+    for (int i = 0; i < BENCHMARK_DICTS; ++i) {
+        for (const TestPair &pair : sets[i]) {
+            Set_Pair(set_dicts[i], pair);
+        }
+    }
+    nanoseconds set_time = steady_clock::now() - start;
+
+    start = steady_clock::now();
+    for (int i = 0; i < BENCHMARK_DICTS; ++i) {
+        built_dicts[i] = Build_Dict(sets[i]);
+    }
+    nanoseconds build_time = steady_clock::now() - start;
+
+    int found = 0;
+    start = steady_clock::now();
+    for (int i = 0; i < BENCHMARK_DICTS; ++i) {
+        for (int key = 0; key <= BENCHMARK_PAIRS * 4; ++key) {
+            found += built_dicts[i].Get_Type(NameKeyType(key)) != Dict::DICT_NONE;
+        }
+    }
+    nanoseconds find_time = steady_clock::now() - start;
+
+    int expected = 0;
+    for (const Dict &dict : set_dicts) {
+        expected += dict.Get_Pair_Count();
+    }
+
+    EXPECT_EQ(found, expected);
+
+    captainslog_info("Built %d dicts of %d pairs.", BENCHMARK_DICTS, BENCHMARK_PAIRS);
+    captainslog_info("Set pairs: %lld us", (long long)duration_cast<microseconds>(set_time).count());
+    captainslog_info("Built pairs: %lld us", (long long)duration_cast<microseconds>(build_time).count());
+    captainslog_info("Key lookups: %lld us", (long long)duration_cast<microseconds>(find_time).count());
+}
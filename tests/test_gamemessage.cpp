@@ -0,0 +1,263 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate and benchmark the storage of game message arguments.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "gamemessage.h"
+
+namespace
+{
+constexpr int RECORDED_FRAMES = 3000;
+constexpr int BENCHMARK_REPLAYS = 5;
+
+struct RecordedArgument
+{
+    ArgumentDataType type;
+    ArgumentType data;
+};
+
+typedef std::vector<RecordedArgument> RecordedCommand;
+
+RecordedArgument Make_Object_Arg(ObjectID id)
+{
+    RecordedArgument arg;
+    arg.type = ARGUMENTDATATYPE_OBJECTID;
+    arg.data.objectID = id;
+    return arg;
+}
+
+RecordedArgument Make_Location_Arg(float x, float y)
+{
+    RecordedArgument arg;
+    arg.type = ARGUMENTDATATYPE_LOCATION;
+    arg.data.position.x = x;
+    arg.data.position.y = y;
+    arg.data.position.z = 0.0f;
+    return arg;
+}
+
+// The kind of commands a replay is made of, mostly moves and attacks of a few units with the odd large group.
+std::vector<RecordedCommand> Make_Command_Stream(unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> kind(0, 9);
+    std::uniform_int_distribution<int> group(1, 40);
+    std::uniform_real_distribution<float> pos(0.0f, 4000.0f);
+    std::vector<RecordedCommand> stream;
+
+    for (int frame = 0; frame < RECORDED_FRAMES; ++frame) {
+        RecordedCommand command;
+        int k = kind(gen);
+
+        if (k < 5) {
+            command.push_back(Make_Location_Arg(pos(gen), pos(gen)));
+        } else if (k < 8) {
+            command.push_back(Make_Object_Arg(ObjectID(gen() % 5000)));
+            command.push_back(Make_Location_Arg(pos(gen), pos(gen)));
+        } else {
+            RecordedArgument arg;
+            arg.type = ARGUMENTDATATYPE_BOOLEAN;
+            arg.data.boolean = true;
+            command.push_back(arg);
+
+            for (int i = group(gen); i > 0; --i) {
+                command.push_back(Make_Object_Arg(ObjectID(gen() % 5000)));
+            }
+        }
+
+        stream.push_back(command);
+    }
+
+    return stream;
+}
+
+// Reads every argument by index the way the command handlers do and folds them into a checksum.
+template<typename Store> unsigned Consume(const Store &store, int count)
+{
+    unsigned sum = 0;
+
+    for (int i = 0; i < count; ++i) {
+        const ArgumentType *arg = store.Get(i);
+        sum = sum * 31 + store.Get_Type(i);
+
+        switch (store.Get_Type(i)) {
+            case ARGUMENTDATATYPE_OBJECTID:
+                sum += arg->objectID;
+                break;
+            case ARGUMENTDATATYPE_LOCATION:
+                sum += unsigned(arg->position.x) ^ unsigned(arg->position.y);
+                break;
+            default:
+                sum += arg->boolean;
+                break;
+        }
+    }
+
+    return sum;
+}
+
+// The pool allocated linked list messages used to keep their arguments in.
+class ArgumentList
+{
+public:
+    ArgumentList() : m_head(nullptr), m_tail(nullptr) {}
+
+    ~ArgumentList()
+    {
+        while (m_head != nullptr) {
+            GameMessageArgument *next = m_head->m_next;
+            m_head->Delete_Instance();
+            m_head = next;
+        }
+    }
+
+    ArgumentType *Append(ArgumentDataType type)
+    {
+        GameMessageArgument *arg = NEW_POOL_OBJ(GameMessageArgument);
+        arg->m_type = type;
+
+        if (m_tail != nullptr) {
+            m_tail->m_next = arg;
+        } else {
+            m_head = arg;
+        }
+
+        m_tail = arg;
+        return &arg->m_data;
+    }
+
+    const GameMessageArgument *Find(int index) const
+    {
+        const GameMessageArgument *arg = m_head;
+
+        for (; index > 0; --index) {
+            arg = arg->m_next;
+        }
+
+        return arg;
+    }
+
+    const ArgumentType *Get(int index) const { return &Find(index)->m_data; }
+    ArgumentDataType Get_Type(int index) const { return Find(index)->m_type; }
+
+private:
+    GameMessageArgument *m_head;
+    GameMessageArgument *m_tail;
+};
+
+// Reads the arguments straight from the recording, to check what the stores read back.
+class RecordedView
+{
+public:
+    RecordedView(const RecordedCommand &command) : m_command(command) {}
+
+    const ArgumentType *Get(int index) const { return &m_command[index].data; }
+    ArgumentDataType Get_Type(int index) const { return m_command[index].type; }
+
+private:
+    const RecordedCommand &m_command;
+};
+
+unsigned Replay_Recording(const std::vector<RecordedCommand> &stream)
+{
+    unsigned sum = 0;
+
+    for (const RecordedCommand &command : stream) {
+        sum = sum * 33 + Consume(RecordedView(command), int(command.size()));
+    }
+
+    return sum;
+}
+
+template<typename Store> unsigned Replay(const std::vector<RecordedCommand> &stream)
+{
+    unsigned sum = 0;
+
+    for (const RecordedCommand &command : stream) {
+        Store store;
+
+        for (const RecordedArgument &arg : command) {
+            *store.Append(arg.type) = arg.data;
+        }
+
+        sum = sum * 33 + Consume(store, int(command.size()));
+    }
+
+    return sum;
+}
+} // namespace
+
+TEST(gamemessage, argument_store)
+{
+    GameMessageArgumentStore store;
+    const int count = GameMessageArgumentStore::INLINE_COUNT * 5 + 1;
+
+    for (int i = 0; i < count; ++i) {
+        if (i % 2 == 0) {
+            store.Append(ARGUMENTDATATYPE_INTEGER)->integer = i;
+        } else {
+            Coord3D pos;
+            pos.x = float(i);
+            pos.y = float(i * 2);
+            pos.z = float(i * 3);
+            store.Append(ARGUMENTDATATYPE_LOCATION)->position = pos;
+        }
+    }
+
+    ASSERT_EQ(store.Count(), count);
+
+    for (int i = 0; i < count; ++i) {
+        if (i % 2 == 0) {
+            ASSERT_EQ(store.Get_Type(i), ARGUMENTDATATYPE_INTEGER);
+            EXPECT_EQ(store.Get(i)->integer, i);
+        } else {
+            ASSERT_EQ(store.Get_Type(i), ARGUMENTDATATYPE_LOCATION);
+            EXPECT_EQ(store.Get(i)->position.x, float(i));
+            EXPECT_EQ(store.Get(i)->position.y, float(i * 2));
+            EXPECT_EQ(store.Get(i)->position.z, float(i * 3));
+        }
+    }
+}
+
+TEST(gamemessage, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    std::vector<RecordedCommand> stream = Make_Command_Stream(1234);
+    unsigned list_sum = 0;
+    unsigned store_sum = 0;
+    nanoseconds list_time(0);
+    nanoseconds store_time(0);
+
+    for (int i = 0; i < BENCHMARK_REPLAYS; ++i) {
+        auto start = steady_clock::now();
+        list_sum += Replay<ArgumentList>(stream);
+        list_time += steady_clock::now() - start;
+
+        start = steady_clock::now();
+        store_sum += Replay<GameMessageArgumentStore>(stream);
+        store_time += steady_clock::now() - start;
+    }
+
+    EXPECT_EQ(list_sum, Replay_Recording(stream) * BENCHMARK_REPLAYS);
+    EXPECT_EQ(store_sum, list_sum);
+
+    captainslog_info("Replayed %d recorded commands %d times.", RECORDED_FRAMES, BENCHMARK_REPLAYS);
+    captainslog_info("Linked arguments: %lld us", (long long)duration_cast<microseconds>(list_time).count());
+    captainslog_info("Packed arguments: %lld us", (long long)duration_cast<microseconds>(store_time).count());
+}
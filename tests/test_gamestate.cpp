@@ -0,0 +1,297 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate and benchmark incremental save games.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "gamestate.h"
+#include "xferload.h"
+#include "xfersave.h"
+
+namespace
+{
+constexpr int BENCHMARK_QUICKSAVES = 20;
+
+const char BASE_FILE[] = "gamestate_base.sav";
+const char QUICK_FILE[] = "gamestate_quick.sav";
+const char FULL_FILE[] = "gamestate_full.sav";
+
+// Stands in for a subsystem, the size of the data decides how much a save costs.
+class ValuesSnapShot : public SnapShot
+{
+public:
+    ValuesSnapShot(int count) : m_values(count) {}
+
+    virtual void CRC_Snapshot(Xfer *xfer) override {}
+    virtual void Load_Post_Process() override {}
+
+    virtual void Xfer_Snapshot(Xfer *xfer) override
+    {
+        uint8_t version = 1;
+        xfer->xferVersion(&version, 1);
+
+        uint32_t count = uint32_t(m_values.size());
+        xfer->xferUnsignedInt(&count);
+        m_values.resize(count);
+
+        for (int32_t &value : m_values) {
+            xfer->xferInt(&value);
+        }
+    }
+
+    std::vector<int32_t> m_values;
+};
+
+// A world where terrain and scripts are large and settle after the start, while objects change all the time.
+struct TestWorld
+{
+    TestWorld(int scale) : terrain(scale * 40), scripts(scale * 10), objects(scale * 5)
+    {
+        for (int i = 0; i < scale * 40; ++i) {
+            terrain.m_values[i] = i * 3;
+        }
+
+        for (int i = 0; i < scale * 10; ++i) {
+            scripts.m_values[i] = i % 17;
+        }
+
+        state.Add_Snapshot_Block("CHUNK_TerrainLogic", &terrain, SNAPSHOT_TYPE_UNK1);
+        state.Add_Snapshot_Block("CHUNK_ScriptEngine", &scripts, SNAPSHOT_TYPE_UNK1);
+        state.Add_Snapshot_Block("CHUNK_GameLogic", &objects, SNAPSHOT_TYPE_UNK1);
+    }
+
+    void Simulate(int frame)
+    {
+        for (size_t i = 0; i < objects.m_values.size(); ++i) {
+            objects.m_values[i] = frame * 1000 + int(i);
+        }
+    }
+
+    GameState state;
+    ValuesSnapShot terrain;
+    ValuesSnapShot scripts;
+    ValuesSnapShot objects;
+};
+
+long File_Size(const char *filename)
+{
+    long size = -1;
+    FILE *fp = fopen(filename, "rb");
+
+    if (fp != nullptr) {
+        fseek(fp, 0, SEEK_END);
+        size = ftell(fp);
+        fclose(fp);
+    }
+
+    return size;
+}
+
+// Returns the status of the save once it is on disk.
+XferStatus Save(TestWorld &world, const char *filename)
+{
+    XferSave xfer;
+    xfer.Open(filename);
+
+    if (world.state.Xfer_Save_Data_Incremental(&xfer, SNAPSHOT_TYPE_UNK1) != XFER_STATUS_OK) {
+        xfer.Discard();
+        return XFER_STATUS_WRITE_ERROR;
+    }
+
+    xfer.Close();
+
+    return XferSave::Wait_For_Flush();
+}
+
+void Load(TestWorld &world, const char *filename)
+{
+    XferLoad xfer;
+    xfer.Open(filename);
+
+    try {
+        world.state.Xfer_Save_Data(&xfer, SNAPSHOT_TYPE_UNK1);
+    } catch (...) {
+        xfer.Close();
+        throw;
+    }
+
+    xfer.Close();
+}
+
+void Expect_Same_State(const TestWorld &loaded, const TestWorld &world)
+{
+    EXPECT_EQ(loaded.terrain.m_values, world.terrain.m_values);
+    EXPECT_EQ(loaded.scripts.m_values, world.scripts.m_values);
+    EXPECT_EQ(loaded.objects.m_values, world.objects.m_values);
+}
+} // namespace
+
+TEST(gamestate, incremental_save)
+{
+    TestWorld world(1000);
+    world.Simulate(1);
+    EXPECT_EQ(Save(world, BASE_FILE), XFER_STATUS_OK);
+
+    // Only the objects changed, the rest is taken from the first save.
+    world.Simulate(2);
+    EXPECT_EQ(Save(world, QUICK_FILE), XFER_STATUS_OK);
+
+    long base_size = File_Size(BASE_FILE);
+    long quick_size = File_Size(QUICK_FILE);
+    EXPECT_GT(base_size, 0);
+    EXPECT_GT(quick_size, 0);
+    EXPECT_LT(quick_size * 4, base_size);
+
+    TestWorld loaded(0);
+    Load(loaded, QUICK_FILE);
+    Expect_Same_State(loaded, world);
+
+    // Changed blocks are saved in full again.
+    world.terrain.m_values[5] = -1;
+    world.Simulate(3);
+    EXPECT_EQ(Save(world, QUICK_FILE), XFER_STATUS_OK);
+
+    TestWorld reloaded(0);
+    Load(reloaded, QUICK_FILE);
+    Expect_Same_State(reloaded, world);
+
+    // A change that keeps the size of the block is still seen.
+    world.scripts.m_values[7] += 1;
+    EXPECT_EQ(Save(world, QUICK_FILE), XFER_STATUS_OK);
+
+    TestWorld changed(0);
+    Load(changed, QUICK_FILE);
+    Expect_Same_State(changed, world);
+
+    // Saving over the base makes a full save that needs no other file, once no save refers to the old one.
+    std::remove(QUICK_FILE);
+    EXPECT_EQ(Save(world, BASE_FILE), XFER_STATUS_OK);
+
+    TestWorld full(0);
+    Load(full, BASE_FILE);
+    Expect_Same_State(full, world);
+
+    std::remove(BASE_FILE);
+}
+
+TEST(gamestate, incremental_base_in_use)
+{
+    TestWorld world(100);
+    world.Simulate(1);
+    EXPECT_EQ(Save(world, BASE_FILE), XFER_STATUS_OK);
+    long base_size = File_Size(BASE_FILE);
+
+    world.Simulate(2);
+    EXPECT_EQ(Save(world, QUICK_FILE), XFER_STATUS_OK);
+
+    // The quicksave refers to the base, so the base is left alone.
+    world.terrain.m_values.push_back(1);
+    EXPECT_EQ(Save(world, BASE_FILE), XFER_STATUS_WRITE_ERROR);
+    EXPECT_EQ(File_Size(BASE_FILE), base_size);
+
+    world.terrain.m_values.pop_back();
+    TestWorld loaded(0);
+    Load(loaded, QUICK_FILE);
+    Expect_Same_State(loaded, world);
+
+    std::remove(BASE_FILE);
+    std::remove(QUICK_FILE);
+}
+
+TEST(gamestate, incremental_base_missing)
+{
+    TestWorld world(100);
+    world.Simulate(1);
+    EXPECT_EQ(Save(world, BASE_FILE), XFER_STATUS_OK);
+    world.Simulate(2);
+    EXPECT_EQ(Save(world, QUICK_FILE), XFER_STATUS_OK);
+
+    // A new game forgets the base, so the next save may overwrite it. The quicksave must not load its blocks.
+    world.state.Clear_Incremental_Base();
+    EXPECT_EQ(Save(world, BASE_FILE), XFER_STATUS_OK);
+
+    TestWorld overwritten(0);
+    EXPECT_THROW(Load(overwritten, QUICK_FILE), XferStatus);
+
+    // Referenced blocks without a base at all fail the same way.
+    std::remove(BASE_FILE);
+    world.state.Clear_Incremental_Base();
+    EXPECT_EQ(Save(world, FULL_FILE), XFER_STATUS_OK);
+    world.Simulate(3);
+    EXPECT_EQ(Save(world, QUICK_FILE), XFER_STATUS_OK);
+    std::remove(FULL_FILE);
+
+    TestWorld missing(0);
+    EXPECT_THROW(Load(missing, QUICK_FILE), XferStatus);
+
+    std::remove(QUICK_FILE);
+}
+
+TEST(gamestate, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    TestWorld world(20000);
+    nanoseconds full_time(0);
+    nanoseconds incremental_time(0);
+    long full_size = 0;
+    long incremental_size = 0;
+
+    world.Simulate(0);
+    ASSERT_EQ(Save(world, BASE_FILE), XFER_STATUS_OK);
+
+    for (int i = 1; i <= BENCHMARK_QUICKSAVES; ++i) {
+        world.Simulate(i);
+
+        auto start = steady_clock::now();
+        XferSave xfer;
+        xfer.Open(FULL_FILE);
+        world.state.Xfer_Save_Data(&xfer, SNAPSHOT_TYPE_UNK1);
+        xfer.Close();
+        EXPECT_EQ(XferSave::Wait_For_Flush(), XFER_STATUS_OK);
+        full_time += steady_clock::now() - start;
+        full_size += File_Size(FULL_FILE);
+
+        start = steady_clock::now();
+        EXPECT_EQ(Save(world, QUICK_FILE), XFER_STATUS_OK);
+        incremental_time += steady_clock::now() - start;
+        incremental_size += File_Size(QUICK_FILE);
+    }
+
+    EXPECT_LT(incremental_size, full_size);
+
+    // Both kinds of save have to give back the state they were made from.
+    TestWorld full(0);
+    Load(full, FULL_FILE);
+    Expect_Same_State(full, world);
+
+    TestWorld incremental(0);
+    Load(incremental, QUICK_FILE);
+    Expect_Same_State(incremental, world);
+
+    captainslog_info("Made %d quicksaves of %d values.",
+        BENCHMARK_QUICKSAVES,
+        int(world.terrain.m_values.size() + world.scripts.m_values.size() + world.objects.m_values.size()));
+    captainslog_info("Full: %lld us, %ld bytes", (long long)duration_cast<microseconds>(full_time).count(), full_size);
+    captainslog_info("Incremental: %lld us, %ld bytes",
+        (long long)duration_cast<microseconds>(incremental_time).count(),
+        incremental_size);
+
+    std::remove(BASE_FILE);
+    std::remove(QUICK_FILE);
+    std::remove(FULL_FILE);
+}
@@ -0,0 +1,448 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate and benchmark loading of string files.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "filesystem.h"
+#include "gametext.h"
+#include "registryget.h"
+#include "win32localfilesystem.h"
+
+extern LocalFileSystem *g_theLocalFileSystem;
+
+namespace
+{
+constexpr int STRING_COUNT = 5000;
+constexpr int BENCHMARK_LOADS = 20;
+
+// Files the string manager loads are kept directly in the test output directory, named after their relative path.
+Utf8String Scratch_Path(const char *filename)
+{
+    Utf8String path = TESTOUTPUT_PATH "/gametext_";
+
+    for (const char *c = filename; *c != '\0'; ++c) {
+        path.Concat(*c == '/' || *c == '\\' ? '_' : *c);
+    }
+
+    return path;
+}
+
+// Resolves the relative paths the string manager loads from against the scratch files.
+class ScratchLocalFileSystem : public Win32LocalFileSystem
+{
+public:
+    virtual File *Open_File(const char *filename, int mode) override
+    {
+        return Win32LocalFileSystem::Open_File(Scratch_Path(filename).Str(), mode);
+    }
+};
+
+std::string Make_Label(const char *prefix, int index)
+{
+    char label[32];
+    snprintf(label, sizeof(label), "%s:Label%04d", prefix, index);
+    return label;
+}
+
+std::string Make_Text(int index)
+{
+    char text[64];
+    snprintf(text, sizeof(text), "Sample text number %d for the string table", index);
+    return text;
+}
+
+Utf16String Widen(const std::string &string)
+{
+    std::vector<unichar_t> wide(string.begin(), string.end());
+    wide.push_back(0);
+    return Utf16String(wide.data());
+}
+
+std::string Make_String_File(const char *prefix)
+{
+    std::string data = "// Generated string file\r\n\r\n";
+
+    for (int i = 0; i < STRING_COUNT; ++i) {
+        data += Make_Label(prefix, i) + "\r\n\"" + Make_Text(i) + "\"";
+
+        if (i % 3 == 0) {
+            data += " = Speech" + std::to_string(i) + "Wav";
+        }
+
+        data += "\r\nEND\r\n\r\n";
+    }
+
+    return data;
+}
+
+void Append_Int(std::string &data, int32_t value)
+{
+    for (int i = 0; i < 4; ++i) {
+        data += char((value >> (i * 8)) & 0xFF);
+    }
+}
+
+std::string Make_CSF_Header(int count)
+{
+    std::string data = " FSC";
+    Append_Int(data, 3);
+    Append_Int(data, count);
+    Append_Int(data, count);
+    Append_Int(data, 0);
+    Append_Int(data, 0);
+
+    return data;
+}
+
+std::vector<uint16_t> Encode_CSF_Text(const std::string &text)
+{
+    std::vector<uint16_t> encoded;
+
+    for (char c : text) {
+        encoded.push_back(~uint16_t(uint8_t(c)));
+    }
+
+    return encoded;
+}
+
+void Append_CSF_String(
+    std::string &data, const std::string &label, const std::vector<uint16_t> &encoded, const std::string &speech)
+{
+    data += " LBL";
+    Append_Int(data, 1);
+    Append_Int(data, int32_t(label.size()));
+    data += label;
+    data += speech.empty() ? " RTS" : "WRTS";
+    Append_Int(data, int32_t(encoded.size()));
+
+    for (uint16_t c : encoded) {
+        data += char(c & 0xFF);
+        data += char(c >> 8);
+    }
+
+    if (!speech.empty()) {
+        Append_Int(data, int32_t(speech.size()));
+        data += speech;
+    }
+}
+
+std::string Make_CSF_File(const char *prefix)
+{
+    std::string data = Make_CSF_Header(STRING_COUNT);
+
+    for (int i = 0; i < STRING_COUNT; ++i) {
+        std::string speech = i % 3 == 0 ? "Speech" + std::to_string(i) + "Wav" : "";
+        Append_CSF_String(data, Make_Label(prefix, i), Encode_CSF_Text(Make_Text(i)), speech);
+    }
+
+    return data;
+}
+
+bool Write_File(const char *filename, const std::string &data)
+{
+    FILE *file = fopen(Scratch_Path(filename).Str(), "wb");
+
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    fclose(file);
+    return written;
+}
+
+void Remove_File(const char *filename)
+{
+    std::remove(Scratch_Path(filename).Str());
+}
+
+void Expect_Strings(GameTextManager &manager, const char *prefix)
+{
+    for (int i = 0; i < STRING_COUNT; i += 7) {
+        std::string label = Make_Label(prefix, i);
+        bool success = false;
+        Utf16String text = manager.Fetch(label.c_str(), &success);
+        EXPECT_TRUE(success) << label;
+        EXPECT_TRUE(text == Widen(Make_Text(i))) << label;
+    }
+}
+
+Utf8String Get_CSF_Path()
+{
+    Utf8String csfpath;
+    csfpath.Format("data/%s/Generals.csf", Get_Registry_Language().Str());
+    return csfpath;
+}
+
+class GameTextTest : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        g_theLocalFileSystem = new ScratchLocalFileSystem;
+        g_theFileSystem = new FileSystem;
+    }
+
+    void TearDown() override
+    {
+        Remove_File("data/Generals.str");
+        Remove_File(Get_CSF_Path().Str());
+        Remove_File("map.str");
+        delete g_theFileSystem;
+        g_theFileSystem = nullptr;
+        delete g_theLocalFileSystem;
+        g_theLocalFileSystem = nullptr;
+    }
+};
+} // namespace
+
+TEST_F(GameTextTest, parse_string_file)
+{
+    ASSERT_TRUE(Write_File("data/Generals.str", Make_String_File("TEST")));
+
+    GameTextManager manager;
+    manager.Init();
+    Expect_Strings(manager, "TEST");
+    manager.Deinit();
+}
+
+TEST_F(GameTextTest, parse_csf_file)
+{
+    Utf8String csfpath = Get_CSF_Path();
+    ASSERT_TRUE(Write_File(csfpath.Str(), Make_CSF_File("TEST")));
+
+    GameTextManager manager;
+    manager.Init();
+    Expect_Strings(manager, "TEST");
+    manager.Deinit();
+}
+
+TEST_F(GameTextTest, csf_text_ends_at_null)
+{
+    std::vector<uint16_t> raw_null = Encode_CSF_Text("Before");
+    raw_null.push_back(0x0000);
+    raw_null.push_back(~uint16_t('A'));
+    std::vector<uint16_t> decoded_null = Encode_CSF_Text("Before");
+    decoded_null.push_back(0xFFFF);
+    decoded_null.push_back(~uint16_t('A'));
+
+    std::string data = Make_CSF_Header(2);
+    Append_CSF_String(data, "TEST:RawNull", raw_null, "");
+    Append_CSF_String(data, "TEST:DecodedNull", decoded_null, "");
+    ASSERT_TRUE(Write_File(Get_CSF_Path().Str(), data));
+
+    GameTextManager manager;
+    manager.Init();
+    EXPECT_TRUE(manager.Fetch("TEST:RawNull") == Widen("Before"));
+    EXPECT_TRUE(manager.Fetch("TEST:DecodedNull") == Widen("Before"));
+    manager.Deinit();
+}
+
+TEST_F(GameTextTest, parse_map_string_file)
+{
+    Utf8String csfpath = Get_CSF_Path();
+    ASSERT_TRUE(Write_File(csfpath.Str(), Make_CSF_File("TEST")));
+    ASSERT_TRUE(Write_File("map.str", Make_String_File("MAP")));
+
+    GameTextManager manager;
+    manager.Init();
+    manager.Init_Map_String_File("map.str");
+    Expect_Strings(manager, "TEST");
+    Expect_Strings(manager, "MAP");
+    manager.Reset();
+    manager.Deinit();
+}
+
+TEST(gametext, label_hash)
+{
+    const int count = 20000;
+    std::vector<StringInfo> infos(count + 2);
+    std::vector<StringLookUp> lut(count + 2);
+
+    for (int i = 0; i < count; ++i) {
+        infos[i].label = Make_Label("HASH", i).c_str();
+    }
+
+    // Labels only differing in case share a slot, like bsearch over the sorted table the first one is found.
+    infos[count].label = "Hash:Duplicate";
+    infos[count + 1].label = "HASH:DUPLICATE";
+
+    for (int i = 0; i < count + 2; ++i) {
+        lut[i].label = &infos[i].label;
+        lut[i].info = &infos[i];
+    }
+
+    qsort(lut.data(), lut.size(), sizeof(StringLookUp), GameTextManager::Compare_LUT);
+
+    StringLabelHash hash;
+    EXPECT_EQ(hash.Find("HASH:Label0000", 14), nullptr);
+    hash.Build(lut.data(), int(lut.size()));
+
+    // With twice as many labels as buckets most buckets hold several labels, each must still get its own slot.
+    for (int i = 0; i < count; ++i) {
+        std::string label = Make_Label("HASH", i);
+        ASSERT_EQ(hash.Find(label.c_str(), label.size()), &infos[i]) << label;
+
+        for (char &c : label) {
+            c = tolower(c);
+        }
+
+        ASSERT_EQ(hash.Find(label.c_str(), label.size()), &infos[i]) << label;
+    }
+
+    const StringLookUp *duplicate = &lut[0];
+
+    while (strcasecmp(duplicate->label->Str(), "hash:duplicate") != 0) {
+        ++duplicate;
+    }
+
+    EXPECT_EQ(hash.Find("hash:duplicate", 14), duplicate->info);
+
+    // Only the given length is part of the label.
+    EXPECT_EQ(hash.Find("HASH:Label0001 and more", 14), &infos[1]);
+
+    EXPECT_EQ(hash.Find("HASH:Label20000", 15), nullptr);
+    EXPECT_EQ(hash.Find("HASH:Label000", 13), nullptr);
+    EXPECT_EQ(hash.Find("HASH:Label0000 ", 15), nullptr);
+    EXPECT_EQ(hash.Find("HASH:Label", 10), nullptr);
+    EXPECT_EQ(hash.Find("", 0), nullptr);
+
+    hash.Clear();
+    EXPECT_EQ(hash.Find("HASH:Label0000", 14), nullptr);
+}
+
+TEST_F(GameTextTest, fetch_label)
+{
+    Utf8String csfpath = Get_CSF_Path();
+    ASSERT_TRUE(Write_File(csfpath.Str(), Make_CSF_File("TEST")));
+    ASSERT_TRUE(Write_File("map.str", Make_String_File("MAP")));
+
+    GameTextManager manager;
+    manager.Init();
+
+    bool success = true;
+    Utf16String text = manager.Fetch("", &success);
+    EXPECT_FALSE(success);
+    EXPECT_TRUE(text == Widen("MISSING: ''"));
+
+    // Map string tables have spare entries with empty labels.
+    manager.Init_Map_String_File("map.str");
+
+    text = manager.Fetch_Label("MAP:Label0042, TEST:Label0001", 13, &success);
+    EXPECT_TRUE(success);
+    EXPECT_TRUE(text == Widen(Make_Text(42)));
+
+    text = manager.Fetch("test:label0001", &success);
+    EXPECT_TRUE(success);
+    EXPECT_TRUE(text == Widen(Make_Text(1)));
+
+    // Missing labels return the same string every time.
+    text = manager.Fetch("TEST:Label9999", &success);
+    EXPECT_FALSE(success);
+    EXPECT_TRUE(text == Widen("MISSING: 'TEST:Label9999'"));
+    EXPECT_TRUE(manager.Fetch_Label("TEST:Label9999", 14, &success) == text);
+    EXPECT_FALSE(success);
+
+    manager.Reset();
+    manager.Deinit();
+}
+
+TEST_F(GameTextTest, strings_with_prefix)
+{
+    Utf8String csfpath = Get_CSF_Path();
+    ASSERT_TRUE(Write_File(csfpath.Str(), Make_CSF_File("TEST")));
+    ASSERT_TRUE(Write_File("map.str", Make_String_File("MAP")));
+
+    GameTextManager manager;
+    manager.Init();
+
+    // An empty prefix matches everything, in sorted order.
+    std::vector<Utf8String> strings = *manager.Get_Strings_With_Prefix("");
+    ASSERT_EQ(int(strings.size()), STRING_COUNT);
+
+    for (int i = 0; i < STRING_COUNT; ++i) {
+        ASSERT_STREQ(strings[i].Str(), Make_Label("TEST", i).c_str());
+    }
+
+    // String table matches come before map string matches.
+    manager.Init_Map_String_File("map.str");
+    strings = *manager.Get_Strings_With_Prefix("TEST:Label4999");
+    ASSERT_EQ(strings.size(), 1u);
+    EXPECT_STREQ(strings[0].Str(), "TEST:Label4999");
+
+    strings = *manager.Get_Strings_With_Prefix("MAP:Label");
+    ASSERT_EQ(int(strings.size()), STRING_COUNT);
+
+    for (int i = 0; i < STRING_COUNT; ++i) {
+        ASSERT_STREQ(strings[i].Str(), Make_Label("MAP", i).c_str());
+    }
+
+    strings = *manager.Get_Strings_With_Prefix("TEST:Label00");
+    ASSERT_EQ(strings.size(), 100u);
+
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_STREQ(strings[i].Str(), Make_Label("TEST", i).c_str());
+    }
+
+    strings = *manager.Get_Strings_With_Prefix("MAP:Label4999");
+    ASSERT_EQ(strings.size(), 1u);
+    EXPECT_STREQ(strings[0].Str(), "MAP:Label4999");
+
+    // The range is found ignoring case but the match is case sensitive.
+    EXPECT_TRUE(manager.Get_Strings_With_Prefix("test:")->empty());
+    EXPECT_TRUE(manager.Get_Strings_With_Prefix("MAP:Label5")->empty());
+    EXPECT_TRUE(manager.Get_Strings_With_Prefix("A")->empty());
+    EXPECT_TRUE(manager.Get_Strings_With_Prefix("ZZZ")->empty());
+    EXPECT_TRUE(manager.Get_Strings_With_Prefix("MAP:Label49999")->empty());
+
+    manager.Reset();
+    manager.Deinit();
+}
+
+TEST_F(GameTextTest, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    Utf8String csfpath = Get_CSF_Path();
+    ASSERT_TRUE(Write_File(csfpath.Str(), Make_CSF_File("TEST")));
+    ASSERT_TRUE(Write_File("map.str", Make_String_File("MAP")));
+
+    GameTextManager manager;
+    nanoseconds csf_time(0);
+    nanoseconds str_time(0);
+
+    for (int i = 0; i < BENCHMARK_LOADS; ++i) {
+        auto start = steady_clock::now();
+        manager.Init();
+        csf_time += steady_clock::now() - start;
+
+        start = steady_clock::now();
+        manager.Init_Map_String_File("map.str");
+        str_time += steady_clock::now() - start;
+
+        manager.Reset();
+        manager.Deinit();
+    }
+
+    captainslog_info("Loaded %d strings %d times.", STRING_COUNT, BENCHMARK_LOADS);
+    captainslog_info("CSF file: %lld us", (long long)duration_cast<microseconds>(csf_time).count());
+    captainslog_info("Map string file: %lld us", (long long)duration_cast<microseconds>(str_time).count());
+}
@@ -12,8 +12,12 @@
  *            A full copy of the GNU General Public License can be found in
  *            LICENSE
  */
+#include <assetmgr.h>
+#include <captainslog.h>
+#include <chrono>
 #include <gtest/gtest.h>
 #include <render2dsentence.h>
+#include <vector>
 
 #define GLYPH_DUMP 0
 
@@ -58,3 +62,266 @@ TEST(text, render)
     DumpGlyph(font, 'g');
 #endif
 }
+
+namespace
+{
+// Lays out a string on one line and blits its glyphs, the same work a sentence build does per character.
+int Blit_String(FontCharsClass &font, const unichar_t *text, std::vector<uint16_t> &surface, int stride)
+{
+    int x = 0;
+
+    for (; *text != U_CHAR('\0'); ++text) {
+        int spacing = font.Get_Char_Spacing(*text);
+
+        if (x + font.Get_Char_Width(*text) > stride) {
+            break;
+        }
+
+        font.Blit_Char(*text, surface.data(), stride * sizeof(uint16_t), x, 0);
+        x += spacing;
+    }
+
+    return x;
+}
+
+void Make_Text(unichar_t *text, const char *prefix, int value)
+{
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), "%s%d", prefix, value);
+
+    for (const char *c = buffer;; ++c) {
+        *text++ = unichar_t(*c);
+
+        if (*c == '\0') {
+            break;
+        }
+    }
+}
+} // namespace
+
+TEST(text, glyph_page_eviction)
+{
+    const unichar_t first = 0x20;
+    const unichar_t last = 0x800;
+    const int stride = 64;
+    std::vector<std::vector<uint16_t>> expected;
+    int reference_pages;
+
+    // Fontconfig is torn down with each font, so the reference glyphs are rendered before the limited font exists.
+    {
+        FontCharsClass reference;
+        reference.Initialize_GDI_Font("Arial", 12, false);
+        if (!reference.Is_Font("Arial", 12, false)) {
+            captainslog_info("Failed to initialize font. Stopping test");
+            return;
+        }
+
+        for (unichar_t ch = first; ch < last; ++ch) {
+            expected.emplace_back(stride * reference.Get_Char_Height());
+            reference.Blit_Char(ch, expected.back().data(), stride * sizeof(uint16_t), 0, 0);
+        }
+
+        reference_pages = reference.Get_Glyph_Page_Count();
+    }
+
+    FontCharsClass font;
+    font.Initialize_GDI_Font("Arial", 12, false);
+    font.Set_Glyph_Page_Limit(2);
+    std::vector<uint16_t> actual(stride * font.Get_Char_Height());
+
+    // Enough glyphs to cycle through the pages several times, then the first ones again after they were evicted.
+    for (int pass = 0; pass < 2; ++pass) {
+        for (unichar_t ch = first; ch < last; ++ch) {
+            std::fill(actual.begin(), actual.end(), 0);
+            font.Blit_Char(ch, actual.data(), stride * sizeof(uint16_t), 0, 0);
+            ASSERT_EQ(actual, expected[ch - first]) << "Character " << int(ch) << " in pass " << pass;
+        }
+    }
+
+    EXPECT_EQ(font.Get_Glyph_Page_Count(), 2);
+    EXPECT_GT(reference_pages, 2);
+}
+
+TEST(text, sentence_cache)
+{
+    FontCharsClass font;
+    Render2DSentenceClass sentence;
+    Render2DSentenceClass other_sentence;
+    SentenceCacheClass cache;
+    unichar_t text[32];
+    int refs = font.Num_Refs();
+
+    sentence.Set_Font(&font);
+
+    Make_Text(text, "Label ", 0);
+    EXPECT_EQ(cache.Find(SentenceCacheClass::Make_Key(sentence, text)), -1);
+    int index = cache.Insert(SentenceCacheClass::Make_Key(sentence, text), sentence, 12, 3);
+    EXPECT_EQ(font.Num_Refs(), refs + 2);
+
+    // The cache keeps its own copy of the text.
+    Make_Text(text, "Label ", 0);
+    EXPECT_EQ(cache.Find(SentenceCacheClass::Make_Key(sentence, text)), index);
+    EXPECT_EQ(cache.Get(index).x, 12);
+    EXPECT_EQ(cache.Get(index).y, 3);
+
+    // Any difference in text, font or layout is a miss.
+    Make_Text(text, "Label ", 1);
+    EXPECT_EQ(cache.Find(SentenceCacheClass::Make_Key(sentence, text)), -1);
+    Make_Text(text, "Label ", 0);
+    text[5] = U_CHAR('\0');
+    EXPECT_EQ(cache.Find(SentenceCacheClass::Make_Key(sentence, text)), -1);
+    Make_Text(text, "Label ", 0);
+    EXPECT_EQ(cache.Find(SentenceCacheClass::Make_Key(other_sentence, text)), -1);
+    sentence.Set_Wrapping_Width(100.0f);
+    EXPECT_EQ(cache.Find(SentenceCacheClass::Make_Key(sentence, text)), -1);
+    sentence.Set_Wrapping_Width(0.0f);
+    sentence.Set_Texture_Size_Hint(256);
+    EXPECT_EQ(cache.Find(SentenceCacheClass::Make_Key(sentence, text)), -1);
+    sentence.Set_Texture_Size_Hint(0);
+
+    for (int i = 1; i < SentenceCacheClass::CACHE_SIZE; ++i) {
+        Make_Text(text, "Label ", i);
+        cache.Insert(SentenceCacheClass::Make_Key(sentence, text), sentence, i, 0);
+    }
+
+    EXPECT_EQ(cache.Count(), int(SentenceCacheClass::CACHE_SIZE));
+
+    // Once full the least recently used sentence makes room, a hit counts as a use.
+    Make_Text(text, "Label ", 0);
+    EXPECT_EQ(cache.Find(SentenceCacheClass::Make_Key(sentence, text)), index);
+    Make_Text(text, "Label ", SentenceCacheClass::CACHE_SIZE);
+    cache.Insert(SentenceCacheClass::Make_Key(sentence, text), sentence, 0, 0);
+    EXPECT_EQ(cache.Count(), int(SentenceCacheClass::CACHE_SIZE));
+
+    Make_Text(text, "Label ", 1);
+    EXPECT_EQ(cache.Find(SentenceCacheClass::Make_Key(sentence, text)), -1);
+
+    for (int i = 0; i <= SentenceCacheClass::CACHE_SIZE; ++i) {
+        if (i != 1) {
+            Make_Text(text, "Label ", i);
+            int found = cache.Find(SentenceCacheClass::Make_Key(sentence, text));
+            ASSERT_NE(found, -1) << "Sentence " << i;
+            EXPECT_EQ(cache.Get(found).x, i == SentenceCacheClass::CACHE_SIZE ? 0 : i == 0 ? 12 : i);
+        }
+    }
+
+    EXPECT_EQ(font.Num_Refs(), refs + 1 + SentenceCacheClass::CACHE_SIZE);
+
+    cache.Flush();
+    EXPECT_EQ(cache.Count(), 0);
+    Make_Text(text, "Label ", 0);
+    EXPECT_EQ(cache.Find(SentenceCacheClass::Make_Key(sentence, text)), -1);
+    EXPECT_EQ(font.Num_Refs(), refs + 1);
+}
+
+TEST(text, sentence_cache_flush)
+{
+    FontCharsClass font;
+    font.Initialize_GDI_Font("Arial", 12, false);
+    if (!font.Is_Font("Arial", 12, false)) {
+        captainslog_info("Failed to initialize font. Stopping test");
+        return;
+    }
+
+    // Only line breaks are built as no surface can be locked for glyphs without a device.
+    const unichar_t *text = U_CHAR("\n\n");
+    int refs = font.Num_Refs();
+    int x;
+    int y;
+    Render2DSentenceClass::Flush_Sentence_Cache();
+
+    {
+        Render2DSentenceClass sentence;
+        sentence.Set_Font(&font);
+        sentence.Build_Sentence(text, &x, &y);
+    }
+
+    // The shared cache holds on to the font after the sentence is gone, an identical sentence reuses its entry.
+    EXPECT_EQ(font.Num_Refs(), refs + 1);
+
+    {
+        Render2DSentenceClass sentence;
+        sentence.Set_Font(&font);
+        int cached_x = -1;
+        int cached_y = -1;
+        sentence.Build_Sentence(text, &cached_x, &cached_y);
+        EXPECT_EQ(cached_x, x);
+        EXPECT_EQ(cached_y, y);
+    }
+
+    EXPECT_EQ(font.Num_Refs(), refs + 1);
+
+    W3DAssetManager assetmngr;
+    assetmngr.Free_Assets();
+    EXPECT_EQ(font.Num_Refs(), refs);
+}
+
+TEST(text, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    FontCharsClass font;
+    font.Initialize_GDI_Font("Arial", 12, false);
+    if (!font.Is_Font("Arial", 12, false)) {
+        captainslog_info("Failed to initialize font. Stopping test");
+        return;
+    }
+
+    // Names and health labels repeat every frame while timers change, with some non latin text mixed in. Surfaces
+    // can't be locked without a device so a sentence build is its glyph blits, done once per cached sentence.
+    const int frames = 200;
+    const int labels = 40;
+    const int timers = 10;
+    const int stride = 512;
+    Render2DSentenceClass sentence;
+    SentenceCacheClass cache;
+    std::vector<uint16_t> surface(stride * font.Get_Char_Height());
+    unichar_t text[64];
+    long long blit_width = 0;
+    long long cached_width = 0;
+    int misses = 0;
+    nanoseconds blit_time(0);
+    nanoseconds cached_time(0);
+
+    font.Set_Glyph_Page_Limit(8);
+    sentence.Set_Font(&font);
+
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int i = 0; i < labels + timers; ++i) {
+            if (i < labels) {
+                Make_Text(text, (i & 1) ? "Health " : "Unit ", i);
+            } else {
+                Make_Text(text, "Time ", frame * timers + i);
+            }
+
+            for (int j = 0; j < 4; ++j) {
+                text[u_strlen(text) + 1] = U_CHAR('\0');
+                text[u_strlen(text)] = unichar_t(0x400 + (i * 7 + j * 13) % 0x300);
+            }
+
+            auto start = steady_clock::now();
+            blit_width += Blit_String(font, text, surface, stride);
+            blit_time += steady_clock::now() - start;
+
+            start = steady_clock::now();
+            SentenceCacheClass::KeyStruct key = SentenceCacheClass::Make_Key(sentence, text);
+            int index = cache.Find(key);
+
+            if (index == -1) {
+                index = cache.Insert(key, sentence, Blit_String(font, text, surface, stride), 0);
+                ++misses;
+            }
+
+            cached_width += cache.Get(index).x;
+            cached_time += steady_clock::now() - start;
+        }
+    }
+
+    EXPECT_EQ(cached_width, blit_width);
+    EXPECT_EQ(misses, labels + frames * timers);
+    EXPECT_LE(font.Get_Glyph_Page_Count(), 8);
+
+    captainslog_info("Built %d sentences, %d of them new.", frames * (labels + timers), misses);
+    captainslog_info("Blitting every sentence: %lld us", (long long)duration_cast<microseconds>(blit_time).count());
+    captainslog_info("Sentence cache: %lld us", (long long)duration_cast<microseconds>(cached_time).count());
+}
@@ -0,0 +1,193 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate and stress the network packet transport over loopback.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "endiantype.h"
+#include "transport.h"
+
+namespace
+{
+constexpr uint32_t LOOPBACK_ADDR = 0x7F000001;
+constexpr int MAX_PAYLOAD = 476;
+
+// The word at a time obfuscation the transport shipped with, to compare against.
+void Reference_Obfuscate(uint8_t *data, int len)
+{
+    int mix_magic = 0xFADE;
+
+    for (int i = 0; i < len / 4; ++i) {
+        uint32_t word;
+        memcpy(&word, &data[i * 4], sizeof(word));
+        word = htobe32(mix_magic ^ word);
+        memcpy(&data[i * 4], &word, sizeof(word));
+        mix_magic += 801;
+    }
+}
+
+// Fills a payload whose contents identify which packet it is.
+int Make_Payload(char *buf, int index)
+{
+    int len = 8 + (index * 37) % (MAX_PAYLOAD - 8);
+    memcpy(buf, &index, sizeof(index));
+
+    for (int i = sizeof(index); i < len; ++i) {
+        buf[i] = char(index + i);
+    }
+
+    return len;
+}
+
+bool Check_Payload(const TransportMessage &msg, int &index)
+{
+    char expected[MAX_PAYLOAD];
+    memcpy(&index, msg.data, sizeof(index));
+
+    return msg.length == Make_Payload(expected, index) && memcmp(msg.data, expected, msg.length) == 0;
+}
+
+// Hands every received message to the caller and frees its slot.
+template<typename Func> int Drain_Incoming(Transport &transport, Func func)
+{
+    int count = 0;
+
+    for (int slot = transport.Next_Incoming(0); slot >= 0; slot = transport.Next_Incoming(slot + 1)) {
+        func(transport.Get_Incoming(slot));
+        transport.Release_Incoming(slot);
+        ++count;
+    }
+
+    return count;
+}
+} // namespace
+
+TEST(transport, obfuscate_matches_reference)
+{
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    for (int len = 0; len <= int(sizeof(TransportMessageHeader) + MAX_PAYLOAD); ++len) {
+        std::vector<uint8_t> original(len);
+
+        for (uint8_t &b : original) {
+            b = uint8_t(byte(gen));
+        }
+
+        std::vector<uint8_t> expected = original;
+        std::vector<uint8_t> actual = original;
+        Reference_Obfuscate(expected.data(), len);
+        Transport::Obfuscate(actual.data(), len);
+        ASSERT_EQ(actual, expected) << "Length " << len;
+
+        Transport::Reveal(actual.data(), len);
+        ASSERT_EQ(actual, original) << "Length " << len;
+    }
+}
+
+TEST(transport, loopback)
+{
+    Transport sender;
+    Transport receiver;
+    ASSERT_TRUE(sender.Init(LOOPBACK_ADDR, 0));
+    ASSERT_TRUE(receiver.Init(LOOPBACK_ADDR, 0));
+    uint16_t sender_port = sender.Get_Local_Port();
+    uint16_t receiver_port = receiver.Get_Local_Port();
+    ASSERT_NE(receiver_port, 0);
+
+    // More packets than there are buffers on either side, so slots have to be reused.
+    const int total = 1000;
+    std::vector<int> seen(total, 0);
+    int queued = 0;
+    int received = 0;
+    char buf[MAX_PAYLOAD];
+
+    for (int frame = 0; frame < 1000 && received < total; ++frame) {
+        while (queued < total && sender.Queue_Send(LOOPBACK_ADDR, receiver_port, buf, Make_Payload(buf, queued))) {
+            ++queued;
+        }
+
+        sender.Update();
+        receiver.Update();
+        received += Drain_Incoming(receiver, [&](const TransportMessage &msg) {
+            int index = -1;
+            ASSERT_TRUE(Check_Payload(msg, index)) << "Packet " << index;
+            ASSERT_TRUE(index >= 0 && index < total);
+            EXPECT_EQ(msg.addr, LOOPBACK_ADDR);
+            EXPECT_EQ(msg.port, sender_port);
+            ++seen[index];
+        });
+    }
+
+    EXPECT_EQ(received, total);
+
+    for (int i = 0; i < total; ++i) {
+        EXPECT_EQ(seen[i], 1) << "Packet " << i;
+    }
+}
+
+TEST(transport, DISABLED_stress)
+{
+    using namespace std::chrono;
+
+    Transport sender;
+    Transport receiver;
+    ASSERT_TRUE(sender.Init(LOOPBACK_ADDR, 0));
+    ASSERT_TRUE(receiver.Init(LOOPBACK_ADDR, 0));
+    uint16_t receiver_port = receiver.Get_Local_Port();
+    ASSERT_NE(receiver_port, 0);
+
+    const int frames = 2000;
+    const int packets_per_frame = 64;
+    int sent = 0;
+    int received = 0;
+    char buf[MAX_PAYLOAD];
+    nanoseconds update_time(0);
+    nanoseconds worst_frame(0);
+    auto start = steady_clock::now();
+
+    for (int frame = 0; frame < frames; ++frame) {
+        for (int i = 0; i < packets_per_frame; ++i) {
+            sent += sender.Queue_Send(LOOPBACK_ADDR, receiver_port, buf, Make_Payload(buf, sent));
+        }
+
+        auto frame_start = steady_clock::now();
+        sender.Update();
+        receiver.Update();
+        nanoseconds frame_time = steady_clock::now() - frame_start;
+        update_time += frame_time;
+        worst_frame = std::max(worst_frame, frame_time);
+
+        received += Drain_Incoming(receiver, [&](const TransportMessage &msg) {
+            int index = -1;
+            EXPECT_TRUE(Check_Payload(msg, index)) << "Packet " << index;
+        });
+    }
+
+    nanoseconds elapsed = steady_clock::now() - start;
+
+    EXPECT_GT(received, 0);
+    EXPECT_LE(received, sent);
+
+    captainslog_info("Sent %d and received %d packets over %d frames.", sent, received, frames);
+    captainslog_info("Packets per second: %lld",
+        (long long)(received * 1000000000LL / std::max<long long>(elapsed.count(), 1)));
+    captainslog_info("Transport update per frame: %.2f us average, %lld us worst",
+        duration_cast<duration<double, std::micro>>(update_time).count() / frames,
+        (long long)duration_cast<microseconds>(worst_frame).count());
+}
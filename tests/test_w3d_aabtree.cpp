@@ -0,0 +1,518 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate and benchmark the AABTreeClass builders and the flattened queries against the recursive
+ *        ones.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <gtest/gtest.h>
+
+#include "aabtree.h"
+#include "aabtreebuilder.h"
+#include "bufffile.h"
+#include "chunkio.h"
+#include "coltest.h"
+#include "inttest.h"
+#include "meshgeometry.h"
+#include "w3d_file.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+// A bumpy terrain patch with loose triangles scattered above it, like a building or some debris.
+class TestMeshClass : public MeshGeometryClass
+{
+    IMPLEMENT_W3D_POOL(TestMeshClass);
+
+public:
+    TestMeshClass(int grid, int loose, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution<float> pos(0.0f, grid * 10.0f);
+        std::uniform_real_distribution<float> offset(-8.0f, 8.0f);
+        int grid_verts = (grid + 1) * (grid + 1);
+        Reset_Geometry(grid * grid * 2 + loose, grid_verts + loose * 3);
+        Vector3 *verts = Get_Vertex_Array();
+        TriIndex *polys = Get_Polys();
+        uint8_t *types = Get_Poly_Surface_Type_Array();
+        int poly = 0;
+
+        for (int y = 0; y <= grid; ++y) {
+            for (int x = 0; x <= grid; ++x) {
+                verts[y * (grid + 1) + x].Set(x * 10.0f, y * 10.0f, sinf(x * 0.7f) * cosf(y * 0.4f) * 6.0f);
+            }
+        }
+
+        for (int y = 0; y < grid; ++y) {
+            for (int x = 0; x < grid; ++x) {
+                int v = y * (grid + 1) + x;
+                polys[poly++] = TriIndex(v, v + 1, v + grid + 2);
+                polys[poly++] = TriIndex(v, v + grid + 2, v + grid + 1);
+            }
+        }
+
+        for (int i = 0; i < loose; ++i) {
+            int v = grid_verts + i * 3;
+            Vector3 center(pos(rng), pos(rng), offset(rng) + 10.0f);
+
+            for (int j = 0; j < 3; ++j) {
+                verts[v + j] = center + Vector3(offset(rng), offset(rng), offset(rng));
+            }
+
+            polys[poly++] = TriIndex(v, v + 1, v + 2);
+        }
+
+        for (int i = 0; i < poly; ++i) {
+            types[i] = uint8_t(i % 32);
+        }
+
+        Generate_Culling_Tree();
+        m_size = grid * 10.0f;
+    }
+
+    float Get_Size() const { return m_size; }
+    AABTreeClass *Get_Tree() { return m_cullTree; }
+
+private:
+    float m_size;
+};
+
+// The geometry of the first mesh in a w3d file, as the builder takes it.
+struct MeshDataStruct
+{
+    std::vector<Vector3> verts;
+    std::vector<TriIndex> polys;
+};
+
+bool Load_Mesh_Data(const char *filename, MeshDataStruct &data)
+{
+    BufferedFileClass file(filename);
+
+    if (!file.Open(FM_READ)) {
+        return false;
+    }
+
+    ChunkLoadClass cload(&file);
+
+    if (!cload.Open_Chunk() || cload.Cur_Chunk_ID() != W3D_CHUNK_MESH) {
+        return false;
+    }
+
+    while (cload.Open_Chunk()) {
+        if (cload.Cur_Chunk_ID() == W3D_CHUNK_VERTICES) {
+            data.verts.resize(cload.Cur_Chunk_Length() / sizeof(W3dVectorStruct));
+
+            for (Vector3 &vert : data.verts) {
+                W3dVectorStruct v;
+                cload.Read(&v, sizeof(v));
+                vert.Set(v.x, v.y, v.z);
+            }
+        } else if (cload.Cur_Chunk_ID() == W3D_CHUNK_TRIANGLES) {
+            data.polys.resize(cload.Cur_Chunk_Length() / sizeof(W3dTriStruct));
+
+            for (TriIndex &poly : data.polys) {
+                W3dTriStruct tri;
+                cload.Read(&tri, sizeof(tri));
+                poly = TriIndex(tri.Vindex[0], tri.Vindex[1], tri.Vindex[2]);
+            }
+        }
+
+        cload.Close_Chunk();
+    }
+
+    cload.Close_Chunk();
+
+    return !data.verts.empty() && !data.polys.empty();
+}
+
+// A mesh made from loaded geometry, its culling tree is built with the current build method.
+class DataMeshClass : public MeshGeometryClass
+{
+    IMPLEMENT_W3D_POOL(DataMeshClass);
+
+public:
+    DataMeshClass(const MeshDataStruct &data)
+    {
+        Reset_Geometry(int(data.polys.size()), int(data.verts.size()));
+        std::copy(data.verts.begin(), data.verts.end(), Get_Vertex_Array());
+        std::copy(data.polys.begin(), data.polys.end(), Get_Polys());
+        Generate_Culling_Tree();
+    }
+};
+
+void Expect_Same_Result(const CastResultStruct &result, const CastResultStruct &expected)
+{
+    EXPECT_EQ(result.start_bad, expected.start_bad);
+    EXPECT_EQ(result.fraction, expected.fraction);
+    EXPECT_EQ(result.normal, expected.normal);
+    EXPECT_EQ(result.surface_type, expected.surface_type);
+    EXPECT_EQ(result.contact_point, expected.contact_point);
+}
+
+// Segments from above the terrain down into it, along it and from below, some of them parallel to an axis.
+std::vector<LineSegClass> Make_Rays(float size, int count, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> pos(-0.1f * size, 1.1f * size);
+    std::uniform_real_distribution<float> height(-20.0f, 40.0f);
+    std::vector<LineSegClass> rays;
+
+    for (int i = 0; i < count; ++i) {
+        Vector3 start(pos(rng), pos(rng), height(rng));
+        Vector3 end(pos(rng), pos(rng), height(rng));
+
+        switch (i % 5) {
+            case 0:
+                end.Set(start.X, start.Y, -30.0f);
+                break;
+            case 1:
+                end.Set(start.X + 40.0f, start.Y, start.Z);
+                break;
+            case 2:
+                end = start + (end - start) * 0.05f;
+                break;
+            default:
+                break;
+        }
+
+        rays.emplace_back(start, end);
+    }
+
+    return rays;
+}
+
+// Picking and line of sight rays, many of them start at the same point and go out next to each other.
+std::vector<LineSegClass> Make_Camera_Rays(float size, int cameras, int rays_per_camera, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> pos(0.0f, size);
+    std::vector<LineSegClass> rays;
+    int side = int(sqrtf(float(rays_per_camera)));
+
+    for (int camera = 0; camera < cameras; ++camera) {
+        Vector3 eye(pos(rng), pos(rng), 150.0f);
+        Vector3 target(pos(rng), pos(rng), 0.0f);
+
+        for (int i = 0; i < rays_per_camera; ++i) {
+            Vector3 end = target + Vector3(float(i % side) * 2.0f, float(i / side) * 2.0f, -20.0f);
+            rays.emplace_back(eye, eye + (end - eye) * 1.5f);
+        }
+    }
+
+    return rays;
+}
+} // namespace
+
+TEST(w3d_aabtree, ray_matches_recursive)
+{
+    TestMeshClass mesh(48, 2000, 46);
+    std::vector<LineSegClass> rays = Make_Rays(mesh.Get_Size(), 20000, 1);
+    std::vector<CastResultStruct> expected(rays.size());
+    std::vector<bool> expected_hit(rays.size());
+    int hit_count = 0;
+
+    AABTreeClass::Set_Quad_Nodes_Enabled(false);
+
+    for (size_t i = 0; i < rays.size(); ++i) {
+        expected[i].compute_contact_point = true;
+        RayCollisionTestClass raytest(rays[i], &expected[i]);
+        expected_hit[i] = mesh.Cast_Ray(raytest);
+        hit_count += expected_hit[i];
+    }
+
+    AABTreeClass::Set_Quad_Nodes_Enabled(true);
+    EXPECT_GT(hit_count, 1000);
+
+    for (size_t i = 0; i < rays.size(); ++i) {
+        CastResultStruct result;
+        result.compute_contact_point = true;
+        RayCollisionTestClass raytest(rays[i], &result);
+        EXPECT_EQ(mesh.Cast_Ray(raytest), expected_hit[i]);
+        Expect_Same_Result(result, expected[i]);
+    }
+
+    // Rays cast together, with a count that leaves a partial packet.
+    std::vector<CastResultStruct> results(rays.size() - 7);
+    std::vector<RayCollisionTestClass *> tests;
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        results[i].compute_contact_point = true;
+        tests.push_back(new RayCollisionTestClass(rays[i], &results[i]));
+    }
+
+    int batch_hits = 0;
+
+    for (size_t i = 0; i < tests.size(); ++i) {
+        batch_hits += expected_hit[i];
+    }
+
+    EXPECT_EQ(mesh.Get_Tree()->Cast_Rays(tests.data(), int(tests.size())), batch_hits);
+
+    for (size_t i = 0; i < tests.size(); ++i) {
+        Expect_Same_Result(results[i], expected[i]);
+        delete tests[i];
+    }
+}
+
+TEST(w3d_aabtree, box_matches_recursive)
+{
+    TestMeshClass mesh(32, 1000, 7);
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> pos(-0.1f * mesh.Get_Size(), 1.1f * mesh.Get_Size());
+    std::uniform_real_distribution<float> height(-10.0f, 30.0f);
+    std::uniform_real_distribution<float> extent(0.5f, 15.0f);
+    std::uniform_real_distribution<float> move(-30.0f, 30.0f);
+    int intersect_count = 0;
+
+    for (int i = 0; i < 5000; ++i) {
+        AABoxClass aabox(Vector3(pos(rng), pos(rng), height(rng)), Vector3(extent(rng), extent(rng), extent(rng)));
+        Vector3 sweep(move(rng), move(rng), move(rng));
+        Matrix3D basis(true);
+        basis.Rotate_Z(move(rng));
+        basis.Rotate_X(move(rng));
+        OBBoxClass obbox(aabox.m_center, aabox.m_extent, Matrix3(basis));
+        CastResultStruct expected[2];
+        CastResultStruct results[2];
+
+        AABTreeClass::Set_Quad_Nodes_Enabled(false);
+        AABoxCollisionTestClass aabox_expected(aabox, sweep, &expected[0]);
+        bool aabox_hit = mesh.Cast_AABox(aabox_expected);
+        OBBoxCollisionTestClass obbox_expected(obbox, sweep, &expected[1]);
+        bool obbox_hit = mesh.Cast_OBBox(obbox_expected);
+        OBBoxIntersectionTestClass intersect_expected(obbox, COLLISION_TYPE_ALL);
+        bool intersect = mesh.Intersect_OBBox(intersect_expected);
+        intersect_count += intersect;
+
+        AABTreeClass::Set_Quad_Nodes_Enabled(true);
+        AABoxCollisionTestClass aabox_test(aabox, sweep, &results[0]);
+        EXPECT_EQ(mesh.Cast_AABox(aabox_test), aabox_hit);
+        Expect_Same_Result(results[0], expected[0]);
+        OBBoxCollisionTestClass obbox_test(obbox, sweep, &results[1]);
+        EXPECT_EQ(mesh.Cast_OBBox(obbox_test), obbox_hit);
+        Expect_Same_Result(results[1], expected[1]);
+        OBBoxIntersectionTestClass intersect_test(obbox, COLLISION_TYPE_ALL);
+        EXPECT_EQ(mesh.Intersect_OBBox(intersect_test), intersect);
+    }
+
+    EXPECT_GT(intersect_count, 500);
+}
+
+TEST(w3d_aabtree, sah_matches_random_planes)
+{
+    AABTreeBuilderClass::Set_Build_Method(AABTreeBuilderClass::BUILD_RANDOM_PLANES);
+    TestMeshClass expected_mesh(48, 2000, 46);
+    AABTreeBuilderClass::Set_Build_Method(AABTreeBuilderClass::BUILD_BINNED_SAH);
+    TestMeshClass mesh(48, 2000, 46);
+    TestMeshClass same_mesh(48, 2000, 46);
+
+    // The binned builder must give the same tree every time and keep every polygon.
+    EXPECT_EQ(mesh.Get_Tree()->Get_Node_Count(), same_mesh.Get_Tree()->Get_Node_Count());
+    EXPECT_EQ(mesh.Get_Tree()->Get_Poly_Count(), mesh.Get_Polygon_Count());
+    EXPECT_EQ(expected_mesh.Get_Tree()->Get_Poly_Count(), mesh.Get_Polygon_Count());
+
+    std::vector<LineSegClass> rays = Make_Rays(mesh.Get_Size(), 20000, 2);
+    int hit_count = 0;
+
+    for (const LineSegClass &ray : rays) {
+        CastResultStruct expected;
+        RayCollisionTestClass expected_test(ray, &expected);
+        bool hit = expected_mesh.Cast_Ray(expected_test);
+        hit_count += hit;
+
+        CastResultStruct result;
+        RayCollisionTestClass test(ray, &result);
+        EXPECT_EQ(mesh.Cast_Ray(test), hit);
+        EXPECT_EQ(result.fraction, expected.fraction);
+
+        CastResultStruct same;
+        RayCollisionTestClass same_test(ray, &same);
+        same_mesh.Cast_Ray(same_test);
+        Expect_Same_Result(same, result);
+    }
+
+    EXPECT_GT(hit_count, 1000);
+}
+
+TEST(w3d_aabtree, DISABLED_build_benchmark)
+{
+    using namespace std::chrono;
+
+    std::vector<MeshDataStruct> meshes(1);
+    std::vector<const char *> names = { "cube.w3d", "terrain 16x16", "terrain 96x96", "terrain 256x256" };
+    ASSERT_TRUE(Load_Mesh_Data((std::string(TESTDATA_PATH) + "/models/cube.w3d").c_str(), meshes[0]));
+
+    for (int grid : { 16, 96, 256 }) {
+        TestMeshClass mesh(grid, grid * grid / 2, grid);
+        meshes.emplace_back();
+        meshes.back().verts.assign(mesh.Get_Vertex_Array(), mesh.Get_Vertex_Array() + mesh.Get_Vertex_Count());
+        meshes.back().polys.assign(mesh.Get_Polygon_Array(), mesh.Get_Polygon_Array() + mesh.Get_Polygon_Count());
+    }
+
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        MeshDataStruct &data = meshes[i];
+        Vector3 min = data.verts[0];
+        Vector3 max = data.verts[0];
+
+        for (const Vector3 &vert : data.verts) {
+            min.Update_Min(vert);
+            max.Update_Max(vert);
+        }
+
+        // Picking rays from above the mesh and rays through its bounds from all sides.
+        std::mt19937 rng(static_cast<unsigned>(i));
+        std::uniform_real_distribution<float> unit(-0.1f, 1.1f);
+        std::vector<LineSegClass> rays;
+
+        for (int r = 0; r < 10000; ++r) {
+            Vector3 start(min.X + (max.X - min.X) * unit(rng),
+                min.Y + (max.Y - min.Y) * unit(rng),
+                min.Z + (max.Z - min.Z) * unit(rng));
+            Vector3 end(min.X + (max.X - min.X) * unit(rng),
+                min.Y + (max.Y - min.Y) * unit(rng),
+                min.Z + (max.Z - min.Z) * unit(rng));
+
+            if (r % 2 == 0) {
+                start.Z = max.Z + 100.0f;
+                end.Set(start.X + (end.X - start.X) * 0.1f, start.Y + (end.Y - start.Y) * 0.1f, min.Z - 1.0f);
+            }
+
+            rays.emplace_back(start, end);
+        }
+
+        long long times[2];
+        double visits[2];
+        int nodes[2];
+        std::vector<CastResultStruct> results[2];
+        std::vector<bool> hits[2];
+
+        for (int method = AABTreeBuilderClass::BUILD_RANDOM_PLANES; method <= AABTreeBuilderClass::BUILD_BINNED_SAH;
+             ++method) {
+            AABTreeBuilderClass::Set_Build_Method(AABTreeBuilderClass::BuildMethodType(method));
+            AABTreeBuilderClass builder;
+            auto start = steady_clock::now();
+            builder.Build_AABTree(int(data.polys.size()), data.polys.data(), int(data.verts.size()), data.verts.data());
+            times[method] = (long long)duration_cast<microseconds>(steady_clock::now() - start).count();
+            nodes[method] = builder.Node_Count();
+            EXPECT_EQ(builder.Poly_Count(), int(data.polys.size()));
+            long long count = 0;
+
+            for (const LineSegClass &ray : rays) {
+                count += builder.Count_Ray_Visits(ray);
+            }
+
+            visits[method] = double(count) / rays.size();
+
+            // Both trees must find the same first hit for every ray.
+            DataMeshClass mesh(data);
+            results[method].resize(rays.size());
+
+            for (size_t r = 0; r < rays.size(); ++r) {
+                RayCollisionTestClass raytest(rays[r], &results[method][r]);
+                hits[method].push_back(mesh.Cast_Ray(raytest));
+            }
+        }
+
+        int hit_count = 0;
+
+        for (size_t r = 0; r < rays.size(); ++r) {
+            EXPECT_EQ(hits[1][r], hits[0][r]);
+            EXPECT_EQ(results[1][r].fraction, results[0][r].fraction);
+            hit_count += hits[0][r];
+        }
+
+        EXPECT_GT(hit_count, 0);
+
+        captainslog_info("Built %s with %d polygons, random planes %lld us, %d nodes, %.1f visits per ray, binned SAH "
+                         "%lld us, %d nodes, %.1f visits per ray",
+            names[i],
+            int(data.polys.size()),
+            times[0],
+            nodes[0],
+            visits[0],
+            times[1],
+            nodes[1],
+            visits[1]);
+
+        if (data.polys.size() > 1000) {
+            EXPECT_LT(visits[1], visits[0]);
+        }
+    }
+
+    AABTreeBuilderClass::Set_Build_Method(AABTreeBuilderClass::BUILD_BINNED_SAH);
+}
+
+TEST(w3d_aabtree, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    TestMeshClass mesh(96, 10000, 3);
+    std::vector<LineSegClass> rays = Make_Camera_Rays(mesh.Get_Size(), 50, 1024, 5);
+    std::vector<CastResultStruct> results(rays.size());
+    std::vector<RayCollisionTestClass *> tests;
+
+    for (size_t i = 0; i < rays.size(); ++i) {
+        tests.push_back(new RayCollisionTestClass(rays[i], &results[i]));
+    }
+
+    long long times[3];
+    int hits[3] = {};
+    std::vector<CastResultStruct> expected;
+
+    for (int run = 0; run < 3; ++run) {
+        AABTreeClass::Set_Quad_Nodes_Enabled(run != 0);
+
+        for (CastResultStruct &result : results) {
+            result.Reset();
+        }
+
+        auto start = steady_clock::now();
+
+        if (run == 2) {
+            hits[run] = mesh.Get_Tree()->Cast_Rays(tests.data(), int(tests.size()));
+        } else {
+            for (RayCollisionTestClass *test : tests) {
+                hits[run] += mesh.Cast_Ray(*test);
+            }
+        }
+
+        times[run] = (long long)duration_cast<microseconds>(steady_clock::now() - start).count();
+
+        // The flattened and packet queries must give the recursive result for every ray.
+        if (run == 0) {
+            expected = results;
+        } else {
+            for (size_t i = 0; i < results.size(); ++i) {
+                Expect_Same_Result(results[i], expected[i]);
+            }
+        }
+    }
+
+    EXPECT_GT(hits[0], 0);
+    EXPECT_EQ(hits[1], hits[0]);
+    EXPECT_EQ(hits[2], hits[0]);
+    captainslog_info("Cast %d rays at %d polygons, recursive %lld us, flattened %lld us, packets %lld us",
+        int(rays.size()),
+        mesh.Get_Polygon_Count(),
+        times[0],
+        times[1],
+        times[2]);
+
+    for (RayCollisionTestClass *test : tests) {
+        delete test;
+    }
+}
@@ -0,0 +1,714 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate sampling of compressed animation channels and posing of trees
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <gtest/gtest.h>
+
+#include "assetmgr.h"
+#include "chunkio.h"
+#include "hanim.h"
+#include "htree.h"
+#include "motchan.h"
+#include "rawfile.h"
+#include "w3d_file.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct TimeCodedKey
+{
+    uint32_t frame;
+    bool interpolated;
+    float value[4];
+};
+
+// Random keys starting at frame 0, every key is either stepped to or interpolated to from the previous one.
+std::vector<TimeCodedKey> Make_Keys(std::mt19937 &rng, int count, int vector_len)
+{
+    std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+    std::vector<TimeCodedKey> keys(count);
+    uint32_t frame = 0;
+
+    for (TimeCodedKey &key : keys) {
+        key.frame = frame;
+        key.interpolated = (rng() & 3) != 0;
+
+        for (int i = 0; i < vector_len; ++i) {
+            key.value[i] = dist(rng);
+        }
+
+        frame += 1 + rng() % 4;
+    }
+
+    return keys;
+}
+
+// Writes the channel chunk to a file and loads it back the way HCompressedAnimClass reads it.
+template<typename ChannelType>
+bool Load_Channel(ChannelType &channel, int chunk_id, const void *header, int header_size, const std::vector<uint32_t> &data)
+{
+    const char *filename = "test_w3d_anim.tmp";
+    RawFileClass file(filename);
+
+    if (!file.Open(FM_WRITE)) {
+        return false;
+    }
+
+    ChunkSaveClass csave(&file);
+    csave.Begin_Chunk(chunk_id);
+    csave.Write(header, header_size);
+    csave.Write(data.data(), unsigned(data.size() * sizeof(uint32_t)));
+    csave.End_Chunk();
+    file.Close();
+
+    if (!file.Open(FM_READ)) {
+        return false;
+    }
+
+    ChunkLoadClass cload(&file);
+    bool loaded = cload.Open_Chunk() && channel.Load_W3D(cload);
+    cload.Close_Chunk();
+    file.Close();
+    file.Delete();
+
+    return loaded;
+}
+
+bool Load_Motion_Channel(TimeCodedMotionChannelClass &channel, const std::vector<TimeCodedKey> &keys, int vector_len)
+{
+    // The header ends in the first word of the data.
+    W3dTimeCodedAnimChannelStruct chan;
+    chan.NumTimeCodes = uint32_t(keys.size());
+    chan.Pivot = 1;
+    chan.VectorLen = uint8_t(vector_len);
+    chan.Flags = vector_len == 4 ? ANIM_CHANNEL_Q : ANIM_CHANNEL_X;
+    std::vector<uint32_t> data;
+
+    for (const TimeCodedKey &key : keys) {
+        data.push_back(key.frame | (key.interpolated ? 0x80000000 : 0));
+
+        for (int i = 0; i < vector_len; ++i) {
+            uint32_t word;
+            memcpy(&word, &key.value[i], sizeof(word));
+            data.push_back(word);
+        }
+    }
+
+    chan.Data[0] = data[0];
+    data.erase(data.begin());
+
+    return Load_Channel(channel, W3D_CHUNK_COMPRESSED_ANIMATION_CHANNEL, &chan, sizeof(chan), data);
+}
+
+// A chain of pivots with every other one hanging off the root.
+void Save_Tree(ChunkSaveClass &csave, const char *name, int num_pivots)
+{
+    W3dHierarchyStruct header = {};
+    header.Version = 0x40001;
+    strcpy(header.Name, name);
+    header.NumPivots = num_pivots;
+    csave.Begin_Chunk(W3D_CHUNK_HIERARCHY_HEADER);
+    csave.Write(&header, sizeof(header));
+    csave.End_Chunk();
+    csave.Begin_Chunk(W3D_CHUNK_PIVOTS);
+
+    for (int i = 0; i < num_pivots; ++i) {
+        W3dPivotStruct pivot = {};
+        pivot.ParentIdx = i == 0 ? uint32_t(-1) : (i & 1) ? i - 1 : 0;
+        pivot.Translation.x = float(i);
+        pivot.Translation.z = 0.5f;
+        pivot.Rotation.q[2] = sinf(0.1f * i);
+        pivot.Rotation.q[3] = cosf(0.1f * i);
+        csave.Write(&pivot, sizeof(pivot));
+    }
+
+    csave.End_Chunk();
+}
+
+bool Load_Tree(HTreeClass &tree, int num_pivots)
+{
+    const char *filename = "test_w3d_anim.tmp";
+    RawFileClass file(filename);
+
+    if (!file.Open(FM_WRITE)) {
+        return false;
+    }
+
+    ChunkSaveClass csave(&file);
+    Save_Tree(csave, "TESTTREE", num_pivots);
+    file.Close();
+
+    if (!file.Open(FM_READ)) {
+        return false;
+    }
+
+    ChunkLoadClass cload(&file);
+    bool loaded = tree.Load_W3D(cload) == 0;
+    file.Close();
+    file.Delete();
+
+    return loaded;
+}
+
+// Writes the tree to <name>.w3d where the asset manager looks for it.
+bool Write_Tree_File(const char *name, int num_pivots)
+{
+    RawFileClass file((std::string(name) + ".w3d").c_str());
+
+    if (!file.Open(FM_WRITE)) {
+        return false;
+    }
+
+    ChunkSaveClass csave(&file);
+    csave.Begin_Chunk(W3D_CHUNK_HIERARCHY);
+    Save_Tree(csave, name, num_pivots);
+    csave.End_Chunk();
+    file.Close();
+
+    return true;
+}
+
+float Anim_Value(int anim, int pivot, int frame)
+{
+    return anim * 1000.0f + pivot * 100.0f + frame;
+}
+
+// Writes an animation moving every pivot along X to <name>.w3d.
+bool Write_Anim_File(const char *tree, const char *name, int anim, int num_pivots, int num_frames)
+{
+    RawFileClass file((std::string(name) + ".w3d").c_str());
+
+    if (!file.Open(FM_WRITE)) {
+        return false;
+    }
+
+    W3dAnimHeaderStruct header = {};
+    header.Version = 0x40001;
+    strcpy(header.Name, name);
+    strcpy(header.HierarchyName, tree);
+    header.NumFrames = num_frames;
+    header.FrameRate = 30;
+    ChunkSaveClass csave(&file);
+    csave.Begin_Chunk(W3D_CHUNK_ANIMATION);
+    csave.Begin_Chunk(W3D_CHUNK_ANIMATION_HEADER);
+    csave.Write(&header, sizeof(header));
+    csave.End_Chunk();
+
+    for (int pivot = 0; pivot < num_pivots; ++pivot) {
+        W3dAnimChannelStruct chan = {};
+        chan.LastFrame = uint16_t(num_frames - 1);
+        chan.VectorLen = 1;
+        chan.Flags = ANIM_CHANNEL_X;
+        chan.Pivot = uint16_t(pivot);
+        chan.Data[0] = Anim_Value(anim, pivot, 0);
+        csave.Begin_Chunk(W3D_CHUNK_ANIMATION_CHANNEL);
+        csave.Write(&chan, sizeof(chan));
+
+        for (int frame = 1; frame < num_frames; ++frame) {
+            float value = Anim_Value(anim, pivot, frame);
+            csave.Write(&value, sizeof(value));
+        }
+
+        csave.End_Chunk();
+    }
+
+    csave.End_Chunk();
+    file.Close();
+
+    return true;
+}
+
+// Moves every pivot along a curve of the frame, so each frame gives a different pose.
+class WaveAnimClass : public HAnimClass
+{
+public:
+    WaveAnimClass(int num_pivots) : m_numPivots(num_pivots) {}
+    const char *Get_Name() const override { return "TESTTREE.WAVE"; }
+    const char *Get_HName() const override { return "TESTTREE"; }
+    int Get_Num_Frames() override { return 30; }
+    float Get_Frame_Rate() override { return 30.0f; }
+    float Get_Total_Time() override { return 1.0f; }
+
+    void Get_Translation(Vector3 &trans, int pividx, float frame) const override
+    {
+        trans.Set(sinf(frame + pividx), cosf(frame * 0.5f), float(pividx) * 0.1f);
+    }
+
+    void Get_Orientation(Quaternion &q, int pividx, float frame) const override
+    {
+        float angle = 0.2f * frame + 0.3f * pividx;
+        q.Set(sinf(angle) * 0.6f, 0.0f, sinf(angle) * 0.8f, cosf(angle));
+    }
+
+    void Get_Transform(Matrix3D &mtx, int pividx, float frame) const override
+    {
+        Quaternion q;
+        Vector3 trans;
+        Get_Orientation(q, pividx, frame);
+        Get_Translation(trans, pividx, frame);
+        mtx = Build_Matrix3D(q);
+        mtx.Set_Translation(trans);
+    }
+
+    bool Get_Visibility(int pividx, float frame) override { return (pividx + int(frame)) % 3 != 0; }
+    int Get_Num_Pivots() const override { return m_numPivots; }
+    bool Is_Node_Motion_Present(int pividx) override { return true; }
+
+private:
+    int m_numPivots;
+};
+
+std::vector<Matrix3D> Get_Transforms(const HTreeClass &tree)
+{
+    std::vector<Matrix3D> transforms;
+
+    for (int i = 0; i < tree.Num_Pivots(); ++i) {
+        transforms.push_back(tree.Get_Transform(i));
+    }
+
+    return transforms;
+}
+
+void Expect_Same_Pose(const HTreeClass &tree, const std::vector<Matrix3D> &expected)
+{
+    ASSERT_EQ(tree.Num_Pivots(), int(expected.size()));
+
+    for (int i = 0; i < tree.Num_Pivots(); ++i) {
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 4; ++col) {
+                EXPECT_NEAR(tree.Get_Transform(i)[row][col], expected[i][row][col], 1e-4f);
+            }
+        }
+    }
+}
+
+// What the channel should give, found without any caching.
+float Expected_Value(const std::vector<TimeCodedKey> &keys, float frame)
+{
+    size_t key = 0;
+
+    while (key + 1 < keys.size() && keys[key + 1].frame <= uint32_t(frame)) {
+        ++key;
+    }
+
+    if (key + 1 == keys.size() || !keys[key + 1].interpolated) {
+        return keys[key].value[0];
+    }
+
+    float t = (frame - keys[key].frame) / (keys[key + 1].frame - keys[key].frame);
+
+    return keys[key].value[0] + (keys[key + 1].value[0] - keys[key].value[0]) * t;
+}
+} // namespace
+
+TEST(w3d_anim, timecoded_cursor)
+{
+    std::mt19937 rng(44);
+
+    for (int count : { 1, 2, 3, 50 }) {
+        std::vector<TimeCodedKey> keys = Make_Keys(rng, count, 1);
+        TimeCodedMotionChannelClass channel;
+        ASSERT_TRUE(Load_Motion_Channel(channel, keys, 1));
+        float last_frame = float(keys.back().frame + 3);
+
+        // Playing forward, backwards and jumping around, with cursors that start out anywhere.
+        std::vector<float> frames;
+
+        for (float frame = 0.0f; frame <= last_frame; frame += 0.25f) {
+            frames.push_back(frame);
+        }
+
+        for (float frame = last_frame; frame >= 0.0f; frame -= 0.5f) {
+            frames.push_back(frame);
+        }
+
+        for (int i = 0; i < 200; ++i) {
+            frames.push_back(std::uniform_real_distribution<float>(0.0f, last_frame)(rng));
+        }
+
+        for (unsigned int start : { 0u, 1u, unsigned(count - 1), unsigned(count), 12345u }) {
+            unsigned int cursor = start;
+
+            for (float frame : frames) {
+                float expected = Expected_Value(keys, frame);
+                float value = 0.0f;
+                channel.Get_Vector(frame, &value, cursor);
+                EXPECT_NEAR(value, expected, 1e-4f);
+                EXPECT_LT(cursor, unsigned(count));
+                value = 0.0f;
+                channel.Get_Vector(frame, &value);
+                EXPECT_NEAR(value, expected, 1e-4f);
+            }
+        }
+    }
+}
+
+TEST(w3d_anim, timecoded_quaternion_cursor)
+{
+    std::mt19937 rng(4);
+    std::vector<TimeCodedKey> keys = Make_Keys(rng, 40, 4);
+
+    for (TimeCodedKey &key : keys) {
+        Quaternion q(key.value[0], key.value[1], key.value[2], key.value[3]);
+        q.Normalize();
+        key.value[0] = q.X;
+        key.value[1] = q.Y;
+        key.value[2] = q.Z;
+        key.value[3] = q.W;
+    }
+
+    TimeCodedMotionChannelClass channel;
+    ASSERT_TRUE(Load_Motion_Channel(channel, keys, 4));
+    unsigned int cursor = 0;
+
+    for (float frame = 0.0f; frame <= keys.back().frame + 2.0f; frame += 0.3f) {
+        Quaternion expected = channel.Get_Quat_Vector(frame);
+        Quaternion q = channel.Get_Quat_Vector(frame, cursor);
+        EXPECT_EQ(q.X, expected.X);
+        EXPECT_EQ(q.Y, expected.Y);
+        EXPECT_EQ(q.Z, expected.Z);
+        EXPECT_EQ(q.W, expected.W);
+    }
+}
+
+TEST(w3d_anim, timecoded_bit_cursor)
+{
+    std::mt19937 rng(7);
+    W3dTimeCodedBitChannelStruct chan;
+    chan.NumTimeCodes = 30;
+    chan.Pivot = 1;
+    chan.Flags = BIT_CHANNEL_VIS;
+    chan.DefaultVal = 1;
+    std::vector<uint32_t> data;
+    std::vector<int> bits;
+    uint32_t frame = 0;
+
+    for (uint32_t i = 0; i < chan.NumTimeCodes; ++i) {
+        uint32_t bit = rng() & 1;
+        data.push_back(frame | (bit << 31));
+        bits.resize(frame + 1 + rng() % 5, bit);
+        frame = uint32_t(bits.size());
+    }
+
+    chan.Data[0] = data[0];
+    data.erase(data.begin());
+    TimeCodedBitChannelClass channel;
+    ASSERT_TRUE(Load_Channel(channel, W3D_CHUNK_COMPRESSED_BIT_CHANNEL, &chan, sizeof(chan), data));
+
+    for (unsigned int start : { 0u, 29u, 500u }) {
+        unsigned int cursor = start;
+
+        for (int i = 0; i < int(bits.size()); ++i) {
+            EXPECT_EQ(channel.Get_Bit(i, cursor), bits[i]);
+        }
+
+        for (int i = int(bits.size()) - 1; i >= 0; --i) {
+            EXPECT_EQ(channel.Get_Bit(i, cursor), bits[i]);
+        }
+    }
+}
+
+// Trees copied from the same tree playing the same animation at the same frame share the pose and only differ in their
+// root.
+TEST(w3d_anim, pose_cache)
+{
+    constexpr int PIVOT_COUNT = 24;
+    constexpr int ANIM_PIVOT_COUNT = PIVOT_COUNT - 4;
+
+    HTreeClass source;
+    ASSERT_TRUE(Load_Tree(source, PIVOT_COUNT));
+    HTreeClass first(source);
+    HTreeClass second(source);
+    WaveAnimClass anim(ANIM_PIVOT_COUNT);
+    WaveAnimClass full_anim(PIVOT_COUNT);
+    bool enabled = HTreeClass::Is_Pose_Cache_Enabled();
+
+    Matrix3D first_root(true);
+    first_root.Translate(100.0f, -20.0f, 3.0f);
+    first_root.Rotate_Z(1.2f);
+    Matrix3D second_root(true);
+    second_root.Translate(-7.0f, 55.0f, 0.0f);
+    second_root.Rotate_X(-0.4f);
+    const float frames[] = { 0.0f, 1.5f, 7.25f };
+    std::vector<std::vector<Matrix3D>> first_expected;
+    std::vector<std::vector<Matrix3D>> second_expected;
+    std::vector<std::vector<bool>> visible;
+
+    // The pivots the animation doesn't have keep the visibility the tree last gave them, which differs between the two.
+    HTreeClass::Set_Pose_Cache_Enabled(false);
+    first.Anim_Update(first_root, &full_anim, 0.0f);
+    second.Base_Update(second_root);
+
+    for (float frame : frames) {
+        first.Anim_Update(first_root, &anim, frame);
+        first_expected.push_back(Get_Transforms(first));
+        second.Anim_Update(second_root, &anim, frame);
+        second_expected.push_back(Get_Transforms(second));
+        visible.emplace_back();
+
+        for (int i = 0; i < PIVOT_COUNT; ++i) {
+            visible.back().push_back(second.Get_Visibility(i));
+        }
+    }
+
+    EXPECT_FALSE(first.Get_Visibility(ANIM_PIVOT_COUNT + 1));
+    EXPECT_TRUE(second.Get_Visibility(ANIM_PIVOT_COUNT + 1));
+
+    HTreeClass::Set_Pose_Cache_Enabled(true);
+    HTreeClass::Reset_Pose_Cache();
+
+    for (size_t i = 0; i < first_expected.size(); ++i) {
+        first.Anim_Update(first_root, &anim, frames[i]);
+        Expect_Same_Pose(first, first_expected[i]);
+        second.Anim_Update(second_root, &anim, frames[i]);
+        Expect_Same_Pose(second, second_expected[i]);
+
+        for (int j = 0; j < PIVOT_COUNT; ++j) {
+            EXPECT_EQ(second.Get_Visibility(j), visible[i][j]);
+        }
+    }
+
+    HTreePoseCacheStatsStruct stats = HTreeClass::Get_Pose_Cache_Stats();
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.hits, 3u);
+
+    // Frames are matched exactly, a slightly different one is posed on its own.
+    second.Anim_Update(second_root, &anim, frames[2] + 0.01f);
+    stats = HTreeClass::Get_Pose_Cache_Stats();
+    EXPECT_EQ(stats.misses, 4u);
+    EXPECT_EQ(stats.hits, 3u);
+
+    // A tree that wasn't copied from the same one may have a different skeleton under the same name.
+    HTreeClass other;
+    ASSERT_TRUE(Load_Tree(other, PIVOT_COUNT));
+    other.Anim_Update(first_root, &anim, frames[2]);
+    Expect_Same_Pose(other, first_expected[2]);
+    stats = HTreeClass::Get_Pose_Cache_Stats();
+    EXPECT_EQ(stats.misses, 5u);
+    EXPECT_EQ(stats.hits, 3u);
+
+    // Captured bones are posed by their owner, such trees don't take part.
+    second.Capture_Bone(3);
+    second.Anim_Update(second_root, &anim, frames[1]);
+    second.Release_Bone(3);
+    stats = HTreeClass::Get_Pose_Cache_Stats();
+    EXPECT_EQ(stats.misses, 5u);
+    EXPECT_EQ(stats.hits, 3u);
+
+    HTreeClass::Set_Pose_Cache_Enabled(enabled);
+    HTreeClass::Reset_Pose_Cache();
+}
+
+// A crowd of units where groups of them were told to play the animation on the same frame.
+TEST(w3d_anim, DISABLED_pose_cache_benchmark)
+{
+    using namespace std::chrono;
+
+    constexpr int UNIT_COUNT = 200;
+    constexpr int GROUP_COUNT = 10;
+    constexpr int PIVOT_COUNT = 50;
+    constexpr int FRAME_COUNT = 100;
+
+    HTreeClass source;
+    ASSERT_TRUE(Load_Tree(source, PIVOT_COUNT));
+    std::vector<HTreeClass> trees(UNIT_COUNT, source);
+    WaveAnimClass anim(PIVOT_COUNT);
+    bool enabled = HTreeClass::Is_Pose_Cache_Enabled();
+    long long times[2];
+    std::vector<std::vector<Matrix3D>> uncached;
+
+    for (int cached = 0; cached < 2; ++cached) {
+        HTreeClass::Set_Pose_Cache_Enabled(cached != 0);
+        HTreeClass::Reset_Pose_Cache();
+        auto start = steady_clock::now();
+
+        for (int frame = 0; frame < FRAME_COUNT; ++frame) {
+            for (int unit = 0; unit < UNIT_COUNT; ++unit) {
+                Matrix3D root(true);
+                root.Translate(float(unit), float(unit % 7), 0.0f);
+                trees[unit].Anim_Update(root, &anim, float(frame % 30) + float(unit % GROUP_COUNT) * 0.125f);
+            }
+        }
+
+        times[cached] = (long long)duration_cast<microseconds>(steady_clock::now() - start).count();
+
+        if (!cached) {
+            for (const HTreeClass &tree : trees) {
+                uncached.push_back(Get_Transforms(tree));
+            }
+        }
+    }
+
+    // Sharing poses must not change them.
+    for (int unit = 0; unit < UNIT_COUNT; ++unit) {
+        Expect_Same_Pose(trees[unit], uncached[unit]);
+    }
+
+    HTreePoseCacheStatsStruct stats = HTreeClass::Get_Pose_Cache_Stats();
+    EXPECT_EQ(stats.hits + stats.misses, unsigned(UNIT_COUNT * FRAME_COUNT));
+    EXPECT_GT(stats.hits, stats.misses);
+    captainslog_info("Posed %d trees of %d pivots over %d frames, uncached %lld us, cached %lld us, %u hits, %u misses",
+        UNIT_COUNT,
+        PIVOT_COUNT,
+        FRAME_COUNT,
+        times[0],
+        times[1],
+        stats.hits,
+        stats.misses);
+
+    HTreeClass::Set_Pose_Cache_Enabled(enabled);
+    HTreeClass::Reset_Pose_Cache();
+}
+
+// Many units playing the same animation at different frames share the channels. With only the cache in the channel every
+// sample searches all keys again, each unit's own cursor finds the key right away.
+TEST(w3d_anim, DISABLED_timecoded_cursor_benchmark)
+{
+    using namespace std::chrono;
+
+    constexpr int UNIT_COUNT = 200;
+    constexpr int CHANNEL_COUNT = 128;
+    constexpr int FRAME_COUNT = 100;
+
+    std::mt19937 rng(300);
+    std::vector<TimeCodedKey> keys = Make_Keys(rng, 1000, 1);
+    std::vector<TimeCodedMotionChannelClass> channels(CHANNEL_COUNT);
+
+    for (TimeCodedMotionChannelClass &channel : channels) {
+        ASSERT_TRUE(Load_Motion_Channel(channel, keys, 1));
+    }
+
+    float length = float(keys.back().frame);
+    std::vector<float> phases(UNIT_COUNT);
+    std::vector<unsigned int> cursors(UNIT_COUNT * CHANNEL_COUNT, 0);
+
+    for (int unit = 0; unit < UNIT_COUNT; ++unit) {
+        phases[unit] = length * unit / UNIT_COUNT;
+    }
+
+    float shared_sum = 0.0f;
+    float cursor_sum = 0.0f;
+    auto start = steady_clock::now();
+
+    for (int frame = 0; frame < FRAME_COUNT; ++frame) {
+        for (int unit = 0; unit < UNIT_COUNT; ++unit) {
+            float time = fmodf(phases[unit] + frame * 0.5f, length);
+
+            for (TimeCodedMotionChannelClass &channel : channels) {
+                float value;
+                channel.Get_Vector(time, &value);
+                shared_sum += value;
+            }
+        }
+    }
+
+    auto shared_time = duration_cast<microseconds>(steady_clock::now() - start);
+    start = steady_clock::now();
+
+    for (int frame = 0; frame < FRAME_COUNT; ++frame) {
+        for (int unit = 0; unit < UNIT_COUNT; ++unit) {
+            float time = fmodf(phases[unit] + frame * 0.5f, length);
+            unsigned int *cursor = &cursors[unit * CHANNEL_COUNT];
+
+            for (TimeCodedMotionChannelClass &channel : channels) {
+                float value;
+                channel.Get_Vector(time, &value, *cursor++);
+                cursor_sum += value;
+            }
+        }
+    }
+
+    auto cursor_time = duration_cast<microseconds>(steady_clock::now() - start);
+    EXPECT_FLOAT_EQ(cursor_sum, shared_sum);
+    captainslog_info("Sampled %d channels for %d units over %d frames, shared cache %lld us, per unit cursors %lld us",
+        CHANNEL_COUNT,
+        UNIT_COUNT,
+        FRAME_COUNT,
+        (long long)shared_time.count(),
+        (long long)cursor_time.count());
+}
+
+// Trees and animations parsed on the prefetch threads must match what loading on demand gives, without loading
+// anything once the prefetch is done.
+TEST(w3d_anim, prefetch_assets)
+{
+    constexpr int NUM_PIVOTS = 5;
+    constexpr int NUM_FRAMES = 8;
+    constexpr int NUM_ANIMS = 12;
+
+    ASSERT_TRUE(Write_Tree_File("PFSKL", NUM_PIVOTS));
+    DynamicVectorClass<StringClass> anims;
+
+    for (int i = 0; i < NUM_ANIMS; ++i) {
+        StringClass name;
+        name.Format("PFANIM%d", i);
+        ASSERT_TRUE(Write_Anim_File("PFSKL", name, i, NUM_PIVOTS, NUM_FRAMES));
+        anims.Add(StringClass("PFSKL.") + name);
+    }
+
+    // The second pass only asks for the animations, their tree is then loaded on demand before they are parsed.
+    for (int pass = 0; pass < 2; ++pass) {
+        W3DAssetManager assetmngr;
+        assetmngr.Set_W3D_Load_On_Demand(true);
+        DynamicVectorClass<StringClass> names;
+
+        if (pass == 0) {
+            names.Add("PFSKL");
+        }
+
+        for (int i = 0; i < anims.Count(); ++i) {
+            names.Add(anims[i]);
+        }
+
+        names.Add("PFSKL.PFMISSING");
+        assetmngr.Prefetch_3D_Assets(names);
+        assetmngr.Set_W3D_Load_On_Demand(false);
+
+        HTreeClass *tree = assetmngr.Get_HTree("PFSKL");
+        ASSERT_NE(tree, nullptr);
+        EXPECT_EQ(tree->Num_Pivots(), NUM_PIVOTS);
+
+        for (int i = 0; i < anims.Count(); ++i) {
+            HAnimClass *anim = assetmngr.Get_HAnim(anims[i]);
+            ASSERT_NE(anim, nullptr);
+            EXPECT_STREQ(anim->Get_Name(), anims[i]);
+            EXPECT_EQ(anim->Get_Num_Frames(), NUM_FRAMES);
+            EXPECT_EQ(anim->Get_Num_Pivots(), NUM_PIVOTS);
+
+            for (int pivot = 0; pivot < NUM_PIVOTS; ++pivot) {
+                for (int frame = 0; frame < NUM_FRAMES; ++frame) {
+                    Vector3 trans;
+                    anim->Get_Translation(trans, pivot, float(frame));
+                    EXPECT_NEAR(trans.X, Anim_Value(i, pivot, frame), 1e-3f);
+                }
+            }
+
+            anim->Release_Ref();
+        }
+
+        EXPECT_EQ(assetmngr.Get_HAnim("PFSKL.PFMISSING"), nullptr);
+    }
+
+    RawFileClass("PFSKL.w3d").Delete();
+
+    for (int i = 0; i < anims.Count(); ++i) {
+        RawFileClass((strchr(anims[i], '.') + 1 + std::string(".w3d")).c_str()).Delete();
+    }
+}
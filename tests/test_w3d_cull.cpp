@@ -0,0 +1,212 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate and benchmark the batched sphere culling against the camera.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "camera.h"
+#include "spherecull.h"
+
+namespace
+{
+// Roughly the extent of a large map with the RTS camera looking down at part of it.
+constexpr float SCENE_SIZE = 4000.0f;
+constexpr int SCENE_OBJECTS = 20000;
+constexpr int BENCHMARK_FRAMES = 50;
+
+std::vector<SphereClass> Make_Random_Scene(int count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> pos(0.0f, SCENE_SIZE);
+    std::uniform_real_distribution<float> height(0.0f, 50.0f);
+    std::uniform_real_distribution<float> radius(1.0f, 40.0f);
+    std::vector<SphereClass> spheres;
+
+    for (int i = 0; i < count; ++i) {
+        spheres.emplace_back(Vector3(pos(gen), pos(gen), height(gen)), radius(gen));
+    }
+
+    return spheres;
+}
+
+void Setup_Camera(CameraClass &camera, float x, float y)
+{
+    Matrix3D tm;
+    tm.Look_At(Vector3(x, y - 300.0f, 400.0f), Vector3(x, y, 0.0f), 0.0f);
+    camera.Set_Transform(tm);
+    camera.Set_Clip_Planes(1.0f, 1200.0f);
+}
+} // namespace
+
+TEST(w3d_cull, list_matches_camera)
+{
+    CameraClass camera;
+    std::vector<SphereClass> spheres = Make_Random_Scene(SCENE_OBJECTS, 1234);
+    SphereCullListClass list;
+
+    for (const SphereClass &sphere : spheres) {
+        list.Add(sphere);
+    }
+
+    for (int frame = 0; frame < 8; ++frame) {
+        Setup_Camera(camera, 500.0f * frame, 400.0f * frame);
+        int visible = list.Cull(camera.Get_Frustum());
+        int expected = 0;
+
+        for (int i = 0; i < list.Count(); ++i) {
+            bool camera_visible = !camera.Cull_Sphere(spheres[i]);
+            expected += camera_visible;
+            ASSERT_EQ(list.Is_Visible(i), camera_visible) << "Sphere " << i << " in frame " << frame;
+        }
+
+        EXPECT_EQ(visible, expected);
+    }
+}
+
+TEST(w3d_cull, grid_matches_camera)
+{
+    CameraClass camera;
+    std::vector<SphereClass> spheres = Make_Random_Scene(SCENE_OBJECTS, 5678);
+    SphereCullGridClass grid;
+
+    for (const SphereClass &sphere : spheres) {
+        grid.Add(sphere);
+    }
+
+    // Move a few spheres after the grid has been built to check the cell bounds follow them.
+    Setup_Camera(camera, 0.0f, 0.0f);
+    grid.Cull(camera.Get_Frustum());
+
+    for (int i = 0; i < SCENE_OBJECTS; i += 97) {
+        spheres[i].Center = Vector3(SCENE_SIZE - spheres[i].Center.X, spheres[i].Center.Y, spheres[i].Center.Z);
+        grid.Set(i, spheres[i]);
+    }
+
+    for (int frame = 0; frame < 8; ++frame) {
+        Setup_Camera(camera, 500.0f * frame, 400.0f * frame);
+        grid.Cull(camera.Get_Frustum());
+
+        for (int i = 0; i < grid.Count(); ++i) {
+            ASSERT_EQ(grid.Is_Visible(i), !camera.Cull_Sphere(spheres[i])) << "Sphere " << i << " in frame " << frame;
+        }
+    }
+
+    EXPECT_GT(grid.Get_Cell_Count(), 1);
+}
+
+TEST(w3d_cull, grid_removal)
+{
+    CameraClass camera;
+    std::vector<SphereClass> original = Make_Random_Scene(SCENE_OBJECTS, 8765);
+    std::vector<SphereClass> spheres = original;
+    std::vector<int> rejected;
+    SphereCullGridClass grid;
+
+    for (const SphereClass &sphere : spheres) {
+        grid.Add(sphere);
+    }
+
+    for (int frame = 0; frame < 8; ++frame) {
+        Setup_Camera(camera, 500.0f * frame, 400.0f * frame);
+        grid.Cull(camera.Get_Frustum());
+        rejected.push_back(grid.Get_Cells_Rejected());
+    }
+
+    // Removed trees and props get a unit sphere at the origin, which must not stretch the bounds of their cell.
+    for (int i = 0; i < SCENE_OBJECTS; i += 13) {
+        spheres[i] = SphereClass(Vector3(0.0f, 0.0f, 0.0f), 1.0f);
+        grid.Set(i, spheres[i]);
+        grid.Remove(i);
+    }
+
+    // Bring a few back to check they are culled again.
+    for (int i = 0; i < SCENE_OBJECTS; i += 13 * 7) {
+        spheres[i] = original[i];
+        grid.Set(i, spheres[i]);
+    }
+
+    for (int frame = 0; frame < 8; ++frame) {
+        Setup_Camera(camera, 500.0f * frame, 400.0f * frame);
+        int visible = grid.Cull(camera.Get_Frustum());
+        int expected = 0;
+
+        for (int i = 0; i < grid.Count(); ++i) {
+            bool removed = i % 13 == 0 && i % (13 * 7) != 0;
+            bool camera_visible = !removed && !camera.Cull_Sphere(spheres[i]);
+            expected += camera_visible;
+            ASSERT_EQ(grid.Is_Visible(i), camera_visible) << "Sphere " << i << " in frame " << frame;
+        }
+
+        EXPECT_EQ(visible, expected);
+        EXPECT_GE(grid.Get_Cells_Rejected(), rejected[frame]) << "Frame " << frame;
+    }
+}
+
+TEST(w3d_cull, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    CameraClass camera;
+    std::vector<SphereClass> spheres = Make_Random_Scene(SCENE_OBJECTS, 4321);
+    SphereCullListClass list;
+    SphereCullGridClass grid;
+
+    for (const SphereClass &sphere : spheres) {
+        list.Add(sphere);
+        grid.Add(sphere);
+    }
+
+    int reference_visible = 0;
+    int list_visible = 0;
+    int grid_visible = 0;
+    int cells_rejected = 0;
+    nanoseconds reference_time(0);
+    nanoseconds list_time(0);
+    nanoseconds grid_time(0);
+
+    for (int frame = 0; frame < BENCHMARK_FRAMES; ++frame) {
+        float t = float(frame) / BENCHMARK_FRAMES;
+        Setup_Camera(camera, SCENE_SIZE * t, SCENE_SIZE * (1.0f - t));
+        const FrustumClass &frustum = camera.Get_Frustum();
+
+        auto start = steady_clock::now();
+        for (const SphereClass &sphere : spheres) {
+            reference_visible += !camera.Cull_Sphere(sphere);
+        }
+        reference_time += steady_clock::now() - start;
+
+        start = steady_clock::now();
+        list_visible += list.Cull(frustum);
+        list_time += steady_clock::now() - start;
+
+        start = steady_clock::now();
+        grid_visible += grid.Cull(frustum);
+        grid_time += steady_clock::now() - start;
+        cells_rejected += grid.Get_Cells_Rejected();
+    }
+
+    EXPECT_EQ(list_visible, reference_visible);
+    EXPECT_EQ(grid_visible, reference_visible);
+
+    captainslog_info("Culled %d spheres over %d frames, %d visible.", SCENE_OBJECTS, BENCHMARK_FRAMES, reference_visible);
+    captainslog_info("Cull_Sphere: %lld us", (long long)duration_cast<microseconds>(reference_time).count());
+    captainslog_info("SphereCullListClass: %lld us", (long long)duration_cast<microseconds>(list_time).count());
+    captainslog_info("SphereCullGridClass: %lld us, %d of %d cells rejected per frame",
+        (long long)duration_cast<microseconds>(grid_time).count(),
+        cells_rejected / BENCHMARK_FRAMES,
+        grid.Get_Cell_Count());
+}
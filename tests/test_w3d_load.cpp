@@ -23,6 +23,10 @@
 #include "meshmdl.h"
 #include "w3d_file.h"
 
+#include <chrono>
+#include <cstring>
+#include <vector>
+
 struct Chunk
 {
     int type;
@@ -115,3 +119,168 @@ TEST(w3d_model, load_model)
 
     cload.Close_Chunk();
 }
+
+namespace
+{
+std::vector<uint8_t> Read_Whole_File(const char *filename)
+{
+    std::vector<uint8_t> data;
+    BufferedFileClass file(filename);
+
+    if (file.Open(FM_READ)) {
+        data.resize(file.Size());
+
+        if (file.Read(data.data(), int(data.size())) != int(data.size())) {
+            data.clear();
+        }
+    }
+
+    return data;
+}
+
+void Load_Mesh(ChunkLoadClass &cload, MeshModelClass &mesh)
+{
+    ASSERT_TRUE(cload.Open_Chunk());
+    ASSERT_EQ(mesh.Load_W3D(cload), W3D_ERROR_OK);
+    cload.Close_Chunk();
+}
+
+void Expect_Same_Mesh(MeshModelClass &mesh, MeshModelClass &expected)
+{
+    ASSERT_EQ(mesh.Get_Polygon_Count(), expected.Get_Polygon_Count());
+    ASSERT_EQ(mesh.Get_Vertex_Count(), expected.Get_Vertex_Count());
+    EXPECT_STREQ(mesh.Get_Name(), expected.Get_Name());
+
+    for (int i = 0; i < mesh.Get_Vertex_Count(); ++i) {
+        EXPECT_EQ(mesh.Get_Vertex_Array()[i], expected.Get_Vertex_Array()[i]);
+    }
+
+    for (int i = 0; i < mesh.Get_Polygon_Count(); ++i) {
+        EXPECT_EQ(mesh.Get_Polygon_Array()[i].I, expected.Get_Polygon_Array()[i].I);
+        EXPECT_EQ(mesh.Get_Polygon_Array()[i].J, expected.Get_Polygon_Array()[i].J);
+        EXPECT_EQ(mesh.Get_Polygon_Array()[i].K, expected.Get_Polygon_Array()[i].K);
+    }
+}
+} // namespace
+
+TEST(w3d_model, validate_buffer_chunk_loader)
+{
+    auto filepath = Utf8String(TESTDATA_PATH) + "/models/cube.w3d";
+    std::vector<uint8_t> data = Read_Whole_File(filepath.Str());
+    ASSERT_FALSE(data.empty());
+    ChunkLoadClass cload(data.data(), unsigned(data.size()));
+
+    // The chunks must look the same as when they are read from the file.
+    validate_chunk(cload, cubemodel);
+    EXPECT_FALSE(cload.Open_Chunk());
+}
+
+TEST(w3d_model, buffer_read_view)
+{
+    auto filepath = Utf8String(TESTDATA_PATH) + "/models/cube.w3d";
+    std::vector<uint8_t> data = Read_Whole_File(filepath.Str());
+    ASSERT_FALSE(data.empty());
+    ChunkLoadClass cload(data.data(), unsigned(data.size()));
+    ASSERT_TRUE(cload.Open_Chunk());
+    ASSERT_TRUE(cload.Open_Chunk());
+    EXPECT_EQ(cload.Cur_Chunk_ID(), W3D_CHUNK_MESH_HEADER3);
+    cload.Close_Chunk();
+    ASSERT_TRUE(cload.Open_Chunk());
+    ASSERT_EQ(cload.Cur_Chunk_ID(), W3D_CHUNK_VERTICES);
+
+    // Vertices are returned in place, not copied.
+    W3dVectorStruct block[4];
+    const void *view = cload.Read_View(block, sizeof(block));
+    EXPECT_GE(static_cast<const uint8_t *>(view), data.data());
+    EXPECT_LT(static_cast<const uint8_t *>(view), data.data() + data.size());
+    EXPECT_EQ(memcmp(view, data.data() + 8 + 8 + 116 + 8, sizeof(block)), 0);
+
+    // Nothing can be read past the end of the chunk.
+    unsigned left = cload.Cur_Chunk_Length() - sizeof(block);
+    std::vector<uint8_t> rest(left + 1);
+    EXPECT_EQ(cload.Read(rest.data(), left + 1), 0u);
+    EXPECT_EQ(cload.Read_View(rest.data(), left + 1), nullptr);
+    EXPECT_EQ(cload.Seek(left + 1), 0u);
+    EXPECT_EQ(cload.Read(rest.data(), left), left);
+    cload.Close_Chunk();
+
+    ASSERT_TRUE(cload.Open_Chunk());
+    EXPECT_EQ(cload.Cur_Chunk_ID(), W3D_CHUNK_VERTEX_NORMALS);
+    cload.Close_Chunk();
+    cload.Close_Chunk();
+
+    // A truncated buffer must not be read past its end either.
+    ChunkLoadClass truncated(data.data(), 20);
+    ASSERT_TRUE(truncated.Open_Chunk());
+    ASSERT_TRUE(truncated.Open_Chunk());
+    EXPECT_EQ(truncated.Cur_Chunk_ID(), W3D_CHUNK_MESH_HEADER3);
+    EXPECT_EQ(truncated.Read(rest.data(), 8), 0u);
+    EXPECT_EQ(truncated.Read(rest.data(), 4), 4u);
+    truncated.Close_Chunk();
+    EXPECT_FALSE(truncated.Open_Chunk());
+}
+
+TEST(w3d_model, load_model_from_buffer)
+{
+    W3DAssetManager assetmngr;
+    auto filepath = Utf8String(TESTDATA_PATH) + "/models/cube.w3d";
+    std::vector<uint8_t> data = Read_Whole_File(filepath.Str());
+    ASSERT_FALSE(data.empty());
+
+    BufferedFileClass file(filepath.Str());
+    ASSERT_TRUE(file.Open(FM_READ));
+    ChunkLoadClass file_cload(&file);
+    MeshModelClass expected;
+    Load_Mesh(file_cload, expected);
+
+    ChunkLoadClass cload(data.data(), unsigned(data.size()));
+    MeshModelClass mesh;
+    Load_Mesh(cload, mesh);
+    Expect_Same_Mesh(mesh, expected);
+}
+
+TEST(w3d_model, DISABLED_buffer_load_benchmark)
+{
+    using namespace std::chrono;
+
+    constexpr int REPEATS = 2000;
+
+    W3DAssetManager assetmngr;
+    auto filepath = Utf8String(TESTDATA_PATH) + "/models/cube.w3d";
+    long long times[2];
+
+    BufferedFileClass expected_file(filepath.Str());
+    ASSERT_TRUE(expected_file.Open(FM_READ));
+    ChunkLoadClass expected_cload(&expected_file);
+    MeshModelClass expected;
+    Load_Mesh(expected_cload, expected);
+
+    for (int mode = 0; mode < 2; ++mode) {
+        auto start = steady_clock::now();
+
+        for (int i = 0; i < REPEATS; ++i) {
+            BufferedFileClass file(filepath.Str());
+            ASSERT_TRUE(file.Open(FM_READ));
+            MeshModelClass mesh;
+
+            if (mode == 0) {
+                ChunkLoadClass cload(&file);
+                Load_Mesh(cload, mesh);
+            } else {
+                std::vector<uint8_t> data(file.Size());
+                ASSERT_EQ(file.Read(data.data(), int(data.size())), int(data.size()));
+                ChunkLoadClass cload(data.data(), unsigned(data.size()));
+                Load_Mesh(cload, mesh);
+            }
+
+            // Only the first load is compared so the check does not show up in the timings.
+            if (i == 0) {
+                Expect_Same_Mesh(mesh, expected);
+            }
+        }
+
+        times[mode] = (long long)duration_cast<microseconds>(steady_clock::now() - start).count();
+    }
+
+    captainslog_info("Loaded cube.w3d %d times, from the file %lld us, from memory %lld us", REPEATS, times[0], times[1]);
+}
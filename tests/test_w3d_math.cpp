@@ -21,7 +21,12 @@
 #include <vector3i.h>
 
 #include <matrix3.h>
+#include <matrix3d.h>
 #include <matrix4.h>
+#include <vp.h>
+
+#include <random>
+#include <vector>
 
 TEST(w3d_math, vector2)
 {
@@ -181,3 +186,63 @@ TEST(w3d_math, matrix4)
     Matrix4 inv = mat.Inverse();
     EXPECT_FLOAT_EQ(inv[0][0], 0.5f);
 }
+
+// The batched transforms must give the same results as transforming one vector at a time, the remainder for every
+// batch width is covered by the different counts.
+TEST(w3d_math, vp_transform)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+    Matrix3D tm(true);
+    tm.Rotate_X(0.3f);
+    tm.Rotate_Y(-1.1f);
+    tm.Rotate_Z(2.2f);
+    tm.Set_Translation(Vector3(5.0f, -17.0f, 42.0f));
+    Matrix4 prj;
+    prj.Init_Perspective(1.0f, 0.75f, 1.0f, 1000.0f);
+    prj = prj * tm;
+
+    for (int count = 0; count < 40; ++count) {
+        std::vector<Vector3> vert(count);
+        std::vector<Vector3> norm(count);
+
+        for (int i = 0; i < count; ++i) {
+            vert[i].Set(dist(rng), dist(rng), dist(rng));
+            norm[i].Set(dist(rng), dist(rng), dist(rng));
+            norm[i].Normalize();
+        }
+
+        std::vector<Vector3> dst_vert(count + 1, Vector3(-1.0f, -1.0f, -1.0f));
+        std::vector<Vector3> dst_norm(count + 1, Vector3(-1.0f, -1.0f, -1.0f));
+        std::vector<Vector4> dst_prj(count + 1, Vector4(-1.0f, -1.0f, -1.0f, -1.0f));
+        VectorProcessorClass::Transform(dst_vert.data(), dst_norm.data(), vert.data(), norm.data(), tm, count);
+        VectorProcessorClass::Transform(dst_prj.data(), vert.data(), prj, count);
+
+        for (int i = 0; i < count; ++i) {
+            Vector3 v = tm * vert[i];
+            Vector3 n = tm.Rotate_Vector(norm[i]);
+            Vector4 p = prj * vert[i];
+
+            for (int j = 0; j < 3; ++j) {
+                EXPECT_NEAR(dst_vert[i][j], v[j], 1e-4f);
+                EXPECT_NEAR(dst_norm[i][j], n[j], 1e-6f);
+            }
+
+            for (int j = 0; j < 4; ++j) {
+                EXPECT_NEAR(dst_prj[i][j], p[j], 1e-4f);
+            }
+        }
+
+        // Nothing past the end is written.
+        EXPECT_EQ(dst_vert[count], Vector3(-1.0f, -1.0f, -1.0f));
+        EXPECT_EQ(dst_norm[count], Vector3(-1.0f, -1.0f, -1.0f));
+        EXPECT_EQ(dst_prj[count], Vector4(-1.0f, -1.0f, -1.0f, -1.0f));
+
+        // Transforming in place works as well.
+        VectorProcessorClass::Transform(vert.data(), vert.data(), tm, count);
+
+        for (int i = 0; i < count; ++i) {
+            EXPECT_EQ(vert[i], dst_vert[i]);
+        }
+    }
+}
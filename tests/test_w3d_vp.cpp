@@ -0,0 +1,256 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate the VectorProcessorClass backends
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <gtest/gtest.h>
+#include <matrix3d.h>
+#include <matrix4.h>
+#include <quat.h>
+#include <vector2.h>
+#include <vector3.h>
+#include <vector4.h>
+#include <vp.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+namespace
+{
+// Everything the functions produce for one set of inputs.
+struct VPResults
+{
+    std::vector<Vector3> vert;
+    std::vector<Vector3> norm;
+    std::vector<Vector3> rotated;
+    std::vector<Vector4> projected;
+    std::vector<Vector2> indexed2;
+    std::vector<Vector3> indexed3;
+    std::vector<Vector4> indexed4;
+    std::vector<unsigned> indexed1;
+    std::vector<Vector4> clamped;
+    std::vector<Vector3> normalized;
+    Vector3 min;
+    Vector3 max;
+    std::vector<float> mul_add;
+    std::vector<float> dot;
+    std::vector<float> clamp_min;
+    std::vector<Matrix3D> matrices;
+};
+
+struct VPInputs
+{
+    VPInputs(int count) :
+        vert(count),
+        norm(count),
+        color(count),
+        values(count),
+        index(count),
+        words(count),
+        uv(count),
+        quat(count),
+        tm(true),
+        prj(true)
+    {
+        std::mt19937 rng(count);
+        std::uniform_real_distribution<float> dist(-100.0f, 100.0f);
+
+        for (int i = 0; i < count; ++i) {
+            vert[i].Set(dist(rng), dist(rng), dist(rng));
+            norm[i].Set(dist(rng), dist(rng), dist(rng));
+            color[i].Set(dist(rng) / 50.0f, dist(rng) / 50.0f, dist(rng) / 50.0f, dist(rng) / 50.0f);
+            uv[i].Set(dist(rng), dist(rng));
+            values[i] = dist(rng);
+            words[i] = unsigned(rng());
+            index[i] = unsigned(rng() % count);
+            quat[i].Set(dist(rng), dist(rng), dist(rng), dist(rng));
+            quat[i].Normalize();
+        }
+
+        // A zero vector must survive normalizing.
+        if (count > 5) {
+            norm[5].Set(0.0f, 0.0f, 0.0f);
+        }
+
+        tm.Rotate_X(0.3f);
+        tm.Rotate_Y(-1.1f);
+        tm.Rotate_Z(2.2f);
+        tm.Set_Translation(Vector3(5.0f, -17.0f, 42.0f));
+        prj.Init_Perspective(1.0f, 0.75f, 1.0f, 1000.0f);
+        prj = prj * tm;
+    }
+
+    std::vector<Vector3> vert;
+    std::vector<Vector3> norm;
+    std::vector<Vector4> color;
+    std::vector<float> values;
+    std::vector<unsigned> index;
+    std::vector<unsigned> words;
+    std::vector<Vector2> uv;
+    std::vector<Quaternion> quat;
+    Matrix3D tm;
+    Matrix4 prj;
+};
+
+void Run_VP(const VPInputs &in, VPResults &out)
+{
+    int count = int(in.vert.size());
+    out.vert.assign(count, Vector3(0.0f, 0.0f, 0.0f));
+    out.norm.assign(count, Vector3(0.0f, 0.0f, 0.0f));
+    out.rotated.assign(count, Vector3(0.0f, 0.0f, 0.0f));
+    out.projected.assign(count, Vector4(0.0f, 0.0f, 0.0f, 0.0f));
+    out.indexed1.assign(count, 0);
+    out.indexed2.assign(count, Vector2(0.0f, 0.0f));
+    out.indexed3.assign(count, Vector3(0.0f, 0.0f, 0.0f));
+    out.indexed4.assign(count, Vector4(0.0f, 0.0f, 0.0f, 0.0f));
+    out.clamped.assign(count, Vector4(0.0f, 0.0f, 0.0f, 0.0f));
+    out.normalized = in.norm;
+    out.mul_add = in.values;
+    out.dot.assign(count, 0.0f);
+    out.clamp_min.assign(count, 0.0f);
+    out.matrices.assign(count, Matrix3D(true));
+
+    VectorProcessorClass::Transform(out.vert.data(), out.norm.data(), in.vert.data(), in.norm.data(), in.tm, count);
+    VectorProcessorClass::TransformNoW(out.rotated.data(), in.vert.data(), in.tm, count);
+    VectorProcessorClass::Transform(out.projected.data(), in.vert.data(), in.prj, count);
+    VectorProcessorClass::CopyIndexed(out.indexed1.data(), in.words.data(), in.index.data(), count);
+    VectorProcessorClass::CopyIndexed(out.indexed2.data(), in.uv.data(), in.index.data(), count);
+    VectorProcessorClass::CopyIndexed(out.indexed3.data(), in.vert.data(), in.index.data(), count);
+    VectorProcessorClass::CopyIndexed(out.indexed4.data(), in.color.data(), in.index.data(), count);
+    VectorProcessorClass::Clamp(out.clamped.data(), in.color.data(), 0.0f, 1.0f, count);
+    VectorProcessorClass::Normalize(out.normalized.data(), count);
+    VectorProcessorClass::MinMax(const_cast<Vector3 *>(in.vert.data()), out.min, out.max, count);
+    VectorProcessorClass::MulAdd(out.mul_add.data(), 0.5f, 0.25f, count);
+    VectorProcessorClass::DotProduct(out.dot.data(), in.norm[0], in.vert.data(), count);
+    VectorProcessorClass::ClampMin(out.clamp_min.data(), const_cast<float *>(in.values.data()), 0.0f, count);
+    VectorProcessorClass::BuildMatrices(out.matrices.data(), in.quat.data(), in.vert.data(), count);
+}
+
+template<typename T> void Expect_Near(const std::vector<T> &a, const std::vector<T> &b, int size, float tolerance)
+{
+    ASSERT_EQ(a.size(), b.size());
+
+    for (size_t i = 0; i < a.size(); ++i) {
+        for (int j = 0; j < size; ++j) {
+            EXPECT_NEAR(a[i][j], b[i][j], tolerance);
+        }
+    }
+}
+} // namespace
+
+// Every backend the CPU supports must give the results of the scalar code, for counts that leave every possible
+// remainder after the wide registers.
+TEST(w3d_vp, kernels)
+{
+    VectorProcessorClass::KernelType best = VectorProcessorClass::Get_Kernel_Type();
+
+    for (int count : { 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 63, 64, 65, 1000 }) {
+        VPInputs in(count);
+        VPResults expected;
+        ASSERT_TRUE(VectorProcessorClass::Set_Kernel_Type(VectorProcessorClass::KERNEL_SCALAR));
+        Run_VP(in, expected);
+
+        for (int type = VectorProcessorClass::KERNEL_SCALAR; type < VectorProcessorClass::KERNEL_COUNT; ++type) {
+            if (!VectorProcessorClass::Set_Kernel_Type(VectorProcessorClass::KernelType(type))) {
+                continue;
+            }
+
+            VPResults results;
+            Run_VP(in, results);
+
+            Expect_Near(results.vert, expected.vert, 3, 1e-4f);
+            Expect_Near(results.norm, expected.norm, 3, 1e-4f);
+            Expect_Near(results.rotated, expected.rotated, 3, 1e-4f);
+            Expect_Near(results.projected, expected.projected, 4, 1e-4f);
+            EXPECT_TRUE(results.indexed1 == expected.indexed1);
+            EXPECT_TRUE(results.indexed2 == expected.indexed2);
+            EXPECT_TRUE(results.indexed3 == expected.indexed3);
+            EXPECT_TRUE(results.indexed4 == expected.indexed4);
+            EXPECT_TRUE(results.clamped == expected.clamped);
+            Expect_Near(results.normalized, expected.normalized, 3, 1e-6f);
+            EXPECT_EQ(results.min, expected.min);
+            EXPECT_EQ(results.max, expected.max);
+            EXPECT_TRUE(results.mul_add == expected.mul_add);
+            EXPECT_TRUE(results.clamp_min == expected.clamp_min);
+
+            for (int i = 0; i < count; ++i) {
+                EXPECT_NEAR(results.dot[i], expected.dot[i], 1e-3f);
+
+                for (int row = 0; row < 3; ++row) {
+                    for (int col = 0; col < 4; ++col) {
+                        EXPECT_NEAR(results.matrices[i][row][col], expected.matrices[i][row][col], 1e-5f);
+                    }
+                }
+            }
+        }
+    }
+
+    EXPECT_TRUE(VectorProcessorClass::Set_Kernel_Type(best));
+    EXPECT_FALSE(VectorProcessorClass::Set_Kernel_Type(VectorProcessorClass::KERNEL_COUNT));
+}
+
+TEST(w3d_vp, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    constexpr int VERTEX_COUNT = 16384;
+    constexpr int REPEATS = 100;
+
+    VectorProcessorClass::KernelType best = VectorProcessorClass::Get_Kernel_Type();
+    VPInputs in(VERTEX_COUNT);
+    std::vector<Vector3> dst_vert(VERTEX_COUNT);
+    std::vector<Vector3> dst_norm(VERTEX_COUNT);
+    std::vector<Vector4> dst_prj(VERTEX_COUNT);
+    std::vector<Vector3> dst_indexed(VERTEX_COUNT);
+
+    for (int type = VectorProcessorClass::KERNEL_SCALAR; type < VectorProcessorClass::KERNEL_COUNT; ++type) {
+        if (!VectorProcessorClass::Set_Kernel_Type(VectorProcessorClass::KernelType(type))) {
+            continue;
+        }
+
+        auto start = steady_clock::now();
+
+        for (int i = 0; i < REPEATS; ++i) {
+            VectorProcessorClass::Transform(
+                dst_vert.data(), dst_norm.data(), in.vert.data(), in.norm.data(), in.tm, VERTEX_COUNT);
+        }
+
+        auto skin_time = duration_cast<microseconds>(steady_clock::now() - start);
+        start = steady_clock::now();
+
+        for (int i = 0; i < REPEATS; ++i) {
+            VectorProcessorClass::Transform(dst_prj.data(), in.vert.data(), in.prj, VERTEX_COUNT);
+        }
+
+        auto project_time = duration_cast<microseconds>(steady_clock::now() - start);
+        start = steady_clock::now();
+
+        for (int i = 0; i < REPEATS; ++i) {
+            VectorProcessorClass::CopyIndexed(dst_indexed.data(), in.vert.data(), in.index.data(), VERTEX_COUNT);
+            VectorProcessorClass::Normalize(dst_indexed.data(), VERTEX_COUNT);
+        }
+
+        auto normalize_time = duration_cast<microseconds>(steady_clock::now() - start);
+        captainslog_info("VectorProcessorClass %s: %d vertices x %d, skin %lld us, project %lld us, gather and normalize "
+                         "%lld us",
+            VectorProcessorClass::Get_Kernel_Name(VectorProcessorClass::KernelType(type)),
+            VERTEX_COUNT,
+            REPEATS,
+            (long long)skin_time.count(),
+            (long long)project_time.count(),
+            (long long)normalize_time.count());
+    }
+
+    EXPECT_TRUE(VectorProcessorClass::Set_Kernel_Type(best));
+}
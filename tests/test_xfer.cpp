@@ -0,0 +1,422 @@
+/**
+ * @file
+ *
+ * @author xezon
+ *
+ * @brief Set of tests to validate and benchmark the buffered save game Xfer backends.
+ *
+ * @copyright Thyme is free software: you can redistribute it and/or
+ *            modify it under the terms of the GNU General Public License
+ *            as published by the Free Software Foundation, either version
+ *            2 of the License, or (at your option) any later version.
+ *            A full copy of the GNU General Public License can be found in
+ *            LICENSE
+ */
+#include <captainslog.h>
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "coord.h"
+#include "snapshot.h"
+#include "unicodestring.h"
+#include "xferload.h"
+#include "xfersave.h"
+
+namespace
+{
+constexpr int BENCHMARK_UNITS = 50000;
+
+const char SAVE_FILE[] = "xfer_test.sav";
+const char REFERENCE_FILE[] = "xfer_test_reference.sav";
+
+struct TestUnit
+{
+    ObjectID id;
+    Coord3D pos;
+    float health;
+    bool selected;
+    Utf8String name;
+    Utf16String display_name;
+    std::vector<ObjectID> targets;
+};
+
+// Holds units the way object snapshots do, every unit in its own block.
+class UnitsSnapShot : public SnapShot
+{
+public:
+    virtual void CRC_Snapshot(Xfer *xfer) override {}
+    virtual void Load_Post_Process() override {}
+
+    virtual void Xfer_Snapshot(Xfer *xfer) override
+    {
+        uint8_t version = 1;
+        xfer->xferVersion(&version, 1);
+
+        uint32_t count = uint32_t(m_units.size());
+        xfer->xferUnsignedInt(&count);
+        m_units.resize(count);
+
+        for (TestUnit &unit : m_units) {
+            xfer->Begin_Block();
+            xfer->xferObjectID(&unit.id);
+            xfer->xferCoord3D(&unit.pos);
+            xfer->xferReal(&unit.health);
+            xfer->xferBool(&unit.selected);
+            xfer->xferAsciiString(&unit.name);
+            xfer->xferUnicodeString(&unit.display_name);
+            xfer->xferSTLObjectIDVector(&unit.targets);
+            xfer->End_Block();
+        }
+    }
+
+    std::vector<TestUnit> m_units;
+};
+
+class SettingsSnapShot : public SnapShot
+{
+public:
+    SettingsSnapShot() : m_frame(0), m_difficulty(0) {}
+
+    virtual void CRC_Snapshot(Xfer *xfer) override {}
+    virtual void Load_Post_Process() override {}
+
+    virtual void Xfer_Snapshot(Xfer *xfer) override
+    {
+        uint8_t version = 1;
+        xfer->xferVersion(&version, 1);
+        xfer->xferUnsignedInt(&m_frame);
+        xfer->xferInt(&m_difficulty);
+        xfer->xferAsciiString(&m_mapName);
+    }
+
+    uint32_t m_frame;
+    int32_t m_difficulty;
+    Utf8String m_mapName;
+};
+
+struct TestGameState
+{
+    SettingsSnapShot settings;
+    UnitsSnapShot units;
+};
+
+// Writes named blocks the way GameState::Xfer_Save_Data does, with a block the loading side doesn't know about.
+void Save_State(Xfer *xfer, TestGameState &state)
+{
+    Utf8String name;
+    SettingsSnapShot unknown;
+    unknown.m_mapName = "A block from a newer version of the game";
+
+    name = "CHUNK_Settings";
+    xfer->xferAsciiString(&name);
+    xfer->Begin_Block();
+    xfer->xferSnapshot(&state.settings);
+    xfer->End_Block();
+
+    name = "CHUNK_Unknown";
+    xfer->xferAsciiString(&name);
+    xfer->Begin_Block();
+    xfer->xferSnapshot(&unknown);
+    xfer->End_Block();
+
+    name = "CHUNK_Units";
+    xfer->xferAsciiString(&name);
+    xfer->Begin_Block();
+    xfer->xferSnapshot(&state.units);
+    xfer->End_Block();
+
+    name = "SG_EOF";
+    xfer->xferAsciiString(&name);
+}
+
+void Load_State(Xfer *xfer, TestGameState &state)
+{
+    Utf8String name;
+
+    for (xfer->xferAsciiString(&name); name != "SG_EOF"; xfer->xferAsciiString(&name)) {
+        if (name == "CHUNK_Settings") {
+            xfer->Begin_Block();
+            xfer->xferSnapshot(&state.settings);
+            xfer->End_Block();
+        } else if (name == "CHUNK_Units") {
+            xfer->Begin_Block();
+            xfer->xferSnapshot(&state.units);
+            xfer->End_Block();
+        } else {
+            xfer->Skip(xfer->Begin_Block());
+        }
+    }
+}
+
+void Make_State(TestGameState &state, int count)
+{
+    state.settings.m_frame = 123456;
+    state.settings.m_difficulty = 2;
+    state.settings.m_mapName = "maps\\tournament desert\\tournament desert.map";
+    state.units.m_units.resize(count);
+
+    for (int i = 0; i < count; ++i) {
+        TestUnit &unit = state.units.m_units[i];
+        unit.id = ObjectID(i + 1);
+        unit.pos.x = float(i) * 10.0f;
+        unit.pos.y = float(i % 100) * 2.5f;
+        unit.pos.z = 0.0f;
+        unit.health = float(i % 300);
+        unit.selected = i % 7 == 0;
+        unit.name.Format(i % 2 == 0 ? "Unit%d" : "AmericaVehicleHumveeWithATeamOfRangers%d", i);
+        unit.display_name.Format(U_CHAR("Humvee %d"), i);
+        unit.targets.clear();
+
+        for (int j = 0; j < i % 4; ++j) {
+            unit.targets.push_back(ObjectID(i * 4 + j));
+        }
+    }
+}
+
+void Expect_Same_State(const TestGameState &expected, const TestGameState &actual)
+{
+    EXPECT_EQ(actual.settings.m_frame, expected.settings.m_frame);
+    EXPECT_EQ(actual.settings.m_difficulty, expected.settings.m_difficulty);
+    EXPECT_STREQ(actual.settings.m_mapName.Str(), expected.settings.m_mapName.Str());
+    ASSERT_EQ(actual.units.m_units.size(), expected.units.m_units.size());
+
+    for (size_t i = 0; i < expected.units.m_units.size(); ++i) {
+        const TestUnit &a = actual.units.m_units[i];
+        const TestUnit &e = expected.units.m_units[i];
+        EXPECT_EQ(a.id, e.id) << "Unit " << i;
+        EXPECT_EQ(a.pos.x, e.pos.x) << "Unit " << i;
+        EXPECT_EQ(a.pos.y, e.pos.y) << "Unit " << i;
+        EXPECT_EQ(a.health, e.health) << "Unit " << i;
+        EXPECT_EQ(a.selected, e.selected) << "Unit " << i;
+        EXPECT_STREQ(a.name.Str(), e.name.Str()) << "Unit " << i;
+        EXPECT_TRUE(a.display_name == e.display_name) << "Unit " << i;
+        EXPECT_EQ(a.targets, e.targets) << "Unit " << i;
+    }
+}
+
+std::string Read_File(const char *filename)
+{
+    std::string data;
+    FILE *fp = fopen(filename, "rb");
+
+    if (fp != nullptr) {
+        char buf[4096];
+
+        for (size_t read = fread(buf, 1, sizeof(buf), fp); read > 0; read = fread(buf, 1, sizeof(buf), fp)) {
+            data.append(buf, read);
+        }
+
+        fclose(fp);
+    }
+
+    return data;
+}
+
+// Saves the way the original game did, writing every value to the file as it goes and seeking back to fill in block
+// sizes.
+class StdioXferSave : public Xfer
+{
+public:
+    StdioXferSave() : m_fileHandle(nullptr) { m_type = XFER_SAVE; }
+
+    virtual void Open(Utf8String filename) override
+    {
+        Xfer::Open(filename);
+        m_fileHandle = fopen(filename.Str(), "w+b");
+    }
+
+    virtual void Close() override
+    {
+        fclose(m_fileHandle);
+        m_fileHandle = nullptr;
+    }
+
+    virtual int Begin_Block() override
+    {
+        int size = 0;
+        m_blockStack.push_back(ftell(m_fileHandle));
+        xferImplementation(&size, sizeof(size));
+        return 0;
+    }
+
+    virtual void End_Block() override
+    {
+        long pos = ftell(m_fileHandle);
+        int size = int(pos - m_blockStack.back() - sizeof(size));
+        fseek(m_fileHandle, m_blockStack.back(), SEEK_SET);
+        fwrite(&size, sizeof(size), 1, m_fileHandle);
+        fseek(m_fileHandle, pos, SEEK_SET);
+        m_blockStack.pop_back();
+    }
+
+    virtual void Skip(int offset) override { fseek(m_fileHandle, offset, SEEK_CUR); }
+    virtual void xferSnapshot(SnapShot *thing) override { thing->Xfer_Snapshot(this); }
+
+    virtual void xferAsciiString(Utf8String *thing) override
+    {
+        uint16_t len = thing->Get_Length();
+        xferUnsignedShort(&len);
+        xferUser(const_cast<char *>(thing->Str()), len);
+    }
+
+    virtual void xferUnicodeString(Utf16String *thing) override
+    {
+        uint8_t len = thing->Get_Length();
+        xferUnsignedByte(&len);
+        xferUser(const_cast<unichar_t *>(thing->Str()), len * sizeof(unichar_t));
+    }
+
+    virtual void xferImplementation(void *thing, int size) override
+    {
+        if (size > 0) {
+            fwrite(thing, size, 1, m_fileHandle);
+        }
+    }
+
+private:
+    FILE *m_fileHandle;
+    std::vector<long> m_blockStack;
+};
+} // namespace
+
+TEST(xfer, round_trip)
+{
+    TestGameState saved;
+    Make_State(saved, 500);
+
+    CompressionType types[] = {
+        COMPRESSION_NONE,
+        COMPRESSION_EAR,
+#ifdef BUILD_WITH_ZLIB
+        COMPRESSION_ZL5,
+#endif
+    };
+
+    for (CompressionType type : types) {
+        XferSave save;
+        save.Set_Compression(type);
+        save.Open(SAVE_FILE);
+        Save_State(&save, saved);
+        save.Close();
+        EXPECT_EQ(XferSave::Wait_For_Flush(), XFER_STATUS_OK);
+
+        TestGameState loaded;
+        XferLoad load;
+        load.Open(SAVE_FILE);
+        Load_State(&load, loaded);
+        load.Close();
+
+        Expect_Same_State(saved, loaded);
+    }
+
+    // Uncompressed saves are laid out exactly as the original game wrote them.
+    StdioXferSave reference;
+    reference.Open(REFERENCE_FILE);
+    Save_State(&reference, saved);
+    reference.Close();
+
+    XferSave save;
+    save.Open(SAVE_FILE);
+    Save_State(&save, saved);
+    save.Close();
+    EXPECT_EQ(XferSave::Wait_For_Flush(), XFER_STATUS_OK);
+
+    std::string reference_data = Read_File(REFERENCE_FILE);
+    EXPECT_GT(reference_data.size(), 0u);
+    EXPECT_TRUE(Read_File(SAVE_FILE) == reference_data);
+
+    std::remove(SAVE_FILE);
+    std::remove(REFERENCE_FILE);
+}
+
+TEST(xfer, flush_error)
+{
+    TestGameState saved;
+    Make_State(saved, 10);
+
+    // The file is written after Close returns, a failure shows up when waiting for it.
+    XferSave save;
+    save.Open("xfer_test_missing_dir/xfer_test.sav");
+    Save_State(&save, saved);
+    save.Close();
+    EXPECT_EQ(XferSave::Wait_For_Flush(), XFER_STATUS_FILE_NOT_FOUND);
+
+    save.Open(SAVE_FILE);
+    Save_State(&save, saved);
+    save.Close();
+    EXPECT_EQ(XferSave::Wait_For_Flush(), XFER_STATUS_OK);
+
+    // The thread is started again by the next save after a shutdown.
+    XferSave::Shutdown_Flush();
+    save.Open(SAVE_FILE);
+    Save_State(&save, saved);
+    save.Close();
+    EXPECT_EQ(XferSave::Wait_For_Flush(), XFER_STATUS_OK);
+
+    std::remove(SAVE_FILE);
+}
+
+TEST(xfer, DISABLED_benchmark)
+{
+    using namespace std::chrono;
+
+    TestGameState state;
+    Make_State(state, BENCHMARK_UNITS);
+
+    auto start = steady_clock::now();
+    StdioXferSave reference;
+    reference.Open(REFERENCE_FILE);
+    Save_State(&reference, state);
+    reference.Close();
+    nanoseconds reference_time = steady_clock::now() - start;
+
+    captainslog_info("Saved %d units.", BENCHMARK_UNITS);
+    captainslog_info("Writing as it goes: %lld us, %d bytes",
+        (long long)duration_cast<microseconds>(reference_time).count(),
+        int(Read_File(REFERENCE_FILE).size()));
+
+    CompressionType types[] = {
+        COMPRESSION_NONE,
+        COMPRESSION_EAR,
+#ifdef BUILD_WITH_ZLIB
+        COMPRESSION_ZL5,
+#endif
+    };
+
+    for (CompressionType type : types) {
+        start = steady_clock::now();
+        XferSave save;
+        save.Set_Compression(type);
+        save.Open(SAVE_FILE);
+        Save_State(&save, state);
+        save.Close();
+        nanoseconds save_time = steady_clock::now() - start;
+
+        XferStatus status = XferSave::Wait_For_Flush();
+        nanoseconds flush_time = steady_clock::now() - start;
+
+        start = steady_clock::now();
+        TestGameState loaded;
+        XferLoad load;
+        load.Open(SAVE_FILE);
+        Load_State(&load, loaded);
+        load.Close();
+        nanoseconds load_time = steady_clock::now() - start;
+
+        EXPECT_EQ(status, XFER_STATUS_OK);
+        Expect_Same_State(state, loaded);
+
+        captainslog_info("Buffered %s: %lld us blocking, %lld us until written, %lld us loading, %d bytes",
+            type == COMPRESSION_NONE ? "uncompressed" : CompressionManager::Get_Compression_Name(type),
+            (long long)duration_cast<microseconds>(save_time).count(),
+            (long long)duration_cast<microseconds>(flush_time).count(),
+            (long long)duration_cast<microseconds>(load_time).count(),
+            int(Read_File(SAVE_FILE).size()));
+    }
+
+    std::remove(SAVE_FILE);
+    std::remove(REFERENCE_FILE);
+}